@@ -24,6 +24,7 @@
 #ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_ACTION_HANDLER_HPP_
 #define OPENHD_OPENHD_OHD_COMMON_OPENHD_ACTION_HANDLER_HPP_
 
+#include <array>
 #include <atomic>
 #include <functional>
 #include <map>
@@ -32,6 +33,7 @@
 #include <utility>
 
 #include "openhd_link_statistics.hpp"
+#include "openhd_seqlock.h"
 #include "openhd_spdlog.h"
 #include "openhd_util.h"
 
@@ -170,8 +172,8 @@ class LinkActionHandler {
  public:
   // Camera stats / info that is broadcast in regular intervals
   // Set by the camera streaming implementation - read by OHDMainComponent
-  // (mavlink broadcast) Simple read - write pattern (mutex is a bit overkill,
-  // but we don't have atomic struct)
+  // (mavlink broadcast) and wb_link (stats). Simple read - write pattern,
+  // readers never block (see SeqLock).
   struct CamInfo {
     bool active = false;  // Do not send stats for a non-active camera
     uint8_t cam_index = 0;
@@ -189,71 +191,79 @@ class LinkActionHandler {
     uint8_t qp_min = 0;
   };
   void set_cam_info(uint8_t cam_index, CamInfo camInfo) {
-    if (cam_index == 0) {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam1_mutex);
-      m_cam_info_cam1 = camInfo;
-    } else {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam2_mutex);
-      m_cam_info_cam2 = camInfo;
-    }
+    cam_info_for(cam_index).write(camInfo);
   }
   void set_cam_info_bitrate(uint8_t cam_index, uint16_t bitrate_kbits) {
-    if (cam_index == 0) {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam1_mutex);
-      m_cam_info_cam1.encoding_bitrate_kbits = bitrate_kbits;
-    } else {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam2_mutex);
-      m_cam_info_cam2.encoding_bitrate_kbits = bitrate_kbits;
-    }
+    cam_info_for(cam_index).modify([bitrate_kbits](CamInfo& info) {
+      info.encoding_bitrate_kbits = bitrate_kbits;
+    });
   }
   void set_cam_info_status(uint8_t cam_index, uint8_t status) {
-    if (cam_index == 0) {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam1_mutex);
-      m_cam_info_cam1.cam_status = status;
-    } else {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam2_mutex);
-      m_cam_info_cam2.cam_status = status;
-    }
+    cam_info_for(cam_index).modify(
+        [status](CamInfo& info) { info.cam_status = status; });
+  }
+  void set_cam_info_air_recording(uint8_t cam_index, bool active) {
+    cam_info_for(cam_index).modify(
+        [active](CamInfo& info) { info.air_recording_active = active; });
   }
   void set_cam_info_type(uint8_t cam_index, uint8_t type) {
-    if (cam_index == 0) {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam1_mutex);
-      m_cam_info_cam1.cam_type = type;
-    } else {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam2_mutex);
-      m_cam_info_cam2.cam_type = type;
-    }
+    cam_info_for(cam_index).modify(
+        [type](CamInfo& info) { info.cam_type = type; });
   }
   CamInfo get_cam_info(int cam_index) {
-    if (cam_index == 0) {
-      std::lock_guard<std::mutex> lock(m_cam_info_cam1_mutex);
-      return m_cam_info_cam1;
-    }
-    std::lock_guard<std::mutex> lock(m_cam_info_cam2_mutex);
-    return m_cam_info_cam2;
+    return cam_info_for(cam_index).read();
   }
 
  private:
-  CamInfo m_cam_info_cam1{};
-  CamInfo m_cam_info_cam2{};
-  std::mutex m_cam_info_cam1_mutex;
-  std::mutex m_cam_info_cam2_mutex;
+  // cam index 0: primary, everything else: secondary
+  SeqLock<CamInfo>& cam_info_for(int cam_index) {
+    return cam_index == 0 ? m_cam_info[0] : m_cam_info[1];
+  }
+  std::array<SeqLock<CamInfo>, 2> m_cam_info;
   // LINK STATISTICS
-  // Written by wb_link, published via mavlink by telemetry OHDMainComponent
+  // Written by wb_link, published via mavlink by telemetry OHDMainComponent.
+  // Read / written without any lock or allocation, such that the stats can
+  // be refreshed often.
  private:
-  std::mutex m_last_link_stats_mutex;
-  openhd::link_statistics::StatsAirGround m_last_link_stats{};
+  SeqLock<openhd::link_statistics::StatsAirGround> m_last_link_stats{};
 
  public:
-  void update_link_stats(openhd::link_statistics::StatsAirGround stats) {
-    std::lock_guard<std::mutex> guard(m_last_link_stats_mutex);
-    m_last_link_stats = std::move(stats);
+  void update_link_stats(const openhd::link_statistics::StatsAirGround& stats) {
+    m_last_link_stats.write(stats);
   }
   openhd::link_statistics::StatsAirGround get_link_stats() {
-    std::lock_guard<std::mutex> guard(m_last_link_stats_mutex);
-    return m_last_link_stats;
+    return m_last_link_stats.read();
   }
 
+ public:
+  // Ground -> air feedback: the ground unit sends its video rx stats to the air
+  // unit (adaptive FEC). Written by OHDMainComponent on the air, read by
+  // wb_link.
+  struct GroundVideoStats {
+    openhd::link_statistics::Xmavlink_openhd_stats_wb_video_ground_t stats{};
+    // Incremented on every report, 0 if there has been no report yet
+    uint32_t n_reports = 0;
+  };
+  void update_ground_video_stats(
+      const openhd::link_statistics::Xmavlink_openhd_stats_wb_video_ground_t&
+          stats) {
+    if (stats.link_index >= m_ground_video_stats.size()) return;
+    m_ground_video_stats[stats.link_index].modify(
+        [&stats](GroundVideoStats& tmp) {
+          tmp.stats = stats;
+          tmp.n_reports++;
+        });
+  }
+  GroundVideoStats get_ground_video_stats(int link_index) {
+    if (link_index < 0 || link_index >= (int)m_ground_video_stats.size()) {
+      return {};
+    }
+    return m_ground_video_stats[link_index].read();
+  }
+
+ private:
+  std::array<SeqLock<GroundVideoStats>, 2> m_ground_video_stats;
+
  public:
   std::function<std::vector<uint16_t>()> wb_get_supported_channels = nullptr;
   std::function<bool(int)> wb_cmd_analyze_channels = nullptr;
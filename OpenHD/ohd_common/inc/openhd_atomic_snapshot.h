@@ -0,0 +1,152 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_ATOMIC_SNAPSHOT_H_
+#define OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_ATOMIC_SNAPSHOT_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace openhd {
+
+/**
+ * RCU-style holder for data that is read very often (e.g. on every packet) but
+ * only changes rarely (e.g. when an external device connects).
+ * Readers get a reference to the current, immutable snapshot. Taking and
+ * dropping a reference is a single atomic fetch_add each - no lock (unlike
+ * std::atomic_load on a shared_ptr, which uses a mutex pool in libstdc++) and
+ * no CAS loop, a reader never waits for a writer. That is wait-free where the
+ * platform has a native 64 bit fetch_add (x86, ARMv8.1+), an ll/sc loop
+ * otherwise (ARMv7, ARMv8.0) - lock-free either way.
+ * Writers copy the current snapshot, modify the copy and publish it
+ * atomically - writers are serialized with a mutex.
+ * A reader can hold on to a reference for as long as it wants (e.g. across a
+ * blocking send) - a replaced snapshot is kept until its last reference is
+ * dropped. Snapshots live in N_SLOTS slots, a writer only waits if all of them
+ * are still referenced (N_SLOTS - 1 outdated snapshots held by readers).
+ *
+ * The slot index of the current snapshot and the number of references taken
+ * on it are packed into one word (split reference count): Readers increment
+ * it to get a reference, and decrement the counter of the slot when done.
+ * When a snapshot is replaced, the writer moves the number of references
+ * taken over to the slot - the slot is unused once it reaches 0 again.
+ */
+template <typename T>
+class AtomicSnapshot {
+  static constexpr int N_SLOTS = 16;
+  static constexpr int INDEX_SHIFT = 56;
+  static constexpr uint64_t COUNT_MASK = (uint64_t{1} << INDEX_SHIFT) - 1;
+  struct Slot {
+    std::unique_ptr<const T> value;
+    // <= 0 while current (-released), >= 0 once replaced (taken - released)
+    std::atomic<int64_t> n_refs{0};
+  };
+
+ public:
+  // Reference to a snapshot, keep it for as long as the snapshot is used
+  class Ref {
+   public:
+    Ref(Ref&& other) noexcept : m_slot(other.m_slot), m_value(other.m_value) {
+      other.m_slot = nullptr;
+    }
+    Ref& operator=(Ref&& other) noexcept {
+      if (this != &other) {
+        release();
+        m_slot = other.m_slot;
+        m_value = other.m_value;
+        other.m_slot = nullptr;
+      }
+      return *this;
+    }
+    Ref(const Ref&) = delete;
+    Ref& operator=(const Ref&) = delete;
+    ~Ref() { release(); }
+    const T& operator*() const { return *m_value; }
+    const T* operator->() const { return m_value; }
+
+   private:
+    friend class AtomicSnapshot;
+    Ref(Slot* slot, const T* value) : m_slot(slot), m_value(value) {}
+    void release() {
+      if (m_slot) m_slot->n_refs.fetch_sub(1, std::memory_order_release);
+      m_slot = nullptr;
+    }
+    Slot* m_slot;
+    const T* m_value;
+  };
+  explicit AtomicSnapshot(T initial = T{}) {
+    m_slots[0].value = std::make_unique<const T>(std::move(initial));
+  }
+  AtomicSnapshot(const AtomicSnapshot&) = delete;
+  AtomicSnapshot& operator=(const AtomicSnapshot&) = delete;
+  Ref get() const {
+    // Synchronizes with the exchange in update() - the slot's value is set
+    const uint64_t current = m_current.fetch_add(1, std::memory_order_acquire);
+    Slot& slot = m_slots[current >> INDEX_SHIFT];
+    return Ref{&slot, slot.value.get()};
+  }
+  // Thread-safe, modify is called with a copy of the current snapshot which is
+  // then published.
+  void update(const std::function<void(T&)>& modify) {
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    const int current_index =
+        static_cast<int>(m_current.load(std::memory_order_relaxed) >>
+                         INDEX_SHIFT);
+    auto next = std::make_unique<T>(*m_slots[current_index].value);
+    modify(*next);
+    const int next_index = wait_for_unused_slot(current_index);
+    m_slots[next_index].value = std::move(next);
+    const uint64_t replaced = m_current.exchange(
+        static_cast<uint64_t>(next_index) << INDEX_SHIFT,
+        std::memory_order_acq_rel);
+    m_slots[current_index].n_refs.fetch_add(
+        static_cast<int64_t>(replaced & COUNT_MASK), std::memory_order_relaxed);
+  }
+
+ private:
+  int wait_for_unused_slot(int current_index) {
+    while (true) {
+      for (int i = 0; i < N_SLOTS; i++) {
+        // Synchronizes with the release of the last reference
+        if (i != current_index &&
+            m_slots[i].n_refs.load(std::memory_order_acquire) == 0) {
+          return i;
+        }
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  mutable std::atomic<uint64_t> m_current{0};
+  mutable std::array<Slot, N_SLOTS> m_slots{};
+  std::mutex m_writer_mutex;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_ATOMIC_SNAPSHOT_H_
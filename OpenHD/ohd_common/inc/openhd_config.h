@@ -39,6 +39,7 @@ struct Config {
   std::vector<std::string> WIFI_WB_LINK_CARDS{};
   std::string WIFI_WIFI_HOTSPOT_CARD;
   bool WIFI_MONITOR_CARD_EMULATE = false;
+  int WIFI_MONITOR_CARD_EMULATE_DROP_MODE = 0;
   bool WIFI_FORCE_NO_LINK_BUT_HOTSPOT = false;
   bool WIFI_LOCAL_NETWORK_ENABLE = false;
   std::string WIFI_LOCAL_NETWORK_SSID;
@@ -48,6 +49,8 @@ struct Config {
   std::string NW_ETHERNET_CARD = RPI_ETHERNET_ONLY;
   std::vector<std::string> NW_MANUAL_FORWARDING_IPS;
   bool NW_FORWARD_TO_LOCALHOST_58XX = false;
+  bool NW_BATCH_VIDEO_FORWARDING = false;
+  int NW_BATCH_VIDEO_FORWARDING_MAX_DELAY_US = 2000;
 
   // ETHERNET LINK
   std::string GROUND_UNIT_IP = "";
@@ -69,6 +72,9 @@ struct Config {
   bool GEN_ENABLE_LAST_KNOWN_POSITION = false;
   int GEN_RF_METRICS_LEVEL = 0;
   bool GEN_NO_QOPENHD_AUTOSTART = false;
+  bool GEN_VIDEO_LATENCY_TRACE = false;
+  bool GEN_RATE_CONTROL_TRACE = false;
+  bool GEN_GROUND_RECORDING = false;
 };
 
 // Otherwise, default location is used
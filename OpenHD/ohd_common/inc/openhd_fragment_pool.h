@@ -0,0 +1,102 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_FRAGMENT_POOL_H_
+#define OPENHD_OPENHD_OHD_COMMON_OPENHD_FRAGMENT_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace openhd {
+
+/**
+ * Fixed size pool of MTU-sized buffers for (rtp) video fragments.
+ * At high bitrates, the video path creates thousands of fragments per second -
+ * instead of going through the heap for each of them, producers take a slot
+ * from this pool and the slot is given back once the last reference to it is
+ * gone. Acquiring and releasing a slot is lock-free (tagged free-list), since
+ * fragments are created on the camera thread(s) and released on the link
+ * thread(s).
+ * If the pool is exhausted (or a fragment doesn't fit into a slot) the caller
+ * is expected to fall back to the heap - this is counted as a miss, use the
+ * stats to size the pool for a given platform.
+ */
+class FragmentPool {
+ public:
+  // Large enough for any rtp fragment we create (<=1440 bytes)
+  static constexpr uint32_t SLOT_SIZE = 1536;
+  // ~1.5MB, enough for a couple of high bitrate I-frames in flight
+  static constexpr uint32_t DEFAULT_N_SLOTS = 1024;
+  explicit FragmentPool(uint32_t n_slots);
+  FragmentPool(const FragmentPool&) = delete;
+  FragmentPool& operator=(const FragmentPool&) = delete;
+  // The pool used by all fragment producers inside openhd
+  static FragmentPool& instance();
+  // Returns the index of a free slot (with a reference count of 1)
+  // or -1 if the pool is exhausted.
+  int32_t try_acquire();
+  uint8_t* get_slot_data(uint32_t slot) {
+    return m_memory.get() + (size_t)slot * SLOT_SIZE;
+  }
+  void ref(uint32_t slot) {
+    m_ref_counts[slot].fetch_add(1, std::memory_order_relaxed);
+  }
+  // The slot is given back to the pool once the reference count hits 0
+  void unref(uint32_t slot) {
+    if (m_ref_counts[slot].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      release(slot);
+    }
+  }
+  // Used for fragments that didn't fit into the pool
+  void notify_miss() { m_count_miss.fetch_add(1, std::memory_order_relaxed); }
+  struct Stats {
+    uint64_t count_hit;
+    uint64_t count_miss;
+    uint32_t n_slots;
+    uint32_t n_in_use;
+    // Max n of slots that were in use at the same time
+    uint32_t high_water;
+  };
+  Stats get_stats() const;
+  static std::string stats_to_string(const Stats& stats);
+
+ private:
+  void release(uint32_t slot);
+  const uint32_t m_n_slots;
+  std::unique_ptr<uint8_t[]> m_memory;
+  std::unique_ptr<std::atomic<uint32_t>[]> m_ref_counts;
+  // Free-list, m_next_free[slot] is the next free slot after slot
+  std::unique_ptr<std::atomic<uint32_t>[]> m_next_free;
+  // Upper 32 bits: tag (against ABA), lower 32 bits: first free slot
+  std::atomic<uint64_t> m_free_head;
+  std::atomic<uint64_t> m_count_hit = 0;
+  std::atomic<uint64_t> m_count_miss = 0;
+  std::atomic<uint32_t> m_n_in_use = 0;
+  std::atomic<uint32_t> m_high_water = 0;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_OPENHD_FRAGMENT_POOL_H_
@@ -0,0 +1,156 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_LATENCY_TRACE_H_
+#define OPENHD_OPENHD_OHD_COMMON_OPENHD_LATENCY_TRACE_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "openhd_trace_file.h"
+
+namespace openhd::latency_trace {
+
+// Stages a video frame passes on its way from the encoder to the ground
+// station application. Each stage is measured as the time since the frame's
+// creation_time (arrival of its first fragment at the air unit).
+enum class Stage : int {
+  // Air: last fragment pulled from the encoder (appsink), frame handed to the
+  // link
+  AIR_FRAME_COMPLETE = 0,
+  // Air: frame enqueued for FEC encoding / injection
+  AIR_LINK_ENQUEUE = 1,
+  // Ground: last fragment of the frame received (FEC decoded) by the link
+  GND_LINK_RX = 2,
+  // Ground: last fragment of the frame forwarded via UDP
+  GND_UDP_FORWARD = 3,
+};
+static constexpr int N_STAGES = 4;
+static constexpr int N_STREAMS = 2;
+std::string stage_to_string(Stage stage);
+
+/**
+ * Log-linear latency histogram with microsecond resolution (relative error
+ * <= 1/16) from 0 up to ~16 seconds. Recording is wait-free, such that it can
+ * be done from the video threads directly.
+ */
+class LatencyHistogram {
+ public:
+  void record(std::chrono::nanoseconds latency);
+  struct Summary {
+    uint32_t count = 0;
+    uint32_t p50_us = 0;
+    uint32_t p99_us = 0;
+    uint32_t max_us = 0;
+  };
+  // Summary of all values recorded since the last call
+  Summary get_and_reset();
+
+ private:
+  static constexpr int SUB_BUCKET_BITS = 4;
+  static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+  static constexpr int N_BUCKETS = (24 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+  static int bucket_index(uint32_t value_us);
+  static uint32_t bucket_upper_bound_us(int index);
+  std::array<std::atomic<uint32_t>, N_BUCKETS> m_buckets{};
+  std::atomic<uint32_t> m_max_us{0};
+};
+
+// In-band trace record the air unit sends as an extra (non-rtp) fragment after
+// the last fragment of a frame. The first byte doesn't have the rtp version
+// bits set, such that rtp consumers drop the record if it is not stripped out
+// on the ground.
+struct TraceRecord {
+  uint32_t frame_id;
+  // creation_time of the frame, in air unit steady_clock microseconds
+  int64_t air_creation_time_us;
+};
+static constexpr int TRACE_PACKET_SIZE = 16;
+std::shared_ptr<std::vector<uint8_t>> create_trace_packet(
+    const TraceRecord& record);
+// Cheap enough to be called on every received video fragment
+static bool is_trace_packet(const uint8_t* data, int data_len) {
+  return data_len == TRACE_PACKET_SIZE && data[0] == 'O' && data[1] == 'H' &&
+         data[2] == 'D' && data[3] == 'T';
+}
+TraceRecord parse_trace_packet(const uint8_t* data);
+
+/**
+ * Per-frame latency tracing across air and ground.
+ * The air unit stamps the air stages and sends the frame id and creation time
+ * in-band, the ground unit converts the creation time into its own clock
+ * using the offset established via mavlink TIMESYNC and stamps the ground
+ * stages. Histograms are rolled over once per interval, the summaries are
+ * appended to a (tmpfs, size capped) file and exposed for the link statistics.
+ * Off by default, since it adds a small packet per frame on the link - enable
+ * with GEN_VIDEO_LATENCY_TRACE in hardware.config (on air and ground).
+ */
+class LatencyTracer {
+ public:
+  static LatencyTracer& instance();
+  static constexpr auto TRACE_FILENAME = "/tmp/openhd_latency_trace.csv";
+  static constexpr auto SUMMARY_INTERVAL = std::chrono::seconds(1);
+  bool is_enabled() const { return m_enabled; }
+  void set_enabled(bool enabled) { m_enabled = enabled; }
+  void record(int stream_index, Stage stage,
+              std::chrono::steady_clock::time_point creation_time,
+              std::chrono::steady_clock::time_point now =
+                  std::chrono::steady_clock::now());
+  // Air: trace packet for the frame with the given creation time
+  std::shared_ptr<std::vector<uint8_t>> create_air_trace_packet(
+      int stream_index, std::chrono::steady_clock::time_point creation_time);
+  // Ground: rx_time / forward_time are the time points the last fragment
+  // before the trace packet came out of the link / was forwarded via UDP.
+  // Dropped until the ground has synchronized its clock with the air unit.
+  void on_ground_trace_packet(
+      int stream_index, const uint8_t* data,
+      std::chrono::steady_clock::time_point rx_time,
+      std::chrono::steady_clock::time_point forward_time);
+  // Rolls the histograms over if SUMMARY_INTERVAL has elapsed, returns true
+  // if there is a new summary.
+  bool update();
+  LatencyHistogram::Summary get_summary(int stream_index, Stage stage);
+
+ private:
+  LatencyTracer();
+  void write_summaries(int64_t timestamp_ms);
+  bool m_enabled;
+  std::array<std::array<LatencyHistogram, N_STAGES>, N_STREAMS> m_histograms;
+  std::array<std::atomic<uint32_t>, N_STREAMS> m_next_frame_id{};
+  std::mutex m_summary_mutex;
+  std::array<std::array<LatencyHistogram::Summary, N_STAGES>, N_STREAMS>
+      m_summaries{};
+  std::chrono::steady_clock::time_point m_last_summary =
+      std::chrono::steady_clock::now();
+  std::unique_ptr<openhd::TraceFile> m_trace_file;
+};
+
+}  // namespace openhd::latency_trace
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_OPENHD_LATENCY_TRACE_H_
@@ -24,9 +24,12 @@
 #ifndef OPENHD_OPENHD_OHD_COMMON_OHD_LINK_HPP_
 #define OPENHD_OPENHD_OHD_COMMON_OHD_LINK_HPP_
 
+#include <array>
+#include <chrono>
 #include <cstdint>
 #include <utility>
 
+#include "openhd_latency_trace.h"
 #include "openhd_profile.h"
 #include "openhd_spdlog.h"
 #include "openhd_spdlog_include.h"
@@ -110,11 +113,33 @@ class OHDLink {
   // Called by the wifibroadcast receiver on the ground unit only
   void on_receive_video_data(int stream_index, const uint8_t* data,
                              int data_len) {
+    using namespace openhd::latency_trace;
+    if (is_trace_packet(data, data_len)) {
+      // Never forwarded, the last fragment before it completed the frame.
+      auto& tracer = LatencyTracer::instance();
+      if (tracer.is_enabled() && stream_index >= 0 &&
+          stream_index < N_STREAMS) {
+        const auto& last = m_last_video_fragment[stream_index];
+        tracer.on_ground_trace_packet(stream_index, data, last.rx_time,
+                                      last.forward_time);
+      }
+      return;
+    }
+    const bool trace = LatencyTracer::instance().is_enabled() &&
+                       stream_index >= 0 && stream_index < N_STREAMS;
+    if (trace) {
+      m_last_video_fragment[stream_index].rx_time =
+          std::chrono::steady_clock::now();
+    }
     auto tmp = m_video_data_cb;
     if (tmp) {
       auto& cb = *tmp;
       cb(stream_index, data, data_len);
     }
+    if (trace) {
+      m_last_video_fragment[stream_index].forward_time =
+          std::chrono::steady_clock::now();
+    }
   }
   void register_on_receive_video_data_cb(const ON_VIDEO_DATA_CB& cb) {
     if (cb == nullptr) {
@@ -127,6 +152,14 @@ class OHDLink {
  private:
   std::shared_ptr<ON_TELE_DATA_CB> m_tele_data_cb;
   std::shared_ptr<ON_VIDEO_DATA_CB> m_video_data_cb;
+  // Latency tracing, per video stream. Only accessed from the thread receiving
+  // the given stream.
+  struct LastVideoFragment {
+    std::chrono::steady_clock::time_point rx_time;
+    std::chrono::steady_clock::time_point forward_time;
+  };
+  std::array<LastVideoFragment, openhd::latency_trace::N_STREAMS>
+      m_last_video_fragment{};
 
  public:
   typedef std::function<void(const uint8_t* data, int data_len)>
@@ -158,7 +191,7 @@ class DummyDebugLink : public OHDLink {
       const openhd::FragmentedVideoFrame& fragmented_video_frame) override {
     int64_t total_bytes = 0;
     for (const auto& fragment : fragmented_video_frame.rtp_fragments) {
-      total_bytes += fragment->size();
+      total_bytes += fragment.size();
     }
     m_console_video->debug("Got Frame. Fragments:{} total: {}Bytes",
                            fragmented_video_frame.rtp_fragments.size(),
@@ -24,7 +24,9 @@
 #ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_LINK_STATISTICS_HPP_
 #define OPENHD_OPENHD_OHD_COMMON_OPENHD_LINK_STATISTICS_HPP_
 
+#include <array>
 #include <cstring>
+#include <functional>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -100,7 +102,7 @@ struct Xmavlink_openhd_stats_wb_video_air_fec_performance_t {
   uint32_t curr_fec_encode_time_avg_us; /*<  curr_fec_encode_time_avg_us*/
   uint32_t curr_fec_encode_time_min_us; /*<  curr_fec_encode_time_min_us*/
   uint32_t curr_fec_encode_time_max_us; /*<  curr_fec_encode_time_max_us*/
-  int32_t dummy2;                       /*<  for future use*/
+  int32_t dummy2;                       /*<  trace: p99 enqueued (us)*/
   uint16_t curr_fec_block_size_avg;     /*<  curr_fec_block_size_avg*/
   uint16_t curr_fec_block_size_min;     /*<  curr_fec_block_size_min*/
   uint16_t curr_fec_block_size_max;     /*<  curr_fec_block_size_max*/
@@ -118,16 +120,16 @@ struct Xmavlink_openhd_stats_wb_video_ground_t {
   uint32_t count_blocks_lost;         /*<  count_blocks_lost*/
   uint32_t count_blocks_recovered;    /*<  count_blocks_recovered*/
   uint32_t count_fragments_recovered; /*<  count_fragments_recovered*/
-  int32_t dummy2;                     /*<  for future use*/
+  int32_t dummy2;                     /*<  trace: p99 forwarded (us)*/
   int16_t dummy1;                     /*<  for future use*/
   uint8_t link_index;                 /*<  link_index*/
-  int8_t dummy0;                      /*<  for future use*/
+  int8_t dummy0;                      /*<  rx packet loss (%)*/
 };
 struct Xmavlink_openhd_stats_wb_video_ground_fec_performance_t {
   uint32_t curr_fec_decode_time_avg_us; /*<  todo*/
   uint32_t curr_fec_decode_time_min_us; /*<  todo*/
   uint32_t curr_fec_decode_time_max_us; /*<  todo*/
-  int32_t dummy2;                       /*<  for future use*/
+  int32_t dummy2;                       /*<  trace: p50 forwarded (us)*/
   int16_t dummy1;                       /*<  for future use*/
   uint8_t link_index;                   /*<  link_index*/
   int8_t dummy0;                        /*<  for future use*/
@@ -183,6 +185,28 @@ struct Xmavlink_openhd_wifbroadcast_gnd_operating_mode_t {
 using StatsAllCards =
     std::array<Xmavlink_openhd_stats_monitor_mode_wifi_card_t, 4>;
 
+// Fixed capacity list (no heap), keeps StatsAirGround trivially copyable such
+// that it can be published without a lock (see LinkActionHandler).
+template <typename T, size_t CAPACITY>
+struct FixedCapacityList {
+  std::array<T, CAPACITY> items{};
+  size_t count = 0;
+  // Returns false (and drops the item) if full
+  bool push_back(const T& item) {
+    if (count >= CAPACITY) return false;
+    items[count++] = item;
+    return true;
+  }
+  [[nodiscard]] size_t size() const { return count; }
+  [[nodiscard]] bool empty() const { return count == 0; }
+  const T* begin() const { return items.data(); }
+  const T* end() const { return items.data() + count; }
+  const T& operator[](size_t index) const { return items[index]; }
+};
+
+// Primary and secondary video stream
+static constexpr size_t MAX_N_VIDEO_STREAMS = 2;
+
 struct StatsAirGround {
   bool is_air = false;
   bool ready = false;
@@ -191,10 +215,13 @@ struct StatsAirGround {
   Xmavlink_openhd_stats_telemetry_t telemetry;
   StatsAllCards cards;
   // for air
-  std::vector<Xmavlink_openhd_stats_wb_video_air_t> stats_wb_video_air;
+  FixedCapacityList<Xmavlink_openhd_stats_wb_video_air_t, MAX_N_VIDEO_STREAMS>
+      stats_wb_video_air;
   Xmavlink_openhd_stats_wb_video_air_fec_performance_t air_fec_performance;
   // for ground
-  std::vector<Xmavlink_openhd_stats_wb_video_ground_t> stats_wb_video_ground;
+  FixedCapacityList<Xmavlink_openhd_stats_wb_video_ground_t,
+                    MAX_N_VIDEO_STREAMS>
+      stats_wb_video_ground;
   Xmavlink_openhd_stats_wb_video_ground_fec_performance_t gnd_fec_performance;
   Xmavlink_openhd_wifbroadcast_gnd_operating_mode_t gnd_operating_mode;
 };
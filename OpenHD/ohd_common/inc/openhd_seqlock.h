@@ -0,0 +1,132 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SEQLOCK_H_
+#define OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SEQLOCK_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace openhd {
+
+/**
+ * Seqlock for small, trivially copyable structs (stats, camera info) that are
+ * written every now and then by one thread and polled by others.
+ * - Readers never take a lock and never allocate - they copy the data and
+ *   retry if a write happened in the meantime (rare, a write is a memcpy).
+ * - Writers never wait for readers. Multiple writers are serialized by a
+ *   mutex only writers take.
+ * The data is stored as an array of atomic words, such that concurrent reads
+ * and writes are well defined (no data race on the payload).
+ * Compared to AtomicSnapshot there is no heap allocation per write, which
+ * makes it suitable for data that changes on every update.
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "SeqLock needs a trivially copyable type");
+
+ public:
+  explicit SeqLock(const T& initial = T{}) { store_words(to_words(initial)); }
+  SeqLock(const SeqLock&) = delete;
+  SeqLock& operator=(const SeqLock&) = delete;
+  // Lock-free, returns a consistent copy of the last written value
+  T read() const {
+    Words words;
+    int n_retries = 0;
+    while (true) {
+      const uint32_t seq_begin = m_seq.load(std::memory_order_acquire);
+      if ((seq_begin & 1) == 0) {
+        for (size_t i = 0; i < N_WORDS; i++) {
+          words[i] = m_words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == seq_begin) break;
+      }
+      // Writer is in the middle of a write
+      if (++n_retries > 100) std::this_thread::yield();
+    }
+    return from_words(words);
+  }
+  void write(const T& value) {
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    publish(to_words(value));
+  }
+  // Read - modify - write, thread safe with regard to other writers
+  template <typename F>
+  void modify(F&& modify_fn) {
+    std::lock_guard<std::mutex> lock(m_writer_mutex);
+    // No other writer, we can read without the sequence check
+    Words words;
+    for (size_t i = 0; i < N_WORDS; i++) {
+      words[i] = m_words[i].load(std::memory_order_relaxed);
+    }
+    T value = from_words(words);
+    modify_fn(value);
+    publish(to_words(value));
+  }
+  // Incremented by 2 on every write
+  [[nodiscard]] uint32_t get_sequence() const {
+    return m_seq.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t N_WORDS = (sizeof(T) + 7) / 8;
+  using Words = std::array<uint64_t, N_WORDS>;
+  static Words to_words(const T& value) {
+    Words words{};
+    std::memcpy(words.data(), &value, sizeof(T));
+    return words;
+  }
+  static T from_words(const Words& words) {
+    T value;
+    // T is trivially copyable (see above), but might have default member
+    // initializers - which makes it non-trivial for -Wclass-memaccess
+    std::memcpy(static_cast<void*>(&value), words.data(), sizeof(T));
+    return value;
+  }
+  void store_words(const Words& words) {
+    for (size_t i = 0; i < N_WORDS; i++) {
+      m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+  }
+  void publish(const Words& words) {
+    const uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    store_words(words);
+    m_seq.store(seq + 2, std::memory_order_release);
+  }
+  std::atomic<uint32_t> m_seq{0};
+  std::array<std::atomic<uint64_t>, N_WORDS> m_words{};
+  std::mutex m_writer_mutex;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SEQLOCK_H_
@@ -35,6 +35,7 @@
 // #include <spdlog/spdlog.h>
 // # define FMT_STRING(s) s
 
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -72,12 +73,18 @@ class MavlinkLogMessageBuffer {
   // Dequeues buffered telemetry log messages,
   // called in regular intervals by the telemetry thread
   void enqueue_log_message(MavlinkLogMessage message);
+  // Thread-safe
+  // Called (with the buffer locked - don't log in there) every time a new
+  // message has been enqueued, such that the telemetry thread doesn't need to
+  // poll. Set to nullptr to unregister.
+  void register_on_new_message_cb(std::function<void()> cb);
   // We only have one instance of this class inside openhd
   static MavlinkLogMessageBuffer& instance();
 
  private:
   std::mutex m_mutex;
   std::vector<MavlinkLogMessage> m_buffer;
+  std::function<void()> m_on_new_message_cb = nullptr;
 };
 
 // these match the mavlink SEVERITY_LEVEL enum, but this code should not depend
@@ -0,0 +1,101 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SPSC_QUEUE_H_
+#define OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SPSC_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace openhd {
+
+/**
+ * Bounded, lock-free single producer / single consumer queue.
+ * try_push() must only be called from one thread and try_pop() from one
+ * (other) thread - neither of them ever blocks. Used to hand data from a
+ * latency critical thread (e.g. the camera / link thread) to a worker that
+ * might block (e.g. on disk I/O).
+ * The capacity is rounded up to the next power of 2.
+ */
+template <typename T>
+class SpscQueue {
+ public:
+  explicit SpscQueue(size_t capacity)
+      : m_capacity(round_up_pow2(capacity)),
+        m_mask(m_capacity - 1),
+        m_slots(std::make_unique<T[]>(m_capacity)) {}
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+  // Returns false (and leaves item untouched) if the queue is full
+  bool try_push(T&& item) {
+    const size_t head = m_head.load(std::memory_order_relaxed);
+    if (head - m_cached_tail == m_capacity) {
+      m_cached_tail = m_tail.load(std::memory_order_acquire);
+      if (head - m_cached_tail == m_capacity) return false;
+    }
+    m_slots[head & m_mask] = std::move(item);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+  // Returns false if the queue is empty
+  bool try_pop(T& out) {
+    const size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail == m_cached_head) {
+      m_cached_head = m_head.load(std::memory_order_acquire);
+      if (tail == m_cached_head) return false;
+    }
+    out = std::move(m_slots[tail & m_mask]);
+    // Don't keep whatever the item owns alive until the slot is re-used
+    m_slots[tail & m_mask] = T{};
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  // Approximation if called while the other side is active
+  size_t size() const {
+    const size_t tail = m_tail.load(std::memory_order_acquire);
+    const size_t head = m_head.load(std::memory_order_acquire);
+    return head - tail;
+  }
+  size_t capacity() const { return m_capacity; }
+
+ private:
+  static size_t round_up_pow2(size_t value) {
+    size_t ret = 1;
+    while (ret < value) ret <<= 1;
+    return ret;
+  }
+  const size_t m_capacity;
+  const size_t m_mask;
+  std::unique_ptr<T[]> m_slots;
+  // Written by the producer, cached by the consumer (and vice versa)
+  alignas(64) std::atomic<size_t> m_head{0};
+  size_t m_cached_tail = 0;
+  alignas(64) std::atomic<size_t> m_tail{0};
+  size_t m_cached_head = 0;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_INC_OPENHD_SPSC_QUEUE_H_
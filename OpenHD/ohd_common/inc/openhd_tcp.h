@@ -24,18 +24,26 @@
 #ifndef OPENHD_OPENHD_TCP_H
 #define OPENHD_OPENHD_TCP_H
 
-#include <deque>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "openhd_spdlog.h"
 
 namespace openhd {
 /**
- * Non-blocking multiple-client(s) multi-threaded TCP server
+ * Non-blocking multiple-client(s) TCP server
  * FEATURES:
- * 1) Multiple clients (multi-threaded)
- * 2) Automatically disconnect dead clients
- * 3) Generic interface where implementation can overwrite the following events:
+ * 1) Multiple clients, all served by one epoll thread (no thread per client)
+ * 2) Per-client bounded tx queue - a slow client only ever drops its own
+ * messages (whole messages, never partial ones) and never stalls the others
+ * 3) Automatically disconnect dead / stalled clients
+ * 4) Generic interface where implementation can overwrite the following events:
  *      a) client connected / disconnected
  *      b) message received (any client)
  *   And send messages with a broadcast-like interface.
@@ -46,18 +54,26 @@ class TCPServer {
     // always localhost
     // std::string ip;
     int port;
+    // Max n of bytes queued (not yet accepted by the kernel) per client
+    size_t max_tx_queue_bytes_per_client = 128 * 1024;
+    // A client whose tx queue did not drain at all for this long is considered
+    // dead and disconnected.
+    std::chrono::milliseconds client_stall_timeout = std::chrono::seconds(5);
   };
   explicit TCPServer(std::string tag, Config config, bool debug = false);
   ~TCPServer();
   /**
    * Needs to be overridden by implementation.
    * Called every time a packet (from any client) has been received.
-   * The thread calling the method is different for every client.
+   * Always called from the (single) server thread.
    */
   virtual void on_packet_any_tcp_client(const uint8_t* data, int data_len) = 0;
   /**
    * Send the given message to all (currently) connected clients.
-   * Non-blocking -
+   * Non-blocking - what the socket doesn't accept immediately is queued and
+   * written by the server thread once the client is writable again. If the
+   * queue of a client is full, the message is dropped for this client.
+   * Thread-safe.
    */
   void send_message_to_all_clients(const uint8_t* data, int data_len);
   /**
@@ -72,11 +88,25 @@ class TCPServer {
   const Config m_config;
   const bool m_debug;
   std::shared_ptr<spdlog::logger> m_console;
-  std::unique_ptr<std::thread> m_accept_thread = nullptr;
-  bool m_keep_accept_thread_alive = true;
-  int server_fd = 0;
+  std::unique_ptr<std::thread> m_loop_thread = nullptr;
+  std::atomic<bool> m_keep_looping = true;
+  int m_server_fd = -1;
+  int m_epoll_fd = -1;
+  // eventfd, used to wake up the server thread
+  int m_wakeup_fd = -1;
   static constexpr const size_t READ_BUFF_SIZE = 65507;
-  void loop_accept();
+  static constexpr const int MAX_EPOLL_EVENTS = 16;
+  // Upper bound, so stalled clients are reaped even if there are no events
+  static constexpr const int LOOP_TIMEOUT_MS = 1000;
+  std::unique_ptr<std::array<uint8_t, READ_BUFF_SIZE>> m_rx_buff;
+  void loop_epoll();
+  bool setup_server_socket();
+  void accept_new_clients();
+  void on_client_readable(int fd);
+  void on_client_writable(int fd);
+  void mark_client_for_removal(int fd);
+  void reap_clients();
+  void wake_up_loop();
 
  private:
   struct ConnectedClient {
@@ -84,13 +114,23 @@ class TCPServer {
     std::string ip;
     int port;
     bool marked_to_be_removed = false;
-    std::shared_ptr<std::thread> rx_loop_thread;
-    void loop_rx();
-    bool keep_rx_looping = true;
-    TCPServer* parent;
+    // Bounded ring buffer of data not yet accepted by the socket
+    std::vector<uint8_t> tx_buff;
+    size_t tx_head = 0;
+    size_t tx_size = 0;
+    bool epollout_armed = false;
+    std::chrono::steady_clock::time_point last_tx_progress;
+    uint64_t n_dropped_messages = 0;
   };
-  std::mutex m_clients_list_mutex;
-  std::deque<std::shared_ptr<ConnectedClient>> m_clients_list;
+  // The following need m_clients_mutex to be held
+  void send_to_client(ConnectedClient& client, const uint8_t* data,
+                      int data_len);
+  void flush_tx(ConnectedClient& client);
+  void set_epollout(ConnectedClient& client, bool enable);
+  // Clients are only ever added / removed (and their fd closed) by the server
+  // thread, but the tx side is accessed by any thread sending messages.
+  std::mutex m_clients_mutex;
+  std::unordered_map<int, std::shared_ptr<ConnectedClient>> m_clients;
 };
 }  // namespace openhd
 
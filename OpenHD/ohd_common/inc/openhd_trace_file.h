@@ -0,0 +1,64 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_TRACE_FILE_H_
+#define OPENHD_OPENHD_OHD_COMMON_OPENHD_TRACE_FILE_H_
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+namespace openhd {
+
+/**
+ * (CSV) trace file for debugging, usually in /tmp - which is tmpfs (RAM) on
+ * the OpenHD images. The size is capped: once the file reaches max_size_bytes
+ * it is moved to <filename>.1 (replacing the previous one) and a new file is
+ * started, so a trace never takes more than 2x max_size_bytes of RAM.
+ * Buffered, lines end up in the file once the stream buffer is full, on
+ * rotation and on destruction. Not thread safe.
+ */
+class TraceFile {
+ public:
+  static constexpr size_t DEFAULT_MAX_SIZE_BYTES = 1024 * 1024;
+  // The header (without newline) is written at the top of each file
+  TraceFile(std::string filename, std::string header,
+            size_t max_size_bytes = DEFAULT_MAX_SIZE_BYTES);
+  TraceFile(const TraceFile&) = delete;
+  TraceFile& operator=(const TraceFile&) = delete;
+  // Appends the given line (without newline)
+  void write_line(const std::string& line);
+  const std::string& get_filename() const { return m_filename; }
+
+ private:
+  void open();
+  const std::string m_filename;
+  const std::string m_header;
+  const size_t m_max_size_bytes;
+  std::ofstream m_file;
+  size_t m_curr_size_bytes = 0;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_COMMON_OPENHD_TRACE_FILE_H_
@@ -25,7 +25,12 @@
 #define OPENHD_OPENHD_UDP_H
 
 #include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <functional>
 #include <list>
 #include <memory>
@@ -33,6 +38,9 @@
 #include <optional>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "openhd_atomic_snapshot.h"
 
 //
 // openhd UDP helpers
@@ -47,6 +55,8 @@ class UDPForwarder {
   UDPForwarder &operator=(const UDPForwarder &) = delete;
   ~UDPForwarder();
   void forwardPacketViaUDP(const uint8_t *packet, std::size_t packetSize) const;
+  // Same, but the packet is gathered from n_parts memory regions
+  void forwardPacketViaUDP(const struct iovec *parts, int n_parts) const;
 
  private:
   struct sockaddr_in saddr {};
@@ -63,9 +73,10 @@ class UDPForwarder {
  */
 class UDPMultiForwarder {
  public:
-  explicit UDPMultiForwarder() = default;
+  explicit UDPMultiForwarder();
   UDPMultiForwarder(const UDPMultiForwarder &) = delete;
   UDPMultiForwarder &operator=(const UDPMultiForwarder &) = delete;
+  ~UDPMultiForwarder();
   /**
    * Start forwarding data to another IP::Port tuple
    */
@@ -79,16 +90,73 @@ class UDPMultiForwarder {
    * Forward data to all added IP::Port tuples via UDP
    */
   void forwardPacketViaUDP(const uint8_t *packet, std::size_t packetSize);
-  [[nodiscard]] const std::list<std::unique_ptr<UDPForwarder>> &getForwarders()
-      const;
+  // Same, but the packet is gathered from n_parts memory regions
+  void forwardPacketViaUDP(const struct iovec *parts, int n_parts);
+  struct Destination {
+    std::string client_addr;
+    int client_udp_port;
+    struct sockaddr_in saddr;
+  };
+  [[nodiscard]] std::vector<Destination> getDestinations() const;
+  /**
+   * Batched forwarding: Instead of one sendto per packet and destination,
+   * packets passed to forwardPacketViaUDP are buffered and sent to all
+   * destinations with sendmmsg (at least one call per flush, more if the
+   * kernel sends only part of the messages or one of them fails) once either
+   * 1) flushBatch() is called (e.g. end of a video frame) or
+   * 2) the batch is full or
+   * 3) the oldest buffered packet has waited for max_delay.
+   * Packets larger than MAX_BATCHED_PACKET_SIZE bypass the batch, after the
+   * batch has been flushed (order is kept).
+   * A failing destination only loses its own messages, like with sendto.
+   */
+  void enableBatching(std::chrono::microseconds max_delay);
+  void flushBatch();
+  static constexpr int MAX_BATCH_N_PACKETS = 64;
+  static constexpr size_t MAX_BATCHED_PACKET_SIZE = 2048;
+  struct BatchStats {
+    uint64_t n_packets = 0;
+    // sendto / sendmmsg calls
+    uint64_t n_syscalls = 0;
+    uint64_t n_flushes = 0;
+    // Time a packet waited in the batch (first packet of each batch)
+    std::chrono::nanoseconds delay_sum{};
+    std::chrono::nanoseconds delay_max{};
+  };
+  BatchStats getBatchStats();
+
+ private:
+  // All the host::port tuples we send the data to, as a contiguous array of
+  // prepared addresses. Published as an immutable snapshot, such that the
+  // (per packet) forwarding doesn't need to lock.
+  AtomicSnapshot<std::vector<Destination>> m_destinations;
+  // All data is sent from this socket
+  int m_sockfd = -1;
 
  private:
-  // list of host::port tuples where we send the data to.
-  std::list<std::unique_ptr<UDPForwarder>> udpForwarders;
-  // modifying the list of forwarders must be thread-safe
-  std::mutex udpForwardersLock;
+  void enqueueBatched(const struct iovec *parts, int n_parts,
+                      std::size_t packetSize);
+  // Sends out the batch, m_batch_mutex needs to be locked
+  void flushBatchLocked();
+  void loopFlushDeadline();
+  std::atomic<bool> m_batching_enabled = false;
+  std::chrono::microseconds m_batch_max_delay{};
+  std::mutex m_batch_mutex;
+  std::condition_variable m_batch_cv;
+  std::vector<uint8_t> m_batch_data;
+  std::vector<size_t> m_batch_sizes;
+  // Reused by every flush, m_batch_iovecs[i] points to batch slot i
+  std::vector<struct iovec> m_batch_iovecs;
+  std::vector<struct mmsghdr> m_batch_messages;
+  std::chrono::steady_clock::time_point m_batch_oldest_packet{};
+  BatchStats m_batch_stats{};
+  bool m_batch_flush_thread_run = false;
+  std::unique_ptr<std::thread> m_batch_flush_thread = nullptr;
 };
 
+// Create a ipv4 destination address, ip has to be in dotted decimal notation
+struct sockaddr_in create_udp_destination(const std::string &ip, int port);
+
 // Open the specified port for udp receiving
 // sets SO_REUSEADDR to true if possible
 // throws a runtime exception if opening the socket fails
@@ -110,6 +178,33 @@ class UDPReceiver {
    */
   explicit UDPReceiver(std::string client_addr, int client_udp_port,
                        OUTPUT_DATA_CALLBACK cb);
+  /**
+   * Batched receive mode: The socket is drained with recvmmsg into preallocated
+   * buffers and all the packets returned by one call are handed to the
+   * callback at once - one syscall / callback per burst instead of per packet.
+   * The packet data is only valid for the duration of the callback.
+   */
+  struct ReceivedPacket {
+    const uint8_t *data;
+    std::size_t size;
+    // Kernel receive timestamp (CLOCK_REALTIME) if enabled, 0 otherwise
+    std::chrono::nanoseconds kernel_timestamp;
+  };
+  typedef std::function<void(const ReceivedPacket *packets,
+                             std::size_t n_packets)>
+      OUTPUT_BATCH_CALLBACK;
+  struct BatchConfig {
+    // Max n of packets received by one recvmmsg call
+    int max_n_packets = 32;
+    // Datagrams larger than this are dropped (truncated by the kernel)
+    std::size_t max_packet_size = 2048;
+    // SO_RCVBUF to request, 0 to keep the system default
+    int rcvbuf_size = 0;
+    // Attach SO_TIMESTAMPNS kernel timestamps to each packet
+    bool kernel_timestamps = false;
+  };
+  explicit UDPReceiver(std::string client_addr, int client_udp_port,
+                       OUTPUT_BATCH_CALLBACK cb, BatchConfig config);
   ~UDPReceiver();
   void loopUntilError();
   // Now this one is kinda special - for mavsdk we need to send messages from
@@ -118,12 +213,19 @@ class UDPReceiver {
   // listening on).
   void forwardPacketViaUDP(const std::string &destIp, int destPort,
                            const uint8_t *packet, std::size_t packetSize) const;
+  // Same as above, but with an already prepared destination address
+  void forwardPacketViaUDP(const struct sockaddr_in &dest,
+                           const uint8_t *packet, std::size_t packetSize) const;
   void stopLooping();
   void runInBackground();
   void stopBackground();
 
  private:
   const OUTPUT_DATA_CALLBACK mCb;
+  const OUTPUT_BATCH_CALLBACK m_batch_cb;
+  const BatchConfig m_batch_config{};
+  void loop_recvmmsg();
+  void log_receive_error(ssize_t ret);
   bool receiving = true;
   int mSocket;
   std::unique_ptr<std::thread> receiverThread = nullptr;
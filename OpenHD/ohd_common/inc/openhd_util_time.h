@@ -43,8 +43,12 @@ std::string time_readable_ns(uint64_t nanoseconds);
 
 uint32_t get_micros(std::chrono::nanoseconds ns);
 
+// Offset (in us) to convert air unit steady_clock time into ground unit
+// steady_clock time, established via mavlink TIMESYNC on the ground.
 void store_air_unit_time_offset_us(int64_t offset_us);
 int64_t get_air_unit_time_offset_us();
+// false until the offset above has been stored
+bool has_air_unit_time_offset();
 
 }  // namespace openhd::util
 
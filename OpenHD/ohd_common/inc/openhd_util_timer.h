@@ -0,0 +1,92 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_UTIL_TIMER_H
+#define OPENHD_OPENHD_UTIL_TIMER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace openhd::util {
+
+/**
+ * For a worker thread that runs tasks at a fixed interval (wb_link work
+ * thread, telemetry components). Keeps the rate instead of drifting by however
+ * late the thread was, and tells the thread when the task is due next.
+ */
+class IntervalTimer {
+ public:
+  explicit IntervalTimer(std::chrono::milliseconds interval)
+      : m_interval(interval),
+        m_next_due(std::chrono::steady_clock::now() + interval) {}
+  // Returns true if the task is due, and schedules the next run
+  bool poll(const std::chrono::steady_clock::time_point now) {
+    if (now < m_next_due) return false;
+    m_next_due += m_interval;
+    if (m_next_due <= now) {
+      // We fell behind by more than one interval, don't run a burst
+      m_next_due = now + m_interval;
+    }
+    return true;
+  }
+  [[nodiscard]] std::chrono::steady_clock::time_point next_due() const {
+    return m_next_due;
+  }
+
+ private:
+  const std::chrono::milliseconds m_interval;
+  std::chrono::steady_clock::time_point m_next_due;
+};
+
+/**
+ * Lets a worker thread sleep until its next deadline, unless another thread
+ * has something urgent for it. A notify() before the wait is not lost, the
+ * next wait_until() returns right away. Thread-safe.
+ */
+class WakeupSignal {
+ public:
+  // Wakes up wait_until() as soon as possible
+  void notify() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_notified = true;
+    }
+    m_cv.notify_one();
+  }
+  // Returns once the deadline is reached or notify() has been called
+  void wait_until(const std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cv.wait_until(lock, deadline, [this] { return m_notified; });
+    m_notified = false;
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_notified = false;
+};
+
+}  // namespace openhd::util
+
+#endif  // OPENHD_OPENHD_UTIL_TIMER_H
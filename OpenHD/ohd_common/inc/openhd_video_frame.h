@@ -24,19 +24,214 @@
 #ifndef OPENHD_OPENHD_OHD_COMMON_OPENHD_VIDEO_FRAME_H_
 #define OPENHD_OPENHD_OHD_COMMON_OPENHD_VIDEO_FRAME_H_
 
+#include <sys/uio.h>
+
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
 #include <memory>
 #include <sstream>
 #include <vector>
 
+#include "openhd_fragment_pool.h"
+
 namespace openhd {
 
+// A single (rtp) fragment of a video frame.
+// The fragment itself doesn't care where its memory comes from - it only keeps
+// a reference on whatever owns the memory (e.g. a std::vector, a FragmentPool
+// slot or a gstreamer buffer) and releases it once the last copy of the
+// fragment is gone. This way, we can hand fragments from the encoder to the
+// link without copying the data. Copying a fragment is cheap (it only copies
+// the reference).
+// A fragment might not be contiguous in memory (see MAX_N_SPANS), consumers
+// that need it in one piece (e.g. WBStreamTx) copy it exactly once.
+class VideoFragment {
+ public:
+  VideoFragment() = default;
+  VideoFragment(const VideoFragment& other)
+      : m_owner(other.m_owner),
+        m_data(other.m_data),
+        m_size(other.m_size),
+        m_tail_data(other.m_tail_data),
+        m_tail_size(other.m_tail_size),
+        m_is_vector(other.m_is_vector),
+        m_pool(other.m_pool),
+        m_slot(other.m_slot),
+        m_external(other.m_external),
+        m_external_handle(other.m_external_handle) {
+    if (m_pool) m_pool->ref(m_slot);
+    if (m_external) m_external->ref(m_external_handle);
+  }
+  VideoFragment(VideoFragment&& other) noexcept
+      : m_owner(std::move(other.m_owner)),
+        m_data(other.m_data),
+        m_size(other.m_size),
+        m_tail_data(other.m_tail_data),
+        m_tail_size(other.m_tail_size),
+        m_is_vector(other.m_is_vector),
+        m_pool(other.m_pool),
+        m_slot(other.m_slot),
+        m_external(other.m_external),
+        m_external_handle(other.m_external_handle) {
+    other.m_pool = nullptr;
+    other.m_external = nullptr;
+  }
+  VideoFragment& operator=(VideoFragment other) noexcept {
+    std::swap(m_owner, other.m_owner);
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+    std::swap(m_tail_data, other.m_tail_data);
+    std::swap(m_tail_size, other.m_tail_size);
+    std::swap(m_is_vector, other.m_is_vector);
+    std::swap(m_pool, other.m_pool);
+    std::swap(m_slot, other.m_slot);
+    std::swap(m_external, other.m_external);
+    std::swap(m_external_handle, other.m_external_handle);
+    return *this;
+  }
+  ~VideoFragment() {
+    if (m_pool) m_pool->unref(m_slot);
+    if (m_external) m_external->unref(m_external_handle);
+  }
+  // For owners that are reference counted on their own (e.g. a GstBuffer),
+  // referencing them doesn't need an allocation.
+  struct ExternalRef {
+    void (*ref)(void* handle);
+    void (*unref)(void* handle);
+  };
+  // Max n of (non-contiguous) memory regions a fragment can be made of
+  static constexpr int MAX_N_SPANS = 2;
+  // Takes over one reference on handle. The fragment is made of data and an
+  // optional tail that lives somewhere else - e.g. the rtp header and the
+  // payload of a gstreamer buffer, which are two different memories.
+  static VideoFragment from_external(const ExternalRef& external, void* handle,
+                                     const uint8_t* data, size_t size,
+                                     const uint8_t* tail_data = nullptr,
+                                     size_t tail_size = 0) {
+    VideoFragment ret{};
+    ret.m_data = data;
+    ret.m_size = size;
+    ret.m_tail_data = tail_data;
+    ret.m_tail_size = tail_size;
+    ret.m_external = &external;
+    ret.m_external_handle = handle;
+    return ret;
+  }
+  // Fragment referencing size bytes at data, data is valid as long as owner is
+  // alive.
+  VideoFragment(std::shared_ptr<const void> owner, const uint8_t* data,
+                size_t size)
+      : m_owner(std::move(owner)), m_data(data), m_size(size) {}
+  // Fragment backed by a std::vector (no copy)
+  explicit VideoFragment(std::shared_ptr<std::vector<uint8_t>> data)
+      : m_data(data ? data->data() : nullptr),
+        m_size(data ? data->size() : 0),
+        m_is_vector(true) {
+    m_owner = std::move(data);
+  }
+  // Fragment with its own copy of the given data
+  static VideoFragment copy_of(const uint8_t* data, size_t size) {
+    return VideoFragment(
+        std::make_shared<std::vector<uint8_t>>(data, data + size));
+  }
+  // Same as above, but the copy lives in a slot of the given pool.
+  // Falls back to the heap if the pool is exhausted or data doesn't fit.
+  static VideoFragment pooled_copy_of(
+      const uint8_t* data, size_t size,
+      FragmentPool& pool = FragmentPool::instance()) {
+    uint8_t* out_data = nullptr;
+    VideoFragment ret = pooled_create(size, out_data, pool);
+    std::memcpy(out_data, data, size);
+    return ret;
+  }
+  // Fragment of size (uninitialized) bytes, for producers that write their
+  // data in place (e.g. an rtp packet from its header and payload) through
+  // out_data. Same pool / heap fallback as pooled_copy_of.
+  static VideoFragment pooled_create(
+      size_t size, uint8_t*& out_data,
+      FragmentPool& pool = FragmentPool::instance()) {
+    if (size > FragmentPool::SLOT_SIZE) {
+      pool.notify_miss();
+    } else if (const int32_t slot = pool.try_acquire(); slot >= 0) {
+      VideoFragment ret{};
+      out_data = pool.get_slot_data(slot);
+      ret.m_data = out_data;
+      ret.m_size = size;
+      ret.m_pool = &pool;
+      ret.m_slot = (uint32_t)slot;
+      return ret;
+    }
+    auto buffer = std::make_shared<std::vector<uint8_t>>(size);
+    out_data = buffer->data();
+    return VideoFragment(std::move(buffer));
+  }
+  // Only valid for contiguous fragments, use get_spans / copy_to otherwise
+  const uint8_t* data() const {
+    assert(is_contiguous());
+    return m_data;
+  }
+  size_t size() const { return m_size + m_tail_size; }
+  bool empty() const { return size() == 0; }
+  bool is_contiguous() const { return m_tail_size == 0; }
+  // Writes the memory region(s) of this fragment to out (at most
+  // MAX_N_SPANS), returns the n of regions - e.g. for sendmsg
+  int get_spans(struct iovec* out) const {
+    out[0].iov_base = (void*)m_data;
+    out[0].iov_len = m_size;
+    if (is_contiguous()) return 1;
+    out[1].iov_base = (void*)m_tail_data;
+    out[1].iov_len = m_tail_size;
+    return 2;
+  }
+  // Copies (at most max_size bytes of) the data to dst, returns the n of bytes
+  // copied
+  size_t copy_to(uint8_t* dst, size_t max_size) const {
+    const size_t head = std::min(m_size, max_size);
+    std::memcpy(dst, m_data, head);
+    const size_t tail = std::min(m_tail_size, max_size - head);
+    if (tail > 0) std::memcpy(dst + head, m_tail_data, tail);
+    return head + tail;
+  }
+  // True if as_vector() doesn't need to copy
+  bool is_vector() const { return m_is_vector; }
+  // For consumer(s) that need the data as a std::vector - only copies if this
+  // fragment is not backed by a std::vector already.
+  std::shared_ptr<std::vector<uint8_t>> as_vector() const {
+    if (m_is_vector) {
+      return std::const_pointer_cast<std::vector<uint8_t>>(
+          std::static_pointer_cast<const std::vector<uint8_t>>(m_owner));
+    }
+    auto ret = std::make_shared<std::vector<uint8_t>>(size());
+    copy_to(ret->data(), ret->size());
+    return ret;
+  }
+
+ private:
+  std::shared_ptr<const void> m_owner = nullptr;
+  const uint8_t* m_data = nullptr;
+  size_t m_size = 0;
+  // Second (non-contiguous) memory region, if any
+  const uint8_t* m_tail_data = nullptr;
+  size_t m_tail_size = 0;
+  bool m_is_vector = false;
+  // Set if this fragment references a pool slot
+  FragmentPool* m_pool = nullptr;
+  uint32_t m_slot = 0;
+  // Set if this fragment references an externally reference counted owner
+  const ExternalRef* m_external = nullptr;
+  void* m_external_handle = nullptr;
+};
+
 // R.n this is the best name i can come up with
 // This is not required to be exactly one frame, but should be
 // already packetized into rtp fragments
 // R.n it is always either h264,h265 or mjpeg fragmented using the RTP protocol
 struct FragmentedVideoFrame {
-  std::vector<std::shared_ptr<std::vector<uint8_t>>> rtp_fragments;
+  std::vector<VideoFragment> rtp_fragments;
   // Time point of when this frame was produced, as early as possible.
   // ideally, this would be the time point when the frame was generated by the
   // CMOS - but r.n no platform supports measurements this deep.
@@ -54,15 +249,34 @@ struct FragmentedVideoFrame {
   // Set to true if this frame is an IDR frame and therefore we can safely drop
   // previous frame(s) without having complete corruption
   bool is_idr_frame = false;
+  // Early (sub-frame) transmission: a frame might be handed to the link in
+  // multiple parts (e.g. one per slice) as soon as each part is complete.
+  // All parts share the same creation_time. 0 for the first (or only) part.
+  int part_index = 0;
+  // false for all but the last part of a frame
+  bool is_last_part = true;
   std::string to_string() const {
     int total_bytes = 0;
-    for (auto& fragment : rtp_fragments) total_bytes += fragment->size();
+    for (auto& fragment : rtp_fragments) total_bytes += fragment.size();
     if (dirty_frame) total_bytes += dirty_frame->size();
     std::stringstream ss;
     ss << "Bytes:" << total_bytes << " Fragments:" << rtp_fragments.size();
     ss << " IDR:" << (is_idr_frame ? "Y" : "N");
+    if (part_index != 0 || !is_last_part) {
+      ss << " Part:" << part_index << (is_last_part ? "(last)" : "");
+    }
     return ss.str();
   }
+  // For link implementation(s) that can only consume std::vector fragments
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> get_fragments_as_vectors()
+      const {
+    std::vector<std::shared_ptr<std::vector<uint8_t>>> ret;
+    ret.reserve(rtp_fragments.size());
+    for (const auto& fragment : rtp_fragments) {
+      ret.push_back(fragment.as_vector());
+    }
+    return ret;
+  }
 };
 typedef std::function<void(int stream_index, const openhd::FragmentedVideoFrame&
                                                  fragmented_video_frame)>
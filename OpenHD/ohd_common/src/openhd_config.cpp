@@ -62,6 +62,8 @@ static openhd::Config load_or_default() {
           r.Get<std::string>("wifi", "WIFI_WIFI_HOTSPOT_CARD", "");
       ret.WIFI_MONITOR_CARD_EMULATE =
           r.Get<bool>("wifi", "WIFI_MONITOR_CARD_EMULATE", false);
+      ret.WIFI_MONITOR_CARD_EMULATE_DROP_MODE =
+          r.Get<int>("wifi", "WIFI_MONITOR_CARD_EMULATE_DROP_MODE", 0);
       ret.WIFI_FORCE_NO_LINK_BUT_HOTSPOT =
           r.Get<bool>("wifi", "WIFI_FORCE_NO_LINK_BUT_HOTSPOT", false);
       ret.WIFI_LOCAL_NETWORK_ENABLE =
@@ -78,6 +80,10 @@ static openhd::Config load_or_default() {
           r.GetVector<std::string>("network", "NW_MANUAL_FORWARDING_IPS");
       ret.NW_FORWARD_TO_LOCALHOST_58XX =
           r.Get<bool>("network", "NW_FORWARD_TO_LOCALHOST_58XX", false);
+      ret.NW_BATCH_VIDEO_FORWARDING =
+          r.Get<bool>("network", "NW_BATCH_VIDEO_FORWARDING", false);
+      ret.NW_BATCH_VIDEO_FORWARDING_MAX_DELAY_US = r.Get<int>(
+          "network", "NW_BATCH_VIDEO_FORWARDING_MAX_DELAY_US", 2000);
 
       // Parse Ethernet link configuration
       std::cout << "WARN: Parsing Ethernet link configuration" << std::endl;
@@ -135,6 +141,12 @@ static openhd::Config load_or_default() {
     ret.GEN_RF_METRICS_LEVEL = r.Get<int>("generic", "GEN_RF_METRICS_LEVEL", 0);
     ret.GEN_NO_QOPENHD_AUTOSTART =
         r.Get<bool>("generic", "GEN_NO_QOPENHD_AUTOSTART", false);
+    ret.GEN_VIDEO_LATENCY_TRACE =
+        r.Get<bool>("generic", "GEN_VIDEO_LATENCY_TRACE", false);
+    ret.GEN_RATE_CONTROL_TRACE =
+        r.Get<bool>("generic", "GEN_RATE_CONTROL_TRACE", false);
+    ret.GEN_GROUND_RECORDING =
+        r.Get<bool>("generic", "GEN_GROUND_RECORDING", false);
     return ret;
   } catch (std::exception& exception) {
     std::cerr << "ERROR: Ill-formatted config file: " << exception.what()
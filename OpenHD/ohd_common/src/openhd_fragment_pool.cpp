@@ -0,0 +1,103 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "openhd_fragment_pool.h"
+
+#include <sstream>
+
+static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+static uint64_t make_head(uint64_t tag, uint32_t slot) {
+  return (tag << 32) | slot;
+}
+
+openhd::FragmentPool::FragmentPool(uint32_t n_slots)
+    : m_n_slots(n_slots),
+      m_memory(std::make_unique<uint8_t[]>((size_t)n_slots * SLOT_SIZE)),
+      m_ref_counts(std::make_unique<std::atomic<uint32_t>[]>(n_slots)),
+      m_next_free(std::make_unique<std::atomic<uint32_t>[]>(n_slots)) {
+  for (uint32_t i = 0; i < m_n_slots; i++) {
+    m_ref_counts[i].store(0);
+    m_next_free[i].store(i + 1 < m_n_slots ? i + 1 : NO_SLOT);
+  }
+  m_free_head = make_head(0, m_n_slots > 0 ? 0 : NO_SLOT);
+}
+
+openhd::FragmentPool& openhd::FragmentPool::instance() {
+  static FragmentPool instance{DEFAULT_N_SLOTS};
+  return instance;
+}
+
+int32_t openhd::FragmentPool::try_acquire() {
+  uint64_t head = m_free_head.load(std::memory_order_acquire);
+  while (true) {
+    const uint32_t slot = head & 0xFFFFFFFF;
+    if (slot == NO_SLOT) {
+      m_count_miss.fetch_add(1, std::memory_order_relaxed);
+      return -1;
+    }
+    const uint32_t next = m_next_free[slot].load(std::memory_order_relaxed);
+    const uint64_t new_head = make_head((head >> 32) + 1, next);
+    if (m_free_head.compare_exchange_weak(head, new_head,
+                                          std::memory_order_acq_rel,
+                                          std::memory_order_acquire)) {
+      m_ref_counts[slot].store(1, std::memory_order_relaxed);
+      m_count_hit.fetch_add(1, std::memory_order_relaxed);
+      const uint32_t n_in_use =
+          m_n_in_use.fetch_add(1, std::memory_order_relaxed) + 1;
+      uint32_t high_water = m_high_water.load(std::memory_order_relaxed);
+      while (n_in_use > high_water &&
+             !m_high_water.compare_exchange_weak(high_water, n_in_use,
+                                                 std::memory_order_relaxed)) {
+      }
+      return (int32_t)slot;
+    }
+  }
+}
+
+void openhd::FragmentPool::release(uint32_t slot) {
+  m_n_in_use.fetch_sub(1, std::memory_order_relaxed);
+  uint64_t head = m_free_head.load(std::memory_order_relaxed);
+  while (true) {
+    m_next_free[slot].store(head & 0xFFFFFFFF, std::memory_order_relaxed);
+    const uint64_t new_head = make_head((head >> 32) + 1, slot);
+    if (m_free_head.compare_exchange_weak(head, new_head,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed)) {
+      return;
+    }
+  }
+}
+
+openhd::FragmentPool::Stats openhd::FragmentPool::get_stats() const {
+  return Stats{m_count_hit.load(), m_count_miss.load(), m_n_slots,
+               m_n_in_use.load(), m_high_water.load()};
+}
+
+std::string openhd::FragmentPool::stats_to_string(const Stats& stats) {
+  std::stringstream ss;
+  ss << "FragmentPool[hit:" << stats.count_hit << " miss:" << stats.count_miss
+     << " in use:" << stats.n_in_use << "/" << stats.n_slots
+     << " high water:" << stats.high_water << "]";
+  return ss.str();
+}
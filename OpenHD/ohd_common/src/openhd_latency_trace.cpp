@@ -0,0 +1,215 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "openhd_latency_trace.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "openhd_config.h"
+#include "openhd_spdlog.h"
+#include "openhd_util_time.h"
+
+namespace openhd::latency_trace {
+
+std::string stage_to_string(Stage stage) {
+  switch (stage) {
+    case Stage::AIR_FRAME_COMPLETE:
+      return "AIR_FRAME_COMPLETE";
+    case Stage::AIR_LINK_ENQUEUE:
+      return "AIR_LINK_ENQUEUE";
+    case Stage::GND_LINK_RX:
+      return "GND_LINK_RX";
+    case Stage::GND_UDP_FORWARD:
+      return "GND_UDP_FORWARD";
+  }
+  return "UNKNOWN";
+}
+
+int LatencyHistogram::bucket_index(uint32_t value_us) {
+  static constexpr uint32_t MAX_VALUE_US = (1 << 24) - 1;
+  if (value_us > MAX_VALUE_US) value_us = MAX_VALUE_US;
+  if (value_us < SUB_BUCKETS) return (int)value_us;
+  const int exponent = 31 - __builtin_clz(value_us);
+  const int shift = exponent - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS +
+         (int)((value_us >> shift) & (SUB_BUCKETS - 1));
+}
+
+uint32_t LatencyHistogram::bucket_upper_bound_us(int index) {
+  if (index < SUB_BUCKETS) return index;
+  const int shift = index / SUB_BUCKETS - 1;
+  const uint32_t lower = (uint32_t)(SUB_BUCKETS + index % SUB_BUCKETS)
+                         << shift;
+  return lower + (1u << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  // Negative values can only come from a bad clock offset
+  const uint32_t value_us =
+      us < 0 ? 0 : (us > UINT32_MAX ? UINT32_MAX : (uint32_t)us);
+  m_buckets[bucket_index(value_us)].fetch_add(1, std::memory_order_relaxed);
+  uint32_t curr_max = m_max_us.load(std::memory_order_relaxed);
+  while (value_us > curr_max &&
+         !m_max_us.compare_exchange_weak(curr_max, value_us,
+                                         std::memory_order_relaxed)) {
+  }
+}
+
+LatencyHistogram::Summary LatencyHistogram::get_and_reset() {
+  std::array<uint32_t, N_BUCKETS> counts{};
+  Summary ret{};
+  for (int i = 0; i < N_BUCKETS; i++) {
+    counts[i] = m_buckets[i].exchange(0, std::memory_order_relaxed);
+    ret.count += counts[i];
+  }
+  ret.max_us = m_max_us.exchange(0, std::memory_order_relaxed);
+  if (ret.count == 0) return ret;
+  const uint64_t rank_p50 = ((uint64_t)ret.count * 50 + 99) / 100;
+  const uint64_t rank_p99 = ((uint64_t)ret.count * 99 + 99) / 100;
+  uint64_t cumulative = 0;
+  bool has_p50 = false;
+  for (int i = 0; i < N_BUCKETS; i++) {
+    cumulative += counts[i];
+    if (!has_p50 && cumulative >= rank_p50) {
+      ret.p50_us = std::min(bucket_upper_bound_us(i), ret.max_us);
+      has_p50 = true;
+    }
+    if (cumulative >= rank_p99) {
+      ret.p99_us = std::min(bucket_upper_bound_us(i), ret.max_us);
+      break;
+    }
+  }
+  return ret;
+}
+
+// Layout (little endian): 'O','H','D','T', frame_id (4 bytes), air creation
+// time (8 bytes)
+std::shared_ptr<std::vector<uint8_t>> create_trace_packet(
+    const TraceRecord& record) {
+  auto ret = std::make_shared<std::vector<uint8_t>>(TRACE_PACKET_SIZE);
+  uint8_t* data = ret->data();
+  data[0] = 'O';
+  data[1] = 'H';
+  data[2] = 'D';
+  data[3] = 'T';
+  std::memcpy(data + 4, &record.frame_id, sizeof(record.frame_id));
+  std::memcpy(data + 8, &record.air_creation_time_us,
+              sizeof(record.air_creation_time_us));
+  return ret;
+}
+
+TraceRecord parse_trace_packet(const uint8_t* data) {
+  TraceRecord ret{};
+  std::memcpy(&ret.frame_id, data + 4, sizeof(ret.frame_id));
+  std::memcpy(&ret.air_creation_time_us, data + 8,
+              sizeof(ret.air_creation_time_us));
+  return ret;
+}
+
+static int64_t to_us(std::chrono::steady_clock::time_point time_point) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             time_point.time_since_epoch())
+      .count();
+}
+
+LatencyTracer::LatencyTracer()
+    : m_enabled(openhd::load_config().GEN_VIDEO_LATENCY_TRACE) {}
+
+LatencyTracer& LatencyTracer::instance() {
+  static LatencyTracer instance{};
+  return instance;
+}
+
+void LatencyTracer::record(int stream_index, Stage stage,
+                           std::chrono::steady_clock::time_point creation_time,
+                           std::chrono::steady_clock::time_point now) {
+  if (stream_index < 0 || stream_index >= N_STREAMS) return;
+  m_histograms[stream_index][(int)stage].record(now - creation_time);
+}
+
+std::shared_ptr<std::vector<uint8_t>> LatencyTracer::create_air_trace_packet(
+    int stream_index, std::chrono::steady_clock::time_point creation_time) {
+  TraceRecord record{};
+  if (stream_index >= 0 && stream_index < N_STREAMS) {
+    record.frame_id = m_next_frame_id[stream_index].fetch_add(1);
+  }
+  record.air_creation_time_us = to_us(creation_time);
+  return create_trace_packet(record);
+}
+
+void LatencyTracer::on_ground_trace_packet(
+    int stream_index, const uint8_t* data,
+    std::chrono::steady_clock::time_point rx_time,
+    std::chrono::steady_clock::time_point forward_time) {
+  if (!openhd::util::has_air_unit_time_offset()) return;
+  const auto trace = parse_trace_packet(data);
+  const int64_t creation_time_us = trace.air_creation_time_us +
+                                   openhd::util::get_air_unit_time_offset_us();
+  const auto creation_time = std::chrono::steady_clock::time_point(
+      std::chrono::microseconds(creation_time_us));
+  record(stream_index, Stage::GND_LINK_RX, creation_time, rx_time);
+  record(stream_index, Stage::GND_UDP_FORWARD, creation_time, forward_time);
+}
+
+bool LatencyTracer::update() {
+  const auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> guard(m_summary_mutex);
+  if (now - m_last_summary < SUMMARY_INTERVAL) return false;
+  m_last_summary = now;
+  for (int stream = 0; stream < N_STREAMS; stream++) {
+    for (int stage = 0; stage < N_STAGES; stage++) {
+      m_summaries[stream][stage] = m_histograms[stream][stage].get_and_reset();
+    }
+  }
+  write_summaries(to_us(now) / 1000);
+  return true;
+}
+
+LatencyHistogram::Summary LatencyTracer::get_summary(int stream_index,
+                                                     Stage stage) {
+  if (stream_index < 0 || stream_index >= N_STREAMS) return {};
+  std::lock_guard<std::mutex> guard(m_summary_mutex);
+  return m_summaries[stream_index][(int)stage];
+}
+
+void LatencyTracer::write_summaries(int64_t timestamp_ms) {
+  if (m_trace_file == nullptr) {
+    m_trace_file = std::make_unique<openhd::TraceFile>(
+        TRACE_FILENAME, "time_ms,stream,stage,count,p50_us,p99_us,max_us");
+  }
+  for (int stream = 0; stream < N_STREAMS; stream++) {
+    for (int stage = 0; stage < N_STAGES; stage++) {
+      const auto& summary = m_summaries[stream][stage];
+      if (summary.count == 0) continue;
+      m_trace_file->write_line(fmt::format(
+          "{},{},{},{},{},{},{}", timestamp_ms, stream,
+          stage_to_string((Stage)stage), summary.count, summary.p50_us,
+          summary.p99_us, summary.max_us));
+    }
+  }
+}
+
+}  // namespace openhd::latency_trace
@@ -96,6 +96,15 @@ void openhd::log::MavlinkLogMessageBuffer::enqueue_log_message(
     return;
   }
   m_buffer.push_back(message);
+  if (m_on_new_message_cb) {
+    m_on_new_message_cb();
+  }
+}
+
+void openhd::log::MavlinkLogMessageBuffer::register_on_new_message_cb(
+    std::function<void()> cb) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_on_new_message_cb = std::move(cb);
 }
 
 openhd::log::MavlinkLogMessageBuffer&
@@ -24,10 +24,14 @@
 #include "openhd_tcp.h"
 
 #include <arpa/inet.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
-#include <csignal>
-#include <queue>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
 #include <utility>
 
 openhd::TCPServer::TCPServer(const std::string tag,
@@ -35,121 +39,310 @@ openhd::TCPServer::TCPServer(const std::string tag,
     : m_config(config), m_debug(debug) {
   m_console = openhd::log::create_or_get(tag);
   assert(m_console);
-  m_accept_thread =
-      std::make_unique<std::thread>(&TCPServer::loop_accept, this);
+  m_rx_buff = std::make_unique<std::array<uint8_t, READ_BUFF_SIZE>>();
+  m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (m_epoll_fd < 0 || m_wakeup_fd < 0) {
+    m_console->warn("epoll / eventfd create failed {}", strerror(errno));
+  } else {
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = m_wakeup_fd;
+    epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &ev);
+  }
+  m_loop_thread = std::make_unique<std::thread>(&TCPServer::loop_epoll, this);
   m_console->debug("created with {}", m_config.port);
 }
 
 openhd::TCPServer::~TCPServer() {
-  // debug_if("TCPEndpoint::~TCPEndpoint() begin");
-  //  First we make sure we don't accept any new connections anymore
-  m_keep_accept_thread_alive = false;
-  shutdown(server_fd, SHUT_RDWR);  // This will break out of select
-  m_accept_thread->join();
-  m_accept_thread = nullptr;
-  server_fd = 0;
-  // Then we make sure to clean up any connected client(s) (If there are any)
-  for (const auto& client : m_clients_list) {
-    client->marked_to_be_removed = true;
-    client->keep_rx_looping = false;
-    shutdown(client->sock_fd, SHUT_RDWR);
-    client->rx_loop_thread->join();
-    client->rx_loop_thread = nullptr;
-  }
-  m_console->debug("TCPEndpoint::~TCPEndpoint() end");
+  m_keep_looping = false;
+  wake_up_loop();
+  m_loop_thread->join();
+  m_loop_thread = nullptr;
+  // The server thread is gone, no need to hold the lock for closing
+  for (const auto& [fd, client] : m_clients) {
+    shutdown(fd, SHUT_RDWR);
+    close(fd);
+  }
+  m_clients.clear();
+  if (m_server_fd >= 0) close(m_server_fd);
+  if (m_wakeup_fd >= 0) close(m_wakeup_fd);
+  if (m_epoll_fd >= 0) close(m_epoll_fd);
+  m_console->debug("TCPServer::~TCPServer() end");
 }
 
-void openhd::TCPServer::loop_accept() {
-  struct sockaddr_in sockaddr {};
-  if ((server_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0) {
+bool openhd::TCPServer::setup_server_socket() {
+  if (m_epoll_fd < 0 || m_wakeup_fd < 0) return false;
+  m_server_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (m_server_fd < 0) {
     m_console->warn("open socket failed");
-    return;
+    return false;
   }
   int opt = 1;
-  if (setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt,
+  if (setsockopt(m_server_fd, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt,
                  sizeof(opt))) {
     m_console->warn("setsockopt failed");
-    close(server_fd);
-    return;
+    return false;
   }
+  struct sockaddr_in sockaddr {};
   sockaddr.sin_family = AF_INET;
   sockaddr.sin_addr.s_addr = INADDR_ANY;
   sockaddr.sin_port = htons(m_config.port);
-  if (bind(server_fd, (struct sockaddr*)&sockaddr, sizeof(sockaddr)) < 0) {
+  if (bind(m_server_fd, (struct sockaddr*)&sockaddr, sizeof(sockaddr)) < 0) {
     m_console->warn("bind failed");
-    close(server_fd);
-    return;
+    return false;
   }
   // signal readiness to accept clients
-  if (listen(server_fd, 5) < 0) {
+  if (listen(m_server_fd, 5) < 0) {
     m_console->warn("listen failed");
-    close(server_fd);
+    return false;
+  }
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.fd = m_server_fd;
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_server_fd, &ev) < 0) {
+    m_console->warn("epoll add server fd failed");
+    return false;
+  }
+  return true;
+}
+
+void openhd::TCPServer::loop_epoll() {
+  if (!setup_server_socket()) {
     return;
   }
-  const int sockaddr_len = sizeof(sockaddr);
-  while (m_keep_accept_thread_alive) {
-    const auto accept_result = accept(server_fd, (struct sockaddr*)&sockaddr,
-                                      (socklen_t*)&sockaddr_len);
-    if (accept_result < 0) {
-      m_console->debug("accept failed");
-      close(server_fd);
+  std::array<epoll_event, MAX_EPOLL_EVENTS> events{};
+  while (m_keep_looping) {
+    const int n_events =
+        epoll_wait(m_epoll_fd, events.data(), events.size(), LOOP_TIMEOUT_MS);
+    if (n_events < 0) {
+      if (errno == EINTR) continue;
+      m_console->warn("epoll_wait failed {}", strerror(errno));
+      break;
+    }
+    for (int i = 0; i < n_events; i++) {
+      const int fd = events[i].data.fd;
+      const uint32_t flags = events[i].events;
+      if (fd == m_wakeup_fd) {
+        eventfd_t unused;
+        eventfd_read(m_wakeup_fd, &unused);
+      } else if (fd == m_server_fd) {
+        accept_new_clients();
+      } else {
+        if (flags & EPOLLIN) on_client_readable(fd);
+        if (flags & EPOLLOUT) on_client_writable(fd);
+        if (flags & (EPOLLERR | EPOLLHUP)) mark_client_for_removal(fd);
+      }
+    }
+    reap_clients();
+  }
+}
+
+void openhd::TCPServer::accept_new_clients() {
+  while (true) {
+    struct sockaddr_in sockaddr {};
+    socklen_t sockaddr_len = sizeof(sockaddr);
+    const int fd = accept4(m_server_fd, (struct sockaddr*)&sockaddr,
+                           &sockaddr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_console->debug("accept failed {}", strerror(errno));
+      }
       return;
     }
-    const std::string client_ip = inet_ntoa(sockaddr.sin_addr);
-    const int client_port = ntohs(sockaddr.sin_port);
-    m_console->debug("accepted client,sockfd:{}, ip:{}, port:{}", accept_result,
-                     client_ip, client_port);
+    int opt = 1;
+    // telemetry is latency sensitive and already aggregated by the sender
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+    // Detect half-open connections (e.g. cable unplugged) even if the client
+    // never sends anything
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &opt, sizeof(opt));
+    int keepalive_idle_s = 5, keepalive_interval_s = 1, keepalive_count = 3;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &keepalive_idle_s,
+               sizeof(keepalive_idle_s));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &keepalive_interval_s,
+               sizeof(keepalive_interval_s));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &keepalive_count,
+               sizeof(keepalive_count));
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+      m_console->warn("epoll add client failed {}", strerror(errno));
+      close(fd);
+      continue;
+    }
     auto new_client = std::make_shared<ConnectedClient>();
-    new_client->sock_fd = accept_result;
-    new_client->ip = client_ip;
-    new_client->port = client_port;
-    new_client->keep_rx_looping = true;
-    new_client->parent = this;
-    new_client->rx_loop_thread = std::make_shared<std::thread>(
-        &TCPServer::ConnectedClient::loop_rx, new_client.get());
-    on_external_device(client_ip, client_port, true);
+    new_client->sock_fd = fd;
+    new_client->ip = inet_ntoa(sockaddr.sin_addr);
+    new_client->port = ntohs(sockaddr.sin_port);
+    new_client->tx_buff.resize(m_config.max_tx_queue_bytes_per_client);
+    m_console->debug("accepted client,sockfd:{}, ip:{}, port:{}", fd,
+                     new_client->ip, new_client->port);
     {
-      std::lock_guard<std::mutex> guard(m_clients_list_mutex);
-      m_clients_list.push_back(new_client);
+      std::lock_guard<std::mutex> guard(m_clients_mutex);
+      m_clients[fd] = new_client;
     }
+    on_external_device(new_client->ip, new_client->port, true);
   }
 }
 
+void openhd::TCPServer::on_client_readable(int fd) {
+  // Only the server thread closes client fds, no need to hold the lock here
+  const ssize_t message_length = read(fd, m_rx_buff->data(), m_rx_buff->size());
+  if (message_length > 0) {
+    on_packet_any_tcp_client(m_rx_buff->data(), (int)message_length);
+    return;
+  }
+  if (message_length < 0 &&
+      (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return;
+  }
+  if (message_length == 0) {
+    m_console->debug("Client {} disconnected", fd);
+  } else {
+    m_console->debug("Client {} read error {}", fd, strerror(errno));
+  }
+  mark_client_for_removal(fd);
+}
+
+void openhd::TCPServer::on_client_writable(int fd) {
+  std::lock_guard<std::mutex> guard(m_clients_mutex);
+  auto it = m_clients.find(fd);
+  if (it == m_clients.end() || it->second->marked_to_be_removed) return;
+  auto& client = *it->second;
+  flush_tx(client);
+  if (!client.marked_to_be_removed) {
+    set_epollout(client, client.tx_size > 0);
+  }
+}
+
+void openhd::TCPServer::mark_client_for_removal(int fd) {
+  std::lock_guard<std::mutex> guard(m_clients_mutex);
+  auto it = m_clients.find(fd);
+  if (it != m_clients.end()) {
+    it->second->marked_to_be_removed = true;
+  }
+}
+
+void openhd::TCPServer::reap_clients() {
+  std::vector<std::shared_ptr<ConnectedClient>> removed;
+  const auto now = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> guard(m_clients_mutex);
+    for (auto it = m_clients.begin(); it != m_clients.end();) {
+      auto& client = it->second;
+      if (!client->marked_to_be_removed && client->tx_size > 0 &&
+          now - client->last_tx_progress > m_config.client_stall_timeout) {
+        m_console->warn("Client {}:{} stalled, disconnecting", client->ip,
+                        client->port);
+        client->marked_to_be_removed = true;
+      }
+      if (client->marked_to_be_removed) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, client->sock_fd, nullptr);
+        close(client->sock_fd);
+        removed.push_back(client);
+        it = m_clients.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (const auto& client : removed) {
+    on_external_device(client->ip, client->port, false);
+  }
+}
+
+void openhd::TCPServer::wake_up_loop() {
+  if (m_wakeup_fd >= 0) eventfd_write(m_wakeup_fd, 1);
+}
+
 void openhd::TCPServer::send_message_to_all_clients(const uint8_t* data,
                                                     int data_len) {
-  std::lock_guard<std::mutex> guard(m_clients_list_mutex);
-  for (auto& client : m_clients_list) {
+  std::lock_guard<std::mutex> guard(m_clients_mutex);
+  for (auto& [fd, client] : m_clients) {
     if (!client->marked_to_be_removed) {
-      const int flags =
-          MSG_DONTWAIT |  // otherwise we might block if the socket got
-                          // disconnected
-          MSG_NOSIGNAL;   // otherwise we might crash if the socket disconnects
-      if (!send(client->sock_fd, data, data_len, flags)) {
-        m_console->debug("Client {} disconnected (cannot send data)",
-                         client->ip);
-        // Will be disconnected / removed by the accept thread
-        client->marked_to_be_removed = true;
-      }
+      send_to_client(*client, data, data_len);
     }
   }
 }
 
-void openhd::TCPServer::ConnectedClient::loop_rx() {
-  auto console = openhd::log::create_or_get(fmt::format("TCPClient{}", ip));
-  const auto buff = std::make_unique<std::array<uint8_t, READ_BUFF_SIZE>>();
-  while (keep_rx_looping) {
-    const ssize_t message_length = read(sock_fd, buff->data(), buff->size());
-    if (message_length < 0) {
-      console->debug("Read error {} {}", message_length, strerror(errno));
-      marked_to_be_removed = true;
-      break;
+void openhd::TCPServer::send_to_client(ConnectedClient& client,
+                                       const uint8_t* data, int data_len) {
+  const size_t capacity = client.tx_buff.size();
+  const auto len = (size_t)data_len;
+  size_t offset = 0;
+  if (client.tx_size == 0 && len <= capacity) {
+    // Nothing queued - hand the message directly to the socket
+    const int flags =
+        MSG_DONTWAIT |  // never block the sender
+        MSG_NOSIGNAL;   // otherwise we might crash if the socket disconnects
+    const ssize_t sent = send(client.sock_fd, data, len, flags);
+    if (sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      m_console->debug("Client {} disconnected (cannot send data)", client.ip);
+      client.marked_to_be_removed = true;
+      wake_up_loop();
+      return;
     }
-    if (message_length == 0) {
-      console->debug("Client disconnected");
-      marked_to_be_removed = true;
-      break;
+    offset = sent > 0 ? (size_t)sent : 0;
+    if (offset == len) return;
+    client.last_tx_progress = std::chrono::steady_clock::now();
+  }
+  const size_t remaining = len - offset;
+  if (remaining > capacity - client.tx_size) {
+    // Drop the whole message (a partially written message would corrupt the
+    // stream for this client). Can only happen if offset==0.
+    client.n_dropped_messages++;
+    if (client.n_dropped_messages % 1000 == 1) {
+      m_console->warn("Client {}:{} too slow, dropped {} messages", client.ip,
+                      client.port, client.n_dropped_messages);
     }
-    parent->on_packet_any_tcp_client(buff->data(), message_length);
+    return;
+  }
+  const size_t tail = (client.tx_head + client.tx_size) % capacity;
+  const size_t first = std::min(remaining, capacity - tail);
+  std::memcpy(client.tx_buff.data() + tail, data + offset, first);
+  std::memcpy(client.tx_buff.data(), data + offset + first, remaining - first);
+  client.tx_size += remaining;
+  set_epollout(client, true);
+}
+
+void openhd::TCPServer::flush_tx(ConnectedClient& client) {
+  const size_t capacity = client.tx_buff.size();
+  while (client.tx_size > 0) {
+    const size_t first = std::min(client.tx_size, capacity - client.tx_head);
+    struct iovec iov[2];
+    iov[0].iov_base = client.tx_buff.data() + client.tx_head;
+    iov[0].iov_len = first;
+    iov[1].iov_base = client.tx_buff.data();
+    iov[1].iov_len = client.tx_size - first;
+    struct msghdr msg {};
+    msg.msg_iov = iov;
+    msg.msg_iovlen = iov[1].iov_len > 0 ? 2 : 1;
+    const ssize_t sent =
+        sendmsg(client.sock_fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (sent < 0) {
+      if (errno == EINTR) continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        m_console->debug("Client {} disconnected (cannot send data)",
+                         client.ip);
+        client.marked_to_be_removed = true;
+      }
+      return;
+    }
+    client.tx_head = (client.tx_head + sent) % capacity;
+    client.tx_size -= sent;
+    client.last_tx_progress = std::chrono::steady_clock::now();
+  }
+  client.tx_head = 0;
+}
+
+void openhd::TCPServer::set_epollout(ConnectedClient& client, bool enable) {
+  if (client.epollout_armed == enable) return;
+  epoll_event ev{};
+  ev.events = (uint32_t)EPOLLIN | (enable ? (uint32_t)EPOLLOUT : (uint32_t)0);
+  ev.data.fd = client.sock_fd;
+  if (epoll_ctl(m_epoll_fd, EPOLL_CTL_MOD, client.sock_fd, &ev) == 0) {
+    client.epollout_armed = enable;
   }
-  parent->on_external_device(ip, port, false);
 }
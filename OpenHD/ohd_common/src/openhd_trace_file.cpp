@@ -0,0 +1,63 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "openhd_trace_file.h"
+
+#include <cstdio>
+#include <utility>
+
+#include "openhd_spdlog.h"
+
+namespace openhd {
+
+TraceFile::TraceFile(std::string filename, std::string header,
+                     size_t max_size_bytes)
+    : m_filename(std::move(filename)),
+      m_header(std::move(header)),
+      m_max_size_bytes(max_size_bytes) {
+  open();
+}
+
+void TraceFile::open() {
+  m_file.open(m_filename, std::ios::out | std::ios::trunc);
+  if (!m_file.good()) {
+    openhd::log::get_default()->warn("Cannot open {}", m_filename);
+  }
+  m_file << m_header << "\n";
+  m_curr_size_bytes = m_header.size() + 1;
+}
+
+void TraceFile::write_line(const std::string& line) {
+  if (m_curr_size_bytes + line.size() + 1 > m_max_size_bytes) {
+    m_file.close();
+    const auto rotated = m_filename + ".1";
+    if (std::rename(m_filename.c_str(), rotated.c_str()) != 0) {
+      openhd::log::get_default()->warn("Cannot rotate {}", m_filename);
+    }
+    open();
+  }
+  m_file << line << "\n";
+  m_curr_size_bytes += line.size() + 1;
+}
+
+}  // namespace openhd
@@ -24,6 +24,7 @@
 #include "openhd_udp.h"
 
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <unistd.h>
 
 #include <algorithm>
@@ -63,53 +64,263 @@ void openhd::UDPForwarder::forwardPacketViaUDP(
   // openhd::log::get_default()->debug("Forward {}",packetSize);
   const auto ret = sendto(sockfd, packet, packetSize, 0,
                           (const struct sockaddr *)&saddr, sizeof(saddr));
-  if (ret < 0 || ret != packetSize) {
+  if (ret < 0 || (std::size_t)ret != packetSize) {
     get_console()->warn("Error sending packet of size:{} to {}:{} code:{} {}",
                         packetSize, client_addr, client_udp_port, ret,
                         strerror(errno));
   }
 }
 
+static std::size_t get_total_size(const struct iovec *parts, int n_parts) {
+  std::size_t ret = 0;
+  for (int i = 0; i < n_parts; i++) ret += parts[i].iov_len;
+  return ret;
+}
+
+void openhd::UDPForwarder::forwardPacketViaUDP(const struct iovec *parts,
+                                               int n_parts) const {
+  struct msghdr hdr {};
+  hdr.msg_name = (void *)&saddr;
+  hdr.msg_namelen = sizeof(saddr);
+  hdr.msg_iov = (struct iovec *)parts;
+  hdr.msg_iovlen = n_parts;
+  const auto packetSize = get_total_size(parts, n_parts);
+  const auto ret = sendmsg(sockfd, &hdr, 0);
+  if (ret < 0 || (std::size_t)ret != packetSize) {
+    get_console()->warn("Error sending packet of size:{} to {}:{} code:{} {}",
+                        packetSize, client_addr, client_udp_port, ret,
+                        strerror(errno));
+  }
+}
+
+openhd::UDPMultiForwarder::UDPMultiForwarder() {
+  m_sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (m_sockfd < 0) {
+    get_console()->warn("UDPMultiForwarder: Error opening socket: {}",
+                        strerror(errno));
+  }
+}
+
+openhd::UDPMultiForwarder::~UDPMultiForwarder() {
+  if (m_batch_flush_thread) {
+    {
+      std::lock_guard<std::mutex> lock(m_batch_mutex);
+      m_batch_flush_thread_run = false;
+    }
+    m_batch_cv.notify_one();
+    m_batch_flush_thread->join();
+    m_batch_flush_thread = nullptr;
+  }
+  if (m_sockfd >= 0) {
+    close(m_sockfd);
+  }
+}
+
 void openhd::UDPMultiForwarder::addForwarder(const std::string &client_addr,
                                              int client_udp_port) {
-  std::lock_guard<std::mutex> guard(udpForwardersLock);
-  // check if we already forward data to this IP::Port tuple
-  for (const auto &udpForwarder : udpForwarders) {
-    if (udpForwarder->client_addr == client_addr &&
-        udpForwarder->client_udp_port == client_udp_port) {
-      get_console()->info("UDPMultiForwarder: already forwarding to: {}:{}",
-                          client_addr, client_udp_port);
-      return;
+  m_destinations.update([&](std::vector<Destination> &destinations) {
+    // check if we already forward data to this IP::Port tuple
+    for (const auto &destination : destinations) {
+      if (destination.client_addr == client_addr &&
+          destination.client_udp_port == client_udp_port) {
+        get_console()->info("UDPMultiForwarder: already forwarding to: {}:{}",
+                            client_addr, client_udp_port);
+        return;
+      }
     }
-  }
-  get_console()->info("UDPMultiForwarder: add forwarding to: {}:{}",
-                      client_addr, client_udp_port);
-  udpForwarders.emplace_back(
-      std::make_unique<openhd::UDPForwarder>(client_addr, client_udp_port));
+    get_console()->info("UDPMultiForwarder: add forwarding to: {}:{}",
+                        client_addr, client_udp_port);
+    destinations.push_back(
+        Destination{client_addr, client_udp_port,
+                    create_udp_destination(client_addr, client_udp_port)});
+  });
 }
 
 void openhd::UDPMultiForwarder::removeForwarder(const std::string &client_addr,
                                                 int client_udp_port) {
-  std::lock_guard<std::mutex> guard(udpForwardersLock);
-  udpForwarders.erase(
-      std::find_if(udpForwarders.begin(), udpForwarders.end(),
-                   [&client_addr, &client_udp_port](const auto &udpForwarder) {
-                     return udpForwarder->client_addr == client_addr &&
-                            udpForwarder->client_udp_port == client_udp_port;
-                   }));
+  m_destinations.update([&](std::vector<Destination> &destinations) {
+    destinations.erase(
+        std::remove_if(destinations.begin(), destinations.end(),
+                       [&](const Destination &destination) {
+                         return destination.client_addr == client_addr &&
+                                destination.client_udp_port == client_udp_port;
+                       }),
+        destinations.end());
+  });
 }
 
 void openhd::UDPMultiForwarder::forwardPacketViaUDP(
     const uint8_t *packet, const std::size_t packetSize) {
-  std::lock_guard<std::mutex> guard(udpForwardersLock);
-  for (const auto &udpForwarder : udpForwarders) {
-    udpForwarder->forwardPacketViaUDP(packet, packetSize);
+  const struct iovec part {
+    (void *)packet, packetSize
+  };
+  forwardPacketViaUDP(&part, 1);
+}
+
+void openhd::UDPMultiForwarder::forwardPacketViaUDP(const struct iovec *parts,
+                                                    int n_parts) {
+  const auto packetSize = get_total_size(parts, n_parts);
+  if (m_batching_enabled && packetSize <= MAX_BATCHED_PACKET_SIZE) {
+    enqueueBatched(parts, n_parts, packetSize);
+    return;
+  }
+  // Too big for the batch - send out what is queued first, such that this
+  // packet doesn't overtake them (and keep the lock, such that the deadline
+  // thread doesn't either)
+  std::unique_lock<std::mutex> lock(m_batch_mutex, std::defer_lock);
+  if (m_batching_enabled) {
+    lock.lock();
+    flushBatchLocked();
+  }
+  struct msghdr hdr {};
+  hdr.msg_namelen = sizeof(struct sockaddr_in);
+  hdr.msg_iov = (struct iovec *)parts;
+  hdr.msg_iovlen = n_parts;
+  const auto destinations = m_destinations.get();
+  for (const auto &destination : *destinations) {
+    hdr.msg_name = (void *)&destination.saddr;
+    const auto ret = sendmsg(m_sockfd, &hdr, 0);
+    if (ret < 0 || (std::size_t)ret != packetSize) {
+      get_console()->warn("Error sending packet of size:{} to {}:{} code:{} {}",
+                          packetSize, destination.client_addr,
+                          destination.client_udp_port, ret, strerror(errno));
+    }
   }
 }
 
-const std::list<std::unique_ptr<openhd::UDPForwarder>>
-    &openhd::UDPMultiForwarder::getForwarders() const {
-  return udpForwarders;
+std::vector<openhd::UDPMultiForwarder::Destination>
+openhd::UDPMultiForwarder::getDestinations() const {
+  return *m_destinations.get();
+}
+
+void openhd::UDPMultiForwarder::enableBatching(
+    std::chrono::microseconds max_delay) {
+  if (m_batching_enabled) return;
+  m_batch_max_delay = max_delay;
+  m_batch_data.resize(MAX_BATCH_N_PACKETS * MAX_BATCHED_PACKET_SIZE);
+  m_batch_sizes.reserve(MAX_BATCH_N_PACKETS);
+  m_batch_iovecs.resize(MAX_BATCH_N_PACKETS);
+  for (int i = 0; i < MAX_BATCH_N_PACKETS; i++) {
+    m_batch_iovecs[i].iov_base =
+        m_batch_data.data() + i * MAX_BATCHED_PACKET_SIZE;
+  }
+  m_batch_flush_thread_run = true;
+  m_batch_flush_thread = std::make_unique<std::thread>(
+      &UDPMultiForwarder::loopFlushDeadline, this);
+  m_batching_enabled = true;
+  get_console()->info("UDPMultiForwarder: batching enabled, max delay {}us",
+                      max_delay.count());
+}
+
+void openhd::UDPMultiForwarder::flushBatch() {
+  if (!m_batching_enabled) return;
+  std::lock_guard<std::mutex> lock(m_batch_mutex);
+  flushBatchLocked();
+}
+
+openhd::UDPMultiForwarder::BatchStats
+openhd::UDPMultiForwarder::getBatchStats() {
+  std::lock_guard<std::mutex> lock(m_batch_mutex);
+  return m_batch_stats;
+}
+
+void openhd::UDPMultiForwarder::enqueueBatched(const struct iovec *parts,
+                                               int n_parts,
+                                               std::size_t packetSize) {
+  std::unique_lock<std::mutex> lock(m_batch_mutex);
+  if (m_batch_sizes.empty()) {
+    m_batch_oldest_packet = std::chrono::steady_clock::now();
+    // Wake up the deadline thread, such that it starts waiting for this batch
+    m_batch_cv.notify_one();
+  }
+  // Gathered into the batch slot
+  uint8_t *slot =
+      m_batch_data.data() + m_batch_sizes.size() * MAX_BATCHED_PACKET_SIZE;
+  for (int i = 0; i < n_parts; i++) {
+    std::memcpy(slot, parts[i].iov_base, parts[i].iov_len);
+    slot += parts[i].iov_len;
+  }
+  m_batch_sizes.push_back(packetSize);
+  m_batch_stats.n_packets++;
+  if (m_batch_sizes.size() >= MAX_BATCH_N_PACKETS) {
+    flushBatchLocked();
+  }
+}
+
+void openhd::UDPMultiForwarder::flushBatchLocked() {
+  if (m_batch_sizes.empty()) return;
+  const auto delay = std::chrono::steady_clock::now() - m_batch_oldest_packet;
+  m_batch_stats.n_flushes++;
+  m_batch_stats.delay_sum += delay;
+  m_batch_stats.delay_max = std::max(
+      m_batch_stats.delay_max,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(delay));
+  // Every packet to every destination, one message each
+  const auto destinations_snapshot = m_destinations.get();
+  const auto &destinations = *destinations_snapshot;
+  const size_t n_packets = m_batch_sizes.size();
+  const size_t n_messages = n_packets * destinations.size();
+  // Member storage, only grows (if destinations are added)
+  if (m_batch_messages.size() < n_messages) {
+    m_batch_messages.resize(n_messages);
+  }
+  auto *messages = m_batch_messages.data();
+  for (size_t i = 0; i < n_packets; i++) {
+    m_batch_iovecs[i].iov_len = m_batch_sizes[i];
+  }
+  for (size_t d = 0; d < destinations.size(); d++) {
+    for (size_t i = 0; i < n_packets; i++) {
+      auto &hdr = messages[d * n_packets + i].msg_hdr;
+      hdr.msg_name = (void *)&destinations[d].saddr;
+      hdr.msg_namelen = sizeof(struct sockaddr_in);
+      hdr.msg_iov = &m_batch_iovecs[i];
+      hdr.msg_iovlen = 1;
+    }
+  }
+  size_t n_sent = 0;
+  size_t n_failed = 0;
+  int last_errno = 0;
+  const Destination *last_failed_destination = nullptr;
+  while (n_sent < n_messages) {
+    const int ret = sendmmsg(m_sockfd, messages + n_sent,
+                             n_messages - n_sent, 0);
+    m_batch_stats.n_syscalls++;
+    if (ret <= 0) {
+      // The message at n_sent failed (e.g. the route to this destination went
+      // away) - skip only that one, such that the other destinations (e.g.
+      // localhost) still get the whole batch
+      last_errno = errno;
+      last_failed_destination = &destinations[n_sent / n_packets];
+      n_failed++;
+      n_sent++;
+      continue;
+    }
+    n_sent += ret;
+  }
+  if (n_failed > 0) {
+    get_console()->warn("Error sending {}/{} packets, last to {}:{} {}",
+                        n_failed, n_messages,
+                        last_failed_destination->client_addr,
+                        last_failed_destination->client_udp_port,
+                        strerror(last_errno));
+  }
+  m_batch_sizes.clear();
+}
+
+void openhd::UDPMultiForwarder::loopFlushDeadline() {
+  std::unique_lock<std::mutex> lock(m_batch_mutex);
+  while (m_batch_flush_thread_run) {
+    if (m_batch_sizes.empty()) {
+      m_batch_cv.wait(lock);
+      continue;
+    }
+    const auto deadline = m_batch_oldest_packet + m_batch_max_delay;
+    if (std::chrono::steady_clock::now() >= deadline) {
+      flushBatchLocked();
+    } else {
+      m_batch_cv.wait_until(lock, deadline);
+    }
+  }
 }
 
 openhd::UDPReceiver::UDPReceiver(std::string client_addr, int client_udp_port,
@@ -120,9 +331,124 @@ openhd::UDPReceiver::UDPReceiver(std::string client_addr, int client_udp_port,
                       client_udp_port);
 }
 
+openhd::UDPReceiver::UDPReceiver(std::string client_addr, int client_udp_port,
+                                 OUTPUT_BATCH_CALLBACK cb, BatchConfig config)
+    : m_batch_cb(std::move(cb)), m_batch_config(config) {
+  mSocket = openhd::openUdpSocketForReceiving(client_addr, client_udp_port);
+  if (mSocket >= 0 && config.rcvbuf_size > 0) {
+    if (setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, &config.rcvbuf_size,
+                   sizeof(config.rcvbuf_size)) < 0) {
+      get_console()->warn("Cannot set SO_RCVBUF {}", strerror(errno));
+    }
+    // The kernel silently caps the value at net.core.rmem_max
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    getsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, &actual, &len);
+    get_console()->debug("SO_RCVBUF wanted:{} got:{}", config.rcvbuf_size,
+                         actual);
+  }
+  if (mSocket >= 0 && config.kernel_timestamps) {
+    int enable = 1;
+    if (setsockopt(mSocket, SOL_SOCKET, SO_TIMESTAMPNS, &enable,
+                   sizeof(enable)) < 0) {
+      get_console()->warn("Cannot enable SO_TIMESTAMPNS {}", strerror(errno));
+    }
+  }
+  get_console()->info("UDPReceiver (batched {}x{}) created with {}:{}",
+                      config.max_n_packets, config.max_packet_size,
+                      client_addr, client_udp_port);
+}
+
 openhd::UDPReceiver::~UDPReceiver() { stopBackground(); }
 
+void openhd::UDPReceiver::log_receive_error(const ssize_t ret) {
+  // this can also come from the shutdown, in which case it is not an error.
+  if (!receiving) return;
+  if (std::chrono::steady_clock::now() - m_last_receive_error_log >=
+      std::chrono::seconds(3)) {
+    get_console()->warn("Got message length of: {} log_skip_count:{}", ret,
+                        m_last_receive_error_log_skip_count);
+    m_last_receive_error_log = std::chrono::steady_clock::now();
+    m_last_receive_error_log_skip_count = 0;
+  } else {
+    m_last_receive_error_log_skip_count++;
+  }
+}
+
+void openhd::UDPReceiver::loop_recvmmsg() {
+  const auto &config = m_batch_config;
+  const size_t n_max = std::max(config.max_n_packets, 1);
+  // CMSG_SPACE is a multiple of the cmsg alignment, so every slot is aligned
+  static constexpr size_t CMSG_SLOT_SIZE = CMSG_SPACE(sizeof(struct timespec));
+  std::vector<uint8_t> buffers(n_max * config.max_packet_size);
+  std::vector<uint8_t> cmsg_buffers(n_max * CMSG_SLOT_SIZE);
+  std::vector<struct iovec> iovecs(n_max);
+  std::vector<struct mmsghdr> messages(n_max);
+  std::vector<ReceivedPacket> packets(n_max);
+  for (size_t i = 0; i < n_max; i++) {
+    iovecs[i].iov_base = buffers.data() + i * config.max_packet_size;
+    iovecs[i].iov_len = config.max_packet_size;
+  }
+  uint64_t n_truncated = 0;
+  while (receiving) {
+    for (size_t i = 0; i < n_max; i++) {
+      auto &hdr = messages[i].msg_hdr;
+      hdr = {};
+      hdr.msg_iov = &iovecs[i];
+      hdr.msg_iovlen = 1;
+      if (config.kernel_timestamps) {
+        hdr.msg_control = cmsg_buffers.data() + i * CMSG_SLOT_SIZE;
+        hdr.msg_controllen = CMSG_SLOT_SIZE;
+      }
+      messages[i].msg_len = 0;
+    }
+    // Block until at least one packet is there, then take whatever else is
+    // already queued without blocking again
+    const int ret =
+        recvmmsg(mSocket, messages.data(), n_max, MSG_WAITFORONE, nullptr);
+    if (ret <= 0) {
+      log_receive_error(ret);
+      continue;
+    }
+    size_t n_packets = 0;
+    for (int i = 0; i < ret; i++) {
+      auto &hdr = messages[i].msg_hdr;
+      if (hdr.msg_flags & MSG_TRUNC) {
+        if (n_truncated++ % 100 == 0) {
+          get_console()->warn("Dropped packet > {} bytes (total {})",
+                              config.max_packet_size, n_truncated);
+        }
+        continue;
+      }
+      if (messages[i].msg_len == 0) continue;
+      auto &packet = packets[n_packets++];
+      packet.data = (const uint8_t *)iovecs[i].iov_base;
+      packet.size = messages[i].msg_len;
+      packet.kernel_timestamp = std::chrono::nanoseconds(0);
+      if (!config.kernel_timestamps) continue;
+      for (auto *cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr;
+           cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+          struct timespec ts {};
+          std::memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+          packet.kernel_timestamp = std::chrono::seconds(ts.tv_sec) +
+                                    std::chrono::nanoseconds(ts.tv_nsec);
+        }
+      }
+    }
+    if (n_packets > 0) {
+      m_batch_cb(packets.data(), n_packets);
+    }
+  }
+  get_console()->debug("UDP end");
+}
+
 void openhd::UDPReceiver::loopUntilError() {
+  if (m_batch_cb) {
+    loop_recvmmsg();
+    return;
+  }
   const auto buff =
       std::make_unique<std::array<uint8_t, UDP_PACKET_MAX_SIZE>>();
   // sockaddr_in source;
@@ -136,20 +462,7 @@ void openhd::UDPReceiver::loopUntilError() {
     if (message_length > 0) {
       mCb(buff->data(), (size_t)message_length);
     } else {
-      // this can also come from the shutdown, in which case it is not an error.
-      // But this way we break out of the loop.
-      if (receiving) {
-        if (std::chrono::steady_clock::now() - m_last_receive_error_log >=
-            std::chrono::seconds(3)) {
-          get_console()->warn("Got message length of: {} log_skip_count:{}",
-                              message_length,
-                              m_last_receive_error_log_skip_count);
-          m_last_receive_error_log = std::chrono::steady_clock::now();
-          m_last_receive_error_log_skip_count = 0;
-        } else {
-          m_last_receive_error_log_skip_count++;
-        }
-      }
+      log_receive_error(message_length);
     }
   }
   get_console()->debug("UDP end");
@@ -158,19 +471,20 @@ void openhd::UDPReceiver::loopUntilError() {
 void openhd::UDPReceiver::forwardPacketViaUDP(
     const std::string &destIp, const int destPort, const uint8_t *packet,
     const std::size_t packetSize) const {
-  // set up the destination
-  struct sockaddr_in saddr {};
-  bzero((char *)&saddr, sizeof(saddr));
-  saddr.sin_family = AF_INET;
-  // saddr.sin_addr.s_addr = inet_addr(client_addr.c_str());
-  inet_aton(destIp.c_str(), (in_addr *)&saddr.sin_addr.s_addr);
-  saddr.sin_port = htons((uint16_t)destPort);
+  forwardPacketViaUDP(create_udp_destination(destIp, destPort), packet,
+                      packetSize);
+}
+
+void openhd::UDPReceiver::forwardPacketViaUDP(
+    const struct sockaddr_in &dest, const uint8_t *packet,
+    const std::size_t packetSize) const {
   // send from the currently bound UDP port to the destination address
   const auto ret = sendto(mSocket, packet, packetSize, 0,
-                          (const struct sockaddr *)&saddr, sizeof(saddr));
-  if (ret < 0 || ret != packetSize) {
+                          (const struct sockaddr *)&dest, sizeof(dest));
+  if (ret < 0 || (std::size_t)ret != packetSize) {
     get_console()->warn("Error sending packet of size:{} to {}:{} code:{} {}",
-                        packetSize, destIp, destPort, ret, strerror(errno));
+                        packetSize, inet_ntoa(dest.sin_addr),
+                        ntohs(dest.sin_port), ret, strerror(errno));
   }
 }
 
@@ -233,3 +547,13 @@ void openhd::setSocketReuse(int sockfd) {
     get_console()->warn("Cannot set socket reuse");
   }
 }
+
+struct sockaddr_in openhd::create_udp_destination(const std::string &ip,
+                                                  int port) {
+  struct sockaddr_in saddr {};
+  bzero((char *)&saddr, sizeof(saddr));
+  saddr.sin_family = AF_INET;
+  inet_aton(ip.c_str(), (in_addr *)&saddr.sin_addr.s_addr);
+  saddr.sin_port = htons((uint16_t)port);
+  return saddr;
+}
@@ -100,11 +100,17 @@ class ThreadSafeINT64_t {
   void store(int64_t v) {
     std::lock_guard<std::mutex> lock(m_mutex);
     value = v;
+    has_value = true;
+  }
+  bool is_set() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return has_value;
   }
 
  private:
   std::mutex m_mutex;
   int64_t value = 0;
+  bool has_value = false;
 };
 static ThreadSafeINT64_t& get_air_ts() {
   static ThreadSafeINT64_t holder;
@@ -117,3 +123,4 @@ void openhd::util::store_air_unit_time_offset_us(int64_t offset_us) {
 int64_t openhd::util::get_air_unit_time_offset_us() {
   return get_air_ts().load();
 }
+bool openhd::util::has_air_unit_time_offset() { return get_air_ts().is_set(); }
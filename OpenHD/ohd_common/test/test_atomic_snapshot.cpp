@@ -0,0 +1,120 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "openhd_atomic_snapshot.h"
+
+// Easy to check for inconsistent snapshots - all values are the same
+using TestData = std::vector<uint32_t>;
+
+static void test_basics() {
+  openhd::AtomicSnapshot<TestData> snapshot{TestData(4, 1)};
+  const auto first = snapshot.get();
+  assert(first->size() == 4);
+  snapshot.update([](TestData& data) { data.push_back(1); });
+  // The old snapshot is untouched
+  assert(first->size() == 4);
+  assert(snapshot.get()->size() == 5);
+  // More updates than slots while a reference is held
+  for (int i = 0; i < 100; i++) {
+    snapshot.update([](TestData& data) { data.push_back(1); });
+  }
+  assert(first->size() == 4);
+  assert(snapshot.get()->size() == 105);
+  auto moved = snapshot.get();
+  moved = snapshot.get();
+  assert((*moved).size() == 105);
+  std::cout << "Basics OK" << std::endl;
+}
+
+static void test_concurrent() {
+  openhd::AtomicSnapshot<TestData> snapshot{TestData(64, 0)};
+  std::atomic<bool> run{true};
+  std::atomic<int64_t> n_updates{0};
+  std::thread writer([&] {
+    uint32_t counter = 0;
+    while (run) {
+      counter++;
+      snapshot.update([&](TestData& data) {
+        for (auto& value : data) value = counter;
+      });
+      n_updates++;
+    }
+  });
+  std::atomic<int64_t> n_reads{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&, i] {
+      uint32_t last = 0;
+      while (run) {
+        const auto data = snapshot.get();
+        for (const auto value : *data) {
+          assert(value == data->front());
+        }
+        // Snapshots are published in order
+        assert(data->front() >= last);
+        last = data->front();
+        // Like a blocking send while holding the snapshot
+        if (i == 0) std::this_thread::sleep_for(std::chrono::microseconds(50));
+        n_reads++;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  run = false;
+  writer.join();
+  for (auto& reader : readers) reader.join();
+  std::cout << "Consistent snapshots in " << n_reads << " reads, " << n_updates
+            << " updates" << std::endl;
+}
+
+static void bench_get() {
+  openhd::AtomicSnapshot<TestData> snapshot{TestData(4, 1)};
+  const int N = 10000000;
+  uint64_t sum = 0;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) {
+    sum += snapshot.get()->size();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  assert(sum == (uint64_t)N * 4);
+  std::cout << "get: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                       .count() /
+                   (double)N
+            << "ns" << std::endl;
+}
+
+int main() {
+  test_basics();
+  test_concurrent();
+  bench_get();
+  return 0;
+}
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "openhd_fragment_pool.h"
+#include "openhd_video_frame.h"
+
+// Counts all allocations while enabled
+static std::atomic<bool> g_count_allocations{false};
+static std::atomic<int64_t> g_n_allocations{0};
+
+void* operator new(std::size_t size) {
+  if (g_count_allocations) g_n_allocations++;
+  void* ret = std::malloc(size == 0 ? 1 : size);
+  if (ret == nullptr) throw std::bad_alloc();
+  return ret;
+}
+// noinline - otherwise gcc sees free() on memory from new and warns
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr,
+                                               std::size_t) noexcept {
+  std::free(ptr);
+}
+
+static void test_pool_basics() {
+  openhd::FragmentPool pool{4};
+  std::vector<uint8_t> data(1000, 0x22);
+  std::vector<openhd::VideoFragment> fragments;
+  for (int i = 0; i < 4; i++) {
+    fragments.push_back(
+        openhd::VideoFragment::pooled_copy_of(data.data(), data.size(), pool));
+  }
+  assert(pool.get_stats().n_in_use == 4);
+  // Exhausted - falls back to the heap
+  auto heap_fragment =
+      openhd::VideoFragment::pooled_copy_of(data.data(), data.size(), pool);
+  assert(heap_fragment.size() == data.size());
+  assert(pool.get_stats().count_miss == 1);
+  // Copies keep the slot alive
+  auto copy = fragments[0];
+  fragments.clear();
+  assert(pool.get_stats().n_in_use == 1);
+  assert(std::memcmp(copy.data(), data.data(), data.size()) == 0);
+  copy = openhd::VideoFragment{};
+  const auto stats = pool.get_stats();
+  assert(stats.n_in_use == 0);
+  assert(stats.high_water == 4);
+  assert(stats.count_hit == 4);
+  std::cout << openhd::FragmentPool::stats_to_string(stats) << "\n";
+}
+
+// Simulates the camera thread producing 1080p60 frames (~30MBit/s, 10x larger
+// I-frame every second) in real time and the link thread consuming them.
+// The consumer holds on to the fragments for as long as the WB video tx queue
+// does (WBLink::VIDEO_TX_BLOCK_QUEUE_SIZE blocks queued + the one that is
+// being transmitted), such that the pool sees the same number of fragments in
+// flight as on the air unit. Reports the allocations per second (all
+// threads), the producer cost per fragment and the pool hit / miss /
+// high-water counters.
+static constexpr int FPS = 60;
+static constexpr int WB_N_FRAMES_IN_FLIGHT = 2 + 1;
+
+static void benchmark(const std::string& tag, bool use_pool, int duration_s) {
+  static constexpr int FRAGMENT_SIZE = 1434;
+  static constexpr int N_FRAGMENTS_P_FRAME = 44;
+  const int n_frames = FPS * duration_s;
+  // A pool per run, such that the stats are for this run only
+  openhd::FragmentPool pool{openhd::FragmentPool::DEFAULT_N_SLOTS};
+  const std::vector<uint8_t> encoder_output(FRAGMENT_SIZE, 0x11);
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<openhd::FragmentedVideoFrame> queue;
+  bool done = false;
+  int64_t n_fragments = 0;
+  std::thread consumer([&]() {
+    std::deque<openhd::FragmentedVideoFrame> in_flight;
+    while (true) {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&]() { return !queue.empty() || done; });
+      if (queue.empty()) return;
+      auto frame = std::move(queue.front());
+      queue.pop_front();
+      lock.unlock();
+      for (const auto& fragment : frame.rtp_fragments) {
+        n_fragments += fragment.data()[0] > 0 ? 1 : 0;
+      }
+      in_flight.push_back(std::move(frame));
+      if (in_flight.size() > WB_N_FRAMES_IN_FLIGHT) in_flight.pop_front();
+    }
+  });
+  std::chrono::nanoseconds produce_duration{};
+  g_n_allocations = 0;
+  g_count_allocations = true;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < n_frames; i++) {
+    const auto produce_begin = std::chrono::steady_clock::now();
+    openhd::FragmentedVideoFrame frame{};
+    const int n = i % FPS == 0 ? N_FRAGMENTS_P_FRAME * 10 : N_FRAGMENTS_P_FRAME;
+    for (int j = 0; j < n; j++) {
+      if (use_pool) {
+        frame.rtp_fragments.push_back(openhd::VideoFragment::pooled_copy_of(
+            encoder_output.data(), encoder_output.size(), pool));
+      } else {
+        frame.rtp_fragments.push_back(openhd::VideoFragment::copy_of(
+            encoder_output.data(), encoder_output.size()));
+      }
+    }
+    produce_duration += std::chrono::steady_clock::now() - produce_begin;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.push_back(std::move(frame));
+      cv.notify_one();
+    }
+    std::this_thread::sleep_until(
+        begin + std::chrono::microseconds(1000000 / FPS * (i + 1)));
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_one();
+  }
+  consumer.join();
+  g_count_allocations = false;
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  const double elapsed_s =
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() /
+      1000.0;
+  std::cout << tag << ": " << n_fragments << " fragments, "
+            << (int64_t)(g_n_allocations / elapsed_s) << " allocations/s, "
+            << produce_duration.count() / n_fragments
+            << "ns per fragment (producer), "
+            << openhd::FragmentPool::stats_to_string(pool.get_stats()) << "\n";
+}
+
+// Usage: test_fragment_pool [duration of each benchmark run in s]
+int main(int argc, char* argv[]) {
+  const int duration_s = argc > 1 ? std::atoi(argv[1]) : 1;
+  test_pool_basics();
+  benchmark("heap", false, duration_s);
+  benchmark("pool", true, duration_s);
+  return 0;
+}
@@ -0,0 +1,135 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <cassert>
+#include <iostream>
+#include <thread>
+
+#include "openhd_latency_trace.h"
+#include "openhd_link.hpp"
+#include "openhd_util_time.h"
+
+using namespace openhd::latency_trace;
+
+// Ground unit link that doesn't transmit anything
+class TestGroundLink : public OHDLink {
+ public:
+  void transmit_telemetry_data(TelemetryTxPacket packet) override {}
+  void transmit_video_data(
+      int stream_index,
+      const openhd::FragmentedVideoFrame& fragmented_video_frame) override {}
+  void transmit_audio_data(const openhd::AudioPacket& audio_packet) override {}
+};
+
+static void test_histogram() {
+  LatencyHistogram histogram{};
+  for (int i = 1; i <= 1000; i++) {
+    histogram.record(std::chrono::microseconds(i));
+  }
+  const auto summary = histogram.get_and_reset();
+  std::cout << "count:" << summary.count << " p50:" << summary.p50_us
+            << " p99:" << summary.p99_us << " max:" << summary.max_us << "\n";
+  assert(summary.count == 1000);
+  assert(summary.max_us == 1000);
+  // Bucket resolution is 1/16
+  assert(summary.p50_us >= 500 && summary.p50_us <= 500 + 500 / 16);
+  assert(summary.p99_us >= 990 && summary.p99_us <= 1000);
+  assert(histogram.get_and_reset().count == 0);
+  // Out of range values are clamped, not lost
+  histogram.record(std::chrono::seconds(100));
+  histogram.record(std::chrono::microseconds(-5));
+  assert(histogram.get_and_reset().count == 2);
+}
+
+static void test_trace_packet() {
+  const TraceRecord record{1234, 987654321012};
+  const auto packet = create_trace_packet(record);
+  assert(is_trace_packet(packet->data(), packet->size()));
+  const auto parsed = parse_trace_packet(packet->data());
+  assert(parsed.frame_id == record.frame_id);
+  assert(parsed.air_creation_time_us == record.air_creation_time_us);
+  // rtp version 2, never a trace packet
+  std::vector<uint8_t> rtp(TRACE_PACKET_SIZE, 0);
+  rtp[0] = 0x80;
+  assert(!is_trace_packet(rtp.data(), rtp.size()));
+}
+
+// Air and ground in one process, ground clock 10 seconds ahead of the air
+// clock.
+static void test_air_to_ground() {
+  static constexpr int64_t OFFSET_US = 10 * 1000 * 1000;
+  auto& tracer = LatencyTracer::instance();
+  tracer.set_enabled(true);
+  openhd::util::store_air_unit_time_offset_us(OFFSET_US);
+  TestGroundLink link{};
+  int n_forwarded = 0;
+  link.register_on_receive_video_data_cb(
+      [&](int stream_index, const uint8_t* data, int data_len) {
+        assert(!is_trace_packet(data, data_len));
+        n_forwarded++;
+        std::this_thread::sleep_for(std::chrono::microseconds(500));
+      });
+  const std::vector<uint8_t> rtp_fragment(1000, 0x80);
+  for (int i = 0; i < 10; i++) {
+    const auto creation_time = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    tracer.record(0, Stage::AIR_FRAME_COMPLETE, creation_time);
+    const auto trace_packet = tracer.create_air_trace_packet(0, creation_time);
+    tracer.record(0, Stage::AIR_LINK_ENQUEUE, creation_time);
+    // Ground unit receives the frame with the (air) clock offset
+    std::this_thread::sleep_for(std::chrono::milliseconds(3));
+    auto ground_packet = *trace_packet;
+    auto record = parse_trace_packet(ground_packet.data());
+    assert(record.frame_id == (uint32_t)i);
+    record.air_creation_time_us -= OFFSET_US;
+    ground_packet = *create_trace_packet(record);
+    link.on_receive_video_data(0, rtp_fragment.data(), rtp_fragment.size());
+    link.on_receive_video_data(0, ground_packet.data(), ground_packet.size());
+  }
+  assert(n_forwarded == 10);
+  std::this_thread::sleep_for(LatencyTracer::SUMMARY_INTERVAL);
+  assert(tracer.update());
+  for (int stage = 0; stage < N_STAGES; stage++) {
+    const auto summary = tracer.get_summary(0, (Stage)stage);
+    std::cout << stage_to_string((Stage)stage) << " count:" << summary.count
+              << " p50:" << summary.p50_us << " p99:" << summary.p99_us
+              << " max:" << summary.max_us << "\n";
+    assert(summary.count == 10);
+  }
+  // air 2ms, ground 5ms, forwarded 0.5ms later
+  assert(tracer.get_summary(0, Stage::AIR_LINK_ENQUEUE).p50_us >= 2000);
+  const auto rx = tracer.get_summary(0, Stage::GND_LINK_RX);
+  const auto fwd = tracer.get_summary(0, Stage::GND_UDP_FORWARD);
+  assert(rx.p50_us >= 5000 && rx.p50_us < 50000);
+  assert(fwd.p50_us >= rx.p50_us + 400);
+  assert(tracer.get_summary(1, Stage::GND_LINK_RX).count == 0);
+}
+
+int main(int argc, char* argv[]) {
+  test_histogram();
+  test_trace_packet();
+  test_air_to_ground();
+  std::cout << "See " << LatencyTracer::TRACE_FILENAME << "\n";
+  std::cout << "All tests passed\n";
+  return 0;
+}
@@ -0,0 +1,126 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "openhd_action_handler.h"
+#include "openhd_seqlock.h"
+
+// A struct that is easy to check for torn reads - all values are the same
+struct TestData {
+  uint32_t values[64];
+  uint16_t tail;
+};
+
+static void test_basics() {
+  openhd::SeqLock<TestData> lock{};
+  assert(lock.read().values[0] == 0);
+  assert(lock.get_sequence() == 0);
+  TestData data{};
+  data.values[63] = 5;
+  lock.write(data);
+  assert(lock.read().values[63] == 5);
+  assert(lock.get_sequence() == 2);
+  lock.modify([](TestData& value) { value.tail = 7; });
+  const auto read = lock.read();
+  assert(read.values[63] == 5 && read.tail == 7);
+  std::cout << "Basics OK" << std::endl;
+}
+
+static void test_no_torn_reads() {
+  openhd::SeqLock<TestData> lock{};
+  std::atomic<bool> run{true};
+  std::thread writer([&] {
+    uint32_t counter = 0;
+    while (run) {
+      counter++;
+      TestData data{};
+      for (auto& value : data.values) value = counter;
+      data.tail = static_cast<uint16_t>(counter);
+      lock.write(data);
+    }
+  });
+  std::atomic<int64_t> n_reads{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++) {
+    readers.emplace_back([&] {
+      while (run) {
+        const auto data = lock.read();
+        for (const auto value : data.values) {
+          assert(value == data.values[0]);
+        }
+        assert(data.tail == static_cast<uint16_t>(data.values[0]));
+        n_reads++;
+      }
+    });
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  run = false;
+  writer.join();
+  for (auto& reader : readers) reader.join();
+  std::cout << "No torn reads in " << n_reads << " reads, "
+            << lock.get_sequence() / 2 << " writes" << std::endl;
+}
+
+static void test_link_stats() {
+  auto& handler = openhd::LinkActionHandler::instance();
+  openhd::link_statistics::StatsAirGround stats{};
+  stats.ready = true;
+  stats.stats_wb_video_air.push_back({});
+  stats.stats_wb_video_air.push_back({});
+  // Capacity is 2 video streams
+  assert(!stats.stats_wb_video_air.push_back({}));
+  handler.update_link_stats(stats);
+  const auto read = handler.get_link_stats();
+  assert(read.ready);
+  assert(read.stats_wb_video_air.size() == 2);
+  handler.set_cam_info_bitrate(1, 1234);
+  assert(handler.get_cam_info(1).encoding_bitrate_kbits == 1234);
+  assert(handler.get_cam_info(0).encoding_bitrate_kbits == 0);
+  // What a 10Hz stats refresh costs
+  const int N = 100000;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int i = 0; i < N; i++) {
+    handler.update_link_stats(stats);
+    const auto tmp = handler.get_link_stats();
+    assert(tmp.ready);
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  std::cout << "Link stats write+read: "
+            << std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                       .count() /
+                   N
+            << "ns (" << sizeof(stats) << " bytes)" << std::endl;
+}
+
+int main() {
+  test_basics();
+  test_no_torn_reads();
+  test_link_stats();
+  return 0;
+}
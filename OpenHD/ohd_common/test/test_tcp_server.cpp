@@ -21,17 +21,25 @@
  * © OpenHD, All Rights Reserved.
  ******************************************************************************/
 
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <cstring>
+
 #include "openhd_spdlog_include.h"
 #include "openhd_tcp.h"
 
 class TestServer : public openhd::TCPServer {
  public:
-  explicit TestServer()
-      : openhd::TCPServer("Test", openhd::TCPServer::Config{5760}){};
+  explicit TestServer(openhd::TCPServer::Config config)
+      : openhd::TCPServer("Test", config){};
   void on_external_device(std::string ip, int port, bool connected) override {
     if (connected) {
+      n_connected++;
       openhd::log::get_default()->debug("Device {}:{} connected", ip, port);
     } else {
+      n_connected--;
       openhd::log::get_default()->debug("Device {}:{} disconnected", ip, port);
     }
   };
@@ -39,16 +47,101 @@ class TestServer : public openhd::TCPServer {
     // do nothing
     openhd::log::get_default()->debug("Got data {}", data_len);
   };
+  std::atomic<int> n_connected = 0;
 };
 
+static int connect_client(int port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+  if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static uint8_t pattern_byte(size_t idx) { return (uint8_t)(idx * 31 + 7); }
+
+// N readers and one client that never reads - the readers need to get the
+// complete, uncorrupted stream and the stalled client needs to be reaped.
+static void test_slow_client_does_not_stall_others() {
+  static constexpr int PORT = 5761;
+  static constexpr int N_READERS = 8;
+  static constexpr size_t MSG_SIZE = 280;
+  static constexpr size_t N_MESSAGES = 20000;
+  openhd::TCPServer::Config config{PORT};
+  config.client_stall_timeout = std::chrono::milliseconds(500);
+  TestServer server(config);
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  const int stalled_fd = connect_client(PORT);
+  assert(stalled_fd >= 0);
+  std::atomic<int> n_readers_ok = 0;
+  std::vector<std::thread> readers;
+  for (int i = 0; i < N_READERS; i++) {
+    readers.emplace_back([&n_readers_ok] {
+      const int fd = connect_client(PORT);
+      if (fd < 0) return;
+      std::vector<uint8_t> buff(4096);
+      size_t n_total = 0;
+      bool valid = true;
+      while (n_total < MSG_SIZE * N_MESSAGES) {
+        const ssize_t len = read(fd, buff.data(), buff.size());
+        if (len <= 0) break;
+        for (ssize_t j = 0; j < len; j++) {
+          if (buff[j] != pattern_byte(n_total + j)) valid = false;
+        }
+        n_total += len;
+      }
+      if (valid && n_total == MSG_SIZE * N_MESSAGES) n_readers_ok++;
+      close(fd);
+    });
+  }
+  while (server.n_connected < N_READERS + 1) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  std::vector<uint8_t> msg(MSG_SIZE);
+  const auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < N_MESSAGES; i++) {
+    for (size_t j = 0; j < MSG_SIZE; j++) {
+      msg[j] = pattern_byte(i * MSG_SIZE + j);
+    }
+    server.send_message_to_all_clients(msg.data(), msg.size());
+    // Roughly the rate of a busy telemetry link, not a flood
+    if (i % 100 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  for (auto& reader : readers) reader.join();
+  openhd::log::get_default()->info(
+      "Sent {} messages to {} clients in {}ms, {} readers got all data",
+      N_MESSAGES, N_READERS + 1,
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count(),
+      n_readers_ok.load());
+  assert(n_readers_ok == N_READERS);
+  // The stalled client should be disconnected by now (or shortly after)
+  for (int i = 0; i < 30 && server.n_connected > 0; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  assert(server.n_connected == 0);
+  close(stalled_fd);
+}
+
 int main(int argc, char* argv[]) {
-  auto test_server = std::make_unique<TestServer>();
-  // Run netcat 0.0.0.0 5760 to test
-  while (true) {
-    std::this_thread::sleep_for(std::chrono::seconds(1));
-    std::string buff = "Hello\n";
-    const int buff_size = buff.length() + 1;
-    test_server->send_message_to_all_clients((uint8_t*)buff.c_str(), buff_size);
+  if (argc > 1 && std::string(argv[1]) == "--netcat") {
+    auto test_server =
+        std::make_unique<TestServer>(openhd::TCPServer::Config{5760});
+    // Run netcat 0.0.0.0 5760 to test
+    while (true) {
+      std::this_thread::sleep_for(std::chrono::seconds(1));
+      std::string buff = "Hello\n";
+      const int buff_size = buff.length() + 1;
+      test_server->send_message_to_all_clients((uint8_t*)buff.c_str(),
+                                               buff_size);
+    }
   }
-  std::this_thread::sleep_for(std::chrono::seconds(100));
-}
\ No newline at end of file
+  test_slow_client_does_not_stall_others();
+  openhd::log::get_default()->info("test_tcp_server passed");
+  return 0;
+}
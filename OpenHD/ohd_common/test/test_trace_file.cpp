@@ -0,0 +1,78 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "openhd_trace_file.h"
+
+static constexpr auto FILENAME = "/tmp/test_trace_file.csv";
+
+static int count_lines(const std::string& filename) {
+  std::ifstream file(filename);
+  int count = 0;
+  std::string line;
+  while (std::getline(file, line)) count++;
+  return count;
+}
+
+// The size never exceeds the limit, older lines end up in <filename>.1
+static void test_rotation() {
+  const std::string rotated = std::string(FILENAME) + ".1";
+  std::remove(rotated.c_str());
+  static constexpr size_t MAX_SIZE = 1024;
+  // 10 bytes per line, header included
+  const std::string line = "123456789";
+  {
+    openhd::TraceFile trace(FILENAME, "a,b,c,d,e", MAX_SIZE);
+    for (int i = 0; i < 100; i++) {
+      trace.write_line(line);
+    }
+    assert(!std::filesystem::exists(rotated));
+    for (int i = 0; i < 1000; i++) {
+      trace.write_line(line);
+    }
+  }
+  assert(std::filesystem::exists(rotated));
+  assert(std::filesystem::file_size(FILENAME) <= MAX_SIZE);
+  assert(std::filesystem::file_size(rotated) <= MAX_SIZE);
+  // 1 header + 101 lines per file, 1100 lines: 10 full files, 90 in the last
+  assert(count_lines(rotated) == 102);
+  assert(count_lines(FILENAME) == 1 + 1100 - 10 * 101);
+  std::ifstream file(FILENAME);
+  std::string header;
+  std::getline(file, header);
+  assert(header == "a,b,c,d,e");
+  std::cout << "Rotation OK" << std::endl;
+}
+
+int main() {
+  test_rotation();
+  std::remove(FILENAME);
+  std::remove((std::string(FILENAME) + ".1").c_str());
+  return 0;
+}
@@ -0,0 +1,185 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#include "openhd_spdlog_include.h"
+#include "openhd_udp.h"
+#include "openhd_util_time.h"
+
+//
+// Benchmark for UDPMultiForwarder - forwards 60fps video (rtp like fragments,
+// marker bit set on the last fragment of a frame) to 3 local consumers and
+// reports syscalls/s and the latency until the consumer received a fragment.
+//
+static constexpr int N_DESTINATIONS = 3;
+static constexpr int BASE_PORT = 6700;
+static constexpr int FRAGMENT_SIZE = 1440;
+static constexpr int N_FRAGMENTS_P_FRAME = 40;
+static constexpr int FPS = 60;
+static constexpr int N_FRAMES = FPS * 3;
+
+static int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static void run(bool batched) {
+  std::atomic<int64_t> n_received = 0;
+  std::atomic<int64_t> latency_sum_ns = 0;
+  std::atomic<int64_t> latency_max_ns = 0;
+  std::vector<std::unique_ptr<openhd::UDPReceiver>> receivers;
+  for (int i = 0; i < N_DESTINATIONS; i++) {
+    auto cb = [&](const uint8_t* payload, const std::size_t payloadSize) {
+      int64_t sent_ns;
+      std::memcpy(&sent_ns, payload + 12, sizeof(sent_ns));
+      const int64_t latency = now_ns() - sent_ns;
+      n_received++;
+      latency_sum_ns += latency;
+      int64_t curr_max = latency_max_ns;
+      while (latency > curr_max &&
+             !latency_max_ns.compare_exchange_weak(curr_max, latency)) {
+      }
+    };
+    receivers.push_back(std::make_unique<openhd::UDPReceiver>(
+        openhd::ADDRESS_LOCALHOST, BASE_PORT + i, cb));
+    receivers.back()->runInBackground();
+  }
+  openhd::UDPMultiForwarder forwarder{};
+  for (int i = 0; i < N_DESTINATIONS; i++) {
+    forwarder.addForwarder(openhd::ADDRESS_LOCALHOST, BASE_PORT + i);
+  }
+  if (batched) {
+    forwarder.enableBatching(std::chrono::milliseconds(2));
+  }
+  std::vector<uint8_t> fragment(FRAGMENT_SIZE, 0);
+  const auto begin = std::chrono::steady_clock::now();
+  for (int frame = 0; frame < N_FRAMES; frame++) {
+    for (int i = 0; i < N_FRAGMENTS_P_FRAME; i++) {
+      const bool last = i == N_FRAGMENTS_P_FRAME - 1;
+      fragment[1] = last ? 0x80 : 0x00;
+      const int64_t ts = now_ns();
+      std::memcpy(fragment.data() + 12, &ts, sizeof(ts));
+      forwarder.forwardPacketViaUDP(fragment.data(), fragment.size());
+      // Like OHDVideoGround::on_video_data
+      if (last) forwarder.flushBatch();
+    }
+    std::this_thread::sleep_until(begin + std::chrono::microseconds(
+                                              1000000 / FPS * (frame + 1)));
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  for (auto& receiver : receivers) receiver->stopBackground();
+  const int64_t n_packets = (int64_t)N_FRAMES * N_FRAGMENTS_P_FRAME;
+  const int64_t n_syscalls = batched ? forwarder.getBatchStats().n_syscalls
+                                     : n_packets * N_DESTINATIONS;
+  const double elapsed_s =
+      std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() /
+      1000.0;
+  std::cout << (batched ? "batched" : "default") << ": "
+            << (int64_t)(n_syscalls / elapsed_s) << " syscalls/s, received "
+            << n_received << "/" << n_packets * N_DESTINATIONS
+            << " latency avg:"
+            << openhd::util::time_readable_ns(
+                   n_received > 0 ? latency_sum_ns / n_received : 0)
+            << " max:" << openhd::util::time_readable_ns(latency_max_ns)
+            << "\n";
+}
+
+// Packets too big for the batch must not overtake the batched ones
+static void check_order() {
+  static constexpr int N_PACKETS = 1000;
+  std::atomic<int> n_received = 0;
+  std::atomic<int> n_out_of_order = 0;
+  int last_seq = -1;
+  auto cb = [&](const uint8_t* payload, const std::size_t payloadSize) {
+    int seq;
+    std::memcpy(&seq, payload, sizeof(seq));
+    if (seq <= last_seq) n_out_of_order++;
+    last_seq = seq;
+    n_received++;
+  };
+  openhd::UDPReceiver receiver{openhd::ADDRESS_LOCALHOST, BASE_PORT, cb};
+  receiver.runInBackground();
+  openhd::UDPMultiForwarder forwarder{};
+  forwarder.addForwarder(openhd::ADDRESS_LOCALHOST, BASE_PORT);
+  forwarder.enableBatching(std::chrono::milliseconds(2));
+  std::vector<uint8_t> packet(
+      openhd::UDPMultiForwarder::MAX_BATCHED_PACKET_SIZE + 1000, 0);
+  for (int seq = 0; seq < N_PACKETS; seq++) {
+    std::memcpy(packet.data(), &seq, sizeof(seq));
+    const bool oversize = seq % 7 == 0;
+    forwarder.forwardPacketViaUDP(
+        packet.data(), oversize ? packet.size() : (size_t)FRAGMENT_SIZE);
+    if (seq % 50 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  forwarder.flushBatch();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  receiver.stopBackground();
+  std::cout << "order: received " << n_received << "/" << N_PACKETS
+            << " out of order:" << n_out_of_order << "\n";
+  assert(n_out_of_order == 0);
+}
+
+// A destination that can't be reached (here: broadcast without SO_BROADCAST,
+// EACCES) must not cost the other destinations any packets
+static void check_failing_destination() {
+  static constexpr int N_PACKETS = 500;
+  std::atomic<int> n_received = 0;
+  auto cb = [&](const uint8_t* payload, const std::size_t payloadSize) {
+    n_received++;
+  };
+  openhd::UDPReceiver receiver{openhd::ADDRESS_LOCALHOST, BASE_PORT, cb};
+  receiver.runInBackground();
+  openhd::UDPMultiForwarder forwarder{};
+  forwarder.addForwarder("255.255.255.255", BASE_PORT);
+  forwarder.addForwarder(openhd::ADDRESS_LOCALHOST, BASE_PORT);
+  forwarder.enableBatching(std::chrono::milliseconds(2));
+  std::vector<uint8_t> packet(FRAGMENT_SIZE, 0);
+  for (int seq = 0; seq < N_PACKETS; seq++) {
+    forwarder.forwardPacketViaUDP(packet.data(), packet.size());
+    if (seq % 50 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  forwarder.flushBatch();
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  receiver.stopBackground();
+  std::cout << "failing destination: received " << n_received << "/"
+            << N_PACKETS << "\n";
+  assert(n_received == N_PACKETS);
+}
+
+int main(int argc, char* argv[]) {
+  run(false);
+  run(true);
+  check_order();
+  check_failing_destination();
+  return 0;
+}
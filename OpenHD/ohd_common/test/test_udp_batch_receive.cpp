@@ -0,0 +1,114 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+#include "openhd_spdlog_include.h"
+#include "openhd_udp.h"
+#include "openhd_util_time.h"
+
+//
+// Benchmark for UDPReceiver - bursts of video-sized packets (like one
+// fragmented frame) received per packet (recv) vs. batched (recvmmsg).
+// Reports received packets, callbacks and (batched only) the time between
+// the kernel receiving a packet and the callback seeing it.
+//
+static constexpr int PORT = 6750;
+static constexpr int PACKET_SIZE = 1440;
+static constexpr int N_PACKETS_P_BURST = 40;
+static constexpr int N_BURSTS = 500;
+
+static int64_t realtime_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+static void run(bool batched) {
+  std::atomic<int64_t> n_received = 0;
+  std::atomic<int64_t> n_callbacks = 0;
+  int64_t kernel_latency_sum_ns = 0;
+  int64_t kernel_latency_max_ns = 0;
+  std::unique_ptr<openhd::UDPReceiver> receiver;
+  if (batched) {
+    openhd::UDPReceiver::BatchConfig config{};
+    config.max_n_packets = 64;
+    config.rcvbuf_size = 1024 * 1024;
+    config.kernel_timestamps = true;
+    auto cb = [&](const openhd::UDPReceiver::ReceivedPacket* packets,
+                  std::size_t n_packets) {
+      const int64_t now = realtime_now_ns();
+      for (std::size_t i = 0; i < n_packets; i++) {
+        const int64_t latency = now - packets[i].kernel_timestamp.count();
+        kernel_latency_sum_ns += latency;
+        kernel_latency_max_ns = std::max(kernel_latency_max_ns, latency);
+      }
+      n_received += (int64_t)n_packets;
+      n_callbacks++;
+    };
+    receiver = std::make_unique<openhd::UDPReceiver>(
+        openhd::ADDRESS_LOCALHOST, PORT, cb, config);
+  } else {
+    auto cb = [&](const uint8_t* payload, const std::size_t payloadSize) {
+      n_received++;
+      n_callbacks++;
+    };
+    receiver = std::make_unique<openhd::UDPReceiver>(openhd::ADDRESS_LOCALHOST,
+                                                     PORT, cb);
+  }
+  receiver->runInBackground();
+  openhd::UDPForwarder forwarder{openhd::ADDRESS_LOCALHOST, PORT};
+  std::vector<uint8_t> packet(PACKET_SIZE, 0);
+  const auto begin = std::chrono::steady_clock::now();
+  for (int burst = 0; burst < N_BURSTS; burst++) {
+    for (int i = 0; i < N_PACKETS_P_BURST; i++) {
+      forwarder.forwardPacketViaUDP(packet.data(), packet.size());
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  receiver->stopBackground();
+  const int64_t n_packets = (int64_t)N_BURSTS * N_PACKETS_P_BURST;
+  std::cout << (batched ? "recvmmsg" : "recv") << ": received " << n_received
+            << "/" << n_packets << " in " << n_callbacks << " callbacks, "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed)
+                   .count()
+            << "ms";
+  if (batched && n_received > 0) {
+    std::cout << " kernel->callback avg:"
+              << openhd::util::time_readable_ns(kernel_latency_sum_ns /
+                                                n_received)
+              << " max:"
+              << openhd::util::time_readable_ns(kernel_latency_max_ns);
+  }
+  std::cout << "\n";
+}
+
+int main(int argc, char* argv[]) {
+  run(false);
+  run(true);
+  return 0;
+}
@@ -41,12 +41,17 @@
 #include "openhd_profile.h"
 #include "openhd_settings_imp.h"
 #include "openhd_spdlog.h"
+#include "openhd_trace_file.h"
 #include "openhd_util_time.h"
+#include "wb_link_adaptive_fec.h"
 #include "wb_link_helper.h"
 #include "wb_link_manager.h"
+#include "wb_link_rate_controller.h"
+#include "wb_link_scan.h"
 #include "wb_link_settings.h"
 #include "wb_link_work_item.hpp"
 #include "wifi_card.h"
+#include "wifi_nl80211.h"
 
 /**
  * This class takes a list of cards supporting monitor mode (only 1 card on air)
@@ -92,10 +97,11 @@ class WBLink : public OHDLink {
   // an invalid param (e.g. an unsupported frequency by the card). We then
   // return true if we can enqueue this change operation to be applied on the
   // worker thread (false otherwise). This way we have the nice feature that we
-  // 1) reject settings while the worker thread is busy (e.g. during a channel
-  // scan) or if a previous change (like tx power) is still being performed. In
-  // this case, the user can just try again later (and should not be able to
-  // change the frequency for example during a channel scan anyway). 2) can send
+  // 1) reject frequency / channel width changes while another one or a channel
+  // scan is still being performed. In this case, the user can just try again
+  // later (and should not be able to change the frequency for example during a
+  // channel scan anyway). Quick changes like tx power are still accepted. 2)
+  // can send
   // the mavlink ack immediately, instead of needing to wait for the action to
   // be performed (Changing the tx power for example can take some time, while
   // the OS is busy talking to the wifi driver). Only disadvantage: We need to
@@ -113,6 +119,7 @@ class WBLink : public OHDLink {
   // These do not "break" the bidirectional connectivity and therefore
   // can be changed easily on the fly
   bool set_air_video_fec_percentage(int fec_percentage);
+  bool set_air_video_fec_adaptive(int value);
   bool set_air_enable_wb_video_variable_bitrate(int value);
   bool set_air_max_fec_block_size_for_platform(int value);
   bool set_air_wb_video_rate_for_mcs_adjustment_percent(int value);
@@ -126,7 +133,8 @@ class WBLink : public OHDLink {
   bool request_start_analyze_channels(int channels_to_scan);
 
   // apply the frequency (wifi channel) and channel with for all wifibroadcast
-  // cards r.n uses both iw and modifies the radiotap header
+  // cards r.n uses both nl80211 (iw as fallback) and modifies the radiotap
+  // header
   bool apply_frequency_and_channel_width(int frequency, int channel_width_rx,
                                          int channel_width_tx);
   bool apply_frequency_and_channel_width_from_settings();
@@ -138,13 +146,32 @@ class WBLink : public OHDLink {
    * the main thread updates the tx power
    */
   void update_arming_state(bool armed);
-  // Recalculate stats, apply settings asynchronously and more
+  // Recalculate stats, apply settings asynchronously and more. Sleeps until
+  // the next timed task is due, a work item is ready or a change needs to be
+  // applied right away.
   void loop_do_work();
+  // Short and exclusive items run on the worker thread, long running ones on
+  // their own thread
+  void wt_execute_work_item(const std::shared_ptr<WorkItem>& work_item);
   // update statistics, done in regular intervals, updated data is given to the
   // ohd_telemetry module via the action handler
   void wt_update_statistics();
+  // Air only, FragmentPool stats and the n of fragments WB had to copy
+  void wt_log_fragment_pool_stats();
+  // Adaptive FEC, feeds the ground video stats into the per-stream
+  // controllers. Otherwise, just applies the FEC settings.
+  void wt_perform_fec_adjustment();
   // Do rate adjustments, does nothing if variable bitrate is disabled
   void wt_perform_rate_adjustment();
+  // Air only, samples the tx path at a higher rate than the work loop and
+  // feeds the congestion controller
+  void loop_rate_control();
+  void rt_perform_rate_control();
+  // Back to the default bitrate for the current wifi config, the rate control
+  // thread starts over from there
+  void reset_rate_control();
+  // X20: thermal protection & armed state limit the encoder bitrate
+  int apply_platform_bitrate_limits(int video_bitrate_kbits);
   void wt_gnd_perform_channel_management();
   // this is special, mcs index can not only be changed via mavlink param, but
   // also via RC channel (if enabled)
@@ -154,11 +181,10 @@ class WBLink : public OHDLink {
   void wt_perform_air_hotspot_after_timeout();
   // X20 only, thermal protection
   void wt_perform_update_thermal_protection();
-  // Returns true if the work item queue is currently empty and the item has
-  // been added false otherwise. In general, we only suport one item on the work
-  // queue - otherwise we reject the param, since the user can just try again
-  // later (and in case the work queue is currently busy with a frequency scan
-  // for example, we do not support changing the frequency or similar.
+  // Returns true if the item has been added to the work queue, false if the
+  // queue is full or if the item is exclusive (frequency / channel width /
+  // channel scan) and another exclusive item is still queued or in progress.
+  // The user can just try again later in this case.
   bool try_schedule_work_item(const std::shared_ptr<WorkItem>& work_item);
   // Called by telemetry on both air and ground (send to opposite, respective)
   void transmit_telemetry_data(TelemetryTxPacket packet) override;
@@ -179,6 +205,12 @@ class WBLink : public OHDLink {
       const openhd::LinkActionHandler::ScanChannelsParam& scan_channels_params);
   // similar to channel scan, analyze channel(s) for interference
   void perform_channel_analyze(int channels_to_scan);
+  // Scan / analyze: disables injection, then tunes each card to the
+  // candidate it got in this round (-1: card is not used).
+  // Returns which cards were tuned successfully.
+  std::vector<bool> scan_tune_cards(
+      const std::vector<openhd::wb::ScanCandidate>& candidates,
+      const std::vector<int>& round, openhd::wb::ScanHopStats& hop_stats);
   void reset_all_rx_stats();
   void recommend_bitrate_to_encoder(int recommended_video_bitrate_kbits);
   // set passive mode to disabled (do not drop packets) unless we are ground
@@ -193,6 +225,8 @@ class WBLink : public OHDLink {
   const std::vector<WiFiCard> m_broadcast_cards;
   std::shared_ptr<spdlog::logger> m_console;
   std::unique_ptr<openhd::WBLinkSettingsHolder> m_settings;
+  // Persistent nl80211 socket for frequency / tx power changes
+  std::unique_ptr<wifi::nl80211::ChannelControl> m_nl80211;
   std::shared_ptr<RadiotapHeaderTxHolder> m_tx_header_1;
   // On air, we use different radiotap data header(s) for different streams
   // (20Mhz vs 40Mhz)
@@ -205,28 +239,80 @@ class WBLink : public OHDLink {
   // instances.
   std::vector<std::unique_ptr<WBStreamTx>> m_wb_video_tx_list;
   std::vector<std::unique_ptr<WBStreamRx>> m_wb_video_rx_list;
+  // In blocks (frames or parts of frames with early transmission)
+  static constexpr int VIDEO_TX_BLOCK_QUEUE_SIZE = 2;
+  // Per video tx stream, only accessed by the thread feeding this stream
+  std::array<bool, 2> m_video_tx_drop_rest_of_frame{};
+  // FEC overhead / max block length currently in use per video stream.
+  // Written by the worker thread, read by the thread(s) feeding the streams.
+  std::array<std::atomic<int>, 2> m_video_fec_percentage{};
+  std::array<std::atomic<int>, 2> m_video_max_fec_block_size{};
+  // Only accessed by the worker thread, nullptr if adaptive FEC is disabled
+  std::array<std::unique_ptr<openhd::wb::AdaptiveFecController>, 2>
+      m_adaptive_fec;
+  std::array<uint32_t, 2> m_adaptive_fec_last_n_reports{};
+  // Set when the user changes the FEC percentage (restarts adaptive FEC)
+  std::atomic_bool m_request_reset_adaptive_fec = false;
   // For audio or custom data
   std::unique_ptr<WBStreamTx> m_wb_audio_tx;
   std::unique_ptr<WBStreamRx> m_wb_audio_rx;
   // We have one worker thread for asynchronously performing operation(s) like
   // changing the frequency but also recalculating statistics that are then
   // forwarded to openhd_telemetry for broadcast
-  bool m_work_thread_run;
+  std::atomic_bool m_work_thread_run;
   std::unique_ptr<std::thread> m_work_thread;
-  std::mutex m_work_item_queue_mutex;
-  // NOTE: We only support one active work item at a time,
-  // otherwise, we reject any changes requested by the user.
-  std::queue<std::shared_ptr<WorkItem>> m_work_item_queue;
-  static constexpr auto RECALCULATE_STATISTICS_INTERVAL =
+  static constexpr size_t MAX_QUEUED_WORK_ITEMS = 8;
+  WorkItemQueue m_work_queue{MAX_QUEUED_WORK_ITEMS};
+  // Channel scan / analyze, see WorkItem::Type::LONG_RUNNING
+  std::unique_ptr<std::thread> m_long_running_work_thread;
+  // Set while the long running item executes - the worker thread doesn't touch
+  // the card(s) / settings in the meantime
+  std::atomic_bool m_long_running_work_active = false;
+  // Timed tasks of the worker thread
+  // Ground refreshes at 10Hz for the OSD - cheap, since publishing the stats
+  // is lock-free (see LinkActionHandler::update_link_stats)
+  static constexpr auto AIR_RECALCULATE_STATISTICS_INTERVAL =
       std::chrono::milliseconds(500);
-  std::chrono::steady_clock::time_point m_last_stats_recalculation =
-      std::chrono::steady_clock::now();
+  static constexpr auto GND_RECALCULATE_STATISTICS_INTERVAL =
+      std::chrono::milliseconds(100);
+  // FEC / rate adjustment, ground channel management
+  static constexpr auto LINK_CONTROL_INTERVAL = std::chrono::milliseconds(100);
+  // Thermal protection, hotspot timeout
+  static constexpr auto SLOW_TASKS_INTERVAL = std::chrono::seconds(1);
+  openhd::util::IntervalTimer m_stats_timer{
+      m_profile.is_air ? AIR_RECALCULATE_STATISTICS_INTERVAL
+                       : GND_RECALCULATE_STATISTICS_INTERVAL};
+  openhd::util::IntervalTimer m_link_control_timer{LINK_CONTROL_INTERVAL};
+  openhd::util::IntervalTimer m_slow_tasks_timer{SLOW_TASKS_INTERVAL};
+  // FragmentPool usage and the copy into WBStreamTx's std::vector fragments
+  // (air only, logged only if there was video)
+  static constexpr auto POOL_STATS_LOG_INTERVAL = std::chrono::seconds(10);
+  openhd::util::IntervalTimer m_pool_stats_log_timer{POOL_STATS_LOG_INTERVAL};
+  std::atomic<uint64_t> m_n_video_fragments_gathered = 0;
+  uint64_t m_n_video_fragments_gathered_last_log = 0;
+  // Run the FEC / rate adjustment now instead of waiting for the timer
+  std::atomic_bool m_link_control_now = false;
+  // 0 = normal, 1 = channel scan, 2 = channel analyze (ground)
+  std::atomic<uint8_t> m_gnd_operating_mode = 0;
   std::atomic<int> m_max_total_rate_for_current_wifi_config_kbits = 0;
   std::atomic<int> m_max_video_rate_for_current_wifi_fec_config = 0;
   // Whenever the frequency has been changed, we reset tx errors and start new
   bool m_rate_adjustment_frequency_changed = false;
-  // bitrate we recommend to the encoder / camera(s)
-  int m_recommended_video_bitrate_kbits = 0;
+  // bitrate we recommend to the encoder / camera(s), before platform limits
+  std::atomic<int> m_recommended_video_bitrate_kbits = 0;
+  // Rate control (congestion controller) thread, only on air
+  static constexpr auto RATE_CONTROL_INTERVAL = std::chrono::milliseconds(20);
+  std::unique_ptr<std::thread> m_rate_control_thread;
+  // Incremented by the work thread whenever the rate for the current wifi
+  // config has been re-calculated, restarts the controller
+  std::atomic<int> m_rate_control_generation = 0;
+  // Only accessed by the rate control thread
+  openhd::wb::TxPressureRateController m_rate_controller;
+  int m_rate_controller_generation = -1;
+  // Written if GEN_RATE_CONTROL_TRACE is set, input for test_rate_controller
+  static constexpr auto RATE_CONTROL_TRACE_FILENAME =
+      "/tmp/openhd_rate_control_trace.csv";
+  std::unique_ptr<openhd::TraceFile> m_rate_control_trace;
   std::atomic<int> m_last_announced_bitrate_kbits = -1;
   std::atomic<int> m_curr_n_rate_adjustments = 0;
   // Set to true when armed, disarmed by default
@@ -266,14 +352,12 @@ class WBLink : public OHDLink {
  private:
   openhd::wb::ForeignPacketsHelper m_foreign_p_helper;
   openhd::wb::RCChannelHelper m_rc_channel_helper;
-  openhd::wb::FrameDropsHelper m_frame_drop_helper;
   std::atomic_int m_primary_total_dropped_frames = 0;
   std::atomic_int m_secondary_total_dropped_frames = 0;
 
  private:
   const bool DIRTY_forward_gapped_fragments = false;
   const bool DIRTY_add_aud_nal = false;
-  const int DIRTY_emulate_drop_mode = 0;
 
  private:
   const std::chrono::steady_clock::time_point m_wb_link_start_ts =
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_ADAPTIVE_FEC_H_
+#define OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_ADAPTIVE_FEC_H_
+
+#include <cstdint>
+#include <string>
+
+namespace openhd::wb {
+
+/**
+ * Closed-loop FEC controller for one video stream, runs on the air unit.
+ * Input are the FEC counters and the packet loss the ground unit reports over
+ * the telemetry link, output is the FEC overhead and the max FEC block length
+ * the air unit should use for this stream.
+ * - Lost (unrecoverable) blocks: the overhead goes up right away, and so does
+ *   the block length (longer blocks spread the FEC packets over a longer time,
+ *   which helps against bursts).
+ * - The overhead only goes down again after HOLD_REPORTS consecutive clean
+ *   reports, one step at a time and never below what the reported packet loss
+ *   needs. The block length follows (less latency, less FEC CPU per block).
+ *   Nothing goes down while most blocks still need recovery.
+ * Not thread-safe, driven by the wb_link worker thread.
+ */
+class AdaptiveFecController {
+ public:
+  struct Limits {
+    int min_fec_percentage = 5;
+    int max_fec_percentage = 100;
+    int min_block_size = 8;
+    int max_block_size = 20;
+  };
+  // Counters are cumulative (as reported by the ground), the packet loss is
+  // the current value.
+  struct GroundReport {
+    uint32_t count_blocks_total = 0;
+    uint32_t count_blocks_lost = 0;
+    uint32_t count_blocks_recovered = 0;
+    uint32_t count_fragments_recovered = 0;
+    int packet_loss_perc = 0;
+  };
+  AdaptiveFecController(Limits limits, int initial_fec_percentage);
+  // Returns true if the fec percentage and/or the block size changed
+  bool on_ground_report(const GroundReport& report);
+  int get_fec_percentage() const { return m_fec_percentage; }
+  int get_max_block_size() const { return m_block_size; }
+  const Limits& get_limits() const { return m_limits; }
+  // FEC overhead needed to fix up the given (random) packet loss, with some
+  // headroom for the variance per block.
+  static int fec_percentage_for_packet_loss(int packet_loss_perc);
+  std::string to_string() const;
+
+  // Don't make a decision on fewer blocks
+  static constexpr uint32_t MIN_BLOCKS_PER_DECISION = 20;
+  // N of consecutive clean reports before the overhead is decreased
+  static constexpr int HOLD_REPORTS = 10;
+  static constexpr int STEP_UP_PERCENTAGE = 10;
+  static constexpr int STEP_DOWN_PERCENTAGE = 5;
+  // If more than this many blocks needed recovery, we are close to the
+  // capacity of the current overhead and never decrease it.
+  static constexpr int MAX_RECOVERED_BLOCKS_PERC_FOR_DECREASE = 50;
+
+ private:
+  void increase(int needed_fec_percentage, bool lost_blocks);
+  void decrease(int needed_fec_percentage);
+  const Limits m_limits;
+  int m_fec_percentage;
+  int m_block_size;
+  bool m_has_baseline = false;
+  GroundReport m_baseline{};
+  int m_n_clean_reports = 0;
+  // Reports lag behind - the first report after an increase might still
+  // contain losses from before the increase.
+  bool m_cooldown = false;
+};
+
+}  // namespace openhd::wb
+
+#endif  // OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_ADAPTIVE_FEC_H_
@@ -31,6 +31,7 @@
 #include "TimeHelper.hpp"
 #include "openhd_spdlog.h"
 #include "wb_link_settings.h"
+#include "wifi_nl80211.h"
 
 /**
  * The wb_link class is becoming a bit big and therefore hard to read.
@@ -71,13 +72,16 @@ bool any_card_support_frequency(
     uint32_t frequency, const std::vector<WiFiCard>& m_broadcast_cards,
     const std::shared_ptr<spdlog::logger>& m_console);
 
+// nl80211: if given, used instead of forking iw (see wifi_nl80211.h)
 bool set_frequency_and_channel_width_for_all_cards(
     uint32_t frequency, uint32_t channel_width,
-    const std::vector<WiFiCard>& m_broadcast_cards);
+    const std::vector<WiFiCard>& m_broadcast_cards,
+    wifi::nl80211::ChannelControl* nl80211 = nullptr);
 
-void set_tx_power_for_all_cards(int tx_power_mw,
-                                int rtl8812au_tx_power_index_override,
-                                const std::vector<WiFiCard>& m_broadcast_cards);
+void set_tx_power_for_all_cards(
+    int tx_power_mw, int rtl8812au_tx_power_index_override,
+    const std::vector<WiFiCard>& m_broadcast_cards,
+    wifi::nl80211::ChannelControl* nl80211 = nullptr);
 
 // WB takes a list of card device names
 std::vector<std::string> get_card_names(const std::vector<WiFiCard>& cards);
@@ -180,63 +184,6 @@ class RCChannelHelper {
   std::mutex m_rc_channels_mutex;
 };
 
-class FrameDropsHelper {
- public:
-  // Thread-safe, aka can be called from the thread injecting frame(s) in
-  // reference to the wb_link worker thread
-  void notify_dropped_frame(int n_dropped = 1) {
-    m_frame_drop_counter += n_dropped;
-  }
-  // Thread-safe as long as it is called from the thread performing management
-  bool needs_bitrate_reduction() {
-    if (m_opt_no_error_delay.has_value()) {
-      if (std::chrono::steady_clock::now() >= m_opt_no_error_delay) {
-        const auto elapsed = std::chrono::steady_clock::now() - m_last_check;
-        m_last_check = std::chrono::steady_clock::now();
-        const int dropped_since_last_check = m_frame_drop_counter.exchange(0);
-        m_console->debug(
-            "Dropped {} frames in {} during adjust period (no bitrate "
-            "reduction)",
-            dropped_since_last_check, MyTimeHelper::R(elapsed));
-        m_opt_no_error_delay = std::nullopt;
-      }
-      return false;
-    }
-    const auto elapsed = std::chrono::steady_clock::now() - m_last_check;
-    if (elapsed >= std::chrono::seconds(3)) {
-      m_last_check = std::chrono::steady_clock::now();
-      const int dropped_since_last_check = m_frame_drop_counter.exchange(0);
-      static constexpr int MAX_DROPPED_FRAMES_ALLOWED = 3;
-      if (dropped_since_last_check > MAX_DROPPED_FRAMES_ALLOWED) {
-        m_console->debug("Dropped {} frames during {} delta period",
-                         dropped_since_last_check, MyTimeHelper::R(elapsed));
-        return true;
-      }
-    }
-    return false;
-  }
-  void set_console(std::shared_ptr<spdlog::logger> console) {
-    m_console = std::move(console);
-  }
-  // Every time we change the bitrate, it might take some time until the camera
-  // reacts (TODO: Define a minumum allowed variance for openhd supported
-  // cameras)
-  // - this results in dropped frame(s) during this period not being reported as
-  // an error (Such that we don't do any rate reduction while the encoder is
-  // still reacting to the newly set bitrate)
-  void delay_for(std::chrono::milliseconds delay) {
-    m_opt_no_error_delay = std::chrono::steady_clock::now() + delay;
-  }
-
- private:
-  std::shared_ptr<spdlog::logger> m_console;
-  std::chrono::steady_clock::time_point m_last_check =
-      std::chrono::steady_clock::now();
-  std::atomic_int m_frame_drop_counter = 0;
-  std::optional<std::chrono::steady_clock::time_point> m_opt_no_error_delay =
-      std::nullopt;
-};
-
 class PollutionHelper {
  public:
  private:
@@ -24,6 +24,8 @@
 #ifndef OPENHD_WBLINKMANAGER_H
 #define OPENHD_WBLINKMANAGER_H
 
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -87,6 +89,14 @@ class ManagementGround {
  public:
   std::atomic<int> m_air_reported_curr_frequency = -1;
   std::atomic<int> m_air_reported_curr_channel_width = -1;
+  // Same as above, but per card that received the management frame - during
+  // a parallel channel scan each card listens on a different channel.
+  static constexpr int MAX_N_CARDS = 4;
+  std::array<std::atomic<int>, MAX_N_CARDS> m_air_reported_frequency_per_card{};
+  std::array<std::atomic<int>, MAX_N_CARDS>
+      m_air_reported_channel_width_per_card{};
+  // Sets all the air reported values above to -1
+  void reset_air_reports();
   int get_last_received_packet_ts_ms();
 
  private:
@@ -97,7 +107,8 @@ class ManagementGround {
   std::unique_ptr<std::thread> m_tx_thread;
   std::atomic<int> m_last_received_packet_timestamp_ms = 0;
   // 40Mhz / 20Mhz link management
-  void on_new_management_packet(const uint8_t *data, int data_len);
+  void on_new_management_packet(const uint8_t *data, int data_len,
+                                int wlan_index);
 };
 
 #endif  // OPENHD_WBLINKMANAGER_H
@@ -0,0 +1,129 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_RATE_CONTROLLER_H_
+#define OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_RATE_CONTROLLER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace openhd::wb {
+
+/**
+ * Congestion controller for the video bitrate (AIMD), runs on the air unit.
+ * The upper limit (ceiling) is the theoretical rate for the current wifi
+ * config (see calculate_bitrate_for_wifi_config_kbits). The controller lowers
+ * the bitrate recommended to the encoder when the tx path shows pressure:
+ * - severe: tx queue overflow, aka dropped frames or packets dropped by the
+ *   card: multiplicative decrease by SEVERE_DECREASE_PERC.
+ * - mild: the video tx queue stays (mostly) full, blocks wait too long until
+ *   they are injected or the driver reports injection errors: multiplicative
+ *   decrease by MILD_DECREASE_PERC.
+ * A decrease is followed by a hold-off, since the encoder needs some time to
+ * react. After a while without any pressure, the rate increases again
+ * additively, up to the ceiling.
+ * Not thread-safe, driven by the wb_link rate control thread (or the replay
+ * harness).
+ */
+class TxPressureRateController {
+ public:
+  // One sample of the tx stats. Counters are cumulative, a counter going
+  // backwards is treated as a reset.
+  struct Sample {
+    // Monotonic time of this sample
+    int64_t time_ms = 0;
+    // Video tx queue (WBStreamTx), in blocks
+    int tx_queue_used = 0;
+    int tx_queue_capacity = 0;
+    // Card (WBTxRx)
+    uint64_t count_tx_dropped_packets = 0;
+    uint64_t count_tx_inj_error_hint = 0;
+    // Frames the video tx queue could not take
+    uint64_t count_dropped_frames = 0;
+    // Time blocks spend in the tx queue until they are injected
+    int block_until_tx_avg_us = 0;
+    int block_until_tx_max_us = 0;
+    // Theoretical max video rate for the current wifi config
+    int ceiling_kbits = 0;
+    // One line for a trace file, see CSV_HEADER
+    std::string to_csv() const;
+    static std::optional<Sample> from_csv(const std::string& line);
+  };
+  static constexpr auto CSV_HEADER =
+      "time_ms,tx_queue_used,tx_queue_capacity,count_tx_dropped_packets,"
+      "count_tx_inj_error_hint,count_dropped_frames,block_until_tx_avg_us,"
+      "block_until_tx_max_us,ceiling_kbits";
+  enum class Pressure { NONE, MILD, SEVERE };
+
+  TxPressureRateController() = default;
+  // Returns the bitrate to recommend to the encoder, in kBit/s. Starts at the
+  // ceiling of the first sample. A lower ceiling limits the bitrate right away,
+  // a higher one is approached by the additive increase.
+  int on_sample(const Sample& sample);
+  int get_bitrate_kbits() const { return m_bitrate_kbits; }
+  // N of decreases since the last (re)start
+  int get_n_decreases() const { return m_n_decreases; }
+  Pressure get_last_pressure() const { return m_last_pressure; }
+  std::string to_string() const;
+
+  // Never recommend less than this (the encoder won't produce a usable image
+  // anymore at some point)
+  static constexpr int MIN_BITRATE_KBITS = 1000 * 2;
+  static constexpr int SEVERE_DECREASE_PERC = 30;
+  static constexpr int MILD_DECREASE_PERC = 10;
+  // Give the encoder time to react after a change
+  static constexpr int64_t HOLD_OFF_AFTER_DECREASE_MS = 500;
+  // Drops right after a (re)start are expected, the encoder is still
+  // adjusting to the new rate
+  static constexpr int64_t GRACE_PERIOD_AFTER_START_MS = 5000;
+  // Time without any pressure before the rate increases again
+  static constexpr int64_t CLEAN_BEFORE_INCREASE_MS = 2000;
+  static constexpr int64_t INCREASE_INTERVAL_MS = 500;
+  // Additive increase, in percent of the ceiling
+  static constexpr int INCREASE_STEP_PERC = 5;
+  // Mild pressure: average queue fill (EWMA, percent) above this
+  static constexpr int QUEUE_FILL_THRESHOLD_PERC = 75;
+  // Mild pressure: blocks wait longer than this on average (~1 frame at 60fps)
+  static constexpr int BLOCK_UNTIL_TX_THRESHOLD_US = 17 * 1000;
+
+ private:
+  Pressure classify(const Sample& sample);
+  void restart(const Sample& sample);
+  bool m_started = false;
+  Sample m_last{};
+  int m_ceiling_kbits = 0;
+  int m_bitrate_kbits = 0;
+  int m_n_decreases = 0;
+  // Queue fill, exponentially weighted, in percent * 100
+  int m_queue_fill_ewma = 0;
+  int64_t m_start_ms = 0;
+  int64_t m_last_decrease_ms = 0;
+  int64_t m_last_pressure_ms = 0;
+  int64_t m_last_increase_ms = 0;
+  Pressure m_last_pressure = Pressure::NONE;
+};
+
+}  // namespace openhd::wb
+
+#endif  // OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_RATE_CONTROLLER_H_
@@ -0,0 +1,89 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_SCAN_H_
+#define OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_SCAN_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Helpers for the (ground) channel scan / channel analyze.
+// With rx diversity the ground has more than one card - instead of hopping
+// all cards together, each card dwells on a different channel at the same
+// time, which divides the time a scan takes by the number of cards.
+// Kept free of any WBTxRx dependency such that it can be simulated, see
+// test_parallel_scan.
+namespace openhd::wb {
+
+// One frequency x channel width combination to listen on
+struct ScanCandidate {
+  uint32_t frequency;
+  int channel;
+  uint16_t channel_width;
+};
+
+// Splits the candidates over the cards. Returns the rounds, each holding the
+// candidate index per card (-1 if a card has nothing to do in this round).
+// Candidates keep their order, e.g. 2 cards and candidates A,B,C give the
+// rounds {A,B} and {C,-1}. A candidate is only given to a card that
+// supports(card_idx, candidate_idx), candidates no card supports are dropped.
+std::vector<std::vector<int>> plan_scan_rounds(
+    int n_candidates, int n_cards,
+    const std::function<bool(int card_idx, int candidate_idx)>& supports);
+
+// What one card saw while dwelling on one candidate
+struct ScanObservation {
+  int card_idx = -1;
+  ScanCandidate candidate{};
+  int64_t n_valid_packets = 0;
+  int packet_loss_perc = -1;  // -1 if unknown
+  int rssi_dbm = -128;
+  // Reported by the air unit via management frames, -1 if none received
+  int air_reported_frequency = -1;
+  int air_reported_channel_width = -1;
+};
+// True if the card received packets from an air unit that reports it is
+// sending on exactly this frequency
+bool is_air_unit_observation(const ScanObservation& observation);
+// Merges what all cards saw in a round - returns the best observation
+// where an air unit was found (lowest loss, then highest rssi), if any.
+std::optional<ScanObservation> pick_best_scan_observation(
+    const std::vector<ScanObservation>& observations);
+
+// How long the card(s) take to hop to the next channel
+struct ScanHopStats {
+  int count = 0;
+  std::chrono::nanoseconds min = std::chrono::nanoseconds::max();
+  std::chrono::nanoseconds max{0};
+  std::chrono::nanoseconds sum{0};
+  void add(std::chrono::nanoseconds hop_duration);
+  std::string to_string() const;
+};
+
+}  // namespace openhd::wb
+
+#endif  // OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_SCAN_H_
@@ -114,6 +114,10 @@ struct WBLinkSettings {
   uint32_t wb_rtl8812au_tx_pwr_idx_override_armed =
       RTL8812AU_TX_POWER_INDEX_ARMED_DISABLED;
   uint32_t wb_video_fec_percentage = DEFAULT_WB_VIDEO_FEC_PERCENTAGE;
+  // Let the air unit adjust the FEC overhead and block length (per video
+  // stream) depending on the FEC stats the ground reports. The FEC percentage
+  // above is then only the starting point.
+  bool wb_video_fec_adaptive = false;
   // decrease this value when there is a lot of pollution on your channel, and
   // you consistently get tx errors even though variable bitrate is working
   // fine. If you set this value to 80% (for example), it reduces the bitrate(s)
@@ -189,6 +193,7 @@ static constexpr auto WB_CHANNEL_WIDTH = "WB_CHANNEL_W";
 static constexpr auto WB_MCS_INDEX = "WB_MCS_INDEX";
 static constexpr auto WB_VIDEO_FEC_BLOCK_LENGTH = "WB_V_FEC_BLK_L";
 static constexpr auto WB_VIDEO_FEC_PERCENTAGE = "WB_V_FEC_PERC";
+static constexpr auto WB_VIDEO_FEC_ADAPTIVE = "WB_V_FEC_ADAPT";
 static constexpr auto WB_VIDEO_RATE_FOR_MCS_ADJUSTMENT_PERC =
     "WB_V_RATE_PERC";  // wb_video_rate_for_mcs_adjustment_percent
 static constexpr auto WB_MAX_FEC_BLOCK_SIZE_FOR_PLATFORM = "WB_MAX_D_BZ";
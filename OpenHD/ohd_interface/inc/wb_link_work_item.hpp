@@ -26,11 +26,33 @@
 #ifndef OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_WORK_ITEM_H_
 #define OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_WORK_ITEM_H_
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "openhd_util_timer.h"
+
 // I took this pattern from MAVSDK.
 // A work item refers to some task that is queued up for a worker thread to
 // handle
 class WorkItem {
  public:
+  enum class Type {
+    // Quick (e.g. store a setting and request it to be applied), never
+    // rejected because something else is going on.
+    SHORT,
+    // Changes the frequency / channel width of the card(s). Only one
+    // exclusive or long running item can be queued / in progress at a time.
+    EXCLUSIVE,
+    // Like EXCLUSIVE, but takes seconds to minutes (channel scan / analyze).
+    // Runs on its own thread, such that the worker thread keeps going.
+    LONG_RUNNING
+  };
   /**
    * @param work lambda - the work to perform
    * @param earliest_execution_time earliest time point this work item should be
@@ -38,19 +60,103 @@ class WorkItem {
    */
   explicit WorkItem(
       std::string tag, std::function<void()> work,
-      std::chrono::steady_clock::time_point earliest_execution_time)
+      std::chrono::steady_clock::time_point earliest_execution_time,
+      Type type = Type::SHORT)
       : TAG(std::move(tag)),
+        TYPE(type),
         m_earliest_execution_time(earliest_execution_time),
         m_work(std::move(work)) {}
   void execute() { m_work(); }
   bool ready_to_be_executed() {
     return std::chrono::steady_clock::now() >= m_earliest_execution_time;
   }
+  [[nodiscard]] std::chrono::steady_clock::time_point
+  get_earliest_execution_time() const {
+    return m_earliest_execution_time;
+  }
+  [[nodiscard]] bool is_exclusive() const { return TYPE != Type::SHORT; }
   const std::string TAG;
+  const Type TYPE;
 
  private:
   const std::chrono::steady_clock::time_point m_earliest_execution_time;
   const std::function<void()> m_work;
 };
 
+/**
+ * Bounded queue of work items for the wb_link worker thread, which sleeps on it
+ * until the next item is ready, the next timed task is due or someone calls
+ * notify() (e.g. the arming state changed and the tx power needs to be
+ * applied right away). Short items are handed out before exclusive ones, in
+ * order of submission otherwise. All methods are thread-safe.
+ */
+class WorkItemQueue {
+ public:
+  explicit WorkItemQueue(size_t max_size) : m_max_size(max_size) {}
+  // Returns false (and the item is not added) if the queue is full or if the
+  // item is exclusive and another exclusive item is queued or in progress.
+  bool try_push(std::shared_ptr<WorkItem> item) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_items.size() >= m_max_size) return false;
+      if (item->is_exclusive()) {
+        if (m_exclusive_in_progress) return false;
+        m_exclusive_in_progress = true;
+      }
+      m_items.push_back(std::move(item));
+    }
+    m_wakeup.notify();
+    return true;
+  }
+  // Returns the next item that is ready to be executed, nullptr if there is
+  // none.
+  std::shared_ptr<WorkItem> try_pop_ready() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const auto now = std::chrono::steady_clock::now();
+    auto best = m_items.end();
+    for (auto it = m_items.begin(); it != m_items.end(); ++it) {
+      if ((*it)->get_earliest_execution_time() > now) continue;
+      if (!(*it)->is_exclusive()) {
+        best = it;
+        break;
+      }
+      if (best == m_items.end()) best = it;
+    }
+    if (best == m_items.end()) return nullptr;
+    auto ret = *best;
+    m_items.erase(best);
+    return ret;
+  }
+  // Must be called once an exclusive item has been executed
+  void on_exclusive_done() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_exclusive_in_progress = false;
+  }
+  bool is_exclusive_in_progress() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_exclusive_in_progress;
+  }
+  // Wakes up wait_until() as soon as possible
+  void notify() { m_wakeup.notify(); }
+  // Returns once the deadline or the execution time of a queued item is
+  // reached, or notify() has been called
+  void wait_until(std::chrono::steady_clock::time_point deadline) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      for (const auto& item : m_items) {
+        deadline = std::min(deadline, item->get_earliest_execution_time());
+      }
+    }
+    // An item pushed in between has notified, we don't miss it
+    m_wakeup.wait_until(deadline);
+  }
+
+ private:
+  const size_t m_max_size;
+  std::mutex m_mutex;
+  std::deque<std::shared_ptr<WorkItem>> m_items;
+  bool m_exclusive_in_progress = false;
+  openhd::util::WakeupSignal m_wakeup;
+};
+
 #endif  // OPENHD_OPENHD_OHD_INTERFACE_INC_WB_LINK_WORK_ITEM_H_
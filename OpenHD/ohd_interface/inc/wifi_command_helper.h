@@ -30,6 +30,7 @@
 #include <vector>
 
 #include "wifi_card.h"
+#include "wifi_nl80211.h"
 
 // NOTE:
 // All those iw commands use netlink to talk to linux - we could theoretically
@@ -37,6 +38,9 @@
 // bit more compile-time safety but I don't think that's worth it - it would be
 // one more stack we need to test, and those commands used here are pretty much
 // guaranteed to be available on every linux system.
+// Exception: frequency and tx power changes, which are done often (channel
+// scan) and therefore go through a persistent nl80211 socket if one is given
+// (see wifi_nl80211.h), with iw as fallback.
 namespace wifi::commandhelper {
 
 // needed for enabling monitor mode
@@ -76,6 +80,15 @@ bool iw_set_frequency_and_channel_width2(const std::string& device,
 //		Specify transmit power level and setting type.
 bool iw_set_tx_power(const std::string& device, uint32_t tx_power_mBm);
 
+// Same as the iw_ variants, but issued via the given (persistent) nl80211
+// control, which saves the fork + exec of iw. Falls back to iw if nl80211 is
+// nullptr or the request failed.
+bool nl_or_iw_set_frequency_and_channel_width(
+    wifi::nl80211::ChannelControl* nl80211, const std::string& device,
+    uint32_t freq_mhz, uint32_t channel_width, bool ht40_plus = true);
+bool nl_or_iw_set_tx_power(wifi::nl80211::ChannelControl* nl80211,
+                           const std::string& device, uint32_t tx_power_mBm);
+
 // NOTE: so far, no card has been found that supports changing the mcs index in
 // monitor mode via iw - rtl8812bu does it by changing the mcs index in the
 // radiotap header
@@ -120,14 +133,14 @@ bool iw_supports_monitor_mode(int phy_index);
 // Sets the channel and channel width
 // REQUIRES openhd rtl8812au driver
 // BUT works regardless of crda for all channels - YEAH !
-bool openhd_driver_set_frequency_and_channel_width(WiFiCardType type,
-                                                   const std::string& device,
-                                                   uint32_t freq_mhz,
-                                                   uint32_t channel_width);
+bool openhd_driver_set_frequency_and_channel_width(
+    WiFiCardType type, const std::string& device, uint32_t freq_mhz,
+    uint32_t channel_width, wifi::nl80211::ChannelControl* nl80211 = nullptr);
 
 // RTL8812bu driver only so far
-bool openhd_driver_set_tx_power(WiFiCardType type, const std::string& device,
-                                uint32_t tx_power_mBm);
+bool openhd_driver_set_tx_power(
+    WiFiCardType type, const std::string& device, uint32_t tx_power_mBm,
+    wifi::nl80211::ChannelControl* nl80211 = nullptr);
 // RTL8812au driver only
 void openhd_driver_set_tx_power_index_override(const std::string& device,
                                                uint32_t tpi);
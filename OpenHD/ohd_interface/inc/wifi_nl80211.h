@@ -0,0 +1,119 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_INTERFACE_INC_WIFI_NL80211_H_
+#define OPENHD_OPENHD_OHD_INTERFACE_INC_WIFI_NL80211_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Frequency / channel width and tx power changes without forking iw.
+// iw itself does nothing more than sending one nl80211 message per command -
+// but fork + exec + libnl setup + family lookup costs us tens of milliseconds
+// per call on the pi, which adds up quickly during a channel scan.
+namespace wifi::nl80211 {
+
+// What the kernel calls a chandef - frequency, width (as nl80211 enum) and
+// center frequency, plus the legacy channel type for 20/40Mhz (which some of
+// the rtl drivers still look at).
+struct ChannelDefinition {
+  uint32_t control_freq_mhz;
+  uint32_t nl_channel_width;  // enum nl80211_chan_width
+  uint32_t center_freq1_mhz;
+  std::optional<uint32_t> nl_channel_type;  // enum nl80211_channel_type
+};
+// Same mapping iw does for
+// "set freq <freq> [5MHz|10MHz|HT20|HT40+|HT40-|80MHz]".
+// Unknown channel widths are treated as 20Mhz (like the iw path does).
+// Returns std::nullopt if there is no valid 80Mhz channel for the given freq.
+std::optional<ChannelDefinition> make_channel_definition(uint32_t freq_mhz,
+                                                         uint32_t channel_width,
+                                                         bool ht40_plus);
+
+// Interface such that the wb link doesn't care whether it talks to the
+// kernel or to a fake (see test_nl80211_control).
+// All methods return false if the request failed - the caller is expected to
+// fall back to iw in this case.
+class ChannelControl {
+ public:
+  virtual ~ChannelControl() = default;
+  // channel_width: 5,10,20,40 or 80 Mhz, ht40_plus is only used for 40Mhz
+  virtual bool set_frequency_and_channel_width(const std::string& device,
+                                               uint32_t freq_mhz,
+                                               uint32_t channel_width,
+                                               bool ht40_plus) = 0;
+  // Same (weird) mBm semantics as iw_set_tx_power
+  virtual bool set_tx_power(const std::string& device,
+                            uint32_t tx_power_mBm) = 0;
+};
+
+// Talks to nl80211 via one generic netlink socket that stays open for the
+// lifetime of this object. The nl80211 family id and the ifindex of each card
+// are resolved once and then cached, a channel change is a single send / ack
+// round trip. Uses the plain kernel netlink api (libnl is not linked in).
+// Thread safe (the channel scan and the worker might both use it).
+class NetlinkChannelControl : public ChannelControl {
+ public:
+  NetlinkChannelControl();
+  ~NetlinkChannelControl() override;
+  NetlinkChannelControl(const NetlinkChannelControl&) = delete;
+  NetlinkChannelControl& operator=(const NetlinkChannelControl&) = delete;
+  bool set_frequency_and_channel_width(const std::string& device,
+                                       uint32_t freq_mhz,
+                                       uint32_t channel_width,
+                                       bool ht40_plus) override;
+  bool set_tx_power(const std::string& device, uint32_t tx_power_mBm) override;
+
+ private:
+  class Request;
+  // Opens the socket and resolves the nl80211 family id, if not done yet.
+  bool ensure_open();
+  void close_socket();
+  std::optional<uint32_t> get_ifindex(const std::string& device);
+  // Sends the request and waits for the matching ack.
+  // Returns 0 on success, -errno otherwise.
+  int transact(Request& request, uint16_t* out_family_id = nullptr);
+  // Performs a nl80211 SET_WIPHY for the given device, logs on failure
+  bool set_wiphy(const std::string& device, const char* what,
+                 const std::vector<std::pair<uint16_t, uint32_t>>& attrs);
+
+ private:
+  std::mutex m_mutex;
+  int m_fd = -1;
+  uint16_t m_family_id = 0;
+  uint32_t m_seq = 0;
+  std::map<std::string, uint32_t> m_ifindex_cache;
+  std::vector<uint8_t> m_rx_buffer;
+};
+
+// Returns a control that talks to the kernel.
+std::unique_ptr<ChannelControl> create_channel_control();
+
+}  // namespace wifi::nl80211
+
+#endif  // OPENHD_OPENHD_OHD_INTERFACE_INC_WIFI_NL80211_H_
@@ -103,10 +103,21 @@ void EthernetLink::initialize_air_unit() {
 
 void EthernetLink::initialize_ground_unit() {
   // Initialize video receiver for receiving video from the air unit
+  // A video frame arrives as a burst of fragments - drain it with recvmmsg
+  openhd::UDPReceiver::BatchConfig video_rx_config{};
+  video_rx_config.max_n_packets = 64;
+  video_rx_config.max_packet_size = 4096;
+  video_rx_config.rcvbuf_size = 2 * 1024 * 1024;
   m_video_rx = std::make_unique<openhd::UDPReceiver>(
-      "0.0.0.0", VIDEO_PORT, [this](const uint8_t* data, std::size_t len) {
-        handle_video_data(0, data, len);  // Process incoming video
-      });
+      "0.0.0.0", VIDEO_PORT,
+      [this](const openhd::UDPReceiver::ReceivedPacket* packets,
+             std::size_t n_packets) {
+        for (std::size_t i = 0; i < n_packets; i++) {
+          // Process incoming video
+          handle_video_data(0, packets[i].data, (int)packets[i].size);
+        }
+      },
+      video_rx_config);
 
   // Initialize telemetry transmitter and receiver for bidirectional telemetry
   m_telemetry_tx =
@@ -135,7 +146,9 @@ void EthernetLink::transmit_video_data(
   // Send video data fragments to the destination
   if (m_video_tx) {
     for (const auto& fragment : fragmented_video_frame.rtp_fragments) {
-      m_video_tx->forwardPacketViaUDP(fragment->data(), fragment->size());
+      struct iovec spans[openhd::VideoFragment::MAX_N_SPANS];
+      const int n_spans = fragment.get_spans(spans);
+      m_video_tx->forwardPacketViaUDP(spans, n_spans);
     }
   }
 }
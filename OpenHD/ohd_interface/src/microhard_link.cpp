@@ -438,11 +438,20 @@ MicrohardLink::MicrohardLink(OHDProfile profile) : m_profile(profile) {
     m_telemetry_tx_rx = std::make_unique<openhd::UDPReceiver>(
         DEVICE_IP_AIR, MICROHARD_UDP_PORT_TELEMETRY_AIR_TX, cb_telemetry_rx);
   } else {
-    auto cb_video_rx = [this](const uint8_t* payload, std::size_t payloadSize) {
-      on_receive_video_data(0, payload, payloadSize);
-    };
+    auto cb_video_rx =
+        [this](const openhd::UDPReceiver::ReceivedPacket* packets,
+               std::size_t n_packets) {
+          for (std::size_t i = 0; i < n_packets; i++) {
+            on_receive_video_data(0, packets[i].data, packets[i].size);
+          }
+        };
+    openhd::UDPReceiver::BatchConfig video_rx_config{};
+    video_rx_config.max_n_packets = 64;
+    video_rx_config.max_packet_size = 4096;
+    video_rx_config.rcvbuf_size = 2 * 1024 * 1024;
     m_video_rx = std::make_unique<openhd::UDPReceiver>(
-        DEVICE_IP_GND, MICROHARD_UDP_PORT_VIDEO_AIR_TX, cb_video_rx);
+        DEVICE_IP_GND, MICROHARD_UDP_PORT_VIDEO_AIR_TX, cb_video_rx,
+        video_rx_config);
 
     auto cb_telemetry_rx = [this](const uint8_t* data, std::size_t data_len) {
       auto shared =
@@ -484,7 +493,9 @@ void MicrohardLink::transmit_video_data(
   assert(m_profile.is_air);
   if (stream_index == 0) {
     for (const auto& fragment : fragmented_video_frame.rtp_fragments) {
-      m_video_tx->forwardPacketViaUDP(fragment->data(), fragment->size());
+      struct iovec spans[openhd::VideoFragment::MAX_N_SPANS];
+      const int n_spans = fragment.get_spans(spans);
+      m_video_tx->forwardPacketViaUDP(spans, n_spans);
     }
   }
 }
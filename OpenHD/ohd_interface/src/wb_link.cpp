@@ -26,13 +26,16 @@
 #include "wifi_command_helper.h"
 // #include "wifi_command_helper2.h"
 
+#include <algorithm>
 #include <iostream>
 #include <utility>
 
 #include "config_paths.h"
 #include "openhd_bitrate.h"
 #include "openhd_config.h"
+#include "openhd_fragment_pool.h"
 #include "openhd_global_constants.hpp"
+#include "openhd_latency_trace.h"
 #include "openhd_platform.h"
 #include "openhd_reboot_util.h"
 #include "openhd_spdlog.h"
@@ -52,7 +55,6 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
           get_fec_max_block_size_for_platform()) {
   m_console = openhd::log::create_or_get("wb_streams");
   assert(m_console);
-  m_frame_drop_helper.set_console(m_console);
   m_console->info("Broadcast cards:{}", debug_cards(m_broadcast_cards));
   // sanity checks
   if (m_broadcast_cards.empty() ||
@@ -67,6 +69,7 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
   // this fetches the last settings, otherwise creates default ones
   m_settings = std::make_unique<openhd::WBLinkSettingsHolder>(
       m_profile, m_broadcast_cards);
+  m_nl80211 = wifi::nl80211::create_channel_control();
   WBTxRx::Options txrx_options{};
   txrx_options.session_key_packet_interval = SESSION_KEY_PACKETS_INTERVAL;
   txrx_options.use_gnd_identifier = m_profile.is_ground();
@@ -160,7 +163,8 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
   };
   auto dummy = m_wb_txrx->get_dummy_link();
   if (dummy) {
-    dummy->set_drop_mode(DIRTY_emulate_drop_mode);
+    dummy->set_drop_mode(
+        openhd::load_config().WIFI_MONITOR_CARD_EMULATE_DROP_MODE);
   }
   {
     // Setup the tx & rx instances for telemetry. Telemetry is bidirectional,aka
@@ -206,7 +210,7 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
       // bitrate overshoot
       // TODO: In ohd_video,  differentiate between "frame" and NALU (nalu can
       // also be config data) such that we can make this queue smaller.
-      options_video_tx.block_data_queue_size = 2;
+      options_video_tx.block_data_queue_size = VIDEO_TX_BLOCK_QUEUE_SIZE;
       options_video_tx.radio_port = openhd::VIDEO_PRIMARY_RADIO_PORT;
       auto primary = std::make_unique<WBStreamTx>(m_wb_txrx, options_video_tx,
                                                   m_tx_header_1);
@@ -292,9 +296,25 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
     m_management_air->m_tx_header = m_tx_header_2;
     m_management_air->start();
   }
+  for (int i = 0; i < 2; i++) {
+    m_video_fec_percentage[i] =
+        (int)m_settings->get_settings().wb_video_fec_percentage;
+    m_video_max_fec_block_size[i] = get_max_fec_block_size();
+  }
   m_wb_txrx->start_receiving();
   m_work_thread_run = true;
   m_work_thread = std::make_unique<std::thread>(&WBLink::loop_do_work, this);
+  if (m_profile.is_air) {
+    if (openhd::load_config().GEN_RATE_CONTROL_TRACE) {
+      m_rate_control_trace = std::make_unique<openhd::TraceFile>(
+          RATE_CONTROL_TRACE_FILENAME,
+          openhd::wb::TxPressureRateController::CSV_HEADER);
+      m_console->info("Writing rate control trace to {}",
+                      RATE_CONTROL_TRACE_FILENAME);
+    }
+    m_rate_control_thread =
+        std::make_unique<std::thread>(&WBLink::loop_rate_control, this);
+  }
   std::function<bool(openhd::LinkActionHandler::ScanChannelsParam)> cb_scan =
       [this](openhd::LinkActionHandler::ScanChannelsParam param) {
         return request_start_scan_channels(param);
@@ -308,6 +328,11 @@ WBLink::WBLink(OHDProfile profile, std::vector<WiFiCard> broadcast_cards)
     // MCS is only changed on air
     auto cb_channel = [this](const std::array<int, 18>& rc_channels) {
       m_rc_channel_helper.set_rc_channels(rc_channels);
+      if (m_settings->get_settings().wb_mcs_index_via_rc_channel >
+          openhd::WB_MCS_INDEX_VIA_RC_CHANNEL_OFF) {
+        // Apply a MCS change via RC right away
+        m_work_queue.notify();
+      }
     };
     openhd::FCRcChannelsHelper::instance().action_on_any_rc_channel_register(
         cb_channel);
@@ -334,8 +359,15 @@ WBLink::~WBLink() {
   m_console->debug("WBLink::~WBLink() begin");
   if (m_work_thread) {
     m_work_thread_run = false;
+    m_work_queue.notify();
     m_work_thread->join();
   }
+  if (m_long_running_work_thread) {
+    m_long_running_work_thread->join();
+  }
+  if (m_rate_control_thread) {
+    m_rate_control_thread->join();
+  }
   m_management_air = nullptr;
   m_management_gnd = nullptr;
   openhd::FCRcChannelsHelper::instance().action_on_any_rc_channel_register(
@@ -390,7 +422,7 @@ bool WBLink::request_set_frequency(int frequency) {
         apply_frequency_and_channel_width_from_settings();
         m_rate_adjustment_frequency_changed = true;
       },
-      std::chrono::steady_clock::now());
+      std::chrono::steady_clock::now(), WorkItem::Type::EXCLUSIVE);
   return try_schedule_work_item(work_item);
 }
 
@@ -418,7 +450,7 @@ bool WBLink::request_set_air_tx_channel_width(int channel_width) {
         apply_frequency_and_channel_width_from_settings();
         m_air_close_video_in = false;
       },
-      std::chrono::steady_clock::now());
+      std::chrono::steady_clock::now(), WorkItem::Type::EXCLUSIVE);
   return try_schedule_work_item(work_item);
 }
 
@@ -498,15 +530,41 @@ bool WBLink::set_air_video_fec_percentage(int fec_percentage) {
   if (!openhd::is_valid_fec_percentage(fec_percentage)) return false;
   m_settings->unsafe_get_settings().wb_video_fec_percentage = fec_percentage;
   m_settings->persist();
-  // The next rate adjustment will adjust the bitrate accordingly
+  // Adaptive FEC (if enabled) starts over from the new value
+  m_request_reset_adaptive_fec = true;
+  // The rate adjustment will adjust the bitrate accordingly
+  m_link_control_now = true;
+  m_work_queue.notify();
+  return true;
+}
+bool WBLink::set_air_video_fec_adaptive(int value) {
+  assert(m_profile.is_air);
+  if (!openhd::validate_yes_or_no(value)) return false;
+  m_settings->unsafe_get_settings().wb_video_fec_adaptive = value;
+  m_settings->persist();
+  m_link_control_now = true;
+  m_work_queue.notify();
   return true;
 }
 bool WBLink::set_air_enable_wb_video_variable_bitrate(int value) {
   assert(m_profile.is_air);
   if (!openhd::validate_yes_or_no(value)) return false;
-  // value is read in regular intervals.
+  const bool changed =
+      m_settings->get_settings().enable_wb_video_variable_bitrate != value;
   m_settings->unsafe_get_settings().enable_wb_video_variable_bitrate = value;
   m_settings->persist();
+  if (changed) {
+    // Disabled: the work thread no longer (re-)announces the bitrate, don't
+    // leave the encoder at a reduced value. Enabled: don't continue from the
+    // state before it was disabled.
+    reset_rate_control();
+    const int bitrate = m_recommended_video_bitrate_kbits;
+    if (bitrate > 0) {
+      recommend_bitrate_to_encoder(apply_platform_bitrate_limits(bitrate));
+    }
+  }
+  m_link_control_now = true;
+  m_work_queue.notify();
   return true;
 }
 
@@ -539,7 +597,7 @@ bool WBLink::request_start_scan_channels(
       [this, scan_channels_params]() {
         perform_channel_scan(scan_channels_params);
       },
-      std::chrono::steady_clock::now());
+      std::chrono::steady_clock::now(), WorkItem::Type::LONG_RUNNING);
   return try_schedule_work_item(work_item);
 }
 
@@ -547,7 +605,7 @@ bool WBLink::request_start_analyze_channels(int channels_to_scan) {
   auto work_item = std::make_shared<WorkItem>(
       "ANALYZE_CHANNELS",
       [this, channels_to_scan]() { perform_channel_analyze(channels_to_scan); },
-      std::chrono::steady_clock::now());
+      std::chrono::steady_clock::now(), WorkItem::Type::LONG_RUNNING);
   return try_schedule_work_item(work_item);
 }
 
@@ -561,8 +619,12 @@ bool WBLink::apply_frequency_and_channel_width(int frequency,
   m_wb_txrx->set_passive_mode(true);
   std::this_thread::sleep_for(std::chrono::milliseconds(
       100));  // Dirty - wait for any tx packets to drain
+  const auto switch_begin = std::chrono::steady_clock::now();
   const auto res = openhd::wb::set_frequency_and_channel_width_for_all_cards(
-      frequency, channel_width_rx, m_broadcast_cards);
+      frequency, channel_width_rx, m_broadcast_cards, m_nl80211.get());
+  const auto switch_delta = std::chrono::steady_clock::now() - switch_begin;
+  m_console->debug("Changing frequency took {}",
+                   MyTimeHelper::R(switch_delta));
   m_tx_header_1->update_channel_width(channel_width_tx);
   m_wb_txrx->tx_reset_stats();
   m_wb_txrx->rx_reset_stats();
@@ -614,7 +676,8 @@ void WBLink::apply_txpower() {
       pwr_index = 50;
     }
   }
-  openhd::wb::set_tx_power_for_all_cards(pwr_mw, pwr_index, m_broadcast_cards);
+  openhd::wb::set_tx_power_for_all_cards(pwr_mw, pwr_index, m_broadcast_cards,
+                                         m_nl80211.get());
   m_curr_tx_power_mw = pwr_mw;
   m_curr_tx_power_idx = pwr_index;
   const auto delta = std::chrono::steady_clock::now() - before;
@@ -657,6 +720,13 @@ std::vector<openhd::Setting> WBLink::get_all_settings() {
         Setting{WB_VIDEO_FEC_PERCENTAGE,
                 openhd::IntSetting{(int)settings.wb_video_fec_percentage,
                                    cb_change_video_fec_percentage}});
+    auto cb_change_video_fec_adaptive = [this](std::string, int value) {
+      return set_air_video_fec_adaptive(value);
+    };
+    ret.push_back(
+        Setting{WB_VIDEO_FEC_ADAPTIVE,
+                openhd::IntSetting{(int)settings.wb_video_fec_adaptive,
+                                   cb_change_video_fec_adaptive}});
     auto cb_enable_wb_video_variable_bitrate = [this](std::string, int value) {
       return set_air_enable_wb_video_variable_bitrate(value);
     };
@@ -846,33 +916,47 @@ std::vector<openhd::Setting> WBLink::get_all_settings() {
 
 void WBLink::loop_do_work() {
   while (m_work_thread_run) {
-    // Perform any queued up work if it exists
-    {
-      m_work_item_queue_mutex.lock();
-      if (!m_work_item_queue.empty()) {
-        auto front = m_work_item_queue.front();
-        if (front->ready_to_be_executed()) {
-          m_console->debug("Start execute work item {}", front->TAG);
-          front->execute();
-          m_console->debug("Done executing work item {}", front->TAG);
-          m_work_item_queue.pop();
-        }
-      }
-      m_work_item_queue_mutex.unlock();
+    // Perform any queued up work that is ready
+    while (auto work_item = m_work_queue.try_pop_ready()) {
+      wt_execute_work_item(work_item);
     }
+    // A channel scan / analyze owns the card(s) until it is done - tx power
+    // and RC MCS changes stay pending until then (see wt_execute_work_item)
+    const bool long_running_active = m_long_running_work_active;
     // If needed, apply the proper tx power (depending on armed / disarmed
     // state).
     bool tmp_true = true;
-    if (m_request_apply_tx_power.compare_exchange_strong(tmp_true, false)) {
+    if (!long_running_active &&
+        m_request_apply_tx_power.compare_exchange_strong(tmp_true, false)) {
       apply_txpower();
     }
-    wt_perform_mcs_via_rc_channel_if_enabled();
+    if (!long_running_active) {
+      wt_perform_mcs_via_rc_channel_if_enabled();
+    }
     // wt_perform_bw_via_rc_channel_if_enabled();
-    wt_gnd_perform_channel_management();
-    // air_perform_reset_frequency();
-    // Perform thermal protection level calculation before rate adjustment !
-    wt_perform_update_thermal_protection();
-    wt_perform_rate_adjustment();
+    const auto now = std::chrono::steady_clock::now();
+    if (m_slow_tasks_timer.poll(now)) {
+      // Perform thermal protection level calculation before rate adjustment !
+      wt_perform_update_thermal_protection();
+      wt_perform_air_hotspot_after_timeout();
+      if (m_profile.is_air && m_pool_stats_log_timer.poll(now)) {
+        wt_log_fragment_pool_stats();
+      }
+    }
+    // A MCS change needs a new rate right away
+    const bool link_control_now = m_link_control_now.exchange(false) ||
+                                  m_request_apply_air_mcs_index.load();
+    if (m_link_control_timer.poll(now) || link_control_now) {
+      // A frequency change / channel scan in progress sets the frequency
+      // itself
+      if (!m_work_queue.is_exclusive_in_progress()) {
+        wt_gnd_perform_channel_management();
+      }
+      // air_perform_reset_frequency();
+      // FEC first, the rate adjustment deducts the current FEC overhead
+      wt_perform_fec_adjustment();
+      wt_perform_rate_adjustment();
+    }
     //  After we've applied the rate, we update the tx header mcs index if
     //  necessary
     tmp_true = true;
@@ -888,18 +972,60 @@ void WBLink::loop_do_work() {
       apply_frequency_and_channel_width_from_settings();
     }*/
     // update statistics in regular intervals
-    wt_update_statistics();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if (m_stats_timer.poll(now)) {
+      wt_update_statistics();
+    }
+    const auto next_deadline =
+        std::min({m_slow_tasks_timer.next_due(),
+                  m_link_control_timer.next_due(), m_stats_timer.next_due()});
+    m_work_queue.wait_until(next_deadline);
   }
 }
 
-void WBLink::wt_update_statistics() {
-  const auto elapsed_since_last =
-      std::chrono::steady_clock::now() - m_last_stats_recalculation;
-  if (elapsed_since_last < RECALCULATE_STATISTICS_INTERVAL) {
+void WBLink::wt_execute_work_item(const std::shared_ptr<WorkItem>& work_item) {
+  if (work_item->TYPE != WorkItem::Type::LONG_RUNNING) {
+    m_console->debug("Start execute work item {}", work_item->TAG);
+    work_item->execute();
+    m_console->debug("Done executing work item {}", work_item->TAG);
+    if (work_item->is_exclusive()) m_work_queue.on_exclusive_done();
     return;
   }
-  m_last_stats_recalculation = std::chrono::steady_clock::now();
+  // Only one long running item at a time (see WorkItemQueue), the previous
+  // thread has finished already.
+  if (m_long_running_work_thread) {
+    m_long_running_work_thread->join();
+  }
+  m_long_running_work_active = true;
+  m_long_running_work_thread =
+      std::make_unique<std::thread>([this, work_item]() {
+        m_console->debug("Start execute long running work item {}",
+                         work_item->TAG);
+        work_item->execute();
+        m_console->debug("Done executing work item {}", work_item->TAG);
+        m_long_running_work_active = false;
+        m_work_queue.on_exclusive_done();
+        m_work_queue.notify();
+      });
+}
+
+void WBLink::wt_log_fragment_pool_stats() {
+  const uint64_t n_gathered =
+      m_n_video_fragments_gathered.load(std::memory_order_relaxed);
+  const uint64_t n_gathered_delta =
+      n_gathered - m_n_video_fragments_gathered_last_log;
+  if (n_gathered_delta == 0) return;
+  m_n_video_fragments_gathered_last_log = n_gathered;
+  const auto stats = openhd::FragmentPool::instance().get_stats();
+  m_console->debug("{} WB gathered:{} fragments in {}s",
+                   openhd::FragmentPool::stats_to_string(stats),
+                   n_gathered_delta, POOL_STATS_LOG_INTERVAL.count());
+}
+
+void WBLink::wt_update_statistics() {
+  auto& tracer = openhd::latency_trace::LatencyTracer::instance();
+  if (tracer.is_enabled()) {
+    tracer.update();
+  }
   // telemetry is available on both air and ground
   openhd::link_statistics::StatsAirGround stats{};
   if (m_wb_tele_tx) {
@@ -959,13 +1085,20 @@ void WBLink::wt_update_statistics() {
       air_fec.curr_tx_delay_min_us = curr_tx_stats.curr_block_until_tx_min_us;
       air_fec.curr_tx_delay_max_us = curr_tx_stats.curr_block_until_tx_max_us;
       air_fec.curr_tx_delay_avg_us = curr_tx_stats.curr_block_until_tx_avg_us;
-      air_video.curr_fec_percentage =
-          m_settings->unsafe_get_settings().wb_video_fec_percentage;
+      if (tracer.is_enabled()) {
+        using openhd::latency_trace::Stage;
+        // p99 of creation -> enqueued, see openhd_latency_trace.h
+        air_fec.dummy2 =
+            (int32_t)tracer.get_summary(i, Stage::AIR_LINK_ENQUEUE).p99_us;
+      }
+      air_video.curr_fec_percentage = m_video_fec_percentage[i];
       stats.stats_wb_video_air.push_back(air_video);
       if (i == 0) stats.air_fec_performance = air_fec;
     }
   } else {
     // video on ground
+    const int gnd_packet_loss_perc = std::clamp<int>(
+        m_wb_txrx->get_rx_stats().curr_lowest_packet_loss, 0, 100);
     for (int i = 0; i < m_wb_video_rx_list.size(); i++) {
       auto& wb_rx = *m_wb_video_rx_list.at(i);
       const auto wb_rx_stats = wb_rx.get_latest_stats();
@@ -984,12 +1117,21 @@ void WBLink::wt_update_statistics() {
       ground_video.count_blocks_recovered = fec_stats.count_blocks_recovered;
       ground_video.count_blocks_lost = fec_stats.count_blocks_lost;
       ground_video.count_blocks_total = fec_stats.count_blocks_total;
+      // Input for the air adaptive FEC
+      ground_video.dummy0 = (int8_t)gnd_packet_loss_perc;
       gnd_fec.curr_fec_decode_time_avg_us =
           openhd::util::get_micros(fec_stats.curr_fec_decode_time.avg);
       gnd_fec.curr_fec_decode_time_min_us =
           openhd::util::get_micros(fec_stats.curr_fec_decode_time.min);
       gnd_fec.curr_fec_decode_time_max_us =
           openhd::util::get_micros(fec_stats.curr_fec_decode_time.max);
+      if (tracer.is_enabled()) {
+        // End to end (air creation -> ground UDP forward) p99 and p50
+        const auto e2e = tracer.get_summary(
+            i, openhd::latency_trace::Stage::GND_UDP_FORWARD);
+        ground_video.dummy2 = (int32_t)e2e.p99_us;
+        gnd_fec.dummy2 = (int32_t)e2e.p50_us;
+      }
       // TODO otimization: Only send stats for an active link
       stats.stats_wb_video_ground.push_back(ground_video);
       if (i == 0) stats.gnd_fec_performance = gnd_fec;
@@ -1041,7 +1183,7 @@ void WBLink::wt_update_statistics() {
       openhd::link_statistics::write_monitor_link_bitfield(bitfield);
   {
     // Operating mode
-    stats.gnd_operating_mode.operating_mode = 0;
+    stats.gnd_operating_mode.operating_mode = m_gnd_operating_mode;
     stats.gnd_operating_mode.tx_passive_mode_is_enabled =
         curr_settings.wb_enable_listen_only_mode ? 1 : 0;
     stats.gnd_operating_mode.progress = 0;
@@ -1111,6 +1253,48 @@ void WBLink::wt_update_statistics() {
   // chan_width:{}",rxStats.last_received_packet_mcs_index,rxStats.last_received_packet_channel_width);
 }
 
+void WBLink::wt_perform_fec_adjustment() {
+  if (!m_profile.is_air) return;  // Only done on air unit
+  const auto& settings = m_settings->get_settings();
+  const int max_block_size = get_max_fec_block_size();
+  const bool reset = m_request_reset_adaptive_fec.exchange(false);
+  for (int i = 0; i < 2; i++) {
+    auto& controller = m_adaptive_fec[i];
+    if (!settings.wb_video_fec_adaptive) {
+      controller = nullptr;
+      m_video_fec_percentage[i] = (int)settings.wb_video_fec_percentage;
+      m_video_max_fec_block_size[i] = max_block_size;
+      continue;
+    }
+    if (controller == nullptr || reset ||
+        controller->get_limits().max_block_size != max_block_size) {
+      openhd::wb::AdaptiveFecController::Limits limits{};
+      limits.max_block_size = max_block_size;
+      limits.min_block_size = std::min(limits.min_block_size, max_block_size);
+      controller = std::make_unique<openhd::wb::AdaptiveFecController>(
+          limits, (int)settings.wb_video_fec_percentage);
+      m_console->debug("Adaptive FEC {} start {}", i, controller->to_string());
+    }
+    const auto gnd_stats =
+        openhd::LinkActionHandler::instance().get_ground_video_stats(i);
+    if (gnd_stats.n_reports != m_adaptive_fec_last_n_reports[i]) {
+      m_adaptive_fec_last_n_reports[i] = gnd_stats.n_reports;
+      openhd::wb::AdaptiveFecController::GroundReport report{};
+      report.count_blocks_total = gnd_stats.stats.count_blocks_total;
+      report.count_blocks_lost = gnd_stats.stats.count_blocks_lost;
+      report.count_blocks_recovered = gnd_stats.stats.count_blocks_recovered;
+      report.count_fragments_recovered =
+          gnd_stats.stats.count_fragments_recovered;
+      report.packet_loss_perc = gnd_stats.stats.dummy0;
+      if (controller->on_ground_report(report)) {
+        m_console->debug("Adaptive FEC {} {}", i, controller->to_string());
+      }
+    }
+    m_video_fec_percentage[i] = controller->get_fec_percentage();
+    m_video_max_fec_block_size[i] = controller->get_max_block_size();
+  }
+}
+
 void WBLink::wt_perform_rate_adjustment() {
   using namespace openhd::wb;
   if (!m_profile.is_air) return;  // Only done on air unit
@@ -1128,23 +1312,24 @@ void WBLink::wt_perform_rate_adjustment() {
           card, settings.wb_frequency, settings.wb_air_tx_channel_width,
           settings.wb_air_mcs_index,
           settings.wb_video_rate_for_mcs_adjustment_percent, false);
+  const bool wifi_config_changed =
+      m_max_total_rate_for_current_wifi_config_kbits !=
+          max_rate_for_current_wifi_config ||
+      m_rate_adjustment_frequency_changed;
   m_max_total_rate_for_current_wifi_config_kbits =
       max_rate_for_current_wifi_config;
   // Subtract the FEC overhead from (video) bitrate
   const int max_video_rate_for_current_wifi_fec_config =
       openhd::wb::deduce_fec_overhead(max_rate_for_current_wifi_config,
-                                      settings.wb_video_fec_percentage);
+                                      m_video_fec_percentage[0]);
   // const auto stats=m_wb_txrx->get_rx_stats();
   // m_foreign_p_helper.update(stats.count_p_any,stats.count_p_valid);
   // m_console->debug("N foreign packets per second
   // :{}",m_foreign_p_helper.get_foreign_packets_per_second());
   if (m_max_video_rate_for_current_wifi_fec_config !=
           max_video_rate_for_current_wifi_fec_config ||
-      m_rate_adjustment_frequency_changed) {
+      wifi_config_changed) {
     m_rate_adjustment_frequency_changed = false;
-    // Apply the default for this configuration, then return - we will start the
-    // auto-adjustment depending on tx error(s) next time the rate adjustment is
-    // called
     m_console->debug(
         "MCS:{} ch_width:{} Calculated max_rate:{}, max_video_rate:{}",
         settings.wb_air_mcs_index, settings.wb_air_tx_channel_width,
@@ -1153,50 +1338,102 @@ void WBLink::wt_perform_rate_adjustment() {
             max_video_rate_for_current_wifi_fec_config));
     m_max_video_rate_for_current_wifi_fec_config =
         max_video_rate_for_current_wifi_fec_config;
-    m_recommended_video_bitrate_kbits =
-        m_max_video_rate_for_current_wifi_fec_config;
-    m_curr_n_rate_adjustments = 0;
-    recommend_bitrate_to_encoder(m_recommended_video_bitrate_kbits);
-    // We 'give' the camera up to X seconds to adjust to the newly set rate. If
-    // we drop frames during this period, we do not count it as errors that need
-    // bitrate reduction.
-    m_frame_drop_helper.delay_for(std::chrono::seconds(5));
-    m_primary_total_dropped_frames = 0;
-    m_secondary_total_dropped_frames = 0;
-    return;
-  }
-  // const bool
-  // dropping_many_frames=m_frame_drop_helper.needs_bitrate_reduction();
-  const bool dropping_many_frames = false;
-  // m_console->debug("Dropped since last check:{}",dropped_since_last_check);
-  if (dropping_many_frames) {
-    // We are dropping frames / too many tx error hint(s), we need to reduce
-    // bitrate. Reduce video bitrate by 1MBit/s
-    m_recommended_video_bitrate_kbits -= 1000;
-    m_curr_n_rate_adjustments++;
-    // Safety, in case we fall below a certain threshold the encoder won't be
-    // able to produce an image at some point anyways.
-    static constexpr auto MIN_BITRATE_KBITS = 1000 * 2;
-    if (m_recommended_video_bitrate_kbits < MIN_BITRATE_KBITS) {
-      m_console->warn("Reached minimum bitrate {}",
-                      openhd::kbits_per_second_to_string(MIN_BITRATE_KBITS));
-      m_recommended_video_bitrate_kbits = MIN_BITRATE_KBITS;
-      m_curr_n_rate_adjustments--;
+    if (wifi_config_changed) {
+      // Apply the default for this configuration
+      reset_rate_control();
+    } else {
+      // Only the FEC overhead changed (e.g. adaptive FEC), the rate control
+      // thread keeps going with the new limit
+      m_recommended_video_bitrate_kbits =
+          std::min(m_recommended_video_bitrate_kbits.load(),
+                   max_video_rate_for_current_wifi_fec_config);
     }
-    m_console->warn("TX errors, reducing video bitrate to {}",
-                    m_recommended_video_bitrate_kbits);
+    recommend_bitrate_to_encoder(
+        apply_platform_bitrate_limits(m_recommended_video_bitrate_kbits));
+    return;
   }
+  // The rate control thread reduces the bitrate right away, here we just
+  // (re-)announce the current value regularly
+  recommend_bitrate_to_encoder(
+      apply_platform_bitrate_limits(m_recommended_video_bitrate_kbits));
+}
+
+void WBLink::reset_rate_control() {
+  // Until the encoder has adjusted, dropped frames are not counted as errors
+  m_recommended_video_bitrate_kbits =
+      m_max_video_rate_for_current_wifi_fec_config.load();
+  m_curr_n_rate_adjustments = 0;
+  m_primary_total_dropped_frames = 0;
+  m_secondary_total_dropped_frames = 0;
+  m_rate_control_generation++;
+}
+
+int WBLink::apply_platform_bitrate_limits(int video_bitrate_kbits) {
   // Extra x20 - thermal protection
   if (OHDPlatform::instance().is_x20()) {
     const int factor = !m_is_armed ? 50 : 100;
-    const int x20_rate =
-        m_thermal_protection_level > 0
-            ? m_recommended_video_bitrate_kbits * 30 / 100 * factor / 100
-            : m_recommended_video_bitrate_kbits * 70 / 100 * factor / 100;
-    recommend_bitrate_to_encoder(x20_rate);
-    return;
+    return m_thermal_protection_level > 0
+               ? video_bitrate_kbits * 30 / 100 * factor / 100
+               : video_bitrate_kbits * 70 / 100 * factor / 100;
+  }
+  return video_bitrate_kbits;
+}
+
+void WBLink::loop_rate_control() {
+  while (m_work_thread_run) {
+    rt_perform_rate_control();
+    std::this_thread::sleep_for(RATE_CONTROL_INTERVAL);
+  }
+}
+
+void WBLink::rt_perform_rate_control() {
+  if (!m_settings->get_settings().enable_wb_video_variable_bitrate) return;
+  const int ceiling_kbits = m_max_video_rate_for_current_wifi_fec_config;
+  // Not yet calculated by the work thread
+  if (ceiling_kbits <= 0 || m_wb_video_tx_list.empty()) return;
+  const int generation = m_rate_control_generation;
+  if (generation != m_rate_controller_generation) {
+    m_rate_controller_generation = generation;
+    m_rate_controller = openhd::wb::TxPressureRateController{};
+  }
+  // Primary and secondary video share the card, the primary video tx queue
+  // carries (almost) all the data
+  auto& tx = *m_wb_video_tx_list[0];
+  const auto curr_tx_stats = tx.get_latest_stats();
+  const auto txStats = m_wb_txrx->get_tx_stats();
+  openhd::wb::TxPressureRateController::Sample sample{};
+  sample.time_ms = openhd::util::steady_clock_time_epoch_ms();
+  sample.tx_queue_capacity = VIDEO_TX_BLOCK_QUEUE_SIZE;
+  sample.tx_queue_used = std::max(
+      VIDEO_TX_BLOCK_QUEUE_SIZE -
+          (int)tx.get_tx_queue_available_size_approximate(),
+      0);
+  sample.count_tx_dropped_packets = txStats.count_tx_dropped_packets;
+  sample.count_tx_inj_error_hint = txStats.count_tx_injections_error_hint;
+  sample.count_dropped_frames = m_primary_total_dropped_frames.load() +
+                                m_secondary_total_dropped_frames.load();
+  sample.block_until_tx_avg_us = curr_tx_stats.curr_block_until_tx_avg_us;
+  sample.block_until_tx_max_us = curr_tx_stats.curr_block_until_tx_max_us;
+  sample.ceiling_kbits = ceiling_kbits;
+  if (m_rate_control_trace) {
+    // 50 lines per second, rotated at 1MB - the last ~10 minutes are kept
+    m_rate_control_trace->write_line(sample.to_csv());
+  }
+  const int previous = m_recommended_video_bitrate_kbits;
+  const int bitrate = m_rate_controller.on_sample(sample);
+  m_curr_n_rate_adjustments = m_rate_controller.get_n_decreases();
+  if (bitrate == previous) return;
+  m_recommended_video_bitrate_kbits = bitrate;
+  if (bitrate < previous) {
+    m_console->warn("TX pressure, reducing video bitrate to {} {}",
+                    openhd::kbits_per_second_to_string(bitrate),
+                    m_rate_controller.to_string());
+    // Don't wait for the work thread, the tx queue is already filling up
+    recommend_bitrate_to_encoder(apply_platform_bitrate_limits(bitrate));
+  } else {
+    m_console->debug("Increasing video bitrate to {}",
+                     openhd::kbits_per_second_to_string(bitrate));
   }
-  recommend_bitrate_to_encoder(m_recommended_video_bitrate_kbits);
 }
 
 void WBLink::recommend_bitrate_to_encoder(int recommended_video_bitrate_kbits) {
@@ -1231,21 +1468,13 @@ void WBLink::recommend_bitrate_to_encoder(int recommended_video_bitrate_kbits) {
 
 bool WBLink::try_schedule_work_item(
     const std::shared_ptr<WorkItem>& work_item) {
-  std::unique_lock<std::mutex> lock(m_work_item_queue_mutex, std::try_to_lock);
-  if (lock.owns_lock()) {
-    if (m_work_item_queue.empty()) {
-      m_console->debug("Adding work item {} to queue", work_item->TAG);
-      m_work_item_queue.push(work_item);
-      return true;
-    }
-    m_console->debug("Work queue full,cannot add {}", work_item->TAG);
-    m_console->warn("Please try again later");
-    return false;
+  if (m_work_queue.try_push(work_item)) {
+    m_console->debug("Adding work item {} to queue", work_item->TAG);
+    return true;
   }
-  // Most likely, the lock is hold by the wb_link thread currently performing a
-  // previous work item - this is not an error, the user has to try changing
-  // param X later.
-  m_console->debug("Cannot get lock,cannot add {}", work_item->TAG);
+  // Most likely, a frequency change / channel scan is still in progress - this
+  // is not an error, the user has to try changing param X later.
+  m_console->debug("Work queue busy,cannot add {}", work_item->TAG);
   m_console->warn("Please try again later");
   return false;
 }
@@ -1264,7 +1493,7 @@ void WBLink::transmit_video_data(
     int stream_index,
     const openhd::FragmentedVideoFrame& fragmented_video_frame) {
   assert(m_profile.is_air);
-  if (stream_index < 0 || stream_index > m_wb_video_tx_list.size()) {
+  if (stream_index < 0 || stream_index >= m_wb_video_tx_list.size()) {
     m_console->debug("Invalid camera stream_index {}", stream_index);
     return;
   }
@@ -1280,8 +1509,10 @@ void WBLink::transmit_video_data(
   // m_console->debug("Got {}",fragmented_video_frame.rtp_fragments.size());
   auto& tx = *m_wb_video_tx_list[stream_index];
   tx.set_encryption(fragmented_video_frame.enable_ultra_secure_encryption);
-  const int max_fec_block_size = get_max_fec_block_size();
-  const int fec_perc = m_settings->get_settings().wb_video_fec_percentage;
+  const int max_fec_block_size =
+      m_video_max_fec_block_size[stream_index].load(std::memory_order_relaxed);
+  const int fec_perc =
+      m_video_fec_percentage[stream_index].load(std::memory_order_relaxed);
   int n_dropped_frames = 0;
   if (fragmented_video_frame.dirty_frame != nullptr) {
     // non rtp
@@ -1293,14 +1524,46 @@ void WBLink::transmit_video_data(
       n_dropped_frames = 1;
     }
   } else {
+    // Early (sub-frame) transmission: every part of a frame becomes its own
+    // FEC block. Once a part has been dropped, the rest of the frame is
+    // useless.
+    bool& drop_rest_of_frame = m_video_tx_drop_rest_of_frame[stream_index];
+    if (fragmented_video_frame.part_index == 0) {
+      drop_rest_of_frame = false;
+    } else if (drop_rest_of_frame) {
+      return;
+    }
     // Pushes out previous enqueued frames if there is not enough space in the
-    // queue
-    const bool use_dropping_enqueue = fragmented_video_frame.is_intra_stream ||
-                                      fragmented_video_frame.is_idr_frame;
+    // queue - only for the first part, otherwise we'd push out the previous
+    // part(s) of the same frame.
+    const bool use_dropping_enqueue = (fragmented_video_frame.is_intra_stream ||
+                                       fragmented_video_frame.is_idr_frame) &&
+                                      fragmented_video_frame.part_index == 0;
+    bool enqueued = true;
+    // WBStreamTx consumes std::vector fragments - fragments that are not
+    // backed by a std::vector already (e.g. gstreamer buffers) are copied here.
+    auto fragments = fragmented_video_frame.get_fragments_as_vectors();
+    int n_gathered = 0;
+    for (const auto& fragment : fragmented_video_frame.rtp_fragments) {
+      if (!fragment.is_vector()) n_gathered++;
+    }
+    m_n_video_fragments_gathered.fetch_add(n_gathered,
+                                           std::memory_order_relaxed);
+    auto& tracer = openhd::latency_trace::LatencyTracer::instance();
+    const bool trace =
+        tracer.is_enabled() && fragmented_video_frame.is_last_part;
+    if (trace) {
+      tracer.record(stream_index,
+                    openhd::latency_trace::Stage::AIR_FRAME_COMPLETE,
+                    fragmented_video_frame.creation_time);
+      // Goes into the same FEC block as the last fragment(s) of the frame
+      fragments.push_back(tracer.create_air_trace_packet(
+          stream_index, fragmented_video_frame.creation_time));
+    }
 
     if (use_dropping_enqueue) {
       const auto count_removed = tx.enqueue_block_dropping(
-          fragmented_video_frame.rtp_fragments, max_fec_block_size, fec_perc,
+          fragments, max_fec_block_size, fec_perc,
           fragmented_video_frame.creation_time);
       if (count_removed != 0) {
         openhd::log::get_default()->debug(
@@ -1310,17 +1573,23 @@ void WBLink::transmit_video_data(
       }
     } else {
       const auto res = tx.try_enqueue_block(
-          fragmented_video_frame.rtp_fragments, max_fec_block_size, fec_perc,
+          fragments, max_fec_block_size, fec_perc,
           fragmented_video_frame.creation_time);
       if (!res) {
         n_dropped_frames = 1;
+        enqueued = false;
+        drop_rest_of_frame = !fragmented_video_frame.is_last_part;
         m_console->debug("TX enqueue video frame failed, queue size:{}",
                          tx.get_tx_queue_available_size_approximate());
       }
     }
+    if (trace && enqueued) {
+      tracer.record(stream_index,
+                    openhd::latency_trace::Stage::AIR_LINK_ENQUEUE,
+                    fragmented_video_frame.creation_time);
+    }
   }
   if (n_dropped_frames != 0) {
-    m_frame_drop_helper.notify_dropped_frame(n_dropped_frames);
     if (stream_index == 0) {
       m_primary_total_dropped_frames += n_dropped_frames;
     } else {
@@ -1348,6 +1617,32 @@ openhd::WifiSpace WBLink::get_current_frequency_channel_space() const {
       m_settings->get_settings().wb_frequency);
 }
 
+std::vector<bool> WBLink::scan_tune_cards(
+    const std::vector<openhd::wb::ScanCandidate>& candidates,
+    const std::vector<int>& round, openhd::wb::ScanHopStats& hop_stats) {
+  // Temporarily stop injecting packets
+  m_wb_txrx->set_passive_mode(true);
+  std::this_thread::sleep_for(std::chrono::milliseconds(
+      100));  // Dirty - wait for any tx packets to drain
+  std::vector<bool> tuned(round.size(), false);
+  for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+    if (round[card_idx] < 0) continue;
+    const auto& candidate = candidates[round[card_idx]];
+    const auto before = std::chrono::steady_clock::now();
+    tuned[card_idx] =
+        openhd::wb::set_frequency_and_channel_width_for_all_cards(
+            candidate.frequency, candidate.channel_width,
+            {m_broadcast_cards[card_idx]}, m_nl80211.get());
+    hop_stats.add(std::chrono::steady_clock::now() - before);
+    if (!tuned[card_idx]) {
+      m_console->warn("Cannot tune card {} to [{}] {}Mhz@{}Mhz", card_idx,
+                      candidate.channel, candidate.frequency,
+                      candidate.channel_width);
+    }
+  }
+  return tuned;
+}
+
 void WBLink::perform_channel_scan(
     const openhd::LinkActionHandler::ScanChannelsParam& scan_channels_params) {
   const WiFiCard& card = m_broadcast_cards.at(0);
@@ -1369,135 +1664,149 @@ void WBLink::perform_channel_scan(
   // add 10mhz scan
   const std::vector<uint16_t> channel_widths_to_scan = {40, 10};
 
-  auto stats_current = openhd::LinkActionHandler::instance().get_link_stats();
-  stats_current.gnd_operating_mode.operating_mode = 1;
-  openhd::LinkActionHandler::instance().update_link_stats(stats_current);
+  m_gnd_operating_mode = 1;
 
-  struct ScanResult {
-    bool success = false;
-    int frequency = 0;
-    int channel_width = 0;
-  };
-  ScanResult result{false, 0, 0};
-  // Note: We intentionally do not modify the persistent settings here
-  m_console->debug(
-      "Channel scan N channels to scan:{} N channel widths to scan:{}",
-      channels_to_scan.size(), channel_widths_to_scan.size());
-  bool done_early = false;
-  // We need to loop through all possible channels
-  for (int i = 0; i < channels_to_scan.size(); i++) {
-    const auto& channel = channels_to_scan[i];
-    if (done_early) break;
-    // and all possible channel widths (20 or 40Mhz only right now)
+  std::vector<openhd::wb::ScanCandidate> candidates;
+  for (const auto& channel : channels_to_scan) {
     for (const auto& channel_width : channel_widths_to_scan) {
-      const auto requested_channel_width = channel_width;
-      auto scan_channel_width = channel_width;
-      if (requested_channel_width == 80) {
-        m_console->warn(
-            "80Mhz channel width requested during scan, downgrading to 40Mhz");
-        scan_channel_width = 40;
-      }
-      // Return early in some cases (e.g. when we have a low loss and are quite
-      // certain about a frequency)
-      if (done_early) break;
-      // Skip channels / frequencies the card doesn't support anyways
-      if (!openhd::wb::any_card_support_frequency(
-              channel.frequency, m_broadcast_cards, m_console)) {
-        continue;
-      }
-      // set new frequency, reset the packet count, sleep, then check if any
-      // openhd packets have been received
-      const bool freq_success = apply_frequency_and_channel_width(
-          channel.frequency, scan_channel_width, scan_channel_width);
-      if (!freq_success) {
-        m_console->warn("Cannot scan [{}] {}Mhz@{}Mhz", channel.channel,
-                        channel.frequency, scan_channel_width);
-        continue;
-      }
+      candidates.push_back(openhd::wb::ScanCandidate{
+          channel.frequency, channel.channel, channel_width});
+    }
+  }
+  // With rx diversity, each card listens on a different channel at the same
+  // time. Skips channels / frequencies the card(s) don't support anyways.
+  const int n_cards = std::min((int)m_broadcast_cards.size(),
+                               ManagementGround::MAX_N_CARDS);
+  const auto rounds = openhd::wb::plan_scan_rounds(
+      (int)candidates.size(), n_cards, [&](int card_idx, int candidate_idx) {
+        return wifi_card_supports_frequency(
+            m_broadcast_cards[card_idx], candidates[candidate_idx].frequency);
+      });
+  // Note: We intentionally do not modify the persistent settings here
+  m_console->debug("Channel scan N channels x widths to scan:{} N cards:{} "
+                   "N rounds:{}",
+                   candidates.size(), n_cards, rounds.size());
+  openhd::wb::ScanHopStats hop_stats{};
+  std::optional<openhd::wb::ScanObservation> result = std::nullopt;
+  for (int i = 0; i < (int)rounds.size() && !result.has_value(); i++) {
+    const auto& round = rounds[i];
+    // set new frequency per card, reset the packet count, sleep, then check if
+    // any openhd packets have been received
+    const auto tuned = scan_tune_cards(candidates, round, hop_stats);
+    const int progress =
+        OHDUtil::calculate_progress_perc(i, (int)rounds.size());
+    bool any_tuned = false;
+    for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+      if (!tuned[card_idx]) continue;
+      any_tuned = true;
+      const auto& candidate = candidates[round[card_idx]];
       openhd::LinkActionHandler::ScanChannelsProgress tmp{};
-      tmp.channel_mhz = (int)channel.frequency;
-      tmp.channel_width_mhz = scan_channel_width;
+      tmp.channel_mhz = (int)candidate.frequency;
+      tmp.channel_width_mhz = candidate.channel_width;
       tmp.success = false;
-      tmp.progress =
-          OHDUtil::calculate_progress_perc(i, (int)channels_to_scan.size());
+      tmp.progress = progress;
       openhd::LinkActionHandler::instance().add_scan_channels_progress(tmp);
-      // Disable injection during scan
-      m_wb_txrx->set_passive_mode(true);
-      // sleeep a bit - some cards /drivers might need time switching
-      std::this_thread::sleep_for(std::chrono::milliseconds(200));
-      m_console->debug("Scanning [{}] {}Mhz@{}Mhz", channel.channel,
-                       channel.frequency, scan_channel_width);
-      reset_all_rx_stats();
-      m_management_gnd->m_air_reported_curr_frequency = -1;
-      m_management_gnd->m_air_reported_curr_channel_width = -1;
-      std::this_thread::sleep_for(std::chrono::seconds(2));
-      const auto n_likely_openhd_packets =
-          m_wb_txrx->get_rx_stats().curr_n_likely_openhd_packets;
-      // If we got what looks to be openhd packets, sleep a bit more such that
-      // we can reliably get a management frame
-      if (n_likely_openhd_packets > 0) {
-        m_console->debug("Got {} likely openhd packets, sleep a bit more",
-                         n_likely_openhd_packets);
-        const auto begin_long_listen = std::chrono::steady_clock::now();
-        while (std::chrono::steady_clock::now() - begin_long_listen <
-               std::chrono::seconds(5)) {
-          const int air_center_frequency =
-              m_management_gnd->m_air_reported_curr_frequency;
-          const int air_tx_channel_width =
-              m_management_gnd->m_air_reported_curr_channel_width;
-          const bool has_received_management =
-              air_center_frequency > 0 && air_tx_channel_width > 0;
-          if (has_received_management) {
-            break;
+      m_console->debug("Scanning [{}] {}Mhz@{}Mhz on card {}",
+                       candidate.channel, candidate.frequency,
+                       candidate.channel_width, card_idx);
+    }
+    if (!any_tuned) continue;
+    // sleeep a bit - some cards /drivers might need time switching
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    reset_all_rx_stats();
+    m_management_gnd->reset_air_reports();
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    const auto n_likely_openhd_packets =
+        m_wb_txrx->get_rx_stats().curr_n_likely_openhd_packets;
+    // If we got what looks to be openhd packets, sleep a bit more such that
+    // we can reliably get a management frame
+    if (n_likely_openhd_packets > 0) {
+      m_console->debug("Got {} likely openhd packets, sleep a bit more",
+                       n_likely_openhd_packets);
+      const auto begin_long_listen = std::chrono::steady_clock::now();
+      while (std::chrono::steady_clock::now() - begin_long_listen <
+             std::chrono::seconds(5)) {
+        bool has_received_management = false;
+        for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+          if (tuned[card_idx] &&
+              m_management_gnd->m_air_reported_frequency_per_card[card_idx] >
+                  0 &&
+              m_management_gnd
+                      ->m_air_reported_channel_width_per_card[card_idx] > 0) {
+            has_received_management = true;
           }
-          std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
+        if (has_received_management) {
+          break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
       }
-      const auto packet_loss =
-          m_wb_txrx->get_rx_stats().curr_lowest_packet_loss;
-      const auto n_valid_packets = m_wb_txrx->get_rx_stats().count_p_valid;
-      const int air_center_frequency =
-          m_management_gnd->m_air_reported_curr_frequency;
-      const int air_tx_channel_width =
-          m_management_gnd->m_air_reported_curr_channel_width;
+    }
+    // Merge what the cards saw in this round
+    std::vector<openhd::wb::ScanObservation> observations;
+    for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+      if (!tuned[card_idx]) continue;
+      const auto rx_stats = m_wb_txrx->get_rx_stats_for_card(card_idx);
+      const auto rf_stats = m_wb_txrx->get_rx_rf_stats_for_card(card_idx);
+      openhd::wb::ScanObservation observation{};
+      observation.card_idx = card_idx;
+      observation.candidate = candidates[round[card_idx]];
+      observation.n_valid_packets = rx_stats.count_p_valid;
+      observation.packet_loss_perc = rx_stats.curr_packet_loss;
+      observation.rssi_dbm = std::max({(int)rf_stats.adapter.rssi_dbm,
+                                       (int)rf_stats.antenna1.rssi_dbm,
+                                       (int)rf_stats.antenna2.rssi_dbm});
+      observation.air_reported_frequency =
+          m_management_gnd->m_air_reported_frequency_per_card[card_idx];
+      observation.air_reported_channel_width =
+          m_management_gnd->m_air_reported_channel_width_per_card[card_idx];
       m_console->debug(
-          "Got {} packets on {}@{} air_reports:[{}@{}] with loss {}%",
-          n_valid_packets, channel.frequency, scan_channel_width,
-          air_center_frequency, air_tx_channel_width, packet_loss);
-      if (n_valid_packets > 0 && air_center_frequency > 0 &&
-          (air_tx_channel_width == 10 || air_tx_channel_width == 20 ||
-           air_tx_channel_width == 40) &&
-          channel.frequency == air_center_frequency) {
-        m_console->debug("Found air unit");
-        result.frequency = channel.frequency;
-        result.channel_width = air_tx_channel_width;
-        result.success = true;
-        m_console->debug("Air unit detected: {} MHz @ {} MHz width",
-                         result.frequency, result.channel_width);
-        done_early = true;
-      }
+          "Card {} got {} packets on {}@{} air_reports:[{}@{}] with loss {}%",
+          card_idx, observation.n_valid_packets,
+          observation.candidate.frequency, observation.candidate.channel_width,
+          observation.air_reported_frequency,
+          observation.air_reported_channel_width,
+          observation.packet_loss_perc);
+      observations.push_back(observation);
     }
+    result = openhd::wb::pick_best_scan_observation(observations);
   }
   re_enable_injection_unless_user_passive_mode_enabled();
-  if (!result.success) {
+  m_console->info("Channel scan: {}", hop_stats.to_string());
+  int result_frequency = 0;
+  int result_channel_width = 0;
+  if (!result.has_value()) {
     m_console->warn("Channel scan failure, restore local settings");
     apply_frequency_and_channel_width_from_settings();
-    result.success = false;
-    result.frequency = 0;
   } else {
-    m_console->debug("Channel scan success, {}@{}Mhz", result.frequency,
-                     result.channel_width);
-    m_settings->unsafe_get_settings().wb_frequency = result.frequency;
-    m_settings->persist();
-    m_gnd_curr_rx_channel_width = result.channel_width;
-    apply_frequency_and_channel_width_from_settings();
+    result_frequency = (int)result->candidate.frequency;
+    result_channel_width = result->air_reported_channel_width;
+    m_console->debug("Air unit detected: {} MHz @ {} MHz width (card {})",
+                     result_frequency, result_channel_width,
+                     result->card_idx);
+    // The settings are only written by the worker thread - applied there
+    // once the scan is done
+    auto work_item = std::make_shared<WorkItem>(
+        fmt::format("APPLY_SCAN_RESULT:{}", result_frequency),
+        [this, result_frequency, result_channel_width]() {
+          m_settings->unsafe_get_settings().wb_frequency = result_frequency;
+          m_settings->persist();
+          m_gnd_curr_rx_channel_width = result_channel_width;
+          apply_frequency_and_channel_width_from_settings();
+        },
+        std::chrono::steady_clock::now());
+    if (!try_schedule_work_item(work_item)) {
+      m_console->warn("Cannot apply channel scan result, restore settings");
+      apply_frequency_and_channel_width_from_settings();
+    }
   }
   openhd::LinkActionHandler::ScanChannelsProgress tmp{};
-  tmp.channel_mhz = (int)result.frequency;
-  tmp.channel_width_mhz = result.channel_width;
-  tmp.success = result.success;
+  tmp.channel_mhz = result_frequency;
+  tmp.channel_width_mhz = result_channel_width;
+  tmp.success = result.has_value();
   tmp.progress = 100;
   openhd::LinkActionHandler::instance().add_scan_channels_progress(tmp);
+  m_gnd_operating_mode = 0;
 }
 
 void WBLink::perform_channel_analyze(int channels_to_scan) {
@@ -1509,31 +1818,51 @@ void WBLink::perform_channel_analyze(int channels_to_scan) {
   const WiFiCard& card = m_broadcast_cards.at(0);
   const auto channels_to_analyze =
       openhd::wb::get_analyze_channels_frequencies(card, channels_to_scan);
-  auto stats_current = openhd::LinkActionHandler::instance().get_link_stats();
-  stats_current.gnd_operating_mode.operating_mode = 2;
-  openhd::LinkActionHandler::instance().update_link_stats(stats_current);
+  m_gnd_operating_mode = 2;
+  // We use fixed 40Mhz during analyze.
+  std::vector<openhd::wb::ScanCandidate> candidates;
+  for (const auto& channel : channels_to_analyze) {
+    candidates.push_back(
+        openhd::wb::ScanCandidate{channel.frequency, channel.channel, 40});
+  }
+  // Same as the channel scan, each card analyzes a different channel
+  const int n_cards = std::min((int)m_broadcast_cards.size(),
+                               ManagementGround::MAX_N_CARDS);
+  const auto rounds = openhd::wb::plan_scan_rounds(
+      (int)candidates.size(), n_cards, [&](int card_idx, int candidate_idx) {
+        return wifi_card_supports_frequency(
+            m_broadcast_cards[card_idx], candidates[candidate_idx].frequency);
+      });
+  openhd::wb::ScanHopStats hop_stats{};
   std::vector<AnalyzeResult> results{};
-  for (int i = 0; i < channels_to_analyze.size(); i++) {
-    const auto channel = channels_to_analyze[i];
-    // We use fixed 40Mhz during analyze.
-    const int channel_width = 40;
-    // set new frequency, reset the packet count, sleep, then check if any
-    // openhd packets have been received
-    apply_frequency_and_channel_width(channel.frequency, channel_width, 20);
-    // Disable injection during analyze
-    m_wb_txrx->set_passive_mode(true);
+  for (int i = 0; i < (int)rounds.size(); i++) {
+    const auto& round = rounds[i];
+    // set new frequency per card (injection stays disabled during analyze),
+    // reset the packet count, sleep, then count the foreign packets
+    const auto tuned = scan_tune_cards(candidates, round, hop_stats);
     // Sleep a bit to give the card time to switch
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    m_console->debug("Analyzing [{}] {}Mhz@{}Mhz", channel.channel,
-                     channel.frequency, channel_width);
+    for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+      if (!tuned[card_idx]) continue;
+      const auto& candidate = candidates[round[card_idx]];
+      m_console->debug("Analyzing [{}] {}Mhz@{}Mhz on card {}",
+                       candidate.channel, candidate.frequency,
+                       candidate.channel_width, card_idx);
+    }
     reset_all_rx_stats();
     std::this_thread::sleep_for(std::chrono::seconds(4));
-    const auto stats = m_wb_txrx->get_rx_stats();
-    const auto n_foreign_packets = stats.count_p_any - stats.count_p_valid;
-    m_console->debug("Got {} foreign packets {}:{}", n_foreign_packets,
-                     stats.count_p_any, stats.count_p_valid);
-    results.push_back(
-        AnalyzeResult{(int)channel.frequency, (int)n_foreign_packets});
+    // Cards are given the candidates in order, results stay sorted
+    for (int card_idx = 0; card_idx < (int)round.size(); card_idx++) {
+      if (!tuned[card_idx]) continue;
+      const auto stats = m_wb_txrx->get_rx_stats_for_card(card_idx);
+      const auto n_foreign_packets = stats.count_p_any - stats.count_p_valid;
+      m_console->debug("Card {} got {} foreign packets {}:{}", card_idx,
+                       n_foreign_packets, stats.count_p_any,
+                       stats.count_p_valid);
+      results.push_back(
+          AnalyzeResult{(int)candidates[round[card_idx]].frequency,
+                        (int)n_foreign_packets});
+    }
 
     openhd::LinkActionHandler::AnalyzeChannelsResult tmp{};
     for (int j = 0; j < 30; j++) {
@@ -1545,8 +1874,8 @@ void WBLink::perform_channel_analyze(int channels_to_scan) {
         tmp.foreign_packets[j] = 0;
       }
     }
-    tmp.progress = OHDUtil::calculate_progress_perc(
-        i + 1, (int)channels_to_analyze.size());
+    tmp.progress =
+        OHDUtil::calculate_progress_perc(i + 1, (int)rounds.size());
     openhd::LinkActionHandler::instance().add_analyze_result(tmp);
   }
   /*std::stringstream ss;
@@ -1556,10 +1885,12 @@ void WBLink::perform_channel_analyze(int channels_to_scan) {
   m_console->debug("{}",ss.str().c_str());*/
   re_enable_injection_unless_user_passive_mode_enabled();
   m_console->debug(
-      "Done analyzing, took:{}",
-      MyTimeHelper::R(std::chrono::steady_clock::now() - analyze_begin));
+      "Done analyzing, took:{} ({})",
+      MyTimeHelper::R(std::chrono::steady_clock::now() - analyze_begin),
+      hop_stats.to_string());
   // Go back to the previous frequency
   apply_frequency_and_channel_width_from_settings();
+  m_gnd_operating_mode = 0;
 }
 
 void WBLink::wt_perform_mcs_via_rc_channel_if_enabled() {
@@ -1613,6 +1944,7 @@ void WBLink::update_arming_state(bool armed) {
   // apply_tx_power - it will set the right tx power if the user enabled it
   m_is_armed = armed;
   m_request_apply_tx_power = true;
+  m_work_queue.notify();
 }
 
 void WBLink::wt_gnd_perform_channel_management() {
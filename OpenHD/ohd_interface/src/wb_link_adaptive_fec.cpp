@@ -0,0 +1,126 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "wb_link_adaptive_fec.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace openhd::wb {
+
+AdaptiveFecController::AdaptiveFecController(Limits limits,
+                                             int initial_fec_percentage)
+    : m_limits(limits),
+      m_fec_percentage(std::clamp(initial_fec_percentage,
+                                  limits.min_fec_percentage,
+                                  limits.max_fec_percentage)),
+      m_block_size(limits.max_block_size) {}
+
+int AdaptiveFecController::fec_percentage_for_packet_loss(
+    int packet_loss_perc) {
+  if (packet_loss_perc <= 0) return 0;
+  const int loss = std::min(packet_loss_perc, 90);
+  // n fec packets per data packet to replace the lost ones: loss / (1-loss)
+  const int fec = loss * 100 / (100 - loss);
+  return fec * 3 / 2 + 5;
+}
+
+bool AdaptiveFecController::on_ground_report(const GroundReport& report) {
+  if (!m_has_baseline ||
+      report.count_blocks_total < m_baseline.count_blocks_total ||
+      report.count_blocks_lost < m_baseline.count_blocks_lost ||
+      report.count_blocks_recovered < m_baseline.count_blocks_recovered) {
+    // First report or the ground has reset its counters
+    m_baseline = report;
+    m_has_baseline = true;
+    return false;
+  }
+  const uint32_t n_blocks =
+      report.count_blocks_total - m_baseline.count_blocks_total;
+  if (n_blocks < MIN_BLOCKS_PER_DECISION) {
+    // Keep accumulating
+    return false;
+  }
+  const uint32_t n_lost =
+      report.count_blocks_lost - m_baseline.count_blocks_lost;
+  const uint32_t n_recovered =
+      report.count_blocks_recovered - m_baseline.count_blocks_recovered;
+  m_baseline = report;
+  if (m_cooldown) {
+    m_cooldown = false;
+    return false;
+  }
+  const int before_fec = m_fec_percentage;
+  const int before_block_size = m_block_size;
+  const int needed = fec_percentage_for_packet_loss(report.packet_loss_perc);
+  if (n_lost > 0 || needed > m_fec_percentage) {
+    increase(needed, n_lost > 0);
+  } else if (needed + STEP_DOWN_PERCENTAGE <= m_fec_percentage &&
+             n_recovered * 100 <=
+                 n_blocks * MAX_RECOVERED_BLOCKS_PERC_FOR_DECREASE) {
+    m_n_clean_reports++;
+    if (m_n_clean_reports >= HOLD_REPORTS) {
+      m_n_clean_reports = 0;
+      decrease(needed);
+    }
+  } else {
+    // Overhead is about right
+    m_n_clean_reports = 0;
+  }
+  return before_fec != m_fec_percentage || before_block_size != m_block_size;
+}
+
+void AdaptiveFecController::increase(int needed_fec_percentage,
+                                     bool lost_blocks) {
+  m_n_clean_reports = 0;
+  m_cooldown = true;
+  if (lost_blocks) {
+    m_fec_percentage =
+        std::max(m_fec_percentage + STEP_UP_PERCENTAGE, needed_fec_percentage);
+    m_block_size = std::min(m_block_size * 5 / 4 + 1, m_limits.max_block_size);
+  } else {
+    // Only the packet loss went up, no need to overshoot
+    m_fec_percentage = std::max(m_fec_percentage, needed_fec_percentage);
+  }
+  m_fec_percentage = std::min(m_fec_percentage, m_limits.max_fec_percentage);
+}
+
+void AdaptiveFecController::decrease(int needed_fec_percentage) {
+  // Bigger steps while far above what is needed
+  const int step = std::max(STEP_DOWN_PERCENTAGE,
+                            (m_fec_percentage - needed_fec_percentage) / 4);
+  m_fec_percentage = std::max({m_fec_percentage - step, needed_fec_percentage,
+                               m_limits.min_fec_percentage});
+  m_block_size = std::max(m_block_size * 4 / 5,
+                          std::min(m_limits.min_block_size,
+                                   m_limits.max_block_size));
+}
+
+std::string AdaptiveFecController::to_string() const {
+  std::stringstream ss;
+  ss << "[fec:" << m_fec_percentage << "% block:" << m_block_size
+     << " clean:" << m_n_clean_reports << "]";
+  return ss.str();
+}
+
+}  // namespace openhd::wb
@@ -82,7 +82,8 @@ bool openhd::wb::any_card_support_frequency(
 
 bool openhd::wb::set_frequency_and_channel_width_for_all_cards(
     uint32_t frequency, uint32_t channel_width,
-    const std::vector<WiFiCard>& m_broadcast_cards) {
+    const std::vector<WiFiCard>& m_broadcast_cards,
+    wifi::nl80211::ChannelControl* nl80211) {
   bool ret = true;  // Initialize return value to true
   for (const auto& card : m_broadcast_cards) {
     // Skip emulated cards
@@ -97,12 +98,12 @@ bool openhd::wb::set_frequency_and_channel_width_for_all_cards(
         card.type == WiFiCardType::OPENHD_RTL_88X2EU ||
         card.type == WiFiCardType::OPENHD_RTL_8852BU) {
       wifi::commandhelper::openhd_driver_set_frequency_and_channel_width(
-          card.type, card.device_name, frequency, channel_width);
+          card.type, card.device_name, frequency, channel_width, nl80211);
     } else {
       // Handle other card types with a different function
       const bool success =
-          wifi::commandhelper::iw_set_frequency_and_channel_width(
-              card.device_name, frequency, channel_width);
+          wifi::commandhelper::nl_or_iw_set_frequency_and_channel_width(
+              nl80211, card.device_name, frequency, channel_width);
       if (!success) {
         ret = false;  // Set return value to false if any setting fails
       }
@@ -113,7 +114,8 @@ bool openhd::wb::set_frequency_and_channel_width_for_all_cards(
 
 void openhd::wb::set_tx_power_for_all_cards(
     int tx_power_mw, int rtl8812au_tx_power_index_override,
-    const std::vector<WiFiCard>& m_broadcast_cards) {
+    const std::vector<WiFiCard>& m_broadcast_cards,
+    wifi::nl80211::ChannelControl* nl80211) {
   for (const auto& card : m_broadcast_cards) {
     if (card.type == WiFiCardType::OPENHD_EMULATED) {
       break;  // Skip further processing for emulated cards
@@ -122,8 +124,8 @@ void openhd::wb::set_tx_power_for_all_cards(
     if (card.type == WiFiCardType::OPENHD_RTL_88X2AU) {
       openhd::log::get_default()->warn("RTL8812AU tx_pwr_idx_override: {}",
                                        rtl8812au_tx_power_index_override);
-      wifi::commandhelper::iw_set_tx_power(card.device_name,
-                                           rtl8812au_tx_power_index_override);
+      wifi::commandhelper::nl_or_iw_set_tx_power(
+          nl80211, card.device_name, rtl8812au_tx_power_index_override);
     } else {
       float adjustment_factor = 1.0f;
       float adjustment_value = 1.0f;
@@ -142,9 +144,10 @@ void openhd::wb::set_tx_power_for_all_cards(
           card.type == WiFiCardType::OPENHD_RTL_8852BU ||
           card.type == WiFiCardType::QUALCOMM) {
         wifi::commandhelper::openhd_driver_set_tx_power(
-            card.type, card.device_name, tx_power_mbm);
+            card.type, card.device_name, tx_power_mbm, nl80211);
       } else {
-        wifi::commandhelper::iw_set_tx_power(card.device_name, tx_power_mbm);
+        wifi::commandhelper::nl_or_iw_set_tx_power(nl80211, card.device_name,
+                                                   tx_power_mbm);
       }
 
       openhd::log::get_default()->debug("Tx power mW: {} mBm: {}", tx_power_mw,
@@ -150,9 +150,10 @@ void ManagementAir::on_new_management_packet(const uint8_t *data,
 ManagementGround::ManagementGround(std::shared_ptr<WBTxRx> wb_tx_rx)
     : m_wb_txrx(std::move(wb_tx_rx)) {
   m_console = openhd::log::create_or_get("wb_mngmt_gnd");
+  reset_air_reports();
   auto cb_packet = [this](uint64_t nonce, int wlan_index, const uint8_t *data,
                           const int data_len) {
-    this->on_new_management_packet(data, data_len);
+    this->on_new_management_packet(data, data_len, wlan_index);
   };
   auto mgmt_handler = std::make_shared<WBTxRx::StreamRxHandler>(
       openhd::MANAGEMENT_RADIO_PORT_AIR_TX, cb_packet, nullptr);
@@ -171,8 +172,17 @@ void ManagementGround::start() {
   m_tx_thread = std::make_unique<std::thread>(&ManagementGround::loop, this);
 }
 
+void ManagementGround::reset_air_reports() {
+  m_air_reported_curr_frequency = -1;
+  m_air_reported_curr_channel_width = -1;
+  for (int i = 0; i < MAX_N_CARDS; i++) {
+    m_air_reported_frequency_per_card[i] = -1;
+    m_air_reported_channel_width_per_card[i] = -1;
+  }
+}
+
 void ManagementGround::on_new_management_packet(const uint8_t *data,
-                                                int data_len) {
+                                                int data_len, int wlan_index) {
   if (data_len == sizeof(DataManagementTxBandwidth) + 1 &&
       data[0] == MNGMNT_PACKET_ID_CHANNEL_WIDTH) {
     DataManagementTxBandwidth packet{};
@@ -180,6 +190,12 @@ void ManagementGround::on_new_management_packet(const uint8_t *data,
     if (packet.bandwidth_mhz == 20 || packet.bandwidth_mhz == 40) {
       m_air_reported_curr_channel_width = packet.bandwidth_mhz;
       m_air_reported_curr_frequency = packet.center_frequency_mhz;
+      if (wlan_index >= 0 && wlan_index < MAX_N_CARDS) {
+        m_air_reported_channel_width_per_card[wlan_index] =
+            packet.bandwidth_mhz;
+        m_air_reported_frequency_per_card[wlan_index] =
+            packet.center_frequency_mhz;
+      }
     } else {
       m_console->warn("Air reports invalid bandwidth {}", packet.bandwidth_mhz);
     }
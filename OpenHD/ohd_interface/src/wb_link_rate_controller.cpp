@@ -0,0 +1,145 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "wb_link_rate_controller.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace openhd::wb {
+
+std::string TxPressureRateController::Sample::to_csv() const {
+  std::stringstream ss;
+  ss << time_ms << "," << tx_queue_used << "," << tx_queue_capacity << ","
+     << count_tx_dropped_packets << "," << count_tx_inj_error_hint << ","
+     << count_dropped_frames << "," << block_until_tx_avg_us << ","
+     << block_until_tx_max_us << "," << ceiling_kbits;
+  return ss.str();
+}
+
+std::optional<TxPressureRateController::Sample>
+TxPressureRateController::Sample::from_csv(const std::string& line) {
+  std::stringstream ss(line);
+  Sample ret{};
+  char sep[8];
+  ss >> ret.time_ms >> sep[0] >> ret.tx_queue_used >> sep[1] >>
+      ret.tx_queue_capacity >> sep[2] >> ret.count_tx_dropped_packets >>
+      sep[3] >> ret.count_tx_inj_error_hint >> sep[4] >>
+      ret.count_dropped_frames >> sep[5] >> ret.block_until_tx_avg_us >>
+      sep[6] >> ret.block_until_tx_max_us >> sep[7] >> ret.ceiling_kbits;
+  if (ss.fail()) return std::nullopt;
+  for (char c : sep) {
+    if (c != ',') return std::nullopt;
+  }
+  return ret;
+}
+
+int TxPressureRateController::on_sample(const Sample& sample) {
+  if (!m_started) {
+    restart(sample);
+    return m_bitrate_kbits;
+  }
+  if (sample.ceiling_kbits != m_ceiling_kbits) {
+    m_ceiling_kbits = sample.ceiling_kbits;
+    m_bitrate_kbits = std::min(m_bitrate_kbits, m_ceiling_kbits);
+  }
+  if (sample.count_tx_dropped_packets < m_last.count_tx_dropped_packets ||
+      sample.count_tx_inj_error_hint < m_last.count_tx_inj_error_hint ||
+      sample.count_dropped_frames < m_last.count_dropped_frames) {
+    // Counters have been reset, new baseline
+    m_last = sample;
+    return m_bitrate_kbits;
+  }
+  const auto pressure = classify(sample);
+  m_last = sample;
+  const int64_t now = sample.time_ms;
+  if (now - m_start_ms < GRACE_PERIOD_AFTER_START_MS) {
+    // We are at the ceiling, nothing to increase either
+    return m_bitrate_kbits;
+  }
+  m_last_pressure = pressure;
+  if (pressure != Pressure::NONE) {
+    m_last_pressure_ms = now;
+    if (now - m_last_decrease_ms >= HOLD_OFF_AFTER_DECREASE_MS) {
+      const int perc = pressure == Pressure::SEVERE ? SEVERE_DECREASE_PERC
+                                                    : MILD_DECREASE_PERC;
+      const int min_bitrate = std::min(MIN_BITRATE_KBITS, m_ceiling_kbits);
+      m_bitrate_kbits =
+          std::max(m_bitrate_kbits * (100 - perc) / 100, min_bitrate);
+      m_last_decrease_ms = now;
+      m_n_decreases++;
+    }
+  } else if (m_bitrate_kbits < m_ceiling_kbits &&
+             now - m_last_pressure_ms >= CLEAN_BEFORE_INCREASE_MS &&
+             now - m_last_increase_ms >= INCREASE_INTERVAL_MS) {
+    m_bitrate_kbits = std::min(
+        m_bitrate_kbits + m_ceiling_kbits * INCREASE_STEP_PERC / 100,
+        m_ceiling_kbits);
+    m_last_increase_ms = now;
+  }
+  return m_bitrate_kbits;
+}
+
+TxPressureRateController::Pressure TxPressureRateController::classify(
+    const Sample& sample) {
+  if (sample.tx_queue_capacity > 0) {
+    const int fill = std::clamp(
+        sample.tx_queue_used * 100 * 100 / sample.tx_queue_capacity, 0,
+        100 * 100);
+    m_queue_fill_ewma = (m_queue_fill_ewma * 7 + fill) / 8;
+  }
+  if (sample.count_dropped_frames > m_last.count_dropped_frames ||
+      sample.count_tx_dropped_packets > m_last.count_tx_dropped_packets) {
+    return Pressure::SEVERE;
+  }
+  if (m_queue_fill_ewma > QUEUE_FILL_THRESHOLD_PERC * 100 ||
+      sample.block_until_tx_avg_us > BLOCK_UNTIL_TX_THRESHOLD_US ||
+      sample.count_tx_inj_error_hint > m_last.count_tx_inj_error_hint) {
+    return Pressure::MILD;
+  }
+  return Pressure::NONE;
+}
+
+void TxPressureRateController::restart(const Sample& sample) {
+  m_started = true;
+  m_last = sample;
+  m_ceiling_kbits = sample.ceiling_kbits;
+  m_bitrate_kbits = sample.ceiling_kbits;
+  m_n_decreases = 0;
+  m_queue_fill_ewma = 0;
+  m_start_ms = sample.time_ms;
+  m_last_decrease_ms = sample.time_ms;
+  m_last_pressure_ms = sample.time_ms;
+  m_last_increase_ms = sample.time_ms;
+  m_last_pressure = Pressure::NONE;
+}
+
+std::string TxPressureRateController::to_string() const {
+  std::stringstream ss;
+  ss << "[rate:" << m_bitrate_kbits << "/" << m_ceiling_kbits
+     << "kBit/s queue:" << m_queue_fill_ewma / 100
+     << "% n_decreases:" << m_n_decreases << "]";
+  return ss.str();
+}
+
+}  // namespace openhd::wb
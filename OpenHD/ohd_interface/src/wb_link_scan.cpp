@@ -0,0 +1,112 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "wb_link_scan.h"
+
+#include <algorithm>
+#include <sstream>
+
+std::vector<std::vector<int>> openhd::wb::plan_scan_rounds(
+    int n_candidates, int n_cards,
+    const std::function<bool(int card_idx, int candidate_idx)>& supports) {
+  std::vector<std::vector<int>> rounds;
+  if (n_cards <= 0) return rounds;
+  // Drop what no card can tune to
+  std::vector<bool> done(n_candidates, false);
+  int n_remaining = 0;
+  for (int candidate_idx = 0; candidate_idx < n_candidates; candidate_idx++) {
+    bool any_supports = false;
+    for (int card_idx = 0; card_idx < n_cards; card_idx++) {
+      if (supports(card_idx, candidate_idx)) {
+        any_supports = true;
+        break;
+      }
+    }
+    done[candidate_idx] = !any_supports;
+    if (any_supports) n_remaining++;
+  }
+  // Each card takes the first remaining candidate it can tune to
+  while (n_remaining > 0) {
+    std::vector<int> round(n_cards, -1);
+    for (int card_idx = 0; card_idx < n_cards; card_idx++) {
+      for (int candidate_idx = 0; candidate_idx < n_candidates;
+           candidate_idx++) {
+        if (!done[candidate_idx] && supports(card_idx, candidate_idx)) {
+          round[card_idx] = candidate_idx;
+          done[candidate_idx] = true;
+          n_remaining--;
+          break;
+        }
+      }
+    }
+    rounds.push_back(round);
+  }
+  return rounds;
+}
+
+bool openhd::wb::is_air_unit_observation(const ScanObservation& observation) {
+  const int width = observation.air_reported_channel_width;
+  return observation.n_valid_packets > 0 &&
+         observation.air_reported_frequency > 0 &&
+         (width == 10 || width == 20 || width == 40) &&
+         observation.air_reported_frequency ==
+             (int)observation.candidate.frequency;
+}
+
+std::optional<openhd::wb::ScanObservation>
+openhd::wb::pick_best_scan_observation(
+    const std::vector<ScanObservation>& observations) {
+  std::optional<ScanObservation> best = std::nullopt;
+  // Unknown loss counts as 100%
+  auto loss = [](const ScanObservation& observation) {
+    return observation.packet_loss_perc < 0 ? 100
+                                            : observation.packet_loss_perc;
+  };
+  for (const auto& observation : observations) {
+    if (!is_air_unit_observation(observation)) continue;
+    if (!best.has_value() || loss(observation) < loss(best.value()) ||
+        (loss(observation) == loss(best.value()) &&
+         observation.rssi_dbm > best->rssi_dbm)) {
+      best = observation;
+    }
+  }
+  return best;
+}
+
+void openhd::wb::ScanHopStats::add(std::chrono::nanoseconds hop_duration) {
+  count++;
+  min = std::min(min, hop_duration);
+  max = std::max(max, hop_duration);
+  sum += hop_duration;
+}
+
+std::string openhd::wb::ScanHopStats::to_string() const {
+  if (count == 0) return "no hops";
+  auto ms = [](std::chrono::nanoseconds value) {
+    return std::chrono::duration<float, std::milli>(value).count();
+  };
+  std::stringstream ss;
+  ss << count << " hops, switch time min:" << ms(min)
+     << "ms avg:" << ms(sum / count) << "ms max:" << ms(max) << "ms";
+  return ss.str();
+}
@@ -70,6 +70,8 @@
      return "HT20";
    } else if (channel_width == 40) {
      return use_ht40_plus ? "HT40+" : "HT40-";
+   } else if (channel_width == 80) {
+     return "80MHz";
    }
    get_logger()->info("Invalid channel width {}, assuming HT20", channel_width);
    return "HT20";
@@ -166,6 +168,40 @@
    return true;
  }
  
+ // Qualcomm cards are configured via their vendor tools, not nl80211
+ static bool uses_vendor_tools(const std::string &device) {
+   return device == "ath0";
+ }
+ 
+ bool wifi::commandhelper::nl_or_iw_set_frequency_and_channel_width(
+     wifi::nl80211::ChannelControl *nl80211, const std::string &device,
+     uint32_t freq_mhz, uint32_t channel_width, bool ht40_plus) {
+   if (uses_vendor_tools(device)) {
+     return iw_set_frequency_and_channel_width(device, freq_mhz, channel_width);
+   }
+   if (nl80211 != nullptr &&
+       nl80211->set_frequency_and_channel_width(device, freq_mhz, channel_width,
+                                                ht40_plus)) {
+     get_logger()->debug("nl80211 set freq {} {}Mhz@{}Mhz", device, freq_mhz,
+                         channel_width);
+     return true;
+   }
+   return iw_set_frequency_and_channel_width2(
+       device, freq_mhz, channel_width_as_iw_string(channel_width, ht40_plus));
+ }
+ 
+ bool wifi::commandhelper::nl_or_iw_set_tx_power(
+     wifi::nl80211::ChannelControl *nl80211, const std::string &device,
+     uint32_t tx_power_mBm) {
+   if (!uses_vendor_tools(device) && nl80211 != nullptr &&
+       nl80211->set_tx_power(device, tx_power_mBm)) {
+     get_logger()->debug("nl80211 set tx_power {} {} mBm", device,
+                         tx_power_mBm);
+     return true;
+   }
+   return iw_set_tx_power(device, tx_power_mBm);
+ }
+ 
  // HE MCS0-11 NSS 1 20 MHz
  static const std::vector<uint32_t> he20_11ax_rate_ol{
      8600,  17200, 25800,  34400,  51600,  68800,
@@ -319,7 +355,7 @@ static constexpr char OPENHD_DRIVER_RTL88xxEU_TX_POWER_MW_OVERRIDE[] =
  
  bool wifi::commandhelper::openhd_driver_set_frequency_and_channel_width(
      WiFiCardType type, const std::string &device, uint32_t freq_mhz,
-     uint32_t channel_width) {
+     uint32_t channel_width, wifi::nl80211::ChannelControl *nl80211) {
    const auto channel_opt = openhd::channel_from_frequency(freq_mhz);
    if (!channel_opt.has_value()) {
      openhd::log::get_default()->warn("Cannot find channel {}Mhz", freq_mhz);
@@ -355,8 +391,8 @@ static constexpr char OPENHD_DRIVER_RTL88xxEU_TX_POWER_MW_OVERRIDE[] =
      openhd::log::get_default()->error(
          "YOU ARE USING THE WRONG DRIVER; CHANNEL WON'T WORK");
      // hope this works
-     wifi::commandhelper::iw_set_frequency_and_channel_width(device, freq_mhz,
-                                                             channel_width);
+     nl_or_iw_set_frequency_and_channel_width(nl80211, device, freq_mhz,
+                                              channel_width);
      return true;
    }
    // /etc/modprobe.d
@@ -374,23 +410,24 @@ static constexpr char OPENHD_DRIVER_RTL88xxEU_TX_POWER_MW_OVERRIDE[] =
    } else {
      dummy_frequency = use_40mhz ? (use_ht40_plus ? 5180 : 5200) : 5180;
    }
-   std::string bw_mode =
-       channel_width_as_iw_string(channel_width, use_ht40_plus);
+   uint32_t dummy_channel_width = channel_width;
    if (type == WiFiCardType::OPENHD_RTL_88X2EU && channel_width == 40) {
      // rtl88x2eu still requires issuing an 80MHz request when 40MHz is desired
-     bw_mode = "80MHZ";
+     dummy_channel_width = 80;
      openhd::log::get_default()->info(
-         "rtl88x2eu requested 40MHz, issuing iw 80MHz command: wlan={} chan={}",
+         "rtl88x2eu requested 40MHz, issuing 80MHz command: wlan={} chan={}",
          device, channel.channel);
    }
-   wifi::commandhelper::iw_set_frequency_and_channel_width2(
-       device, dummy_frequency, bw_mode, true);
+   get_logger()->debug("DUMMY! set freq {} {}Mhz@{}Mhz", device,
+                       dummy_frequency, dummy_channel_width);
+   nl_or_iw_set_frequency_and_channel_width(
+       nl80211, device, dummy_frequency, dummy_channel_width, use_ht40_plus);
    return true;
  }
  
- bool wifi::commandhelper::openhd_driver_set_tx_power(WiFiCardType type,
-                                                      const std::string &device,
-                                                      uint32_t tx_power_mBm) {
+ bool wifi::commandhelper::openhd_driver_set_tx_power(
+     WiFiCardType type, const std::string &device, uint32_t tx_power_mBm,
+     wifi::nl80211::ChannelControl *nl80211) {
    const char *TXPOWER_OVERRIDE_FILENAME = nullptr;
    switch (type) {
      case (WiFiCardType::OPENHD_RTL_88X2AU):
@@ -416,13 +453,13 @@ static constexpr char OPENHD_DRIVER_RTL88xxEU_TX_POWER_MW_OVERRIDE[] =
      openhd::log::get_default()->error(
          "YOU ARE USING THE WRONG DRIVER; TX POWER WON'T WORK");
      // hope this works
-     wifi::commandhelper::iw_set_tx_power(device, tx_power_mBm);
+     nl_or_iw_set_tx_power(nl80211, device, tx_power_mBm);
      return true;
    }
    OHDFilesystemUtil::write_file(TXPOWER_OVERRIDE_FILENAME,
                                  fmt::format("{}", tx_power_mBm));
    // initiate change
-   wifi::commandhelper::iw_set_tx_power(device, tx_power_mBm);
+   nl_or_iw_set_tx_power(nl80211, device, tx_power_mBm);
    return true;
  }
  
@@ -0,0 +1,288 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "wifi_nl80211.h"
+
+#include <linux/genetlink.h>
+#include <linux/netlink.h>
+#include <linux/nl80211.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+
+#include "openhd_spdlog.h"
+#include "openhd_spdlog_include.h"
+
+static std::shared_ptr<spdlog::logger> get_logger() {
+  return openhd::log::create_or_get("nl80211");
+}
+
+// Start of each 80Mhz block (5G), from iw util.c
+static constexpr std::array<uint32_t, 7> BW80_START_FREQS{
+    5180, 5260, 5500, 5580, 5660, 5745, 5825};
+
+std::optional<wifi::nl80211::ChannelDefinition>
+wifi::nl80211::make_channel_definition(uint32_t freq_mhz,
+                                       uint32_t channel_width,
+                                       bool ht40_plus) {
+  ChannelDefinition ret{freq_mhz, NL80211_CHAN_WIDTH_20, freq_mhz,
+                        NL80211_CHAN_HT20};
+  if (channel_width == 5) {
+    ret.nl_channel_width = NL80211_CHAN_WIDTH_5;
+    ret.nl_channel_type = std::nullopt;
+  } else if (channel_width == 10) {
+    ret.nl_channel_width = NL80211_CHAN_WIDTH_10;
+    ret.nl_channel_type = std::nullopt;
+  } else if (channel_width == 40) {
+    ret.nl_channel_width = NL80211_CHAN_WIDTH_40;
+    ret.nl_channel_type =
+        ht40_plus ? NL80211_CHAN_HT40PLUS : NL80211_CHAN_HT40MINUS;
+    ret.center_freq1_mhz = ht40_plus ? freq_mhz + 10 : freq_mhz - 10;
+  } else if (channel_width == 80) {
+    ret.nl_channel_width = NL80211_CHAN_WIDTH_80;
+    ret.nl_channel_type = std::nullopt;
+    bool found = false;
+    for (const auto start : BW80_START_FREQS) {
+      if (freq_mhz >= start && freq_mhz < start + 80) {
+        ret.center_freq1_mhz = start + 30;
+        found = true;
+        break;
+      }
+    }
+    if (!found) return std::nullopt;
+  }
+  return ret;
+}
+
+// Builds one generic netlink request in a fixed size buffer - our messages
+// only ever carry a handful of u32 attributes.
+class wifi::nl80211::NetlinkChannelControl::Request {
+ public:
+  Request(uint16_t family_id, uint8_t cmd, uint8_t version) {
+    auto* nlh = header();
+    nlh->nlmsg_len = NLMSG_LENGTH(GENL_HDRLEN);
+    nlh->nlmsg_type = family_id;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+    auto* genl = reinterpret_cast<genlmsghdr*>(NLMSG_DATA(nlh));
+    genl->cmd = cmd;
+    genl->version = version;
+  }
+  bool put(uint16_t type, const void* data, size_t len) {
+    auto* nlh = header();
+    const size_t offset = NLMSG_ALIGN(nlh->nlmsg_len);
+    if (offset + NLA_HDRLEN + NLA_ALIGN(len) > m_buffer.size()) return false;
+    auto* attr = reinterpret_cast<nlattr*>(m_buffer.data() + offset);
+    attr->nla_type = type;
+    attr->nla_len = static_cast<uint16_t>(NLA_HDRLEN + len);
+    std::memcpy(m_buffer.data() + offset + NLA_HDRLEN, data, len);
+    nlh->nlmsg_len = static_cast<uint32_t>(offset + NLA_ALIGN(attr->nla_len));
+    return true;
+  }
+  bool put_u32(uint16_t type, uint32_t value) {
+    return put(type, &value, sizeof(value));
+  }
+  nlmsghdr* header() { return reinterpret_cast<nlmsghdr*>(m_buffer.data()); }
+
+ private:
+  alignas(nlmsghdr) std::array<uint8_t, 256> m_buffer{};
+};
+
+wifi::nl80211::NetlinkChannelControl::NetlinkChannelControl()
+    : m_rx_buffer(8192) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  if (!ensure_open()) {
+    get_logger()->warn("nl80211 not available (yet), using iw");
+  }
+}
+
+wifi::nl80211::NetlinkChannelControl::~NetlinkChannelControl() {
+  close_socket();
+}
+
+bool wifi::nl80211::NetlinkChannelControl::ensure_open() {
+  if (m_fd >= 0) return true;
+  m_fd = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_GENERIC);
+  if (m_fd < 0) {
+    get_logger()->warn("Cannot open netlink socket {}", strerror(errno));
+    return false;
+  }
+  sockaddr_nl local{};
+  local.nl_family = AF_NETLINK;
+  if (bind(m_fd, reinterpret_cast<sockaddr*>(&local), sizeof(local)) < 0) {
+    get_logger()->warn("Cannot bind netlink socket {}", strerror(errno));
+    close_socket();
+    return false;
+  }
+  // Never block the caller (e.g. the wb link worker) forever on a stuck
+  // driver.
+  timeval timeout{};
+  timeout.tv_sec = 1;
+  setsockopt(m_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  // Resolve the nl80211 family id once
+  Request request(GENL_ID_CTRL, CTRL_CMD_GETFAMILY, 1);
+  request.put(CTRL_ATTR_FAMILY_NAME, NL80211_GENL_NAME,
+              sizeof(NL80211_GENL_NAME));
+  uint16_t family_id = 0;
+  const int ret = transact(request, &family_id);
+  if (ret != 0 || family_id == 0) {
+    get_logger()->warn("Cannot resolve nl80211 family {}", strerror(-ret));
+    close_socket();
+    return false;
+  }
+  m_family_id = family_id;
+  get_logger()->debug("nl80211 family id {}", m_family_id);
+  return true;
+}
+
+void wifi::nl80211::NetlinkChannelControl::close_socket() {
+  if (m_fd >= 0) {
+    close(m_fd);
+  }
+  m_fd = -1;
+  m_family_id = 0;
+}
+
+std::optional<uint32_t> wifi::nl80211::NetlinkChannelControl::get_ifindex(
+    const std::string& device) {
+  const auto it = m_ifindex_cache.find(device);
+  if (it != m_ifindex_cache.end()) return it->second;
+  const uint32_t ifindex = if_nametoindex(device.c_str());
+  if (ifindex == 0) {
+    get_logger()->warn("No ifindex for {}", device);
+    return std::nullopt;
+  }
+  m_ifindex_cache[device] = ifindex;
+  return ifindex;
+}
+
+int wifi::nl80211::NetlinkChannelControl::transact(Request& request,
+                                                   uint16_t* out_family_id) {
+  auto* req = request.header();
+  req->nlmsg_seq = ++m_seq;
+  sockaddr_nl kernel{};
+  kernel.nl_family = AF_NETLINK;
+  if (sendto(m_fd, req, req->nlmsg_len, 0,
+             reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+    return -errno;
+  }
+  while (true) {
+    const ssize_t len = recv(m_fd, m_rx_buffer.data(), m_rx_buffer.size(), 0);
+    if (len < 0) {
+      if (errno == EINTR) continue;
+      return (errno == EAGAIN || errno == EWOULDBLOCK) ? -ETIMEDOUT : -errno;
+    }
+    auto remaining = static_cast<unsigned int>(len);
+    for (auto* nlh = reinterpret_cast<nlmsghdr*>(m_rx_buffer.data());
+         NLMSG_OK(nlh, remaining); nlh = NLMSG_NEXT(nlh, remaining)) {
+      // Stale answer to a request that timed out before
+      if (nlh->nlmsg_seq != req->nlmsg_seq) continue;
+      if (nlh->nlmsg_type == NLMSG_ERROR) {
+        // error==0 is the ack
+        return reinterpret_cast<nlmsgerr*>(NLMSG_DATA(nlh))->error;
+      }
+      if (nlh->nlmsg_type == NLMSG_DONE) return 0;
+      if (out_family_id == nullptr) continue;
+      // Reply to CTRL_CMD_GETFAMILY - look for the family id attribute
+      auto* attr = reinterpret_cast<nlattr*>(
+          reinterpret_cast<uint8_t*>(NLMSG_DATA(nlh)) + GENL_HDRLEN);
+      int attr_len = static_cast<int>(nlh->nlmsg_len) -
+                     static_cast<int>(NLMSG_LENGTH(GENL_HDRLEN));
+      while (attr_len >= static_cast<int>(NLA_HDRLEN) &&
+             attr->nla_len >= NLA_HDRLEN && attr->nla_len <= attr_len) {
+        if ((attr->nla_type & NLA_TYPE_MASK) == CTRL_ATTR_FAMILY_ID) {
+          std::memcpy(out_family_id,
+                      reinterpret_cast<uint8_t*>(attr) + NLA_HDRLEN,
+                      sizeof(uint16_t));
+        }
+        attr_len -= NLA_ALIGN(attr->nla_len);
+        attr = reinterpret_cast<nlattr*>(reinterpret_cast<uint8_t*>(attr) +
+                                         NLA_ALIGN(attr->nla_len));
+      }
+    }
+  }
+}
+
+bool wifi::nl80211::NetlinkChannelControl::set_wiphy(
+    const std::string& device, const char* what,
+    const std::vector<std::pair<uint16_t, uint32_t>>& attrs) {
+  std::lock_guard<std::mutex> guard(m_mutex);
+  if (!ensure_open()) return false;
+  const auto ifindex = get_ifindex(device);
+  if (!ifindex.has_value()) return false;
+  Request request(m_family_id, NL80211_CMD_SET_WIPHY, 0);
+  bool fits = request.put_u32(NL80211_ATTR_IFINDEX, ifindex.value());
+  for (const auto& attr : attrs) {
+    fits = fits && request.put_u32(attr.first, attr.second);
+  }
+  if (!fits) return false;
+  const int ret = transact(request);
+  if (ret == 0) return true;
+  get_logger()->warn("{} {} failed: {}", what, device, strerror(-ret));
+  if (ret == -ENODEV) {
+    // Card was re-enumerated, resolve the ifindex again next time
+    m_ifindex_cache.erase(device);
+  } else if (ret != -EINVAL && ret != -EOPNOTSUPP && ret != -EBUSY) {
+    // Anything but "the driver said no" - start with a fresh socket
+    close_socket();
+  }
+  return false;
+}
+
+bool wifi::nl80211::NetlinkChannelControl::set_frequency_and_channel_width(
+    const std::string& device, uint32_t freq_mhz, uint32_t channel_width,
+    bool ht40_plus) {
+  const auto chandef =
+      make_channel_definition(freq_mhz, channel_width, ht40_plus);
+  if (!chandef.has_value()) {
+    get_logger()->warn("No channel definition for {}Mhz@{}Mhz", freq_mhz,
+                       channel_width);
+    return false;
+  }
+  std::vector<std::pair<uint16_t, uint32_t>> attrs{
+      {NL80211_ATTR_WIPHY_FREQ, chandef->control_freq_mhz},
+      {NL80211_ATTR_CHANNEL_WIDTH, chandef->nl_channel_width},
+      {NL80211_ATTR_CENTER_FREQ1, chandef->center_freq1_mhz}};
+  if (chandef->nl_channel_type.has_value()) {
+    attrs.emplace_back(NL80211_ATTR_WIPHY_CHANNEL_TYPE,
+                       chandef->nl_channel_type.value());
+  }
+  return set_wiphy(device, "set_frequency", attrs);
+}
+
+bool wifi::nl80211::NetlinkChannelControl::set_tx_power(
+    const std::string& device, uint32_t tx_power_mBm) {
+  return set_wiphy(device, "set_tx_power",
+                   {{NL80211_ATTR_WIPHY_TX_POWER_SETTING,
+                     NL80211_TX_POWER_FIXED},
+                    {NL80211_ATTR_WIPHY_TX_POWER_LEVEL, tx_power_mBm}});
+}
+
+std::unique_ptr<wifi::nl80211::ChannelControl>
+wifi::nl80211::create_channel_control() {
+  return std::make_unique<NetlinkChannelControl>();
+}
@@ -0,0 +1,219 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "wb_link_adaptive_fec.h"
+
+// Offline simulation harness for the adaptive FEC controller.
+// Models the drop modes one would use with the emulated card
+// (WIFI_MONITOR_CARD_EMULATE + WIFI_MONITOR_CARD_EMULATE_DROP_MODE), such that
+// the controller can be tuned without any hardware. The air unit splits each
+// frame into FEC blocks the same way WBStreamTx does, the ground unit reports
+// its counters every 500ms, like OpenHD does.
+
+using openhd::wb::AdaptiveFecController;
+
+enum class DropMode {
+  NONE,
+  RANDOM_10,
+  RANDOM_25,
+  // Gilbert-Elliott, 2% loss in the good state, 60% in the bad state
+  BURSTS,
+  // 20s clean, 20s 10% random, 20s 30% random, 20s clean ...
+  CHANGING
+};
+
+static std::string drop_mode_to_string(DropMode mode) {
+  switch (mode) {
+    case DropMode::NONE:
+      return "NONE";
+    case DropMode::RANDOM_10:
+      return "RANDOM_10";
+    case DropMode::RANDOM_25:
+      return "RANDOM_25";
+    case DropMode::BURSTS:
+      return "BURSTS";
+    case DropMode::CHANGING:
+      return "CHANGING";
+  }
+  return "?";
+}
+
+class LossModel {
+ public:
+  explicit LossModel(DropMode mode) : m_mode(mode), m_rng(1234) {}
+  bool drop(double time_s) {
+    std::uniform_real_distribution<double> dist(0, 1);
+    const double r = dist(m_rng);
+    switch (m_mode) {
+      case DropMode::NONE:
+        return false;
+      case DropMode::RANDOM_10:
+        return r < 0.10;
+      case DropMode::RANDOM_25:
+        return r < 0.25;
+      case DropMode::BURSTS: {
+        const double r2 = dist(m_rng);
+        if (m_bad_state) {
+          if (r2 < 0.2) m_bad_state = false;
+        } else {
+          if (r2 < 0.02) m_bad_state = true;
+        }
+        return r < (m_bad_state ? 0.6 : 0.02);
+      }
+      case DropMode::CHANGING: {
+        const int period = (int)(time_s / 20) % 4;
+        if (period == 1) return r < 0.10;
+        if (period == 2) return r < 0.30;
+        return false;
+      }
+    }
+    return false;
+  }
+
+ private:
+  const DropMode m_mode;
+  std::mt19937 m_rng;
+  bool m_bad_state = false;
+};
+
+struct SimResult {
+  double avg_fec_percentage;
+  double block_loss_perc;
+  int final_fec_percentage;
+  int final_block_size;
+};
+
+// 60fps, 20 fragments per frame, IDR (100 fragments) every second
+static SimResult simulate(DropMode mode, bool adaptive, int seconds,
+                          bool verbose) {
+  static constexpr int FPS = 60;
+  static constexpr int USER_FEC_PERCENTAGE = 20;
+  AdaptiveFecController::Limits limits{};
+  limits.max_block_size = 20;
+  AdaptiveFecController controller{limits, USER_FEC_PERCENTAGE};
+  LossModel loss_model{mode};
+  AdaptiveFecController::GroundReport ground{};
+  int window_packets = 0;
+  int window_dropped = 0;
+  double fec_sum = 0;
+  for (int frame = 0; frame < seconds * FPS; frame++) {
+    const double time_s = (double)frame / FPS;
+    const int fec_perc =
+        adaptive ? controller.get_fec_percentage() : USER_FEC_PERCENTAGE;
+    const int max_block_size =
+        adaptive ? controller.get_max_block_size() : limits.max_block_size;
+    fec_sum += fec_perc;
+    const int n_fragments = frame % FPS == 0 ? 100 : 20;
+    const int n_blocks = (n_fragments + max_block_size - 1) / max_block_size;
+    for (int block = 0; block < n_blocks; block++) {
+      const int k = n_fragments / n_blocks + (block < n_fragments % n_blocks);
+      const int m = (k * fec_perc + 99) / 100;
+      int n_received = 0;
+      int n_data_lost = 0;
+      for (int i = 0; i < k + m; i++) {
+        const bool dropped = loss_model.drop(time_s);
+        window_packets++;
+        if (dropped) {
+          window_dropped++;
+          if (i < k) n_data_lost++;
+        } else {
+          n_received++;
+        }
+      }
+      ground.count_blocks_total++;
+      if (n_received < k) {
+        ground.count_blocks_lost++;
+      } else if (n_data_lost > 0) {
+        ground.count_blocks_recovered++;
+        ground.count_fragments_recovered += n_data_lost;
+      }
+    }
+    // Ground reports every 500ms
+    if (frame % (FPS / 2) == FPS / 2 - 1) {
+      ground.packet_loss_perc = window_dropped * 100 / window_packets;
+      window_packets = 0;
+      window_dropped = 0;
+      if (adaptive && controller.on_ground_report(ground) && verbose) {
+        std::cout << "  t=" << (int)time_s
+                  << "s loss:" << ground.packet_loss_perc << "% -> "
+                  << controller.to_string() << "\n";
+      }
+    }
+  }
+  SimResult ret{};
+  ret.avg_fec_percentage = fec_sum / (seconds * FPS);
+  ret.block_loss_perc =
+      100.0 * ground.count_blocks_lost / ground.count_blocks_total;
+  ret.final_fec_percentage = controller.get_fec_percentage();
+  ret.final_block_size = controller.get_max_block_size();
+  return ret;
+}
+
+static void print_result(const std::string& tag, const SimResult& result) {
+  std::cout << tag << " avg fec:" << result.avg_fec_percentage
+            << "% lost blocks:" << result.block_loss_perc << "%\n";
+}
+
+int main(int argc, char* argv[]) {
+  const bool verbose = argc > 1 && std::string(argv[1]) == "-v";
+  assert(AdaptiveFecController::fec_percentage_for_packet_loss(0) == 0);
+  assert(AdaptiveFecController::fec_percentage_for_packet_loss(10) == 21);
+  for (const auto mode : {DropMode::NONE, DropMode::RANDOM_10,
+                          DropMode::RANDOM_25, DropMode::BURSTS,
+                          DropMode::CHANGING}) {
+    std::cout << "Drop mode " << drop_mode_to_string(mode) << "\n";
+    const auto fixed = simulate(mode, false, 160, false);
+    const auto adaptive = simulate(mode, true, 160, verbose);
+    print_result(" static  ", fixed);
+    print_result(" adaptive", adaptive);
+    switch (mode) {
+      case DropMode::NONE:
+        // Converges to the minimum overhead, never loses anything
+        assert(adaptive.final_fec_percentage == 5);
+        assert(adaptive.block_loss_perc == 0);
+        break;
+      case DropMode::RANDOM_10:
+        assert(adaptive.block_loss_perc < 0.5);
+        break;
+      case DropMode::RANDOM_25:
+        // Static 20% cannot cope with 25% loss
+        assert(fixed.block_loss_perc > 50);
+        assert(adaptive.block_loss_perc < 2);
+        break;
+      case DropMode::BURSTS:
+        assert(adaptive.block_loss_perc < fixed.block_loss_perc);
+        break;
+      case DropMode::CHANGING:
+        assert(adaptive.block_loss_perc < fixed.block_loss_perc);
+        break;
+    }
+  }
+  std::cout << "All tests passed\n";
+  return 0;
+}
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <linux/nl80211.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "wb_link_helper.h"
+#include "wifi_command_helper.h"
+#include "wifi_nl80211.h"
+
+// Without arguments: checks the channel definitions and that the wb link
+// helpers route frequency / tx power changes through the given nl80211
+// control (using a fake, no hardware required).
+// With a device name (e.g. test_nl80211_control wlan1): hops through some 5G
+// channels via nl80211 and via iw and prints the per-hop switch time of both.
+// Needs root and a card in monitor mode.
+
+using namespace wifi::nl80211;
+
+class FakeChannelControl : public ChannelControl {
+ public:
+  struct Call {
+    std::string device;
+    uint32_t freq_mhz;
+    uint32_t channel_width;
+    uint32_t tx_power_mBm;
+  };
+  bool set_frequency_and_channel_width(const std::string& device,
+                                       uint32_t freq_mhz,
+                                       uint32_t channel_width,
+                                       bool ht40_plus) override {
+    calls.push_back(Call{device, freq_mhz, channel_width, 0});
+    return true;
+  }
+  bool set_tx_power(const std::string& device,
+                    uint32_t tx_power_mBm) override {
+    calls.push_back(Call{device, 0, 0, tx_power_mBm});
+    return true;
+  }
+  std::vector<Call> calls;
+};
+
+static void test_channel_definitions() {
+  auto def = make_channel_definition(5180, 20, true);
+  assert(def.has_value());
+  assert(def->nl_channel_width == NL80211_CHAN_WIDTH_20);
+  assert(def->center_freq1_mhz == 5180);
+  assert(def->nl_channel_type == NL80211_CHAN_HT20);
+  def = make_channel_definition(5180, 40, true);
+  assert(def->nl_channel_width == NL80211_CHAN_WIDTH_40);
+  assert(def->center_freq1_mhz == 5190);
+  assert(def->nl_channel_type == NL80211_CHAN_HT40PLUS);
+  def = make_channel_definition(5200, 40, false);
+  assert(def->center_freq1_mhz == 5190);
+  assert(def->nl_channel_type == NL80211_CHAN_HT40MINUS);
+  def = make_channel_definition(5745, 10, true);
+  assert(def->nl_channel_width == NL80211_CHAN_WIDTH_10);
+  assert(!def->nl_channel_type.has_value());
+  def = make_channel_definition(5200, 80, true);
+  assert(def->nl_channel_width == NL80211_CHAN_WIDTH_80);
+  assert(def->center_freq1_mhz == 5210);
+  // No 80Mhz channel on 2.4G
+  assert(!make_channel_definition(2412, 80, true).has_value());
+  std::cout << "Channel definitions OK" << std::endl;
+}
+
+static void test_helpers_use_nl80211() {
+  WiFiCard card{};
+  card.device_name = "wlan_fake";
+  card.type = WiFiCardType::UNKNOWN;
+  FakeChannelControl fake{};
+  const bool success =
+      openhd::wb::set_frequency_and_channel_width_for_all_cards(
+          5745, 20, {card}, &fake);
+  assert(success);
+  assert(fake.calls.size() == 1);
+  assert(fake.calls[0].device == "wlan_fake");
+  assert(fake.calls[0].freq_mhz == 5745);
+  assert(fake.calls[0].channel_width == 20);
+  openhd::wb::set_tx_power_for_all_cards(25, 0, {card}, &fake);
+  assert(fake.calls.size() == 2);
+  assert(fake.calls[1].tx_power_mBm > 0);
+  std::cout << "Helpers use nl80211 OK" << std::endl;
+}
+
+struct HopTimes {
+  std::chrono::nanoseconds min = std::chrono::nanoseconds::max();
+  std::chrono::nanoseconds max{0};
+  std::chrono::nanoseconds sum{0};
+  int count = 0;
+  int n_failed = 0;
+};
+
+template <class F>
+static HopTimes measure_hops(const std::vector<uint32_t>& frequencies,
+                             F set_frequency) {
+  HopTimes ret{};
+  for (int round = 0; round < 3; round++) {
+    for (const auto freq : frequencies) {
+      const auto begin = std::chrono::steady_clock::now();
+      const bool success = set_frequency(freq);
+      const auto delta = std::chrono::steady_clock::now() - begin;
+      if (!success) ret.n_failed++;
+      ret.min = std::min(ret.min, delta);
+      ret.max = std::max(ret.max, delta);
+      ret.sum += delta;
+      ret.count++;
+    }
+  }
+  return ret;
+}
+
+static void print_hop_times(const std::string& tag, const HopTimes& times) {
+  using std::chrono::microseconds;
+  auto us = [](std::chrono::nanoseconds value) {
+    return std::chrono::duration_cast<microseconds>(value).count();
+  };
+  std::cout << tag << ": " << times.count << " hops (" << times.n_failed
+            << " failed) min:" << us(times.min)
+            << "us avg:" << us(times.sum / times.count)
+            << "us max:" << us(times.max) << "us" << std::endl;
+}
+
+static void benchmark_hops(const std::string& device) {
+  const std::vector<uint32_t> frequencies{5180, 5200, 5220, 5240, 5745,
+                                          5765, 5785, 5805, 5825};
+  NetlinkChannelControl nl80211{};
+  const auto nl_times = measure_hops(frequencies, [&](uint32_t freq) {
+    return nl80211.set_frequency_and_channel_width(device, freq, 20, true);
+  });
+  const auto iw_times = measure_hops(frequencies, [&](uint32_t freq) {
+    return wifi::commandhelper::iw_set_frequency_and_channel_width(device,
+                                                                   freq, 20);
+  });
+  print_hop_times("nl80211", nl_times);
+  print_hop_times("iw", iw_times);
+}
+
+int main(int argc, char* argv[]) {
+  test_channel_definitions();
+  test_helpers_use_nl80211();
+  if (argc > 1) {
+    benchmark_hops(argv[1]);
+  }
+  return 0;
+}
@@ -0,0 +1,210 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "wb_link_scan.h"
+
+// Offline simulation of the (parallel) channel scan with emulated cards:
+// An air unit sits on a random channel, N ground cards scan the same
+// channel x width list WBLink uses and we count the time until the air unit
+// is found. Dwell times are the ones WBLink::perform_channel_scan uses.
+
+using namespace openhd::wb;
+
+static const std::vector<uint32_t> FREQUENCIES_5G{
+    5180, 5200, 5220, 5240, 5260, 5280, 5300, 5320, 5500, 5520, 5540, 5560,
+    5580, 5600, 5620, 5640, 5660, 5680, 5700, 5745, 5765, 5785, 5805, 5825};
+
+static std::vector<ScanCandidate> create_candidates() {
+  std::vector<ScanCandidate> ret;
+  for (int i = 0; i < (int)FREQUENCIES_5G.size(); i++) {
+    for (const uint16_t width : {40, 10}) {
+      ret.push_back(ScanCandidate{FREQUENCIES_5G[i], i, width});
+    }
+  }
+  return ret;
+}
+
+struct AirUnit {
+  uint32_t frequency;
+  int channel_width;
+};
+
+// What an emulated card listening on candidate sees
+static ScanObservation emulate_card(int card_idx,
+                                    const ScanCandidate& candidate,
+                                    const AirUnit& air, std::mt19937& rng) {
+  ScanObservation ret{};
+  ret.card_idx = card_idx;
+  ret.candidate = candidate;
+  const bool same_channel = candidate.frequency == air.frequency;
+  // 40Mhz listen also gets 20Mhz packets, 10Mhz only talks to 10Mhz
+  const bool width_matches = candidate.channel_width == 10
+                                 ? air.channel_width == 10
+                                 : air.channel_width != 10;
+  const bool adjacent_channel =
+      std::abs((int)candidate.frequency - (int)air.frequency) == 20;
+  std::uniform_int_distribution<int> loss_dist(0, 20);
+  std::uniform_int_distribution<int> rssi_dist(-80, -40);
+  if (same_channel && width_matches) {
+    ret.n_valid_packets = 500;
+    ret.packet_loss_perc = loss_dist(rng);
+    ret.rssi_dbm = rssi_dist(rng);
+    ret.air_reported_frequency = (int)air.frequency;
+    ret.air_reported_channel_width = air.channel_width;
+  } else if (adjacent_channel && width_matches) {
+    // Bleeding in from the neighbour channel
+    ret.n_valid_packets = 20;
+    ret.packet_loss_perc = 90;
+    ret.rssi_dbm = -85;
+    ret.air_reported_frequency = (int)air.frequency;
+    ret.air_reported_channel_width = air.channel_width;
+  }
+  return ret;
+}
+
+static void test_plan_scan_rounds() {
+  // 1 card - same order as the sequential scan
+  auto rounds = plan_scan_rounds(3, 1, [](int, int) { return true; });
+  assert(rounds.size() == 3);
+  assert(rounds[0][0] == 0 && rounds[1][0] == 1 && rounds[2][0] == 2);
+  // 2 cards, odd number of candidates
+  rounds = plan_scan_rounds(3, 2, [](int, int) { return true; });
+  assert(rounds.size() == 2);
+  assert(rounds[0][0] == 0 && rounds[0][1] == 1);
+  assert(rounds[1][0] == 2 && rounds[1][1] == -1);
+  // Card 1 only does the odd candidates, candidate 4 nobody supports
+  rounds = plan_scan_rounds(5, 2, [](int card, int candidate) {
+    if (candidate == 4) return false;
+    return card == 0 || candidate % 2 == 1;
+  });
+  int n_assigned = 0;
+  for (const auto& round : rounds) {
+    assert(round[1] == -1 || round[1] % 2 == 1);
+    for (const auto candidate : round) {
+      assert(candidate != 4);
+      if (candidate >= 0) n_assigned++;
+    }
+  }
+  assert(n_assigned == 4);
+  // No cards
+  assert(plan_scan_rounds(3, 0, [](int, int) { return true; }).empty());
+  std::cout << "plan_scan_rounds OK" << std::endl;
+}
+
+static void test_pick_best() {
+  ScanObservation a{};
+  a.candidate = ScanCandidate{5180, 36, 40};
+  a.n_valid_packets = 10;
+  a.air_reported_frequency = 5180;
+  a.air_reported_channel_width = 20;
+  a.packet_loss_perc = 10;
+  a.rssi_dbm = -60;
+  auto b = a;
+  b.packet_loss_perc = 5;
+  auto c = b;
+  c.rssi_dbm = -50;
+  // Packets, but the air unit is on another channel
+  auto d = a;
+  d.candidate.frequency = 5200;
+  d.packet_loss_perc = 0;
+  auto best = pick_best_scan_observation({a, b, c, d});
+  assert(best.has_value());
+  assert(best->packet_loss_perc == 5 && best->rssi_dbm == -50);
+  assert(!pick_best_scan_observation({d}).has_value());
+  std::cout << "pick_best_scan_observation OK" << std::endl;
+}
+
+// Returns the simulated time in ms until the air unit was found
+static int simulate_scan(int n_cards, const AirUnit& air, std::mt19937& rng) {
+  const auto candidates = create_candidates();
+  const auto rounds = plan_scan_rounds((int)candidates.size(), n_cards,
+                                       [](int, int) { return true; });
+  int time_ms = 0;
+  for (const auto& round : rounds) {
+    // drain, one hop per card (nl80211), settle, listen
+    time_ms += 100 + 5 * n_cards + 200 + 2000;
+    std::vector<ScanObservation> observations;
+    for (int card_idx = 0; card_idx < n_cards; card_idx++) {
+      if (round[card_idx] < 0) continue;
+      observations.push_back(
+          emulate_card(card_idx, candidates[round[card_idx]], air, rng));
+    }
+    bool any_packets = false;
+    for (const auto& observation : observations) {
+      any_packets |= observation.n_valid_packets > 0;
+    }
+    // Waiting for a management frame
+    if (any_packets) time_ms += 300;
+    const auto best = pick_best_scan_observation(observations);
+    if (best.has_value()) {
+      assert(best->candidate.frequency == air.frequency);
+      assert(best->air_reported_channel_width == air.channel_width);
+      return time_ms;
+    }
+  }
+  assert(false);
+  return -1;
+}
+
+static void test_simulated_scan() {
+  std::mt19937 rng(1234);
+  std::uniform_int_distribution<int> freq_dist(
+      0, (int)FREQUENCIES_5G.size() - 1);
+  const int N_RUNS = 200;
+  std::vector<AirUnit> air_units;
+  for (int i = 0; i < N_RUNS; i++) {
+    const int width = i % 4 == 0 ? 10 : (i % 2 == 0 ? 40 : 20);
+    air_units.push_back(AirUnit{FREQUENCIES_5G[freq_dist(rng)], width});
+  }
+  double avg_1_card = 0;
+  for (int n_cards = 1; n_cards <= 4; n_cards++) {
+    double sum_ms = 0;
+    int max_ms = 0;
+    for (const auto& air : air_units) {
+      const int time_ms = simulate_scan(n_cards, air, rng);
+      sum_ms += time_ms;
+      max_ms = std::max(max_ms, time_ms);
+    }
+    const double avg_ms = sum_ms / N_RUNS;
+    if (n_cards == 1) avg_1_card = avg_ms;
+    std::cout << n_cards << " card(s): time to link avg:" << avg_ms / 1000.0
+              << "s max:" << max_ms / 1000.0
+              << "s speedup:" << avg_1_card / avg_ms << std::endl;
+    // Should scale roughly with the number of cards
+    assert(avg_1_card / avg_ms > n_cards * 0.75);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  test_plan_scan_rounds();
+  test_pick_best();
+  test_simulated_scan();
+  return 0;
+}
@@ -0,0 +1,260 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "wb_link_rate_controller.h"
+
+// Replay harness for the tx pressure rate controller.
+// test_rate_controller <trace.csv> [-v]
+//   Replays a trace recorded by the air unit (GEN_RATE_CONTROL_TRACE) and
+//   prints how the controller would have reacted.
+// test_rate_controller [-v]
+//   Runs a simulated link (encoder -> tx queue -> link with changing capacity)
+//   and checks the controller follows the capacity.
+
+using openhd::wb::TxPressureRateController;
+
+static constexpr int64_t SAMPLE_INTERVAL_MS = 20;
+
+static int replay(const std::string& filename, bool verbose) {
+  std::ifstream file(filename);
+  if (!file.is_open()) {
+    std::cerr << "Cannot open " << filename << "\n";
+    return 1;
+  }
+  TxPressureRateController controller;
+  std::string line;
+  int n_samples = 0;
+  int n_invalid = 0;
+  int64_t sum_bitrate = 0;
+  int min_bitrate = INT32_MAX;
+  int prev_bitrate = -1;
+  while (std::getline(file, line)) {
+    if (line.empty() || line == TxPressureRateController::CSV_HEADER) continue;
+    const auto sample = TxPressureRateController::Sample::from_csv(line);
+    if (!sample.has_value()) {
+      n_invalid++;
+      continue;
+    }
+    const int bitrate = controller.on_sample(sample.value());
+    n_samples++;
+    sum_bitrate += bitrate;
+    min_bitrate = std::min(min_bitrate, bitrate);
+    if (verbose && bitrate != prev_bitrate) {
+      std::cout << "t=" << sample->time_ms << "ms " << controller.to_string()
+                << "\n";
+    }
+    prev_bitrate = bitrate;
+  }
+  if (n_samples == 0) {
+    std::cerr << "No samples in " << filename << "\n";
+    return 1;
+  }
+  std::cout << "Replayed " << n_samples << " samples (" << n_invalid
+            << " invalid lines)\n"
+            << " avg bitrate:" << sum_bitrate / n_samples
+            << "kBit/s min bitrate:" << min_bitrate
+            << "kBit/s n_decreases:" << controller.get_n_decreases() << "\n";
+  return 0;
+}
+
+static void test_csv_round_trip() {
+  TxPressureRateController::Sample sample{};
+  sample.time_ms = 123456;
+  sample.tx_queue_used = 1;
+  sample.tx_queue_capacity = 2;
+  sample.count_tx_dropped_packets = 3;
+  sample.count_tx_inj_error_hint = 4;
+  sample.count_dropped_frames = 5;
+  sample.block_until_tx_avg_us = 6000;
+  sample.block_until_tx_max_us = 7000;
+  sample.ceiling_kbits = 14000;
+  const auto parsed = TxPressureRateController::Sample::from_csv(
+      sample.to_csv());
+  assert(parsed.has_value());
+  assert(parsed->to_csv() == sample.to_csv());
+  assert(!TxPressureRateController::Sample::from_csv(
+              TxPressureRateController::CSV_HEADER)
+              .has_value());
+  assert(!TxPressureRateController::Sample::from_csv("1,2,3").has_value());
+}
+
+static void test_ceiling_change() {
+  TxPressureRateController controller;
+  TxPressureRateController::Sample sample{};
+  sample.tx_queue_capacity = 2;
+  sample.ceiling_kbits = 14000;
+  assert(controller.on_sample(sample) == 14000);
+  // Lower limit (e.g. more FEC overhead) applies right away
+  sample.time_ms += SAMPLE_INTERVAL_MS;
+  sample.ceiling_kbits = 10000;
+  assert(controller.on_sample(sample) == 10000);
+  // Higher limit is approached step by step
+  sample.ceiling_kbits = 14000;
+  int bitrate = 0;
+  for (int i = 0; i < 1000; i++) {
+    sample.time_ms += SAMPLE_INTERVAL_MS;
+    const int next = controller.on_sample(sample);
+    assert(next >= bitrate);
+    assert(next - bitrate <= 14000 * 5 / 100 || bitrate == 0);
+    bitrate = next;
+  }
+  assert(bitrate == 14000);
+  assert(controller.get_n_decreases() == 0);
+}
+
+struct SimResult {
+  int n_frames = 0;
+  int n_dropped_frames = 0;
+  // During the low capacity phase, after the controller had time to react
+  int n_frames_low = 0;
+  int n_dropped_frames_low = 0;
+  int bitrate_end_low = 0;
+  int bitrate_end = 0;
+};
+
+// 60fps encoder that follows the recommended bitrate with some delay, a tx
+// queue of 2 frames (like WBStreamTx for video) and a link whose capacity
+// drops from 16 to 6 MBit/s for 20 seconds.
+static SimResult simulate(bool adaptive, bool verbose) {
+  static constexpr int CEILING_KBITS = 14000;
+  static constexpr int64_t DURATION_MS = 60 * 1000;
+  static constexpr int QUEUE_CAPACITY_FRAMES = 2;
+  static constexpr int64_t ENCODER_DELAY_MS = 300;
+  auto capacity_kbits = [](int64_t t_ms) {
+    return (t_ms >= 20000 && t_ms < 40000) ? 6000 : 16000;
+  };
+  TxPressureRateController controller;
+  SimResult ret{};
+  std::vector<std::pair<int64_t, int>> pending_rates;
+  int encoder_kbits = CEILING_KBITS;
+  int recommended = CEILING_KBITS;
+  double backlog_kbits = 0;
+  std::vector<double> queue_frames;
+  int64_t next_frame_ms = 0;
+  uint64_t dropped_frames = 0;
+  for (int64_t t = 0; t < DURATION_MS; t++) {
+    // encoder
+    while (!pending_rates.empty() &&
+           pending_rates.front().first + ENCODER_DELAY_MS <= t) {
+      encoder_kbits = pending_rates.front().second;
+      pending_rates.erase(pending_rates.begin());
+    }
+    if (t >= next_frame_ms) {
+      next_frame_ms += 1000 / 60;
+      const double frame_kbits = encoder_kbits / 60.0;
+      const bool low = t >= 23000 && t < 40000;
+      ret.n_frames++;
+      if (low) ret.n_frames_low++;
+      if ((int)queue_frames.size() >= QUEUE_CAPACITY_FRAMES) {
+        dropped_frames++;
+        ret.n_dropped_frames++;
+        if (low) ret.n_dropped_frames_low++;
+      } else {
+        queue_frames.push_back(frame_kbits);
+        backlog_kbits += frame_kbits;
+      }
+    }
+    // link, drains 1ms worth of capacity
+    double drain = capacity_kbits(t) / 1000.0;
+    while (drain > 0 && !queue_frames.empty()) {
+      const double n = std::min(drain, queue_frames.front());
+      queue_frames.front() -= n;
+      backlog_kbits -= n;
+      drain -= n;
+      if (queue_frames.front() <= 0) queue_frames.erase(queue_frames.begin());
+    }
+    if (t % SAMPLE_INTERVAL_MS != 0) continue;
+    TxPressureRateController::Sample sample{};
+    sample.time_ms = t;
+    sample.tx_queue_used = (int)queue_frames.size();
+    sample.tx_queue_capacity = QUEUE_CAPACITY_FRAMES;
+    sample.count_dropped_frames = dropped_frames;
+    sample.block_until_tx_avg_us =
+        (int)(backlog_kbits * 1000 * 1000 / capacity_kbits(t));
+    sample.block_until_tx_max_us = sample.block_until_tx_avg_us;
+    sample.ceiling_kbits = CEILING_KBITS;
+    if (adaptive) {
+      const int rate = controller.on_sample(sample);
+      if (rate != recommended) {
+        recommended = rate;
+        pending_rates.emplace_back(t, rate);
+        if (verbose) {
+          std::cout << "  t=" << t << "ms capacity:" << capacity_kbits(t)
+                    << " " << controller.to_string() << "\n";
+        }
+      }
+    }
+    if (t == 39000) ret.bitrate_end_low = recommended;
+  }
+  ret.bitrate_end = recommended;
+  return ret;
+}
+
+static double perc(int a, int b) { return b == 0 ? 0 : a * 100.0 / b; }
+
+int main(int argc, char* argv[]) {
+  bool verbose = false;
+  std::string filename;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    if (arg == "-v") {
+      verbose = true;
+    } else {
+      filename = arg;
+    }
+  }
+  if (!filename.empty()) {
+    return replay(filename, verbose);
+  }
+  test_csv_round_trip();
+  test_ceiling_change();
+  const auto fixed = simulate(false, false);
+  const auto adaptive = simulate(true, verbose);
+  std::cout << "Static  dropped frames:" << perc(fixed.n_dropped_frames,
+                                                 fixed.n_frames)
+            << "% (low capacity phase:"
+            << perc(fixed.n_dropped_frames_low, fixed.n_frames_low) << "%)\n";
+  std::cout << "Adaptive dropped frames:"
+            << perc(adaptive.n_dropped_frames, adaptive.n_frames)
+            << "% (low capacity phase:"
+            << perc(adaptive.n_dropped_frames_low, adaptive.n_frames_low)
+            << "%) bitrate end of low phase:" << adaptive.bitrate_end_low
+            << " end:" << adaptive.bitrate_end << "\n";
+  // Follows the capacity down ...
+  assert(adaptive.bitrate_end_low <= 6000);
+  assert(adaptive.bitrate_end_low >= 6000 / 2);
+  assert(perc(adaptive.n_dropped_frames_low, adaptive.n_frames_low) < 2);
+  assert(perc(fixed.n_dropped_frames_low, fixed.n_frames_low) > 20);
+  // ... and back up
+  assert(adaptive.bitrate_end >= 14000 * 9 / 10);
+  std::cout << "All tests passed\n";
+  return 0;
+}
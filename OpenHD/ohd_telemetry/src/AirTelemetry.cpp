@@ -23,6 +23,7 @@
 
 #include "AirTelemetry.h"
 
+#include <algorithm>
 #include <chrono>
 
 #include "mav_helper.h"
@@ -37,7 +38,7 @@ AirTelemetry::AirTelemetry() : MavlinkSystem(OHD_SYS_ID_AIR) {
   m_air_settings = std::make_unique<openhd::telemetry::air::SettingsHolder>();
   m_fc_serial = std::make_unique<SerialEndpointManager>();
   m_ohd_main_component = std::make_shared<OHDMainComponent>(_sys_id, true);
-  m_components.push_back(m_ohd_main_component);
+  add_component(m_ohd_main_component);
   //
   m_generic_mavlink_param_provider = std::make_shared<XMavlinkParamProvider>(
       _sys_id, MAV_COMP_ID_ONBOARD_COMPUTER);
@@ -48,7 +49,7 @@ AirTelemetry::AirTelemetry() : MavlinkSystem(OHD_SYS_ID_AIR) {
   // NOTE: We don't call set ready yet, since we have to wait until other
   // modules have provided all their paramters.
   m_generic_mavlink_param_provider->add_params(get_all_settings());
-  m_components.push_back(m_generic_mavlink_param_provider);
+  add_component(m_generic_mavlink_param_provider);
   m_tcp_server = std::make_unique<TCPEndpoint>(
       openhd::TCPServer::Config{TCPEndpoint::DEFAULT_PORT});  // 1445
   if (m_tcp_server) {
@@ -113,58 +114,61 @@ void AirTelemetry::on_messages_ground_unit(
     if (static_cast<int>(m.msgid) == MAVLINK_MSG_ID_HEARTBEAT &&
         m.sysid == OHD_SYS_ID_GROUND)
       continue;
+    // Same for the ground unit video stats (only for wb_link)
+    if (static_cast<int>(m.msgid) ==
+            MAVLINK_MSG_ID_OPENHD_STATS_WB_VIDEO_GROUND &&
+        m.sysid == OHD_SYS_ID_GROUND)
+      continue;
     filtered_messages_fc.push_back(msg);
   }
   send_messages_fc(filtered_messages_fc);
   // any data created by an OpenHD component on the air pi only needs to be sent
   // to the ground pi, the FC cannot do anything with it anyways.
-  std::lock_guard<std::mutex> guard(m_components_lock);
-  for (auto& component : m_components) {
-    std::vector<MavlinkMessage> responses{};
-    OHDUtil::vec_append(responses,
-                        component->process_mavlink_messages(messages));
-    send_messages_ground_unit(responses);
-  }
+  m_components.get()->dispatch(messages,
+                               [this](std::vector<MavlinkMessage> responses) {
+                                 send_messages_ground_unit(responses);
+                               });
 }
 
 void AirTelemetry::loop_infinite(bool& terminate,
                                  const bool enableExtendedLogging) {
   const auto log_intervall = std::chrono::seconds(5);
-  const auto loop_intervall = std::chrono::milliseconds(100);
   auto last_log = std::chrono::steady_clock::now();
   while (!terminate) {
     const auto loopBegin = std::chrono::steady_clock::now();
-    if (std::chrono::steady_clock::now() - last_log >= log_intervall) {
+    if (loopBegin - last_log >= log_intervall) {
       // State debug logging
-      last_log = std::chrono::steady_clock::now();
+      last_log = loopBegin;
       // m_console->debug("AirTelemetry::loopInfinite()");
       //  for debugging, check if any of the endpoints is not alive
       if (enableExtendedLogging && m_wb_endpoint) {
         m_console->debug(m_wb_endpoint->createInfo());
       }
     }
-    // send messages to the ground pi in regular intervals, includes heartbeat.
+    auto next_deadline = std::min(last_log + log_intervall,
+                                  loopBegin + MAX_LOOP_SLEEP);
+    // send messages to the ground pi when they are due, includes heartbeat.
     // everything else is handled by the callbacks and their threads
     {
       // NOTE: No component on the air unit ever needs to talk to the FC himself
-      std::lock_guard<std::mutex> guard(m_components_lock);
-      for (auto& component : m_components) {
-        auto messages = component->generate_mavlink_messages();
+      const auto components = m_components.get();
+      for (auto& component : components->get_components()) {
+        std::vector<MavlinkMessage> messages;
+        {
+          std::lock_guard<std::mutex> guard(component->m_component_mutex);
+          messages = component->generate_mavlink_messages();
+          next_deadline =
+              std::min(next_deadline, component->get_next_deadline());
+        }
         send_messages_ground_unit(messages);
       }
     }
     const auto loopDelta = std::chrono::steady_clock::now() - loopBegin;
-    if (loopDelta > loop_intervall) {
-      // We can't keep up with the wanted loop interval
-      m_console->debug(
-          "Warning AirTelemetry cannot keep up with the wanted loop interval. "
-          "Took {}",
-          openhd::util::time_readable(loopDelta));
-    } else {
-      const auto sleepTime = loop_intervall - loopDelta;
-      // send out in X second intervals
-      std::this_thread::sleep_for(loop_intervall);
+    if (loopDelta > std::chrono::milliseconds(100)) {
+      m_console->debug("Warning AirTelemetry generating messages took {}",
+                       openhd::util::time_readable(loopDelta));
     }
+    m_scheduler.wait_until(next_deadline);
   }
 }
 
@@ -179,7 +183,8 @@ std::string AirTelemetry::create_debug() {
 
 void AirTelemetry::add_settings_generic(
     const std::vector<openhd::Setting>& settings) {
-  std::lock_guard<std::mutex> guard(m_components_lock);
+  std::lock_guard<std::mutex> guard(
+      m_generic_mavlink_param_provider->m_component_mutex);
   m_generic_mavlink_param_provider->add_params(settings);
   m_console->debug("Added parameter component");
 }
@@ -196,11 +201,17 @@ void AirTelemetry::add_settings_camera_component(
       _sys_id, cam_comp_id, std::chrono::seconds(1));
   param_server->add_params(settings);
   param_server->set_ready();
-  std::lock_guard<std::mutex> guard(m_components_lock);
-  m_components.push_back(param_server);
+  add_component(param_server);
   m_console->debug("Added camera component");
 }
 
+void AirTelemetry::add_component(std::shared_ptr<MavlinkComponent> component) {
+  component->set_scheduler(&m_scheduler);
+  m_components.update([&](MavlinkDispatchTable& table) {
+    table.add_component(std::move(component));
+  });
+}
+
 std::vector<openhd::Setting> AirTelemetry::get_all_settings() {
   std::vector<openhd::Setting> ret{};
   using namespace openhd::telemetry;
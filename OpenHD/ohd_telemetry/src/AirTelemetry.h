@@ -29,8 +29,10 @@
 #include "endpoints/SerialEndpoint.h"
 #include "internal/OHDMainComponent.h"
 #include "openhd_link_statistics.hpp"
+#include "openhd_atomic_snapshot.h"
 #include "openhd_platform.h"
 #include "openhd_settings_imp.h"
+#include "routing/MavlinkDispatchTable.hpp"
 #include "routing/MavlinkSystem.hpp"
 //
 #include "AirTelemetrySettings.h"
@@ -57,6 +59,8 @@ class AirTelemetry : public MavlinkSystem {
    * @param enableExtendedLogging be really verbose on logging.
    */
   void loop_infinite(bool& terminate, bool enableExtendedLogging = false);
+  // Makes loop_infinite() check terminate right away
+  void wake_up_loop() { m_scheduler.notify(); }
   /**
    * @return verbose string about the current state, for debugging
    */
@@ -106,10 +110,16 @@ class AirTelemetry : public MavlinkSystem {
   std::unique_ptr<SerialEndpointManager> m_fc_serial;
   // send/receive data via wb
   std::unique_ptr<WBEndpoint> m_wb_endpoint;
+  // The loop thread sleeps until the next component deadline.
+  // Declared before the components, which keep a pointer to it.
+  TelemetryScheduler m_scheduler;
+  // Upper bound, such that terminate is noticed even without wake_up_loop()
+  static constexpr auto MAX_LOOP_SLEEP = std::chrono::seconds(1);
   // shared because we also push it onto our components list
   std::shared_ptr<OHDMainComponent> m_ohd_main_component;
-  std::mutex m_components_lock;
-  std::vector<std::shared_ptr<MavlinkComponent>> m_components;
+  // Lock-free on the receive path, updated when a component is added
+  openhd::AtomicSnapshot<MavlinkDispatchTable> m_components;
+  void add_component(std::shared_ptr<MavlinkComponent> component);
   std::shared_ptr<XMavlinkParamProvider> m_generic_mavlink_param_provider;
   // rpi only, allow changing gpios via settings
   std::unique_ptr<openhd::telemetry::rpi::GPIOControl> m_opt_gpio_control =
@@ -23,6 +23,7 @@
 
 #include "GroundTelemetry.h"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 
@@ -58,7 +59,7 @@ GroundTelemetry::GroundTelemetry() : MavlinkSystem(OHD_SYS_ID_GROUND) {
         });
   }
   m_ohd_main_component = std::make_shared<OHDMainComponent>(_sys_id, false);
-  m_components.push_back(m_ohd_main_component);
+  add_component(m_ohd_main_component);
 #ifdef OPENHD_TELEMETRY_SDL_FOR_JOYSTICK_FOUND
   if (m_gnd_settings->get_settings().enable_rc_over_joystick) {
     enable_joystick();
@@ -74,7 +75,7 @@ GroundTelemetry::GroundTelemetry() : MavlinkSystem(OHD_SYS_ID_GROUND) {
   m_generic_mavlink_param_provider = std::make_shared<XMavlinkParamProvider>(
       _sys_id, MAV_COMP_ID_ONBOARD_COMPUTER);
   m_generic_mavlink_param_provider->add_params(get_all_settings());
-  m_components.push_back(m_generic_mavlink_param_provider);
+  add_component(m_generic_mavlink_param_provider);
   setup_uart();
   openhd::ExternalDeviceManager::instance().register_listener(
       [this](openhd::ExternalDevice external_device, bool connected) {
@@ -113,6 +114,8 @@ void GroundTelemetry::on_messages_air_unit(
   // 17.April: One exception - timesync
   for (const auto& msg : messages) {
     if (msg.m.msgid == MAVLINK_MSG_ID_TIMESYNC) {
+      std::lock_guard<std::mutex> guard(
+          m_ohd_main_component->m_component_mutex);
       m_ohd_main_component->handle_timesync_message(msg);
     }
   }
@@ -169,12 +172,11 @@ void GroundTelemetry::on_messages_ground_station_clients(
   // OpenHD components running on the ground station don't need to talk to the
   // air unit. This is not exactly following the mavlink routing standard, but
   // saves a lot of bandwidth.
-  std::lock_guard<std::mutex> guard(m_components_lock);
-  for (auto& component : m_components) {
-    const auto responses = component->process_mavlink_messages(messages);
-    // for now, send to the ground station clients only
-    send_messages_ground_station_clients(responses);
-  }
+  m_components.get()->dispatch(
+      messages, [this](const std::vector<MavlinkMessage>& responses) {
+        // for now, send to the ground station clients only
+        send_messages_ground_station_clients(responses);
+      });
 }
 
 void GroundTelemetry::send_messages_ground_station_clients(
@@ -199,12 +201,11 @@ void GroundTelemetry::send_messages_air_unit(
 void GroundTelemetry::loop_infinite(bool& terminate,
                                     const bool enableExtendedLogging) {
   const auto log_intervall = std::chrono::seconds(5);
-  const auto loop_intervall = std::chrono::milliseconds(100);
   auto last_log = std::chrono::steady_clock::now();
   while (!terminate) {
     const auto loopBegin = std::chrono::steady_clock::now();
-    if (std::chrono::steady_clock::now() - last_log >= log_intervall) {
-      last_log = std::chrono::steady_clock::now();
+    if (loopBegin - last_log >= log_intervall) {
+      last_log = loopBegin;
       // m_console->debug("GroundTelemetry::loopInfinite()");
       //  for debugging, check if any of the endpoints is not alive
       if (enableExtendedLogging && m_wb_endpoint) {
@@ -214,38 +215,51 @@ void GroundTelemetry::loop_infinite(bool& terminate,
         m_console->debug(m_gcs_endpoint->createInfo());
       }
     }
-    // send messages to the ground station in regular intervals, includes
+    auto next_deadline = std::min(last_log + log_intervall,
+                                  loopBegin + MAX_LOOP_SLEEP);
+    // send messages to the ground station when they are due, includes
     // heartbeat. everything else is handled by the callbacks and their threads
     {
       // NOTE: No component from the ground station ever needs to talk to the
       // air unit / FC itself
-      std::lock_guard<std::mutex> guard(m_components_lock);
-      for (auto& component : m_components) {
+      bool video_stats_sent = false;
+      const auto components = m_components.get();
+      for (auto& component : components->get_components()) {
         assert(component);
-        const auto messages = component->generate_mavlink_messages();
+        std::vector<MavlinkMessage> messages;
+        {
+          std::lock_guard<std::mutex> guard(component->m_component_mutex);
+          messages = component->generate_mavlink_messages();
+          next_deadline =
+              std::min(next_deadline, component->get_next_deadline());
+        }
         send_messages_ground_station_clients(messages);
-        // exception: timesync
+        // exception(s): timesync
         for (const auto& msg : messages) {
           if (msg.m.msgid == MAVLINK_MSG_ID_TIMESYNC) {
             m_console->debug("Sending timesync to air");
             send_messages_air_unit({msg});
           }
+          // and the video rx stats, which drive the air adaptive FEC.
+          // Throttled, since the uplink is scarce.
+          if (msg.m.msgid == MAVLINK_MSG_ID_OPENHD_STATS_WB_VIDEO_GROUND &&
+              loopBegin - m_last_video_stats_to_air >=
+                  VIDEO_STATS_TO_AIR_INTERVAL) {
+            send_messages_air_unit({msg});
+            video_stats_sent = true;
+          }
         }
       }
+      if (video_stats_sent) {
+        m_last_video_stats_to_air = loopBegin;
+      }
     }
     const auto loopDelta = std::chrono::steady_clock::now() - loopBegin;
-    if (loopDelta > loop_intervall) {
-      // We can't keep up with the wanted loop interval
-      // We can't keep up with the wanted loop interval
-      m_console->debug(
-          "Warning GroundTelemetry cannot keep up with the wanted loop "
-          "interval. Took {}",
-          openhd::util::time_readable(loopDelta));
-    } else {
-      const auto sleepTime = loop_intervall - loopDelta;
-      // send out in X second intervals
-      std::this_thread::sleep_for(loop_intervall);
+    if (loopDelta > std::chrono::milliseconds(100)) {
+      m_console->debug("Warning GroundTelemetry generating messages took {}",
+                       openhd::util::time_readable(loopDelta));
     }
+    m_scheduler.wait_until(next_deadline);
   }
 }
 
@@ -263,7 +277,8 @@ std::string GroundTelemetry::create_debug() const {
 
 void GroundTelemetry::add_settings_generic(
     const std::vector<openhd::Setting>& settings) {
-  std::lock_guard<std::mutex> guard(m_components_lock);
+  std::lock_guard<std::mutex> guard(
+      m_generic_mavlink_param_provider->m_component_mutex);
   m_generic_mavlink_param_provider->add_params(settings);
   m_console->debug("Added parameter component");
 }
@@ -272,6 +287,14 @@ void GroundTelemetry::settings_generic_ready() {
   m_generic_mavlink_param_provider->set_ready();
 }
 
+void GroundTelemetry::add_component(
+    std::shared_ptr<MavlinkComponent> component) {
+  component->set_scheduler(&m_scheduler);
+  m_components.update([&](MavlinkDispatchTable& table) {
+    table.add_component(std::move(component));
+  });
+}
+
 void GroundTelemetry::add_external_ground_station_ip(
     const openhd::ExternalDevice& ext_device) {
   m_console->debug("add_external_ground_station_ip {}", ext_device.to_string());
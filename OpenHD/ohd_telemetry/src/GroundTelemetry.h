@@ -35,7 +35,9 @@
 #include "openhd_external_device.h"
 #include "openhd_link.hpp"
 #include "openhd_settings_imp.h"
+#include "openhd_atomic_snapshot.h"
 #include "openhd_spdlog.h"
+#include "routing/MavlinkDispatchTable.hpp"
 
 #ifdef OPENHD_TELEMETRY_SDL_FOR_JOYSTICK_FOUND
 #include "rc/JoystickReader.h"
@@ -57,6 +59,8 @@ class GroundTelemetry : public MavlinkSystem {
    * @param enableExtendedLogging be really verbose on logging.
    */
   void loop_infinite(bool& terminate, bool enableExtendedLogging = false);
+  // Makes loop_infinite() check terminate right away
+  void wake_up_loop() { m_scheduler.notify(); }
   /**
    * @return verbose string about the current state, for debugging
    */
@@ -113,9 +117,19 @@ class GroundTelemetry : public MavlinkSystem {
   std::unique_ptr<TCPEndpoint> m_tcp_server = nullptr;
   // send/receive data via wb
   std::unique_ptr<WBEndpoint> m_wb_endpoint;
+  // The loop thread sleeps until the next component deadline.
+  // Declared before the components, which keep a pointer to it.
+  TelemetryScheduler m_scheduler;
+  // Upper bound, such that terminate is noticed even without wake_up_loop()
+  static constexpr auto MAX_LOOP_SLEEP = std::chrono::seconds(1);
+  // Ground video rx stats are forwarded to the air unit (adaptive FEC)
+  static constexpr auto VIDEO_STATS_TO_AIR_INTERVAL =
+      std::chrono::milliseconds(500);
+  std::chrono::steady_clock::time_point m_last_video_stats_to_air{};
   std::shared_ptr<OHDMainComponent> m_ohd_main_component;
-  std::mutex m_components_lock;
-  std::vector<std::shared_ptr<MavlinkComponent>> m_components;
+  // Lock-free on the receive path, updated when a component is added
+  openhd::AtomicSnapshot<MavlinkDispatchTable> m_components;
+  void add_component(std::shared_ptr<MavlinkComponent> component);
   std::shared_ptr<XMavlinkParamProvider> m_generic_mavlink_param_provider;
   //
 #ifdef OPENHD_TELEMETRY_SDL_FOR_JOYSTICK_FOUND
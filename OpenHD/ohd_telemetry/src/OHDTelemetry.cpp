@@ -50,6 +50,8 @@ OHDTelemetry::OHDTelemetry(OHDProfile profile1, bool enableExtendedLogging)
 
 OHDTelemetry::~OHDTelemetry() {
   m_loop_thread_terminate = true;
+  if (m_air_telemetry) m_air_telemetry->wake_up_loop();
+  if (m_ground_telemetry) m_ground_telemetry->wake_up_loop();
   m_loop_thread->join();
 }
 
@@ -31,6 +31,7 @@
 MEndpoint::MEndpoint(std::string tag, bool debug_mavlink_msg_packet_loss)
     : TAG(std::move(tag)),
       m_mavlink_channel(checkoutFreeChannel()),
+      m_frame_scanner(m_mavlink_channel),
       m_debug_mavlink_msg_packet_loss(debug_mavlink_msg_packet_loss) {
   openhd::log::get_default()->debug(
       "{} using channel:{} debug_mavlink_msg_packet_los:{}", TAG,
@@ -39,19 +40,26 @@ MEndpoint::MEndpoint(std::string tag, bool debug_mavlink_msg_packet_loss)
 
 void MEndpoint::sendMessages(const std::vector<MavlinkMessage>& messages) {
   if (messages.empty()) return;
-  m_tx_n_bytes += get_size(messages);
-  /*for(const auto& msg: messages){
-    if(msg.m.msgid==MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE){
-      openhd::log::get_default()->debug("Send rc channels override");
-    }
-  }*/
-  // openhd::log::create_or_get(TAG)->debug("N messages
-  // send:{}",messages.size());
-  const auto res = sendMessagesImpl(messages);
+  std::vector<AggregatedMavlinkPacket> packets;
+  int n_bytes;
+  {
+    std::lock_guard<std::mutex> guard(m_tx_free_buffers_mutex);
+    n_bytes = aggregate_pack_messages(messages, get_tx_mtu(), packets,
+                                      &m_tx_free_buffers);
+  }
+  m_tx_n_bytes += n_bytes;
+  const auto res = sendMessagesImpl(packets);
   m_n_messages_sent += messages.size();
   if (!res) {
     m_n_messages_send_failed += messages.size();
   }
+  std::lock_guard<std::mutex> guard(m_tx_free_buffers_mutex);
+  for (auto& packet : packets) {
+    // Still referenced (e.g. queued for wb tx) - let the owner free it.
+    if (packet.aggregated_data.use_count() != 1) continue;
+    if (m_tx_free_buffers.size() >= MAX_N_TX_FREE_BUFFERS) break;
+    m_tx_free_buffers.push_back(std::move(packet.aggregated_data));
+  }
 }
 
 void MEndpoint::registerCallback(MAV_MSG_CALLBACK cb) {
@@ -82,24 +90,18 @@ void MEndpoint::parseNewData(const uint8_t* data, const int data_len) {
   //"<<MavlinkHelpers::raw_content(data,data_len)<<"\n";
   m_rx_n_bytes += data_len;
   std::vector<MavlinkMessage> messages;
-  mavlink_message_t msg;
-  for (int i = 0; i < data_len; i++) {
-    uint8_t res = mavlink_parse_char(m_mavlink_channel, (uint8_t)data[i], &msg,
-                                     &receiveMavlinkStatus);
-    if (res) {
-      messages.push_back(MavlinkMessage{msg});
-      // From
-      // https://github.com/mavlink/c_uart_interface_example/blob/master/serial_port.cpp
-      if ((m_last_status.packet_rx_drop_count !=
-           receiveMavlinkStatus.packet_rx_drop_count) &&
-          m_debug_mavlink_msg_packet_loss) {
-        openhd::log::get_default()->warn(
-            "DROPPED {} PACKETS", receiveMavlinkStatus.packet_rx_drop_count);
-      }
-      m_last_status = receiveMavlinkStatus;
-    }
+  m_frame_scanner.parse(data, data_len, messages, receiveMavlinkStatus);
+  if (messages.empty()) return;
+  // From
+  // https://github.com/mavlink/c_uart_interface_example/blob/master/serial_port.cpp
+  if ((m_last_status.packet_rx_drop_count !=
+       receiveMavlinkStatus.packet_rx_drop_count) &&
+      m_debug_mavlink_msg_packet_loss) {
+    openhd::log::get_default()->warn("DROPPED {} PACKETS",
+                                     receiveMavlinkStatus.packet_rx_drop_count);
   }
-  onNewMavlinkMessages(messages);
+  m_last_status = receiveMavlinkStatus;
+  onNewMavlinkMessages(std::move(messages));
 }
 
 void MEndpoint::onNewMavlinkMessages(std::vector<MavlinkMessage> messages) {
@@ -109,7 +111,7 @@ void MEndpoint::onNewMavlinkMessages(std::vector<MavlinkMessage> messages) {
   lastMessage = std::chrono::steady_clock::now();
   m_n_messages_received += messages.size();
   if (m_callback != nullptr) {
-    m_callback(messages);
+    m_callback(std::move(messages));
   } else {
     openhd::log::get_default()->warn(
         "No callback set,did you forget to add it ?");
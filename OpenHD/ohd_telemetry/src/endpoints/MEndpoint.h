@@ -33,6 +33,7 @@
 
 #include "../mav_helper.h"
 #include "../mav_include.h"
+#include "MavlinkFrameScanner.h"
 #include "openhd_spdlog.h"
 
 // Mavlink Endpoint
@@ -100,8 +101,12 @@ class MEndpoint {
   // Must be overridden by the implementation
   // Returns true if the message(s) have been properly sent (e.g. a connection
   // exists on connection-based endpoints) false otherwise
+  // The messages have already been packed (once, in sendMessages()) into
+  // chunks of at most get_tx_mtu() bytes.
   virtual bool sendMessagesImpl(
-      const std::vector<MavlinkMessage>& messages) = 0;
+      const std::vector<AggregatedMavlinkPacket>& packets) = 0;
+  // Max size of one aggregated packet handed to sendMessagesImpl()
+  virtual uint32_t get_tx_mtu() const { return 1024; }
 
  private:
   MAV_MSG_CALLBACK m_callback = nullptr;
@@ -110,6 +115,7 @@ class MEndpoint {
   void onNewMavlinkMessages(std::vector<MavlinkMessage> messages);
   mavlink_status_t receiveMavlinkStatus{};
   const uint8_t m_mavlink_channel;
+  MavlinkFrameScanner m_frame_scanner;
   std::chrono::steady_clock::time_point lastMessage{};
   int m_n_messages_received = 0;
   // sendMessage() might be called by different threads.
@@ -122,12 +128,19 @@ class MEndpoint {
 
  private:
   // Used to measure incoming / outgoing bits per second
-  int m_tx_n_bytes = 0;
+  std::atomic<int> m_tx_n_bytes = 0;
   int m_rx_n_bytes = 0;
 
  private:
   const bool m_debug_mavlink_msg_packet_loss;
   mavlink_status_t m_last_status;
+
+ private:
+  // Packed chunks that are no longer referenced by the implementation (e.g.
+  // UDP / TCP send synchronously) are recycled instead of re-allocated.
+  std::mutex m_tx_free_buffers_mutex;
+  std::vector<std::shared_ptr<std::vector<uint8_t>>> m_tx_free_buffers;
+  static constexpr size_t MAX_N_TX_FREE_BUFFERS = 8;
 };
 
 #endif  // XMAVLINKSERVICE_MENDPOINT_H
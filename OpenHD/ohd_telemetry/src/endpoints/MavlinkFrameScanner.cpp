@@ -0,0 +1,176 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "MavlinkFrameScanner.h"
+
+#include <cstring>
+
+// Returns a pointer to the first mavlink v1 / v2 start marker in [begin,end),
+// nullptr if there is none. Checks 8 bytes at a time (the usual "has zero
+// byte" trick on data xor marker).
+static const uint8_t* find_stx(const uint8_t* begin, const uint8_t* end) {
+  static constexpr uint64_t ONES = 0x0101010101010101ULL;
+  static constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+  static constexpr uint64_t STX_V2 = ONES * MAVLINK_STX;
+  static constexpr uint64_t STX_V1 = ONES * MAVLINK_STX_MAVLINK1;
+  const uint8_t* p = begin;
+  while (end - p >= 8) {
+    uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    const uint64_t x2 = word ^ STX_V2;
+    const uint64_t x1 = word ^ STX_V1;
+    if ((((x2 - ONES) & ~x2) | ((x1 - ONES) & ~x1)) & HIGHS) break;
+    p += 8;
+  }
+  for (; p < end; p++) {
+    if (*p == MAVLINK_STX || *p == MAVLINK_STX_MAVLINK1) return p;
+  }
+  return nullptr;
+}
+
+MavlinkFrameScanner::MavlinkFrameScanner(uint8_t mavlink_channel)
+    : m_mavlink_channel(mavlink_channel),
+      m_chan_status(mavlink_get_channel_status(mavlink_channel)) {}
+
+bool MavlinkFrameScanner::parser_is_idle() const {
+  return m_chan_status->parse_state == MAVLINK_PARSE_STATE_UNINIT ||
+         m_chan_status->parse_state == MAVLINK_PARSE_STATE_IDLE;
+}
+
+void MavlinkFrameScanner::parse(const uint8_t* data, const int data_len,
+                                std::vector<MavlinkMessage>& out,
+                                mavlink_status_t& r_status) {
+  // With signing enabled, the signature has to be checked by the state machine
+  const bool fast_path_allowed = m_chan_status->signing == nullptr;
+  const uint8_t* const end = data + data_len;
+  const uint8_t* p = data;
+  while (p < end) {
+    if (fast_path_allowed && parser_is_idle()) {
+      // While idle, mavlink_parse_char just drops anything that is not a STX
+      p = find_stx(p, end);
+      if (p == nullptr) break;
+      const int consumed =
+          try_parse_frame_in_place(p, static_cast<int>(end - p), out, r_status);
+      if (consumed > 0) {
+        p += consumed;
+        m_n_frames_fast_path++;
+        continue;
+      }
+    }
+    mavlink_message_t msg;
+    if (mavlink_parse_char(m_mavlink_channel, *p, &msg, &r_status)) {
+      out.push_back(MavlinkMessage{msg});
+    }
+    m_n_bytes_slow_path++;
+    p++;
+  }
+}
+
+int MavlinkFrameScanner::try_parse_frame_in_place(
+    const uint8_t* frame, const int available, std::vector<MavlinkMessage>& out,
+    mavlink_status_t& r_status) {
+  const bool is_v1 = frame[0] == MAVLINK_STX_MAVLINK1;
+  const int header_len = is_v1 ? MAVLINK_CORE_HEADER_MAVLINK1_LEN + 1
+                               : MAVLINK_CORE_HEADER_LEN + 1;
+  if (available < header_len) return 0;
+  const uint8_t payload_len = frame[1];
+  uint8_t incompat_flags = 0;
+  uint8_t compat_flags = 0;
+  uint32_t msgid;
+  const uint8_t* header_rest;
+  if (is_v1) {
+    header_rest = frame + 2;
+    msgid = frame[5];
+  } else {
+    incompat_flags = frame[2];
+    compat_flags = frame[3];
+    // The state machine rejects those (and resyncs differently)
+    if ((incompat_flags & ~MAVLINK_IFLAG_MASK) != 0) return 0;
+    header_rest = frame + 4;
+    msgid = frame[7] | (frame[8] << 8) | (frame[9] << 16);
+  }
+  const int signature_len = (incompat_flags & MAVLINK_IFLAG_SIGNED)
+                                ? MAVLINK_SIGNATURE_BLOCK_LEN
+                                : 0;
+  const int frame_len =
+      header_len + payload_len + MAVLINK_NUM_CHECKSUM_BYTES + signature_len;
+  // Split across reads - the state machine keeps the partial frame for us
+  if (available < frame_len) return 0;
+  const mavlink_msg_entry_t* entry = mavlink_get_msg_entry(msgid);
+#ifdef MAVLINK_CHECK_MESSAGE_LENGTH
+  if (entry == nullptr || payload_len < entry->min_msg_len ||
+      payload_len > entry->max_msg_len) {
+    return 0;
+  }
+#endif
+  uint16_t crc;
+  crc_init(&crc);
+  crc_accumulate_buffer(&crc, reinterpret_cast<const char*>(frame + 1),
+                        header_len - 1 + payload_len);
+  crc_accumulate(entry ? entry->crc_extra : 0, &crc);
+  const uint8_t* ck = frame + header_len + payload_len;
+  if (ck[0] != (crc & 0xFF) || ck[1] != (crc >> 8)) return 0;
+  // Valid frame - copy it out exactly like the state machine would
+  out.emplace_back();
+  mavlink_message_t& msg = out.back().m;
+  msg.magic = frame[0];
+  msg.len = payload_len;
+  msg.incompat_flags = incompat_flags;
+  msg.compat_flags = compat_flags;
+  msg.seq = header_rest[0];
+  msg.sysid = header_rest[1];
+  msg.compid = header_rest[2];
+  msg.msgid = msgid;
+  auto* payload = reinterpret_cast<uint8_t*>(_MAV_PAYLOAD_NON_CONST(&msg));
+  std::memcpy(payload, frame + header_len, payload_len);
+  // (already zero-filled up to max_msg_len, since msg is value initialized)
+  msg.checksum = crc;
+  msg.ck[0] = ck[0];
+  msg.ck[1] = ck[1];
+  if (signature_len > 0) {
+    std::memcpy(msg.signature, ck + MAVLINK_NUM_CHECKSUM_BYTES, signature_len);
+  }
+  // Same bookkeeping as at the end of mavlink_frame_char_buffer()
+  if (is_v1) {
+    m_chan_status->flags |= MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+  } else {
+    m_chan_status->flags &= ~MAVLINK_STATUS_FLAG_IN_MAVLINK1;
+  }
+  m_chan_status->msg_received = MAVLINK_FRAMING_OK;
+  m_chan_status->parse_state = MAVLINK_PARSE_STATE_IDLE;
+  m_chan_status->packet_idx = payload_len;
+  m_chan_status->current_rx_seq = msg.seq;
+  if (m_chan_status->packet_rx_success_count == 0) {
+    m_chan_status->packet_rx_drop_count = 0;
+  }
+  m_chan_status->packet_rx_success_count++;
+  r_status.msg_received = m_chan_status->msg_received;
+  r_status.parse_state = m_chan_status->parse_state;
+  r_status.packet_idx = m_chan_status->packet_idx;
+  r_status.current_rx_seq = m_chan_status->current_rx_seq + 1;
+  r_status.packet_rx_success_count = m_chan_status->packet_rx_success_count;
+  r_status.packet_rx_drop_count = m_chan_status->parse_error;
+  r_status.flags = m_chan_status->flags;
+  m_chan_status->parse_error = 0;
+  return frame_len;
+}
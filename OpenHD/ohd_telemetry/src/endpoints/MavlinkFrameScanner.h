@@ -0,0 +1,70 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_MAVLINKFRAMESCANNER_H_
+#define OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_MAVLINKFRAMESCANNER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "../mav_include.h"
+
+/**
+ * Drop-in replacement for feeding each received byte through
+ * mavlink_parse_char().
+ * While the channel's parser is idle (not inside a frame), the scanner jumps
+ * to the next STX marker (8 bytes at a time) and, if the whole frame is inside
+ * the given buffer, validates header and CRC in place and copies the message
+ * out in one go. Everything else - frames split across reads, frames with a bad
+ * CRC, unsupported flags, message signing - is handed to the byte-state
+ * machine, such that the output is exactly what mavlink_parse_char would have
+ * produced (see test_mavlink_frame_scanner).
+ */
+class MavlinkFrameScanner {
+ public:
+  explicit MavlinkFrameScanner(uint8_t mavlink_channel);
+  /**
+   * Parse new data, append all fully parsed messages to @param out.
+   * @param r_status updated the same way mavlink_parse_char() updates it.
+   */
+  void parse(const uint8_t* data, int data_len,
+             std::vector<MavlinkMessage>& out, mavlink_status_t& r_status);
+  // For debugging
+  uint64_t get_n_frames_fast_path() const { return m_n_frames_fast_path; }
+  uint64_t get_n_bytes_slow_path() const { return m_n_bytes_slow_path; }
+
+ private:
+  const uint8_t m_mavlink_channel;
+  mavlink_status_t* const m_chan_status;
+  uint64_t m_n_frames_fast_path = 0;
+  uint64_t m_n_bytes_slow_path = 0;
+  [[nodiscard]] bool parser_is_idle() const;
+  // Returns the n of bytes consumed if a complete and valid frame starts at
+  // @param frame (message is appended to out), 0 if the byte-state machine has
+  // to deal with it.
+  int try_parse_frame_in_place(const uint8_t* frame, int available,
+                               std::vector<MavlinkMessage>& out,
+                               mavlink_status_t& r_status);
+};
+
+#endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_MAVLINKFRAMESCANNER_H_
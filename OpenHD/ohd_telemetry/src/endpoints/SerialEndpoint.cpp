@@ -80,11 +80,10 @@ SerialEndpoint::SerialEndpoint(std::string TAG1,
 SerialEndpoint::~SerialEndpoint() { stop(); }
 
 bool SerialEndpoint::sendMessagesImpl(
-    const std::vector<MavlinkMessage>& messages) {
-  auto message_buffers = aggregate_pack_messages(messages);
+    const std::vector<AggregatedMavlinkPacket>& packets) {
   bool success = true;
-  for (const auto& message_buffer : message_buffers) {
-    if (!write_data_serial(*message_buffer.aggregated_data)) {
+  for (const auto& packet : packets) {
+    if (!write_data_serial(*packet.aggregated_data)) {
       success = false;
     }
   }
@@ -85,7 +85,8 @@ class SerialEndpoint : public MEndpoint {
 
  private:
   bool uart_log_warning_once = false;
-  bool sendMessagesImpl(const std::vector<MavlinkMessage>& messages) override;
+  bool sendMessagesImpl(
+      const std::vector<AggregatedMavlinkPacket>& packets) override;
   static int define_from_baudrate(int baudrate);
   static int setup_port(const HWOptions& options,
                         std::shared_ptr<spdlog::logger> m_console);
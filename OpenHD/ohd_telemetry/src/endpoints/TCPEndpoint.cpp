@@ -36,10 +36,9 @@ TCPEndpoint::TCPEndpoint(openhd::TCPServer::Config config)
     : MEndpoint("TCPServer"), openhd::TCPServer("MTCPServer", config) {}
 
 bool TCPEndpoint::sendMessagesImpl(
-    const std::vector<MavlinkMessage>& messages) {
-  auto message_buffers = aggregate_pack_messages(messages, 1024);
-  for (const auto& message_buffer : message_buffers) {
-    const auto& buff = message_buffer.aggregated_data;
+    const std::vector<AggregatedMavlinkPacket>& packets) {
+  for (const auto& packet : packets) {
+    const auto& buff = packet.aggregated_data;
     send_message_to_all_clients(buff->data(), buff->size());
   }
   return true;
@@ -36,7 +36,8 @@ class TCPEndpoint : public MEndpoint, openhd::TCPServer {
   static constexpr int DEFAULT_PORT = 5760;
 
  private:
-  bool sendMessagesImpl(const std::vector<MavlinkMessage>& messages) override;
+  bool sendMessagesImpl(
+      const std::vector<AggregatedMavlinkPacket>& packets) override;
   std::mutex m_rx_parse_mutex;
   void on_external_device(std::string ip, int port, bool connected) override;
   void on_packet_any_tcp_client(const uint8_t* data, int data_len) override;
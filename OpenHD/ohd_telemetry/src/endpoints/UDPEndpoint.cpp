@@ -23,6 +23,7 @@
 
 #include "UDPEndpoint.h"
 
+#include <algorithm>
 #include <cassert>
 #include <utility>
 
@@ -35,56 +36,63 @@ UDPEndpoint::UDPEndpoint(const std::string& TAG, int senderPort,
       SEND_PORT(senderPort),
       RECV_PORT(receiverPort),
       SENDER_IP(std::move(senderIp)),
-      RECV_IP(std::move(receiverIp)) {
+      RECV_IP(std::move(receiverIp)),
+      m_main_dest(openhd::create_udp_destination(SENDER_IP, SEND_PORT)) {
   m_console = openhd::log::create_or_get(TAG);
   assert(m_console);
-  const auto cb = [this](const uint8_t* payload,
-                         const std::size_t payloadSize) mutable {
-    this->parseNewData(payload, (int)payloadSize);
+  const auto cb = [this](const openhd::UDPReceiver::ReceivedPacket* packets,
+                         const std::size_t n_packets) mutable {
+    for (std::size_t i = 0; i < n_packets; i++) {
+      this->parseNewData(packets[i].data, (int)packets[i].size);
+    }
   };
-  m_receiver_sender =
-      std::make_unique<openhd::UDPReceiver>(RECV_IP, RECV_PORT, cb);
+  // GCS tools send one (small) mavlink message per datagram, but might send
+  // many of them at once (e.g. parameter / mission transfer).
+  openhd::UDPReceiver::BatchConfig rx_config{};
+  rx_config.max_n_packets = 16;
+  rx_config.max_packet_size = openhd::UDPReceiver::UDP_PACKET_MAX_SIZE;
+  m_receiver_sender = std::make_unique<openhd::UDPReceiver>(RECV_IP, RECV_PORT,
+                                                            cb, rx_config);
   m_receiver_sender->runInBackground();
 }
 
 UDPEndpoint::~UDPEndpoint() { m_receiver_sender->stopBackground(); }
 
 bool UDPEndpoint::sendMessagesImpl(
-    const std::vector<MavlinkMessage>& messages) {
-  auto message_buffers = aggregate_pack_messages(messages);
-  const auto other_ips = get_all_curr_dest_ips();
-  for (const auto& message_buffer : message_buffers) {
-    m_receiver_sender->forwardPacketViaUDP(
-        SENDER_IP, SEND_PORT, message_buffer.aggregated_data->data(),
-        message_buffer.aggregated_data->size());
-    for (const auto& ip : other_ips) {
-      m_receiver_sender->forwardPacketViaUDP(
-          ip, SEND_PORT, message_buffer.aggregated_data->data(),
-          message_buffer.aggregated_data->size());
+    const std::vector<AggregatedMavlinkPacket>& packets) {
+  const auto other_dests = m_other_dests.get();
+  for (const auto& packet : packets) {
+    const auto& buff = *packet.aggregated_data;
+    m_receiver_sender->forwardPacketViaUDP(m_main_dest, buff.data(),
+                                           buff.size());
+    for (const auto& other : *other_dests) {
+      m_receiver_sender->forwardPacketViaUDP(other.addr, buff.data(),
+                                             buff.size());
     }
   }
   return true;
 }
 
 void UDPEndpoint::addAnotherDestIpAddress(const std::string& ip) {
-  std::lock_guard<std::mutex> lock(m_sender_mutex);
   m_console->debug("addAnotherDestIpAddress {}", ip);
-  m_other_dest_ips[ip] = nullptr;
+  m_other_dests.update([&](std::vector<OtherDest>& dests) {
+    for (const auto& dest : dests) {
+      if (dest.ip == ip) return;
+    }
+    dests.push_back(
+        OtherDest{ip, openhd::create_udp_destination(ip, SEND_PORT)});
+  });
 }
 
 void UDPEndpoint::removeAnotherDestIpAddress(const std::string& ip) {
-  std::lock_guard<std::mutex> lock(m_sender_mutex);
   m_console->debug("removeAnotherDestIpAddress {}", ip);
-  m_other_dest_ips.erase(ip);
-}
-
-std::vector<std::string> UDPEndpoint::get_all_curr_dest_ips() {
-  std::vector<std::string> ret;
-  std::lock_guard<std::mutex> lock(m_sender_mutex);
-  for (const auto& [key, value] : m_other_dest_ips) {
-    ret.push_back(key);
-  }
-  return ret;
+  m_other_dests.update([&](std::vector<OtherDest>& dests) {
+    dests.erase(std::remove_if(dests.begin(), dests.end(),
+                               [&](const OtherDest& dest) {
+                                 return dest.ip == ip;
+                               }),
+                dests.end());
+  });
 }
 
 //// Now this is weird, but somehow we get a lot of junk from QGroundControll on
@@ -24,10 +24,11 @@
 #ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_UDPENDPOINT2_H_
 #define OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_UDPENDPOINT2_H_
 
-#include <map>
 #include <thread>
+#include <vector>
 
 #include "MEndpoint.h"
+#include "openhd_atomic_snapshot.h"
 #include "openhd_udp.h"
 
 /**
@@ -53,16 +54,21 @@ class UDPEndpoint : public MEndpoint {
 
  private:
   std::shared_ptr<spdlog::logger> m_console;
-  bool sendMessagesImpl(const std::vector<MavlinkMessage>& messages) override;
+  bool sendMessagesImpl(
+      const std::vector<AggregatedMavlinkPacket>& packets) override;
   const std::string SENDER_IP;
   const int SEND_PORT;
   const std::string RECV_IP;
   const int RECV_PORT;
   std::unique_ptr<openhd::UDPReceiver> m_receiver_sender;
-  //
-  std::mutex m_sender_mutex;
-  std::map<std::string, void*> m_other_dest_ips{};
-  std::vector<std::string> get_all_curr_dest_ips();
+  // SENDER_IP::SEND_PORT
+  const struct sockaddr_in m_main_dest;
+  struct OtherDest {
+    std::string ip;
+    struct sockaddr_in addr;
+  };
+  // Published as an immutable snapshot - read on every send without locking
+  openhd::AtomicSnapshot<std::vector<OtherDest>> m_other_dests;
 };
 
 #endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_ENDPOINTS_UDPENDPOINT2_H_
@@ -48,14 +48,13 @@ WBEndpoint::~WBEndpoint() {
   }
 }
 
-bool WBEndpoint::sendMessagesImpl(const std::vector<MavlinkMessage>& messages) {
-  auto message_buffers = aggregate_pack_messages(messages);
-  for (const auto& message_buffer : message_buffers) {
+bool WBEndpoint::sendMessagesImpl(
+    const std::vector<AggregatedMavlinkPacket>& packets) {
+  for (const auto& packet : packets) {
     if (m_link_handle) {
       std::lock_guard<std::mutex> guard(m_send_messages_mutex);
       m_link_handle->transmit_telemetry_data(
-          {message_buffer.aggregated_data,
-           message_buffer.recommended_n_retransmissions});
+          {packet.aggregated_data, packet.recommended_n_retransmissions});
     }
   }
   return true;
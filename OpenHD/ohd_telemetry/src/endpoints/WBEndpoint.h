@@ -36,7 +36,8 @@ class WBEndpoint : public MEndpoint {
 
  private:
   std::shared_ptr<OHDLink> m_link_handle;
-  bool sendMessagesImpl(const std::vector<MavlinkMessage>& messages) override;
+  bool sendMessagesImpl(
+      const std::vector<AggregatedMavlinkPacket>& packets) override;
   std::mutex m_send_messages_mutex;
 };
 
@@ -148,6 +148,7 @@ static MavlinkMessage pack_vid_air_fec_performance(
   tmp.curr_tx_delay_min_us = stats.curr_tx_delay_min_us;
   tmp.curr_tx_delay_max_us = stats.curr_tx_delay_max_us;
   tmp.curr_tx_delay_avg_us = stats.curr_tx_delay_avg_us;
+  tmp.dummy2 = stats.dummy2;
   mavlink_msg_openhd_stats_wb_video_air_fec_performance_encode(
       system_id, component_id, &msg.m, &tmp);
   return msg;
@@ -165,13 +166,29 @@ static MavlinkMessage pack_vid_gnd(
   tmp.count_blocks_lost = stats.count_blocks_lost;
   tmp.count_blocks_recovered = stats.count_blocks_recovered;
   tmp.count_fragments_recovered = stats.count_fragments_recovered;
-  // tmp.unused0=stats.unused0;
-  // tmp.unused1=stats.unused1;
+  tmp.dummy0 = stats.dummy0;
+  tmp.dummy2 = stats.dummy2;
   mavlink_msg_openhd_stats_wb_video_ground_encode(system_id, component_id,
                                                   &msg.m, &tmp);
   return msg;
 }
 
+static openhd::link_statistics::Xmavlink_openhd_stats_wb_video_ground_t
+unpack_vid_gnd(const mavlink_message_t& msg) {
+  mavlink_openhd_stats_wb_video_ground_t tmp{};
+  mavlink_msg_openhd_stats_wb_video_ground_decode(&msg, &tmp);
+  openhd::link_statistics::Xmavlink_openhd_stats_wb_video_ground_t ret{};
+  ret.link_index = tmp.link_index;
+  ret.curr_incoming_bitrate = tmp.curr_incoming_bitrate;
+  ret.count_blocks_total = tmp.count_blocks_total;
+  ret.count_blocks_lost = tmp.count_blocks_lost;
+  ret.count_blocks_recovered = tmp.count_blocks_recovered;
+  ret.count_fragments_recovered = tmp.count_fragments_recovered;
+  ret.dummy0 = tmp.dummy0;
+  ret.dummy2 = tmp.dummy2;
+  return ret;
+}
+
 static MavlinkMessage pack_vid_gnd_fec_performance(
     const uint8_t system_id, const uint8_t component_id,
     const openhd::link_statistics::
@@ -182,8 +199,7 @@ static MavlinkMessage pack_vid_gnd_fec_performance(
   tmp.curr_fec_decode_time_avg_us = stats.curr_fec_decode_time_avg_us;
   tmp.curr_fec_decode_time_min_us = stats.curr_fec_decode_time_min_us;
   tmp.curr_fec_decode_time_max_us = stats.curr_fec_decode_time_max_us;
-  // tmp.unused0=stats.unused0;
-  // tmp.unused1=stats.unused1;
+  tmp.dummy2 = stats.dummy2;
   mavlink_msg_openhd_stats_wb_video_ground_fec_performance_encode(
       system_id, component_id, &msg.m, &tmp);
   return msg;
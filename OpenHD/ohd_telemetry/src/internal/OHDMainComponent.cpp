@@ -23,6 +23,7 @@
 
 #include "OHDMainComponent.h"
 
+#include <algorithm>
 #include <iostream>
 #include <openhd_global_constants.hpp>
 #include <utility>
@@ -37,13 +38,13 @@
 OHDMainComponent::OHDMainComponent(uint8_t parent_sys_id, bool runsOnAir)
     : RUNS_ON_AIR(runsOnAir),
       MavlinkComponent(parent_sys_id, MAV_COMP_ID_ONBOARD_COMPUTER),
-      m_heartbeats_interval(RUNS_ON_AIR ? std::chrono::milliseconds(500)
-                                        : std::chrono::milliseconds(200)),
-      m_onboard_computer_status_interval(RUNS_ON_AIR
-                                             ? std::chrono::milliseconds(500)
-                                             : std::chrono::milliseconds(200)),
-      m_wb_stats_interval(RUNS_ON_AIR ? std::chrono::milliseconds(500)
-                                      : std::chrono::milliseconds(200)) {
+      m_heartbeat_timer(RUNS_ON_AIR ? std::chrono::milliseconds(500)
+                                    : std::chrono::milliseconds(200)),
+      m_onboard_computer_status_timer(RUNS_ON_AIR
+                                          ? std::chrono::milliseconds(500)
+                                          : std::chrono::milliseconds(200)),
+      m_wb_stats_timer(RUNS_ON_AIR ? std::chrono::milliseconds(500)
+                                   : std::chrono::milliseconds(100)) {
   m_console = openhd::log::create_or_get("t_main_c");
   assert(m_console);
   m_onboard_computer_status_provider =
@@ -52,9 +53,15 @@ OHDMainComponent::OHDMainComponent(uint8_t parent_sys_id, bool runsOnAir)
   if (!RUNS_ON_AIR && config.GEN_ENABLE_LAST_KNOWN_POSITION) {
     m_last_known_position = std::make_unique<LastKnowPosition>();
   }
+  // Forward warnings / errors to the ground station right away
+  openhd::log::MavlinkLogMessageBuffer::instance().register_on_new_message_cb(
+      [this]() { request_generate(); });
 }
 
-OHDMainComponent::~OHDMainComponent() {}
+OHDMainComponent::~OHDMainComponent() {
+  openhd::log::MavlinkLogMessageBuffer::instance().register_on_new_message_cb(
+      nullptr);
+}
 
 std::vector<MavlinkMessage> OHDMainComponent::generate_mavlink_messages() {
   // m_console->debug("InternalTelemetry::generate_mavlink_messages()");
@@ -76,7 +83,7 @@ std::vector<MavlinkMessage> OHDMainComponent::generate_mavlink_messages() {
 }
 
 std::vector<MavlinkMessage> OHDMainComponent::process_mavlink_messages(
-    std::vector<MavlinkMessage> messages) {
+    MavlinkMessageView messages) {
   std::vector<MavlinkMessage> ret{};
   for (const auto& msg : messages) {
     switch (msg.m.msgid) {  // NOLINT(cppcoreguidelines-narrowing-conversions)
@@ -109,6 +116,13 @@ std::vector<MavlinkMessage> OHDMainComponent::process_mavlink_messages(
           m_last_known_position->on_new_position(lat, lon, alt);
         }
       } break;
+      case MAVLINK_MSG_ID_OPENHD_STATS_WB_VIDEO_GROUND: {
+        // The ground unit reports its video rx stats to us (adaptive FEC)
+        if (RUNS_ON_AIR && msg.m.sysid == OHD_SYS_ID_GROUND) {
+          openhd::LinkActionHandler::instance().update_ground_video_stats(
+              openhd::LinkStatisticsHelper::unpack_vid_gnd(msg.m));
+        }
+      } break;
       default:
         break;
     }
@@ -116,6 +130,22 @@ std::vector<MavlinkMessage> OHDMainComponent::process_mavlink_messages(
   return ret;
 }
 
+std::chrono::steady_clock::time_point OHDMainComponent::get_next_deadline()
+    const {
+  return std::min({m_heartbeat_timer.next_due(),
+                   m_onboard_computer_status_timer.next_due(),
+                   m_version_message_timer.next_due(),
+                   m_wb_stats_timer.next_due()});
+}
+
+MavlinkSubscription OHDMainComponent::get_subscription() const {
+  // Keep in sync with process_mavlink_messages
+  return {{MAVLINK_MSG_ID_TIMESYNC, MAVLINK_MSG_ID_COMMAND_LONG,
+           MAVLINK_MSG_ID_GLOBAL_POSITION_INT,
+           MAVLINK_MSG_ID_OPENHD_STATS_WB_VIDEO_GROUND},
+          false};
+}
+
 std::vector<MavlinkMessage> OHDMainComponent::generate_mav_wb_stats() {
   // m_console->debug("OHDMainComponent::generate_mav_wb_stats");
   const auto latest_stats =
@@ -311,9 +341,7 @@ void OHDMainComponent::check_fc_messages_for_actions(
 }
 
 std::optional<MavlinkMessage> OHDMainComponent::create_heartbeat_if_needed() {
-  const auto elapsed = std::chrono::steady_clock::now() - m_last_heartbeat;
-  if (elapsed >= m_heartbeats_interval) {
-    m_last_heartbeat = std::chrono::steady_clock::now();
+  if (m_heartbeat_timer.poll(std::chrono::steady_clock::now())) {
     return MavlinkComponent::create_heartbeat();
   }
   return std::nullopt;
@@ -323,9 +351,7 @@ std::vector<MavlinkMessage>
 OHDMainComponent::create_broadcast_stats_if_needed() {
   std::vector<MavlinkMessage> ret;
   const auto now = std::chrono::steady_clock::now();
-  const auto elapsed_onboard_computer_status = now - m_last_onboard_computer;
-  if (elapsed_onboard_computer_status > m_onboard_computer_status_interval) {
-    m_last_onboard_computer = now;
+  if (m_onboard_computer_status_timer.poll(now)) {
     std::optional<OnboardComputerStatusProvider::ExtraUartInfo> opt_uart_info =
         std::nullopt;
     if (RUNS_ON_AIR) {
@@ -339,16 +365,10 @@ OHDMainComponent::create_broadcast_stats_if_needed() {
     ret.push_back(openhd::LinkStatisticsHelper::generate_sys_status1(
         m_sys_id, m_comp_id, openhd::LinkActionHandler::instance()));
   }
-  {
-    const auto elapsed_version = now - m_last_version_message_tp;
-    if (elapsed_version > m_version_message_interval) {
-      m_last_version_message_tp = now;
-      ret.push_back(generate_ohd_version());
-    }
+  if (m_version_message_timer.poll(now)) {
+    ret.push_back(generate_ohd_version());
   }
-  const auto elapsed_wb = now - m_last_wb_stats;
-  if (elapsed_wb > m_wb_stats_interval) {
-    m_last_wb_stats = now;
+  if (m_wb_stats_timer.poll(now)) {
     OHDUtil::vec_append(ret, generate_mav_wb_stats());
     if (RUNS_ON_AIR) {
       auto cam_stats1 = openhd::LinkActionHandler::instance().get_cam_info(0);
@@ -501,8 +521,10 @@ void OHDMainComponent::handle_timesync_response_self(
       openhd::util::time_readable_ns(round_trip_time_us * 1000),
       local_time_offset);
   if (round_trip_time_us >= 0 && round_trip_time_us < 5 * 1000) {
+    // tc1 is in ns (see handle_timesync_message). Air time + offset = ground
+    // time.
     const auto local_time_offset_adjusted =
-        now_us - round_trip_time_us / 2 - tsync.tc1;
+        now_us - round_trip_time_us / 2 - tsync.tc1 / 1000;
     m_good_timesync_offset_count++;
     m_good_timesync_offset_total += local_time_offset_adjusted;
     if (m_good_timesync_offset_count > 10) {
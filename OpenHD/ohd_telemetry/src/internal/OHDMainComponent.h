@@ -62,7 +62,12 @@ class OHDMainComponent : public MavlinkComponent {
   std::vector<MavlinkMessage> generate_mavlink_messages() override;
   // override from component
   std::vector<MavlinkMessage> process_mavlink_messages(
-      std::vector<MavlinkMessage> messages) override;
+      MavlinkMessageView messages) override;
+  // override from component
+  [[nodiscard]] MavlinkSubscription get_subscription() const override;
+  // override from component
+  [[nodiscard]] std::chrono::steady_clock::time_point get_next_deadline()
+      const override;
   void process_command_self(const mavlink_command_long_t& command,
                             int source_sys_id, int source_comp_id,
                             std::vector<MavlinkMessage>& message_buffer);
@@ -76,23 +81,14 @@ class OHDMainComponent : public MavlinkComponent {
  private:
   const bool RUNS_ON_AIR;
   // Interval in between heartbeats
-  const std::chrono::milliseconds m_heartbeats_interval;
-  std::chrono::steady_clock::time_point m_last_heartbeat =
-      std::chrono::steady_clock::now();
+  openhd::util::IntervalTimer m_heartbeat_timer;
   std::optional<MavlinkMessage> create_heartbeat_if_needed();
   // We have different intervals on air and ground between the different
-  // messages. Always needs to be lower than the telemetry main loop interval.
-  const std::chrono::milliseconds m_onboard_computer_status_interval;
-  std::chrono::steady_clock::time_point m_last_onboard_computer =
-      std::chrono::steady_clock::now();
+  // messages.
+  openhd::util::IntervalTimer m_onboard_computer_status_timer;
   // AIR / GND publishes version in 1 second interval
-  const std::chrono::milliseconds m_version_message_interval =
-      std::chrono::seconds(1);
-  std::chrono::steady_clock::time_point m_last_version_message_tp =
-      std::chrono::steady_clock::now();
-  const std::chrono::milliseconds m_wb_stats_interval;
-  std::chrono::steady_clock::time_point m_last_wb_stats =
-      std::chrono::steady_clock::now();
+  openhd::util::IntervalTimer m_version_message_timer{std::chrono::seconds(1)};
+  openhd::util::IntervalTimer m_wb_stats_timer;
   std::vector<MavlinkMessage> create_broadcast_stats_if_needed();
   [[nodiscard]] std::vector<MavlinkMessage> generate_mav_wb_stats();
   [[nodiscard]] MavlinkMessage generate_ohd_version() const;
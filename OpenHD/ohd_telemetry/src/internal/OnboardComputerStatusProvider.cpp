@@ -25,7 +25,6 @@
 
 #include <set>
 
-#include "onboard_computer_status.hpp"
 #include "onboard_computer_status_rpi.hpp"
 #include "openhd_spdlog_include.h"
 #include "openhd_util_filesystem.h"
@@ -39,15 +38,6 @@ constexpr uint8_t BUS_ADC = ADC_12BIT;
 constexpr uint8_t SHUNT_ADC = ADC_12BIT;
 // INA219 stuff
 
-static int read_cpu_current_frequency_linux_mhz() {
-  static constexpr auto FILEPATH =
-      "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq";
-  auto content = OHDFilesystemUtil::opt_read_file(FILEPATH);
-  if (!content.has_value()) return -1;
-  auto value = OHDUtil::string_to_int(content.value());
-  if (!value.has_value()) return -1;
-  return value.value() / 1000;
-}
 int extract_temperature(const std::string& input) {
   auto pos = input.find("temperature:");
   if (pos != std::string::npos) {
@@ -106,19 +96,15 @@ OnboardComputerStatusProvider::OnboardComputerStatusProvider(bool enable)
     m_ina_219.configure(RANGE, GAIN, BUS_ADC, SHUNT_ADC);
   }
   if (m_enable) {
-    m_calculate_cpu_usage_thread = std::make_unique<std::thread>(
-        &OnboardComputerStatusProvider::calculate_cpu_usage_until_terminate,
-        this);
-    m_calculate_other_thread = std::make_unique<std::thread>(
-        &OnboardComputerStatusProvider::calculate_other_until_terminate, this);
+    m_sample_thread = std::make_unique<std::thread>(
+        &OnboardComputerStatusProvider::sample_until_terminate, this);
   }
 }
 
 OnboardComputerStatusProvider::~OnboardComputerStatusProvider() {
   if (m_enable) {
     terminate = true;
-    m_calculate_cpu_usage_thread->join();
-    m_calculate_other_thread->join();
+    m_sample_thread->join();
   }
 }
 
@@ -128,31 +114,49 @@ OnboardComputerStatusProvider::get_current_status() {
   return m_curr_onboard_computer_status;
 }
 
-void OnboardComputerStatusProvider::calculate_cpu_usage_until_terminate() {
-  while (!terminate) {
-    const auto before = std::chrono::steady_clock::now();
-    const auto value = openhd::onboard::read_cpuload_once_blocking();
-    const auto read_time = std::chrono::steady_clock::now() - before;
-    if (value.has_value()) {
-      // lock mutex and write out
-      std::lock_guard<std::mutex> lock(m_curr_onboard_computer_status_mutex);
-      m_curr_onboard_computer_status.cpu_cores[0] = value.value();
-    }
-    // std::cout<<"Took:"<<std::chrono::duration_cast<std::chrono::milliseconds>(read_time).count()<<"\n";
-    //  top can block up to X seconds, but in case it doesn't make sure we don't
-    //  neccessarily waste cpu here
-    const auto minimum_delay = std::chrono::seconds(1);
-    if (read_time < minimum_delay) {
-      std::this_thread::sleep_for((minimum_delay - read_time));
-    }
+void OnboardComputerStatusProvider::sample_rpi(const int n_samples,
+                                               int8_t& temperature_core,
+                                               int& clock_cpu,
+                                               bool& undervolt) {
+  namespace rpi = openhd::onboard::rpi;
+  const auto temperature = m_sampler.read_temperature_degree();
+  temperature_core = temperature.has_value()
+                         ? static_cast<int8_t>(temperature.value())
+                         : rpi::read_temperature_soc_degree();
+  const auto cpu_freq = m_sampler.read_cpu_frequency_mhz();
+  clock_cpu = cpu_freq.has_value()
+                  ? cpu_freq.value()
+                  : rpi::read_curr_frequency_mhz(rpi::VCGENCMD_CLOCK_CPU);
+  const auto sysfs_undervolt = m_sampler.read_rpi_undervolt();
+  if (sysfs_undervolt.has_value()) {
+    undervolt = sysfs_undervolt.value();
+  }
+  if (n_samples % RPI_VCGENCMD_INTERVAL_N_SAMPLES != 0) {
+    return;
   }
+  if (!sysfs_undervolt.has_value()) {
+    undervolt = rpi::vcgencmd_get_undervolt();
+  }
+  // temporary, until we have our own message
+  m_rpi_vcgencmd_clocks.isp =
+      rpi::read_curr_frequency_mhz(rpi::VCGENCMD_CLOCK_ISP);
+  m_rpi_vcgencmd_clocks.h264 =
+      rpi::read_curr_frequency_mhz(rpi::VCGENCMD_CLOCK_H264);
+  m_rpi_vcgencmd_clocks.core =
+      rpi::read_curr_frequency_mhz(rpi::VCGENCMD_CLOCK_CORE);
+  m_rpi_vcgencmd_clocks.v3d =
+      rpi::read_curr_frequency_mhz(rpi::VCGENCMD_CLOCK_V3D);
 }
 
-void OnboardComputerStatusProvider::calculate_other_until_terminate() {
+void OnboardComputerStatusProvider::sample_until_terminate() {
+  int n_samples = 0;
+  bool curr_rpi_undervolt = false;
   while (!terminate) {
     // We always sleep for 1 second
     // just to make sure to not hog too much cpu here.
     std::this_thread::sleep_for(std::chrono::seconds(1));
+    // Load since the last sample, e.g. over the last second
+    const auto cpu_load = m_sampler.sample_cpu_load();
     // microhard link
     int microhard_enabled = 21;
     int microhard_rssi = 22;
@@ -169,18 +173,13 @@ void OnboardComputerStatusProvider::calculate_other_until_terminate() {
     int8_t curr_temperature_txc1 = 0;
     int txc_temp = 0;
     int curr_clock_cpu = 0;
-    int curr_clock_isp = 0;
-    int curr_clock_h264 = 0;
-    int curr_clock_core = 0;
-    int curr_clock_v3d = 0;
-    bool curr_rpi_undervolt = false;
     int curr_ina219_voltage = 0;
     int curr_ina219_current = 0;
     const int curr_space_left = OHDFilesystemUtil::get_remaining_space_in_mb();
     const auto ohd_platform =
         static_cast<uint8_t>(OHDPlatform::instance().platform_type);
-    const auto curr_ram_usage =
-        openhd::onboard::calculate_memory_usage_percent();
+    const auto curr_ram_usage = m_sampler.sample_memory_usage().value_or(
+        openhd::onboard::RamUsage{0, 0});
     ina219_log_warning_once(curr_ina219_voltage);
     if (!m_ina_219.has_any_error) {
       float voltage = roundf(m_ina_219.voltage() * 1000);
@@ -240,36 +239,31 @@ void OnboardComputerStatusProvider::calculate_other_until_terminate() {
       }
     }
     if (OHDPlatform::instance().is_rpi()) {
-      curr_temperature_core =
-          (int8_t)openhd::onboard::rpi::read_temperature_soc_degree();
-      // temporary, until we have our own message
-      curr_clock_cpu = openhd::onboard::rpi::read_curr_frequency_mhz(
-          openhd::onboard::rpi::VCGENCMD_CLOCK_CPU);
-      curr_clock_isp = openhd::onboard::rpi::read_curr_frequency_mhz(
-          openhd::onboard::rpi::VCGENCMD_CLOCK_ISP);
-      curr_clock_h264 = openhd::onboard::rpi::read_curr_frequency_mhz(
-          openhd::onboard::rpi::VCGENCMD_CLOCK_H264);
-      curr_clock_core = openhd::onboard::rpi::read_curr_frequency_mhz(
-          openhd::onboard::rpi::VCGENCMD_CLOCK_CORE);
-      curr_clock_v3d = openhd::onboard::rpi::read_curr_frequency_mhz(
-          openhd::onboard::rpi::VCGENCMD_CLOCK_V3D);
-      curr_rpi_undervolt = openhd::onboard::rpi::vcgencmd_get_undervolt();
+      sample_rpi(n_samples, curr_temperature_core, curr_clock_cpu,
+                 curr_rpi_undervolt);
     } else {
-      const auto cpu_temp = (int8_t)openhd::onboard::readTemperature();
+      const auto cpu_temp =
+          (int8_t)m_sampler.read_temperature_degree().value_or(0);
       const auto platform = OHDPlatform::instance();
       curr_temperature_core = cpu_temp;
       curr_temperature_txc0 = txc_temp;
       curr_temperature_txc1 = txc_temp;
       if (platform.is_rock() || platform.platform_type == X_PLATFORM_TYPE_X86) {
-        if (OHDFilesystemUtil::exists(
-                "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq")) {
-          curr_clock_cpu = read_cpu_current_frequency_linux_mhz();
-        }
+        curr_clock_cpu = m_sampler.read_cpu_frequency_mhz().value_or(0);
       }
     }
     {
       // lock mutex and write out
       std::lock_guard<std::mutex> lock(m_curr_onboard_computer_status_mutex);
+      if (cpu_load.has_value()) {
+        const auto& load = cpu_load.value();
+        m_curr_onboard_computer_status.cpu_cores[0] = load.total_perc;
+        // temporary, until we have our own message: [1..7] hold the load of
+        // the individual cores 0..6
+        for (int i = 0; i < load.n_cores && i + 1 < 8; i++) {
+          m_curr_onboard_computer_status.cpu_cores[i + 1] = load.core_perc[i];
+        }
+      }
       m_curr_onboard_computer_status.temperature_core[0] =
           curr_temperature_core;
       m_curr_onboard_computer_status.temperature_core[1] =
@@ -278,10 +272,14 @@ void OnboardComputerStatusProvider::calculate_other_until_terminate() {
           curr_temperature_txc1;
       // temporary, until we have our own message
       m_curr_onboard_computer_status.storage_type[0] = curr_clock_cpu;
-      m_curr_onboard_computer_status.storage_type[1] = curr_clock_isp;
-      m_curr_onboard_computer_status.storage_type[2] = curr_clock_h264;
-      m_curr_onboard_computer_status.storage_type[3] = curr_clock_core;
-      m_curr_onboard_computer_status.storage_usage[0] = curr_clock_v3d;
+      m_curr_onboard_computer_status.storage_type[1] =
+          m_rpi_vcgencmd_clocks.isp;
+      m_curr_onboard_computer_status.storage_type[2] =
+          m_rpi_vcgencmd_clocks.h264;
+      m_curr_onboard_computer_status.storage_type[3] =
+          m_rpi_vcgencmd_clocks.core;
+      m_curr_onboard_computer_status.storage_usage[0] =
+          m_rpi_vcgencmd_clocks.v3d;
       m_curr_onboard_computer_status.storage_usage[1] = curr_space_left;
       m_curr_onboard_computer_status.storage_usage[2] = curr_ina219_voltage;
       m_curr_onboard_computer_status.storage_usage[3] = curr_ina219_current;
@@ -306,7 +304,7 @@ void OnboardComputerStatusProvider::calculate_other_until_terminate() {
       m_curr_onboard_computer_status.link_tx_rate[0] =
           curr_rpi_undervolt ? 1 : 0;
     }
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    n_samples++;
   }
 }
 
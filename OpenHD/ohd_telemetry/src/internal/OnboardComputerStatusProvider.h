@@ -24,6 +24,7 @@
 #ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_INTERNAL_ONBOARDCOMPUTERSTATUSPROVIDER_H_
 #define OPENHD_OPENHD_OHD_TELEMETRY_SRC_INTERNAL_ONBOARDCOMPUTERSTATUSPROVIDER_H_
 
+#include <atomic>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -31,6 +32,7 @@
 
 #include "../mav_include.h"
 #include "ina219.h"
+#include "onboard_computer_sampler.h"
 #include "openhd_platform.h"
 
 /**
@@ -39,14 +41,13 @@
  * basically atomically.
  *
  * More info:
- * We need one thread for the CPU usage (workaround) and
- * for some reason, running all those vcgencmd's on rpi for figuring out the
- * current clock speed can also block for a significant amount of time
- * (significant enough that it is a bad idea to call them from the "main"
- * telemetry thread. This class decouples these data generation steps from the
- * main telemetry thread. We do not care about latency at all on these
- * statistics, so we can easily do those stats using a producer / consumer
- * pattern
+ * Most values are sampled from /proc and /sys (see OnboardComputerSampler),
+ * which is cheap. But some rpi specific values are only available via
+ * vcgencmd, which can block for a significant amount of time (significant
+ * enough that it is a bad idea to call them from the "main" telemetry thread).
+ * This class decouples these data generation steps from the main telemetry
+ * thread. We do not care about latency at all on these statistics, so we can
+ * easily do those stats using a producer / consumer pattern
  */
 class OnboardComputerStatusProvider {
  public:
@@ -78,15 +79,22 @@ class OnboardComputerStatusProvider {
   // ina219, a warning is logged once and then no values are read anymore
   INA219 m_ina_219;
   bool m_ina219_warning_logged = false;
-  // One thread for calculating the CPU usage
-  std::unique_ptr<std::thread> m_calculate_cpu_usage_thread;
-  std::unique_ptr<std::thread> m_calculate_other_thread;
-  bool terminate = false;
-  // Note: we need to run this in its own thread, such that "top" can do its
-  // magic over a longer duration
-  void calculate_cpu_usage_until_terminate();
-  // Extra thread for "the rest"
-  void calculate_other_until_terminate();
+  openhd::onboard::OnboardComputerSampler m_sampler;
+  // Clocks we can only get via vcgencmd (forks) - refreshed at a lower rate
+  struct RpiVcgencmdClocks {
+    int isp = 0;
+    int h264 = 0;
+    int core = 0;
+    int v3d = 0;
+  };
+  RpiVcgencmdClocks m_rpi_vcgencmd_clocks{};
+  static constexpr int RPI_VCGENCMD_INTERVAL_N_SAMPLES = 5;
+  std::unique_ptr<std::thread> m_sample_thread;
+  std::atomic<bool> terminate = false;
+  void sample_until_terminate();
+  // rpi specific values, which fall back to vcgencmd if there is no sysfs node
+  void sample_rpi(int n_samples, int8_t& temperature_core, int& clock_cpu,
+                  bool& undervolt);
   void ina219_log_warning_once(int curr_ina219_voltage);
 };
 
@@ -0,0 +1,266 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "onboard_computer_sampler.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstring>
+
+namespace openhd::onboard {
+
+static bool is_space(char c) { return c == ' ' || c == '\t'; }
+static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Parses the next unsigned decimal number starting at pos (skipping leading
+// spaces), advances pos past it.
+static bool next_uint(const char* buf, size_t len, size_t& pos,
+                      uint64_t& out) {
+  while (pos < len && is_space(buf[pos])) pos++;
+  if (pos >= len || !is_digit(buf[pos])) return false;
+  uint64_t value = 0;
+  while (pos < len && is_digit(buf[pos])) {
+    value = value * 10 + (buf[pos] - '0');
+    pos++;
+  }
+  out = value;
+  return true;
+}
+
+static size_t next_line(const char* buf, size_t len, size_t pos) {
+  const void* nl = memchr(buf + pos, '\n', len - pos);
+  if (nl == nullptr) return len;
+  return static_cast<const char*>(nl) - buf + 1;
+}
+
+bool parse_proc_stat(const char* buf, size_t len, ProcStatSnapshot& out) {
+  out.n_cores = 0;
+  bool has_aggregate = false;
+  size_t pos = 0;
+  // The cpu lines always come first, we stop at the first non-cpu line
+  while (pos + 3 < len && memcmp(buf + pos, "cpu", 3) == 0) {
+    const size_t line_end = next_line(buf, len, pos);
+    size_t p = pos + 3;
+    int index = 0;
+    if (p < len && is_digit(buf[p])) {
+      uint64_t core = 0;
+      next_uint(buf, line_end, p, core);
+      index = static_cast<int>(core) + 1;
+    }
+    // user nice system idle iowait irq softirq steal (guest is already
+    // accounted for in user)
+    uint64_t fields[8] = {};
+    int n_fields = 0;
+    while (n_fields < 8 && next_uint(buf, line_end, p, fields[n_fields])) {
+      n_fields++;
+    }
+    if (n_fields >= 4 && index <= MAX_N_CPU_CORES) {
+      uint64_t total = 0;
+      for (int i = 0; i < n_fields; i++) total += fields[i];
+      const uint64_t idle = fields[3] + fields[4];
+      out.times[index] = CpuTimes{total - idle, total};
+      if (index == 0) {
+        has_aggregate = true;
+      } else if (index > out.n_cores) {
+        out.n_cores = index;
+      }
+    }
+    pos = line_end;
+  }
+  return has_aggregate;
+}
+
+static int load_perc(const CpuTimes& prev, const CpuTimes& curr) {
+  if (curr.total <= prev.total || curr.busy < prev.busy) return 0;
+  const uint64_t d_total = curr.total - prev.total;
+  const uint64_t d_busy = curr.busy - prev.busy;
+  const auto perc = static_cast<int>((d_busy * 100 + d_total / 2) / d_total);
+  return perc > 100 ? 100 : perc;
+}
+
+CpuLoad calculate_cpu_load(const ProcStatSnapshot& prev,
+                           const ProcStatSnapshot& curr) {
+  CpuLoad ret{};
+  ret.total_perc = load_perc(prev.times[0], curr.times[0]);
+  ret.n_cores = curr.n_cores;
+  for (int i = 0; i < curr.n_cores; i++) {
+    ret.core_perc[i] =
+        static_cast<uint8_t>(load_perc(prev.times[i + 1], curr.times[i + 1]));
+  }
+  return ret;
+}
+
+bool parse_meminfo(const char* buf, size_t len, int64_t& total_kb,
+                   int64_t& free_kb) {
+  static constexpr char TOTAL[] = "MemTotal:";
+  static constexpr char FREE[] = "MemFree:";
+  bool has_total = false;
+  bool has_free = false;
+  size_t pos = 0;
+  while (pos < len && !(has_total && has_free)) {
+    const size_t line_end = next_line(buf, len, pos);
+    const size_t line_len = line_end - pos;
+    uint64_t value = 0;
+    if (line_len > sizeof(TOTAL) - 1 &&
+        memcmp(buf + pos, TOTAL, sizeof(TOTAL) - 1) == 0) {
+      size_t p = pos + sizeof(TOTAL) - 1;
+      if (next_uint(buf, line_end, p, value)) {
+        total_kb = static_cast<int64_t>(value);
+        has_total = true;
+      }
+    } else if (line_len > sizeof(FREE) - 1 &&
+               memcmp(buf + pos, FREE, sizeof(FREE) - 1) == 0) {
+      size_t p = pos + sizeof(FREE) - 1;
+      if (next_uint(buf, line_end, p, value)) {
+        free_kb = static_cast<int64_t>(value);
+        has_free = true;
+      }
+    }
+    pos = line_end;
+  }
+  return has_total && has_free;
+}
+
+std::optional<int64_t> parse_int(const char* buf, size_t len) {
+  size_t pos = 0;
+  while (pos < len && (is_space(buf[pos]) || buf[pos] == '\n')) pos++;
+  bool negative = false;
+  if (pos < len && buf[pos] == '-') {
+    negative = true;
+    pos++;
+  }
+  if (pos + 1 < len && buf[pos] == '0' &&
+      (buf[pos + 1] == 'x' || buf[pos + 1] == 'X')) {
+    pos += 2;
+    int64_t value = 0;
+    size_t begin = pos;
+    for (; pos < len; pos++) {
+      const char c = buf[pos];
+      int digit;
+      if (is_digit(c)) {
+        digit = c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+      } else {
+        break;
+      }
+      value = value * 16 + digit;
+    }
+    if (pos == begin) return std::nullopt;
+    return negative ? -value : value;
+  }
+  uint64_t value = 0;
+  if (!next_uint(buf, len, pos, value)) return std::nullopt;
+  const auto ret = static_cast<int64_t>(value);
+  return negative ? -ret : ret;
+}
+
+PersistentFile::PersistentFile(const char* path) {
+  m_fd = open(path, O_RDONLY | O_CLOEXEC);
+}
+
+PersistentFile::~PersistentFile() {
+  if (m_fd >= 0) close(m_fd);
+}
+
+int PersistentFile::read(char* buf, size_t buf_size) const {
+  if (m_fd < 0) return -1;
+  const ssize_t ret = pread(m_fd, buf, buf_size, 0);
+  return static_cast<int>(ret);
+}
+
+std::optional<int64_t> PersistentFile::read_int() const {
+  char buf[64];
+  const int len = read(buf, sizeof(buf));
+  if (len <= 0) return std::nullopt;
+  return parse_int(buf, len);
+}
+
+OnboardComputerSampler::OnboardComputerSampler() {
+  // Take the first snapshot, such that the first sample_cpu_load() call
+  // already has something to calculate the delta from
+  sample_cpu_load();
+}
+
+std::optional<CpuLoad> OnboardComputerSampler::sample_cpu_load() {
+  // Large enough for the cpu lines of MAX_N_CPU_CORES cores, the rest of
+  // /proc/stat (interrupts and more) is intentionally cut off
+  char buf[4096];
+  const int len = m_proc_stat.read(buf, sizeof(buf));
+  if (len <= 0) return std::nullopt;
+  ProcStatSnapshot curr{};
+  if (!parse_proc_stat(buf, len, curr)) return std::nullopt;
+  std::optional<CpuLoad> ret = std::nullopt;
+  if (m_has_last_proc_stat) {
+    ret = calculate_cpu_load(m_last_proc_stat, curr);
+  }
+  m_last_proc_stat = curr;
+  m_has_last_proc_stat = true;
+  return ret;
+}
+
+std::optional<RamUsage> OnboardComputerSampler::sample_memory_usage() {
+  char buf[2048];
+  const int len = m_proc_meminfo.read(buf, sizeof(buf));
+  if (len <= 0) return std::nullopt;
+  int64_t total_kb = 0;
+  int64_t free_kb = 0;
+  if (!parse_meminfo(buf, len, total_kb, free_kb) || total_kb <= 0) {
+    return std::nullopt;
+  }
+  const int64_t used_kb = total_kb - free_kb;
+  // NOTE: ram_total has always been filled with the kB value from meminfo
+  return RamUsage{100.0 * used_kb / total_kb, static_cast<int>(total_kb)};
+}
+
+std::optional<int> OnboardComputerSampler::read_temperature_degree() {
+  auto value = m_hwmon_temp.read_int();
+  if (!value.has_value()) {
+    value = m_thermal_zone_temp.read_int();
+  }
+  if (!value.has_value()) return std::nullopt;
+  return static_cast<int>(value.value() / 1000);
+}
+
+std::optional<int> OnboardComputerSampler::read_cpu_frequency_mhz() {
+  const auto value = m_cpu_freq.read_int();
+  if (!value.has_value()) return std::nullopt;
+  return static_cast<int>(value.value() / 1000);
+}
+
+std::optional<bool> OnboardComputerSampler::read_rpi_undervolt() {
+  // The node prints the value in hex, but without "0x" prefix
+  char buf[32];
+  const int len = m_rpi_throttled.read(buf + 2, sizeof(buf) - 2);
+  if (len <= 0) return std::nullopt;
+  buf[0] = '0';
+  buf[1] = 'x';
+  const auto value = parse_int(buf, len + 2);
+  if (!value.has_value()) return std::nullopt;
+  return (value.value() & 0x1) != 0;
+}
+
+}  // namespace openhd::onboard
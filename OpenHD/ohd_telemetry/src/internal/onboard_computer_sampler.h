@@ -0,0 +1,123 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_INTERNAL_ONBOARD_COMPUTER_SAMPLER_H_
+#define OPENHD_OPENHD_OHD_TELEMETRY_SRC_INTERNAL_ONBOARD_COMPUTER_SAMPLER_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+// Cheap, fork-free sampling of the onboard computer status.
+// All the /proc and /sys files we poll are opened once and then re-read with
+// pread() into a stack buffer on each sample - parsing is done without regex
+// and without any heap allocations. This replaces running "top" / "vcgencmd"
+// once per second, which on small boards (e.g. rpi zero 2) showed up as
+// measurable cpu load and fork latency spikes next to the video pipeline.
+namespace openhd::onboard {
+
+struct RamUsage {
+  double ram_usage_perc;
+  int ram_total_mb;
+};
+
+// Cumulative jiffies of one "cpu" line in /proc/stat
+struct CpuTimes {
+  uint64_t busy = 0;
+  uint64_t total = 0;
+};
+static constexpr int MAX_N_CPU_CORES = 16;
+// Aggregate ([0]) and per core ([1..n_cores]) times
+struct ProcStatSnapshot {
+  std::array<CpuTimes, MAX_N_CPU_CORES + 1> times{};
+  int n_cores = 0;
+};
+// Cpu load in percent, calculated from 2 consecutive /proc/stat snapshots
+struct CpuLoad {
+  int total_perc = 0;
+  int n_cores = 0;
+  std::array<uint8_t, MAX_N_CPU_CORES> core_perc{};
+};
+
+// Parsing helpers, exposed for testing.
+// Parses the leading "cpu" lines of /proc/stat, returns false if the buffer
+// doesn't contain at least the aggregate line.
+bool parse_proc_stat(const char* buf, size_t len, ProcStatSnapshot& out);
+CpuLoad calculate_cpu_load(const ProcStatSnapshot& prev,
+                           const ProcStatSnapshot& curr);
+// Looks for MemTotal / MemFree (in kB)
+bool parse_meminfo(const char* buf, size_t len, int64_t& total_kb,
+                   int64_t& free_kb);
+// Parses an optionally signed decimal (or hex with "0x" prefix) integer,
+// leading whitespace and trailing garbage (e.g. a newline) are ignored.
+std::optional<int64_t> parse_int(const char* buf, size_t len);
+
+// A file that is opened once and re-read from the beginning on each read.
+// Works for procfs / sysfs, where each read at offset 0 re-generates the
+// content.
+class PersistentFile {
+ public:
+  explicit PersistentFile(const char* path);
+  ~PersistentFile();
+  PersistentFile(const PersistentFile&) = delete;
+  PersistentFile& operator=(const PersistentFile&) = delete;
+  bool is_open() const { return m_fd >= 0; }
+  // Returns the n of bytes read or -1 on error
+  int read(char* buf, size_t buf_size) const;
+  std::optional<int64_t> read_int() const;
+
+ private:
+  int m_fd = -1;
+};
+
+class OnboardComputerSampler {
+ public:
+  OnboardComputerSampler();
+  // Load since the previous call (or since construction on the first call)
+  std::optional<CpuLoad> sample_cpu_load();
+  std::optional<RamUsage> sample_memory_usage();
+  // CPU/SOC temperature in degree, from hwmon or the first thermal zone
+  std::optional<int> read_temperature_degree();
+  // Current frequency of cpu0
+  std::optional<int> read_cpu_frequency_mhz();
+  // RPI only: undervolt flag from the firmware "get_throttled" sysfs node
+  // (bit 0), nullopt if the kernel doesn't expose it
+  std::optional<bool> read_rpi_undervolt();
+
+ private:
+  PersistentFile m_proc_stat{"/proc/stat"};
+  PersistentFile m_proc_meminfo{"/proc/meminfo"};
+  PersistentFile m_hwmon_temp{"/sys/class/hwmon/hwmon0/temp1_input"};
+  PersistentFile m_thermal_zone_temp{"/sys/class/thermal/thermal_zone0/temp"};
+  PersistentFile m_cpu_freq{
+      "/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq"};
+  PersistentFile m_rpi_throttled{
+      "/sys/devices/platform/soc/soc:firmware/get_throttled"};
+  ProcStatSnapshot m_last_proc_stat{};
+  bool m_has_last_proc_stat = false;
+};
+
+}  // namespace openhd::onboard
+
+#endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_INTERNAL_ONBOARD_COMPUTER_SAMPLER_H_
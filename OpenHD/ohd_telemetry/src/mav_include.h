@@ -31,6 +31,7 @@ extern "C" {
 }
 
 #include <chrono>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <vector>
@@ -76,51 +77,62 @@ struct AggregatedMavlinkPacket {
  * of using a wb packet for each of them - Aggregates the given mavlink
  * message(s) int packets >=@param max_mtu The n of recommended retransmissions
  * is the highest recommended number of all aggregated mavlink messages.
+ * Each message is serialized exactly once, directly into the tail of the
+ * current chunk - a message that doesn't fit anymore is moved (not re-packed)
+ * to the beginning of the next chunk.
+ * @param out the aggregated packets are appended here.
+ * @param free_buffers (optional) buffers to re-use instead of allocating new
+ * ones for each chunk.
+ * @return the total n of bytes of all the packed messages.
  */
-static std::vector<AggregatedMavlinkPacket> aggregate_pack_messages(
-    const std::vector<MavlinkMessage>& messages, uint32_t max_mtu = 1024) {
-  std::vector<AggregatedMavlinkPacket> ret;
-  auto buff = std::make_shared<std::vector<uint8_t>>();
-  buff->reserve(max_mtu);
-  int recommended_n_retransmissions = 1;
-  int n_aggregated_mavlink_packets = 0;
-  for (const auto& msg : messages) {
-    auto data = msg.pack();
-    if (buff->size() + data.size() <= max_mtu) {
-      // we haven't reached MTU yet
-      buff->insert(buff->end(), data.begin(), data.end());
-      n_aggregated_mavlink_packets++;
-      if (msg.recommended_n_injections > recommended_n_retransmissions) {
-        recommended_n_retransmissions = msg.recommended_n_injections;
-      }
+static int aggregate_pack_messages(
+    const std::vector<MavlinkMessage>& messages, uint32_t max_mtu,
+    std::vector<AggregatedMavlinkPacket>& out,
+    std::vector<std::shared_ptr<std::vector<uint8_t>>>* free_buffers =
+        nullptr) {
+  // We pack into the tail of the current chunk, so we need space for one more
+  // (max size) mavlink message past the MTU.
+  const size_t buff_capacity = max_mtu + MAVLINK_MAX_PACKET_LEN;
+  auto get_buffer = [&]() {
+    std::shared_ptr<std::vector<uint8_t>> ret;
+    if (free_buffers != nullptr && !free_buffers->empty()) {
+      ret = std::move(free_buffers->back());
+      free_buffers->pop_back();
     } else {
-      // MTU is reached or we need to allocate a new buffer
-      if (!buff->empty()) {
-        ret.push_back({buff, recommended_n_retransmissions});
-        buff = std::make_shared<std::vector<uint8_t>>();
-        buff->reserve(max_mtu);
-        recommended_n_retransmissions = 1;
-        n_aggregated_mavlink_packets = 0;
-      }
-      buff->insert(buff->end(), data.begin(), data.end());
-      n_aggregated_mavlink_packets++;
-      if (msg.recommended_n_injections > recommended_n_retransmissions) {
-        recommended_n_retransmissions = msg.recommended_n_injections;
-      }
+      ret = std::make_shared<std::vector<uint8_t>>();
+    }
+    ret->resize(buff_capacity);
+    return ret;
+  };
+  int total_n_bytes = 0;
+  AggregatedMavlinkPacket curr{nullptr, 1, 0};
+  size_t curr_size = 0;
+  for (const auto& msg : messages) {
+    if (curr.aggregated_data == nullptr) curr.aggregated_data = get_buffer();
+    auto& buff = *curr.aggregated_data;
+    const size_t msg_size =
+        mavlink_msg_to_send_buffer(buff.data() + curr_size, &msg.m);
+    total_n_bytes += static_cast<int>(msg_size);
+    if (curr_size + msg_size > max_mtu && curr_size > 0) {
+      // MTU is reached - this message goes into a new chunk
+      auto next = get_buffer();
+      std::memcpy(next->data(), buff.data() + curr_size, msg_size);
+      buff.resize(curr_size);
+      out.push_back(std::move(curr));
+      curr = AggregatedMavlinkPacket{std::move(next), 1, 0};
+      curr_size = 0;
+    }
+    curr_size += msg_size;
+    curr.n_aggregated_mavlink_packets++;
+    if (msg.recommended_n_injections > curr.recommended_n_retransmissions) {
+      curr.recommended_n_retransmissions = msg.recommended_n_injections;
     }
   }
-  if (!buff->empty()) {
-    ret.push_back({buff, recommended_n_retransmissions});
-  }
-  return ret;
-}
-
-static int get_size(const std::vector<MavlinkMessage>& messages) {
-  int ret = 0;
-  for (const auto& message : messages) {
-    ret += message.pack().size();
+  if (curr.aggregated_data != nullptr) {
+    curr.aggregated_data->resize(curr_size);
+    out.push_back(std::move(curr));
   }
-  return ret;
+  return total_n_bytes;
 }
 
 // For registering a callback that is called every time component X receives one
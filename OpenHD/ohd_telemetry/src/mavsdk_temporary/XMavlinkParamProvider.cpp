@@ -28,8 +28,10 @@
 XMavlinkParamProvider::XMavlinkParamProvider(
     uint8_t sys_id, uint8_t comp_id,
     std::optional<std::chrono::milliseconds> opt_heartbeat_interval)
-    : MavlinkComponent(sys_id, comp_id),
-      m_opt_heartbeat_interval(opt_heartbeat_interval) {
+    : MavlinkComponent(sys_id, comp_id) {
+  if (opt_heartbeat_interval.has_value()) {
+    m_opt_heartbeat_timer.emplace(opt_heartbeat_interval.value());
+  }
   _sender = std::make_shared<mavsdk::SenderWrapper>(*this);
   _mavlink_message_handler = std::make_shared<mavsdk::MavlinkMessageHandler>();
   _mavlink_parameter_receiver =
@@ -69,8 +71,24 @@ void XMavlinkParamProvider::set_ready() {
 }
 
 std::vector<MavlinkMessage> XMavlinkParamProvider::process_mavlink_messages(
-    std::vector<MavlinkMessage> messages) {
+    MavlinkMessageView messages) {
   std::lock_guard<std::mutex> lock(_mutex);
+  for (const auto& msg : messages) {
+    _mavlink_message_handler->process_message(msg.m);
+  }
+  return update_and_do_work();
+}
+
+MavlinkSubscription XMavlinkParamProvider::get_subscription() const {
+  // The parameter receiver registers for those in ready_for_communication()
+  return {{MAVLINK_MSG_ID_PARAM_SET, MAVLINK_MSG_ID_PARAM_EXT_SET,
+           MAVLINK_MSG_ID_PARAM_REQUEST_READ, MAVLINK_MSG_ID_PARAM_REQUEST_LIST,
+           MAVLINK_MSG_ID_PARAM_EXT_REQUEST_READ,
+           MAVLINK_MSG_ID_PARAM_EXT_REQUEST_LIST},
+          true};
+}
+
+std::vector<MavlinkMessage> XMavlinkParamProvider::update_and_do_work() {
   for (const auto& setting : m_int_settings_with_update_functionality) {
     const auto intSetting = std::get<openhd::IntSetting>(setting.setting);
     const auto currValue =
@@ -87,9 +105,6 @@ std::vector<MavlinkMessage> XMavlinkParamProvider::process_mavlink_messages(
       }
     }
   }
-  for (const auto& msg : messages) {
-    _mavlink_message_handler->process_message(msg.m);
-  }
   for (int i = 0; i < 100; i++) {
     _mavlink_parameter_receiver->do_work();
   }
@@ -100,14 +115,25 @@ std::vector<MavlinkMessage> XMavlinkParamProvider::process_mavlink_messages(
 }
 
 std::vector<MavlinkMessage> XMavlinkParamProvider::generate_mavlink_messages() {
+  // process_mavlink_messages() is only called for param messages, pending work
+  // (e.g. a param list) has to make progress here as well.
   std::vector<MavlinkMessage> ret;
-  if (m_opt_heartbeat_interval.has_value()) {
-    const auto now = std::chrono::steady_clock::now();
-    const auto elapsed = now - m_last_heartbeat;
-    if (elapsed > m_opt_heartbeat_interval.value()) {
-      m_last_heartbeat = now;
-      ret.push_back(MavlinkComponent::create_heartbeat());
-    }
+  const auto now = std::chrono::steady_clock::now();
+  if (m_update_timer.poll(now)) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    ret = update_and_do_work();
+  }
+  if (m_opt_heartbeat_timer.has_value() && m_opt_heartbeat_timer->poll(now)) {
+    ret.push_back(MavlinkComponent::create_heartbeat());
   }
   return ret;
 }
+
+std::chrono::steady_clock::time_point XMavlinkParamProvider::get_next_deadline()
+    const {
+  if (m_opt_heartbeat_timer.has_value()) {
+    return std::min(m_update_timer.next_due(),
+                    m_opt_heartbeat_timer->next_due());
+  }
+  return m_update_timer.next_due();
+}
@@ -50,9 +50,14 @@ class XMavlinkParamProvider : public MavlinkComponent {
   void set_ready();
   // override from component
   std::vector<MavlinkMessage> process_mavlink_messages(
-      std::vector<MavlinkMessage> messages) override;
+      MavlinkMessageView messages) override;
   // override from component
   std::vector<MavlinkMessage> generate_mavlink_messages() override;
+  // override from component
+  [[nodiscard]] MavlinkSubscription get_subscription() const override;
+  // override from component
+  [[nodiscard]] std::chrono::steady_clock::time_point get_next_deadline()
+      const override;
 
  private:
   // mavsdk
@@ -62,11 +67,14 @@ class XMavlinkParamProvider : public MavlinkComponent {
 
  private:
   std::mutex _mutex{};
-  const std::optional<std::chrono::milliseconds> m_opt_heartbeat_interval;
-  std::chrono::steady_clock::time_point m_last_heartbeat =
-      std::chrono::steady_clock::now();
+  std::optional<openhd::util::IntervalTimer> m_opt_heartbeat_timer;
+  // Settings changed by openhd itself are only noticed by polling
+  openhd::util::IntervalTimer m_update_timer{std::chrono::milliseconds(200)};
   // Dirty, when openhd updates a setting
   std::vector<openhd::Setting> m_int_settings_with_update_functionality;
+  // Checks for int settings that were changed by openhd and works through the
+  // pending param responses. Returns the messages to send.
+  std::vector<MavlinkMessage> update_and_do_work();
 };
 
 #endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_MAV_PARAM_XMAVLINKPARAMPROVIDER_H_
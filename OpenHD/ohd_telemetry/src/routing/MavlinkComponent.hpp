@@ -24,13 +24,82 @@
 #ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKCOMPONENT_H_
 #define OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKCOMPONENT_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <mutex>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "MavlinkSystem.hpp"
+#include "TelemetryScheduler.hpp"
 #include "mav_include.h"
 
+// Which incoming messages a component wants to get in
+// process_mavlink_messages(), see MavlinkDispatchTable.
+struct MavlinkSubscription {
+  // Empty means all messages
+  std::vector<uint32_t> msg_ids;
+  // If set, messages with a target sys / comp id (e.g. PARAM_SET) are only
+  // delivered if they target this component or are broadcast (id 0)
+  bool only_targeted_at_self = false;
+};
+
+/**
+ * The messages of a received batch that are for a component - a view into the
+ * batch the parent received, such that routing them (see MavlinkDispatchTable)
+ * neither copies messages nor allocates. Only valid during the
+ * process_mavlink_messages() call it is handed to.
+ */
+class MavlinkMessageView {
+ public:
+  // All of the given messages
+  explicit MavlinkMessageView(const std::vector<MavlinkMessage>& messages)
+      : m_messages(messages.data()), m_count(messages.size()) {}
+  // The messages[i] with (masks[i] & bit) != 0
+  MavlinkMessageView(const MavlinkMessage* messages, const uint32_t* masks,
+                     size_t count, uint32_t bit)
+      : m_messages(messages), m_masks(masks), m_count(count), m_bit(bit) {}
+  class Iterator {
+   public:
+    Iterator(const MavlinkMessageView& view, size_t index)
+        : m_view(view), m_index(view.next(index)) {}
+    const MavlinkMessage& operator*() const {
+      return m_view.m_messages[m_index];
+    }
+    const MavlinkMessage* operator->() const {
+      return &m_view.m_messages[m_index];
+    }
+    Iterator& operator++() {
+      m_index = m_view.next(m_index + 1);
+      return *this;
+    }
+    bool operator!=(const Iterator& other) const {
+      return m_index != other.m_index;
+    }
+
+   private:
+    const MavlinkMessageView& m_view;
+    size_t m_index;
+  };
+  [[nodiscard]] Iterator begin() const { return {*this, 0}; }
+  [[nodiscard]] Iterator end() const { return {*this, m_count}; }
+
+ private:
+  const MavlinkMessage* m_messages;
+  const uint32_t* m_masks = nullptr;
+  size_t m_count;
+  uint32_t m_bit = 0;
+  // First index >= index that is part of this view, m_count if there is none
+  [[nodiscard]] size_t next(size_t index) const {
+    if (m_masks == nullptr) return std::min(index, m_count);
+    while (index < m_count && (m_masks[index] & m_bit) == 0) index++;
+    return index;
+  }
+};
+
 // A component has a (parent) sys id and its own component id (unique per
 // system). It processes and/or creates mavlink messages.
 class MavlinkComponent {
@@ -51,13 +120,36 @@ class MavlinkComponent {
    * unless the given message needs a response.
    */
   virtual std::vector<MavlinkMessage> process_mavlink_messages(
-      std::vector<MavlinkMessage> messages) = 0;
+      MavlinkMessageView messages) = 0;
   /**
    * The parent should call this method in regular intervals and send out the
    * generated mavlink messages. This is for fire and forget messages. For
    * example, a component might return the heartbeat(s) here.
    */
   virtual std::vector<MavlinkMessage> generate_mavlink_messages() = 0;
+  /**
+   * The messages this component is interested in - only those are passed to
+   * process_mavlink_messages(). Queried once, when the component is added.
+   * By default, a component gets everything.
+   */
+  [[nodiscard]] virtual MavlinkSubscription get_subscription() const {
+    return {};
+  }
+  /**
+   * The earliest point in time generate_mavlink_messages() has something to
+   * send, queried after each call to it. The default is the old 100ms polling
+   * interval.
+   */
+  [[nodiscard]] virtual std::chrono::steady_clock::time_point
+  get_next_deadline() const {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+  }
+  // Set by the parent when the component is added
+  void set_scheduler(TelemetryScheduler* scheduler) { m_scheduler = scheduler; }
+  // process_mavlink_messages / generate_mavlink_messages might be called from
+  // different threads (endpoint callbacks, telemetry loop), the parent holds
+  // this lock while calling them.
+  std::mutex m_component_mutex;
 
  protected:
   // These are protected, and MUST be called in the implementation(s) process
@@ -96,6 +188,12 @@ class MavlinkComponent {
       return std::nullopt;
     }
   }*/
+  // Thread-safe. Call this if there is something urgent to send, the parent
+  // then calls generate_mavlink_messages() as soon as possible.
+  void request_generate() const {
+    auto* scheduler = m_scheduler.load();
+    if (scheduler != nullptr) scheduler->notify();
+  }
   // Convenient method to create a heartbeat, for use in the implementation
   [[nodiscard]] MavlinkMessage create_heartbeat() const {
     MavlinkMessage heartbeat;
@@ -105,6 +203,9 @@ class MavlinkComponent {
                                MAV_AUTOPILOT_INVALID, 0, 0, MAV_STATE_ACTIVE);
     return heartbeat;
   }
+
+ private:
+  std::atomic<TelemetryScheduler*> m_scheduler = nullptr;
 };
 
 #endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKCOMPONENT_H_
@@ -0,0 +1,159 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKDISPATCHTABLE_H_
+#define OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKDISPATCHTABLE_H_
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "MavlinkComponent.hpp"
+#include "mav_include.h"
+
+/**
+ * Routes incoming messages to only the component(s) that subscribed to them
+ * (see MavlinkComponent::get_subscription()), instead of handing every message
+ * to every component. The msg id -> component(s) lookup is precomputed as a
+ * bitmask of component indices, dense for the common (<256) msg ids.
+ * Immutable once built - the telemetry classes publish it via
+ * openhd::AtomicSnapshot, such that the receive path doesn't need a lock.
+ */
+class MavlinkDispatchTable {
+ public:
+  static constexpr int MAX_N_COMPONENTS = 32;
+  // Messages per process_mavlink_messages() call, one receive batch usually
+  static constexpr size_t MAX_CHUNK_SIZE = 64;
+  using ComponentMask = uint32_t;
+  using RESPONSES_CB = std::function<void(std::vector<MavlinkMessage>)>;
+
+  void add_component(std::shared_ptr<MavlinkComponent> component) {
+    assert(m_components.size() < MAX_N_COMPONENTS);
+    const ComponentMask bit = ComponentMask{1} << m_components.size();
+    const auto subscription = component->get_subscription();
+    if (subscription.msg_ids.empty()) {
+      m_mask_all |= bit;
+    }
+    for (const auto msg_id : subscription.msg_ids) {
+      if (msg_id < m_dense.size()) {
+        m_dense[msg_id] |= bit;
+      } else {
+        m_sparse[msg_id] |= bit;
+      }
+    }
+    if (subscription.only_targeted_at_self) {
+      m_mask_targeted |= bit;
+    }
+    m_components.push_back(std::move(component));
+  }
+  [[nodiscard]] const std::vector<std::shared_ptr<MavlinkComponent>>&
+  get_components() const {
+    return m_components;
+  }
+  /**
+   * Calls process_mavlink_messages() on each component that is interested in
+   * at least one of the given messages (with only those messages, in order)
+   * and forwards its responses to @param on_responses. The components get a
+   * view into @param messages, nothing is copied or allocated here. Batches
+   * larger than MAX_CHUNK_SIZE are handed out in chunks.
+   */
+  void dispatch(const std::vector<MavlinkMessage>& messages,
+                const RESPONSES_CB& on_responses) const {
+    std::array<ComponentMask, MAX_CHUNK_SIZE> masks;
+    for (size_t offset = 0; offset < messages.size();
+         offset += MAX_CHUNK_SIZE) {
+      const size_t count = std::min(messages.size() - offset, MAX_CHUNK_SIZE);
+      ComponentMask any = 0;
+      for (size_t i = 0; i < count; i++) {
+        masks[i] = get_receivers(messages[offset + i].m);
+        any |= masks[i];
+      }
+      while (any != 0) {
+        const int idx = __builtin_ctz(any);
+        any &= any - 1;
+        auto& component = *m_components[idx];
+        const MavlinkMessageView view(&messages[offset], masks.data(), count,
+                                      ComponentMask{1} << idx);
+        std::vector<MavlinkMessage> responses;
+        {
+          std::lock_guard<std::mutex> guard(component.m_component_mutex);
+          responses = component.process_mavlink_messages(view);
+        }
+        if (!responses.empty()) on_responses(std::move(responses));
+      }
+    }
+  }
+
+ private:
+  std::vector<std::shared_ptr<MavlinkComponent>> m_components;
+  std::array<ComponentMask, 256> m_dense{};
+  std::unordered_map<uint32_t, ComponentMask> m_sparse;
+  // Components that get every message
+  ComponentMask m_mask_all = 0;
+  // Components that only want messages targeted at them
+  ComponentMask m_mask_targeted = 0;
+  // The components that get the given message
+  [[nodiscard]] ComponentMask get_receivers(
+      const mavlink_message_t& msg) const {
+    ComponentMask mask = lookup(msg.msgid);
+    ComponentMask targeted = mask & m_mask_targeted;
+    while (targeted != 0) {
+      const int idx = __builtin_ctz(targeted);
+      targeted &= targeted - 1;
+      const auto& component = *m_components[idx];
+      if (!targets(msg, component.m_sys_id, component.m_comp_id)) {
+        mask &= ~(ComponentMask{1} << idx);
+      }
+    }
+    return mask;
+  }
+  [[nodiscard]] ComponentMask lookup(const uint32_t msg_id) const {
+    if (msg_id < m_dense.size()) {
+      return m_dense[msg_id] | m_mask_all;
+    }
+    const auto it = m_sparse.find(msg_id);
+    return it == m_sparse.end() ? m_mask_all : (it->second | m_mask_all);
+  }
+  // True if the message has no target, is broadcast or targets the given ids
+  static bool targets(const mavlink_message_t& msg, const uint8_t sys_id,
+                      const uint8_t comp_id) {
+    const mavlink_msg_entry_t* entry = mavlink_get_msg_entry(msg.msgid);
+    if (entry == nullptr) return true;
+    const auto* payload = reinterpret_cast<const uint8_t*>(_MAV_PAYLOAD(&msg));
+    if (entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_SYSTEM) {
+      const uint8_t target_sys_id = payload[entry->target_system_ofs];
+      if (target_sys_id != 0 && target_sys_id != sys_id) return false;
+    }
+    if (entry->flags & MAV_MSG_ENTRY_FLAG_HAVE_TARGET_COMPONENT) {
+      const uint8_t target_comp_id = payload[entry->target_component_ofs];
+      if (target_comp_id != 0 && target_comp_id != comp_id) return false;
+    }
+    return true;
+  }
+};
+
+#endif  // OPENHD_OPENHD_OHD_TELEMETRY_SRC_ROUTING_MAVLINKDISPATCHTABLE_H_
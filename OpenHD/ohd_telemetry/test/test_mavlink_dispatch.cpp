@@ -0,0 +1,242 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+// Benchmark for routing incoming messages to the telemetry components -
+// handing every message to every component (under one lock) vs.
+// MavlinkDispatchTable. Simulates a 200Hz ATTITUDE / GPS stream plus parameter
+// traffic for the components OpenHD has on the air unit (main component,
+// generic param server and 2 camera param servers) plus one with the default
+// subscription (everything). Also counts the allocations per dispatch call.
+
+#include <atomic>
+#include <cassert>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <new>
+
+#include "../src/mav_include.h"
+#include "../src/routing/MavlinkDispatchTable.hpp"
+
+// Counts all allocations while enabled
+static std::atomic<bool> g_count_allocations{false};
+static std::atomic<int64_t> g_n_allocations{0};
+
+void* operator new(std::size_t size) {
+  if (g_count_allocations) g_n_allocations++;
+  void* ret = std::malloc(size == 0 ? 1 : size);
+  if (ret == nullptr) throw std::bad_alloc();
+  return ret;
+}
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr,
+                                               std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// Mimics the real components - looks at every message it gets, but only does
+// something for the ones it is interested in.
+class BenchComponent : public MavlinkComponent {
+ public:
+  BenchComponent(uint8_t sys_id, uint8_t comp_id,
+                 MavlinkSubscription subscription)
+      : MavlinkComponent(sys_id, comp_id),
+        m_subscription(std::move(subscription)) {}
+  std::vector<MavlinkMessage> process_mavlink_messages(
+      MavlinkMessageView messages) override {
+    n_calls++;
+    for (const auto& msg : messages) {
+      n_messages_seen++;
+      if (m_subscription.msg_ids.empty()) {
+        n_messages_handled++;
+        continue;
+      }
+      for (const auto msg_id : m_subscription.msg_ids) {
+        if (msg.m.msgid == msg_id) {
+          n_messages_handled++;
+          break;
+        }
+      }
+    }
+    return {};
+  }
+  std::vector<MavlinkMessage> generate_mavlink_messages() override {
+    return {};
+  }
+  [[nodiscard]] MavlinkSubscription get_subscription() const override {
+    return m_subscription;
+  }
+  int n_calls = 0;
+  int n_messages_seen = 0;
+  int n_messages_handled = 0;
+
+ private:
+  const MavlinkSubscription m_subscription;
+};
+
+static std::vector<std::shared_ptr<BenchComponent>> create_components() {
+  const MavlinkSubscription main_subscription{
+      {MAVLINK_MSG_ID_TIMESYNC, MAVLINK_MSG_ID_COMMAND_LONG,
+       MAVLINK_MSG_ID_GLOBAL_POSITION_INT},
+      false};
+  const MavlinkSubscription param_subscription{
+      {MAVLINK_MSG_ID_PARAM_SET, MAVLINK_MSG_ID_PARAM_EXT_SET,
+       MAVLINK_MSG_ID_PARAM_REQUEST_READ, MAVLINK_MSG_ID_PARAM_REQUEST_LIST,
+       MAVLINK_MSG_ID_PARAM_EXT_REQUEST_READ,
+       MAVLINK_MSG_ID_PARAM_EXT_REQUEST_LIST},
+      true};
+  const uint8_t sys_id = OHD_SYS_ID_AIR;
+  return {std::make_shared<BenchComponent>(
+              sys_id, MAV_COMP_ID_ONBOARD_COMPUTER, main_subscription),
+          std::make_shared<BenchComponent>(
+              sys_id, MAV_COMP_ID_ONBOARD_COMPUTER, param_subscription),
+          std::make_shared<BenchComponent>(sys_id, MAV_COMP_ID_CAMERA,
+                                           param_subscription),
+          std::make_shared<BenchComponent>(sys_id, MAV_COMP_ID_CAMERA2,
+                                           param_subscription),
+          std::make_shared<BenchComponent>(sys_id, MAV_COMP_ID_USER1,
+                                           MavlinkSubscription{})};
+}
+
+// One second of traffic, in 5ms batches
+static std::vector<std::vector<MavlinkMessage>> create_one_second_of_traffic() {
+  std::vector<std::vector<MavlinkMessage>> ret;
+  for (int i = 0; i < 200; i++) {
+    std::vector<MavlinkMessage> batch;
+    MavlinkMessage msg{};
+    mavlink_attitude_t attitude{};
+    attitude.time_boot_ms = i * 5;
+    mavlink_msg_attitude_encode(OHD_SYS_ID_FC, MAV_COMP_ID_AUTOPILOT1, &msg.m,
+                                &attitude);
+    batch.push_back(msg);
+    mavlink_gps_raw_int_t gps_raw{};
+    gps_raw.time_usec = i * 5000;
+    gps_raw.fix_type = 3;
+    mavlink_msg_gps_raw_int_encode(OHD_SYS_ID_FC, MAV_COMP_ID_AUTOPILOT1,
+                                   &msg.m, &gps_raw);
+    batch.push_back(msg);
+    if (i % 4 == 0) {
+      // QOpenHD fetching / setting params on one of the components
+      mavlink_param_ext_request_read_t request{};
+      request.target_system = OHD_SYS_ID_AIR;
+      request.target_component =
+          (i % 12 == 0) ? MAV_COMP_ID_CAMERA : MAV_COMP_ID_ONBOARD_COMPUTER;
+      request.param_index = static_cast<int16_t>(i % 40);
+      mavlink_msg_param_ext_request_read_encode(QOPENHD_SYS_ID,
+                                                MAV_COMP_ID_MISSIONPLANNER,
+                                                &msg.m, &request);
+      batch.push_back(msg);
+    }
+    if (i % 40 == 0) {
+      mavlink_timesync_t timesync{};
+      timesync.ts1 = i;
+      mavlink_msg_timesync_encode(OHD_SYS_ID_GROUND,
+                                  MAV_COMP_ID_ONBOARD_COMPUTER, &msg.m,
+                                  &timesync);
+      batch.push_back(msg);
+    }
+    ret.push_back(batch);
+  }
+  return ret;
+}
+
+static void print_result(const char* tag, double elapsed_s, int n_seconds,
+                         int n_calls,
+                         const std::vector<std::shared_ptr<BenchComponent>>&
+                             components) {
+  std::cout << tag << ": " << (elapsed_s * 1000.0 * 1000.0) / n_seconds
+            << " us per second of traffic, "
+            << (double)g_n_allocations / n_calls << " allocations per call\n";
+  for (const auto& component : components) {
+    std::cout << "  comp " << (int)component->m_comp_id
+              << " calls:" << component->n_calls / n_seconds
+              << "/s seen:" << component->n_messages_seen / n_seconds
+              << "/s handled:" << component->n_messages_handled / n_seconds
+              << "/s\n";
+  }
+}
+
+int main() {
+  static constexpr int N_SECONDS = 2000;
+  const auto traffic = create_one_second_of_traffic();
+  std::vector<std::shared_ptr<BenchComponent>> fan_out_components;
+  {
+    // What Air/GroundTelemetry used to do
+    auto components = create_components();
+    std::mutex components_lock;
+    g_n_allocations = 0;
+    g_count_allocations = true;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int second = 0; second < N_SECONDS; second++) {
+      for (const auto& batch : traffic) {
+        std::lock_guard<std::mutex> guard(components_lock);
+        for (auto& component : components) {
+          const auto responses =
+              component->process_mavlink_messages(MavlinkMessageView(batch));
+        }
+      }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    g_count_allocations = false;
+    print_result(
+        "Fan-out to all",
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+            .count(),
+        N_SECONDS, N_SECONDS * (int)traffic.size(), components);
+    fan_out_components = components;
+  }
+  {
+    auto components = create_components();
+    MavlinkDispatchTable table;
+    for (const auto& component : components) {
+      table.add_component(component);
+    }
+    g_n_allocations = 0;
+    g_count_allocations = true;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int second = 0; second < N_SECONDS; second++) {
+      for (const auto& batch : traffic) {
+        table.dispatch(batch, [](std::vector<MavlinkMessage>) {});
+      }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    g_count_allocations = false;
+    print_result(
+        "MavlinkDispatchTable",
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+            .count(),
+        N_SECONDS, N_SECONDS * (int)traffic.size(), components);
+    // Same messages handled (the param servers additionally skip the ones
+    // targeted at another component now), and the dispatch itself doesn't
+    // allocate
+    for (size_t i = 0; i < components.size(); i++) {
+      if (components[i]->get_subscription().only_targeted_at_self) continue;
+      assert(components[i]->n_messages_handled ==
+             fan_out_components[i]->n_messages_handled);
+    }
+    assert(g_n_allocations == 0);
+  }
+  return 0;
+}
@@ -0,0 +1,292 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+// Fuzz test proving MavlinkFrameScanner produces exactly the same messages as
+// feeding every byte through mavlink_parse_char (valid v1 / v2 / signed
+// frames, garbage in between, bit flips, truncated frames, random read sizes),
+// followed by a throughput benchmark on aggregated telemetry packets.
+
+#include <endpoints/MavlinkFrameScanner.h>
+
+#include <cstring>
+#include <iostream>
+#include <random>
+
+#include "../src/mav_helper.h"
+#include "../src/mav_include.h"
+
+static constexpr uint8_t REFERENCE_CHANNEL = 0;
+static constexpr uint8_t SCANNER_CHANNEL = 1;
+static constexpr uint8_t TX_CHANNEL = 2;
+
+class Parser {
+ public:
+  virtual ~Parser() = default;
+  virtual void parse(const uint8_t* data, int data_len,
+                     std::vector<MavlinkMessage>& out) = 0;
+  mavlink_status_t status{};
+};
+
+class ReferenceParser : public Parser {
+ public:
+  void parse(const uint8_t* data, int data_len,
+             std::vector<MavlinkMessage>& out) override {
+    mavlink_message_t msg;
+    for (int i = 0; i < data_len; i++) {
+      if (mavlink_parse_char(REFERENCE_CHANNEL, data[i], &msg, &status)) {
+        out.push_back(MavlinkMessage{msg});
+      }
+    }
+  }
+};
+
+class ScannerParser : public Parser {
+ public:
+  void parse(const uint8_t* data, int data_len,
+             std::vector<MavlinkMessage>& out) override {
+    scanner.parse(data, data_len, out, status);
+  }
+  MavlinkFrameScanner scanner{SCANNER_CHANNEL};
+};
+
+static std::vector<uint8_t> create_frame(std::mt19937& rng, bool v1,
+                                         bool sign) {
+  const uint8_t sys_id = rng() % 256;
+  const uint8_t comp_id = rng() % 256;
+  mavlink_status_t* tx_status = mavlink_get_channel_status(TX_CHANNEL);
+  if (v1) {
+    tx_status->flags |= MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+  } else {
+    tx_status->flags &= ~MAVLINK_STATUS_FLAG_OUT_MAVLINK1;
+  }
+  mavlink_message_t msg{};
+  switch (rng() % 4) {
+    case 0: {
+      mavlink_heartbeat_t heartbeat{};
+      heartbeat.type = MAV_TYPE_QUADROTOR;
+      heartbeat.custom_mode = rng();
+      mavlink_msg_heartbeat_encode_chan(sys_id, comp_id, TX_CHANNEL, &msg,
+                                        &heartbeat);
+    } break;
+    case 1: {
+      mavlink_attitude_t attitude{};
+      attitude.time_boot_ms = rng();
+      attitude.roll = static_cast<float>(rng() % 1000) / 1000.0f;
+      attitude.yawspeed = static_cast<float>(rng() % 1000) / 1000.0f;
+      mavlink_msg_attitude_encode_chan(sys_id, comp_id, TX_CHANNEL, &msg,
+                                       &attitude);
+    } break;
+    case 2: {
+      // Mostly zero - exercises payload truncation on v2
+      mavlink_gps_raw_int_t gps_raw{};
+      gps_raw.time_usec = rng() % 2;
+      gps_raw.fix_type = rng() % 4;
+      mavlink_msg_gps_raw_int_encode_chan(sys_id, comp_id, TX_CHANNEL, &msg,
+                                          &gps_raw);
+    } break;
+    default: {
+      mavlink_statustext_t statustext{};
+      const int text_len = rng() % sizeof(statustext.text);
+      for (int i = 0; i < text_len; i++) {
+        statustext.text[i] = static_cast<char>('a' + rng() % 26);
+      }
+      statustext.severity = MAV_SEVERITY_INFO;
+      mavlink_msg_statustext_encode_chan(sys_id, comp_id, TX_CHANNEL, &msg,
+                                         &statustext);
+    } break;
+  }
+  std::vector<uint8_t> ret(MAVLINK_MAX_PACKET_LEN);
+  ret.resize(mavlink_msg_to_send_buffer(ret.data(), &msg));
+  if (sign && !v1) {
+    // Nobody checks signatures on our channels, but the frame layout differs.
+    ret[2] |= MAVLINK_IFLAG_SIGNED;
+    const int header_len = MAVLINK_CORE_HEADER_LEN + 1;
+    const int payload_len = ret[1];
+    uint16_t crc;
+    crc_init(&crc);
+    crc_accumulate_buffer(&crc, reinterpret_cast<const char*>(ret.data() + 1),
+                          header_len - 1 + payload_len);
+    crc_accumulate(mavlink_get_msg_entry(msg.msgid)->crc_extra, &crc);
+    ret.resize(header_len + payload_len);
+    ret.push_back(crc & 0xFF);
+    ret.push_back(crc >> 8);
+    for (int i = 0; i < MAVLINK_SIGNATURE_BLOCK_LEN; i++) {
+      ret.push_back(rng() % 256);
+    }
+  }
+  return ret;
+}
+
+static bool messages_equal(const mavlink_message_t& a,
+                           const mavlink_message_t& b) {
+  if (a.magic != b.magic || a.len != b.len ||
+      a.incompat_flags != b.incompat_flags ||
+      a.compat_flags != b.compat_flags || a.seq != b.seq ||
+      a.sysid != b.sysid || a.compid != b.compid || a.msgid != b.msgid ||
+      a.checksum != b.checksum || a.ck[0] != b.ck[0] || a.ck[1] != b.ck[1]) {
+    return false;
+  }
+  // The state machine zero-fills up to the max message len, anything past
+  // that is left over from previous messages in the channel buffer.
+  const mavlink_msg_entry_t* entry = mavlink_get_msg_entry(a.msgid);
+  const int compare_len =
+      std::max<int>(a.len, entry != nullptr ? entry->max_msg_len : 0);
+  if (std::memcmp(_MAV_PAYLOAD(&a), _MAV_PAYLOAD(&b), compare_len) != 0) {
+    return false;
+  }
+  if ((a.incompat_flags & MAVLINK_IFLAG_SIGNED) &&
+      std::memcmp(a.signature, b.signature, MAVLINK_SIGNATURE_BLOCK_LEN) != 0) {
+    return false;
+  }
+  return true;
+}
+
+static bool status_equal(const mavlink_status_t& a, const mavlink_status_t& b) {
+  return a.parse_state == b.parse_state &&
+         a.packet_rx_success_count == b.packet_rx_success_count &&
+         a.current_rx_seq == b.current_rx_seq && a.flags == b.flags;
+}
+
+static std::vector<uint8_t> create_fuzzed_stream(std::mt19937& rng) {
+  std::vector<uint8_t> ret;
+  const int n_frames = 1 + rng() % 40;
+  for (int i = 0; i < n_frames; i++) {
+    if (rng() % 4 == 0) {
+      const int n_garbage = rng() % 20;
+      for (int j = 0; j < n_garbage; j++) {
+        // Make false start markers a lot more likely than in random data
+        const auto r = rng() % 8;
+        ret.push_back(r == 0   ? MAVLINK_STX
+                      : r == 1 ? MAVLINK_STX_MAVLINK1
+                               : rng() % 256);
+      }
+    }
+    auto frame = create_frame(rng, rng() % 5 == 0, rng() % 5 == 0);
+    const auto mutation = rng() % 20;
+    if (mutation == 0) {
+      frame[rng() % frame.size()] ^= (1 << (rng() % 8));
+    } else if (mutation == 1) {
+      frame.resize(rng() % frame.size());
+    } else if (mutation == 2) {
+      // corrupt the length
+      frame[1] = rng() % 256;
+    }
+    ret.insert(ret.end(), frame.begin(), frame.end());
+  }
+  return ret;
+}
+
+static bool fuzz_round(std::mt19937& rng) {
+  mavlink_reset_channel_status(REFERENCE_CHANNEL);
+  mavlink_reset_channel_status(SCANNER_CHANNEL);
+  ReferenceParser reference;
+  ScannerParser scanner;
+  std::vector<MavlinkMessage> reference_out;
+  std::vector<MavlinkMessage> scanner_out;
+  const auto stream = create_fuzzed_stream(rng);
+  const int max_read_size = 1 + rng() % 600;
+  size_t offset = 0;
+  while (offset < stream.size()) {
+    const int read_size = std::min<int>(1 + rng() % max_read_size,
+                                        stream.size() - offset);
+    reference.parse(stream.data() + offset, read_size, reference_out);
+    scanner.parse(stream.data() + offset, read_size, scanner_out);
+    offset += read_size;
+    // (Before the first message, mavlink_parse_char reports a seq of 1 for
+    // dropped garbage bytes, which the scanner doesn't even look at)
+    if (!reference_out.empty() &&
+        !status_equal(reference.status, scanner.status)) {
+      std::cerr << "Status mismatch:\n"
+                << MavlinkHelpers::mavlink_status_to_string(reference.status)
+                << "\n"
+                << MavlinkHelpers::mavlink_status_to_string(scanner.status)
+                << std::endl;
+      return false;
+    }
+  }
+  if (reference_out.size() != scanner_out.size()) {
+    std::cerr << "N messages mismatch " << reference_out.size() << " vs "
+              << scanner_out.size() << std::endl;
+    return false;
+  }
+  for (size_t i = 0; i < reference_out.size(); i++) {
+    if (!messages_equal(reference_out[i].m, scanner_out[i].m)) {
+      std::cerr << "Message " << i << " mismatch" << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class T>
+static void benchmark(const char* tag,
+                      const std::vector<std::vector<uint8_t>>& packets,
+                      const int n_passes) {
+  mavlink_reset_channel_status(REFERENCE_CHANNEL);
+  mavlink_reset_channel_status(SCANNER_CHANNEL);
+  T parser;
+  size_t n_bytes = 0;
+  size_t n_messages = 0;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int pass = 0; pass < n_passes; pass++) {
+    for (const auto& packet : packets) {
+      std::vector<MavlinkMessage> messages;
+      parser.parse(packet.data(), packet.size(), messages);
+      n_bytes += packet.size();
+      n_messages += messages.size();
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  const double elapsed_s =
+      std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+          .count();
+  std::cout << tag << ": " << (n_bytes / elapsed_s) / (1024 * 1024)
+            << " MB/s, " << n_messages / elapsed_s << " messages/s"
+            << std::endl;
+}
+
+int main() {
+  std::mt19937 rng(42);
+  static constexpr int N_FUZZ_ROUNDS = 20000;
+  for (int i = 0; i < N_FUZZ_ROUNDS; i++) {
+    if (!fuzz_round(rng)) {
+      std::cerr << "Fuzz round " << i << " failed" << std::endl;
+      return -1;
+    }
+  }
+  std::cout << "Fuzz: " << N_FUZZ_ROUNDS << " rounds equivalent" << std::endl;
+  // Aggregated packets like they come in from WB / UDP (no corruption)
+  std::vector<std::vector<uint8_t>> packets;
+  for (int i = 0; i < 1000; i++) {
+    std::vector<uint8_t> packet;
+    while (true) {
+      const auto frame = create_frame(rng, false, false);
+      if (packet.size() + frame.size() > 1024) break;
+      packet.insert(packet.end(), frame.begin(), frame.end());
+    }
+    packets.push_back(packet);
+  }
+  benchmark<ReferenceParser>("mavlink_parse_char", packets, 100);
+  benchmark<ScannerParser>("MavlinkFrameScanner", packets, 100);
+  return 0;
+}
@@ -0,0 +1,237 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+// Benchmark for MEndpoint::sendMessages with a mix of messages similar to what
+// a FC (ardupilot / px4) streams by default. Compares the old "pack to count
+// bytes, then pack again to aggregate" path with the current single-pass
+// packing, and verifies both produce the same bytes on the wire.
+
+#include <endpoints/MEndpoint.h>
+
+#include <iostream>
+
+#include "../src/mav_helper.h"
+#include "../src/mav_include.h"
+#include "openhd_spdlog_include.h"
+
+// Endpoint that drops everything, so we only measure packing overhead.
+class NullEndpoint : public MEndpoint {
+ public:
+  NullEndpoint() : MEndpoint("NullEndpoint") {}
+  int n_packets = 0;
+
+ private:
+  bool sendMessagesImpl(
+      const std::vector<AggregatedMavlinkPacket>& packets) override {
+    n_packets += packets.size();
+    return true;
+  }
+};
+
+// One "telemetry tick" - roughly what the FC sends within ~100ms at default
+// stream rates.
+static std::vector<MavlinkMessage> create_fc_telemetry_mix() {
+  std::vector<MavlinkMessage> ret;
+  const auto sys_id = OHD_SYS_ID_FC;
+  const auto comp_id = MAV_COMP_ID_AUTOPILOT1;
+  for (int i = 0; i < 5; i++) {
+    ret.push_back(MExampleMessage::attitude(sys_id, comp_id));
+  }
+  for (int i = 0; i < 2; i++) {
+    mavlink_global_position_int_t global_position{};
+    global_position.time_boot_ms = 12345;
+    global_position.lat = 473977418;
+    global_position.lon = 85455939;
+    global_position.alt = 500123;
+    global_position.relative_alt = 20123;
+    global_position.vx = 12;
+    global_position.hdg = 27000;
+    MavlinkMessage msg{};
+    mavlink_msg_global_position_int_encode(sys_id, comp_id, &msg.m,
+                                           &global_position);
+    ret.push_back(msg);
+    mavlink_vfr_hud_t vfr_hud{};
+    vfr_hud.airspeed = 12.3f;
+    vfr_hud.groundspeed = 12.9f;
+    vfr_hud.heading = 270;
+    vfr_hud.throttle = 55;
+    vfr_hud.alt = 500.1f;
+    vfr_hud.climb = 0.2f;
+    mavlink_msg_vfr_hud_encode(sys_id, comp_id, &msg.m, &vfr_hud);
+    ret.push_back(msg);
+    mavlink_rc_channels_t rc_channels{};
+    rc_channels.time_boot_ms = 12345;
+    rc_channels.chancount = 16;
+    rc_channels.chan1_raw = 1500;
+    rc_channels.chan2_raw = 1500;
+    rc_channels.chan3_raw = 1000;
+    rc_channels.chan4_raw = 1500;
+    rc_channels.chan5_raw = 1900;
+    rc_channels.rssi = 200;
+    mavlink_msg_rc_channels_encode(sys_id, comp_id, &msg.m, &rc_channels);
+    ret.push_back(msg);
+    mavlink_servo_output_raw_t servo_output{};
+    servo_output.time_usec = 12345;
+    servo_output.servo1_raw = 1500;
+    servo_output.servo2_raw = 1500;
+    servo_output.servo3_raw = 1200;
+    servo_output.servo4_raw = 1500;
+    mavlink_msg_servo_output_raw_encode(sys_id, comp_id, &msg.m,
+                                        &servo_output);
+    ret.push_back(msg);
+  }
+  {
+    MavlinkMessage msg{};
+    mavlink_gps_raw_int_t gps_raw{};
+    gps_raw.time_usec = 12345;
+    gps_raw.fix_type = 3;
+    gps_raw.lat = 473977418;
+    gps_raw.lon = 85455939;
+    gps_raw.alt = 500123;
+    gps_raw.eph = 121;
+    gps_raw.epv = 150;
+    gps_raw.satellites_visible = 14;
+    mavlink_msg_gps_raw_int_encode(sys_id, comp_id, &msg.m, &gps_raw);
+    ret.push_back(msg);
+    mavlink_sys_status_t sys_status{};
+    sys_status.onboard_control_sensors_present = 0x3FFFFF;
+    sys_status.onboard_control_sensors_enabled = 0x3FFFFF;
+    sys_status.onboard_control_sensors_health = 0x3FFFFF;
+    sys_status.load = 250;
+    sys_status.voltage_battery = 15800;
+    sys_status.current_battery = 1230;
+    sys_status.battery_remaining = 87;
+    mavlink_msg_sys_status_encode(sys_id, comp_id, &msg.m, &sys_status);
+    ret.push_back(msg);
+    mavlink_battery_status_t battery_status{};
+    battery_status.battery_function = MAV_BATTERY_FUNCTION_ALL;
+    battery_status.type = MAV_BATTERY_TYPE_LIPO;
+    battery_status.temperature = 3100;
+    for (auto& voltage : battery_status.voltages) voltage = UINT16_MAX;
+    for (int cell = 0; cell < 4; cell++) battery_status.voltages[cell] = 3950;
+    battery_status.current_battery = 1230;
+    battery_status.current_consumed = 850;
+    battery_status.energy_consumed = -1;
+    battery_status.battery_remaining = 87;
+    mavlink_msg_battery_status_encode(sys_id, comp_id, &msg.m,
+                                      &battery_status);
+    ret.push_back(msg);
+    ret.push_back(MExampleMessage::heartbeat(sys_id, comp_id));
+  }
+  return ret;
+}
+
+// What MEndpoint::sendMessages used to do.
+static int legacy_pack(const std::vector<MavlinkMessage>& messages,
+                       std::vector<AggregatedMavlinkPacket>& out) {
+  int n_bytes = 0;
+  for (const auto& message : messages) {
+    n_bytes += message.pack().size();
+  }
+  const uint32_t max_mtu = 1024;
+  auto buff = std::make_shared<std::vector<uint8_t>>();
+  buff->reserve(max_mtu);
+  for (const auto& msg : messages) {
+    auto data = msg.pack();
+    if (buff->size() + data.size() > max_mtu && !buff->empty()) {
+      out.push_back({buff, 1});
+      buff = std::make_shared<std::vector<uint8_t>>();
+      buff->reserve(max_mtu);
+    }
+    buff->insert(buff->end(), data.begin(), data.end());
+  }
+  if (!buff->empty()) out.push_back({buff, 1});
+  return n_bytes;
+}
+
+static std::vector<uint8_t> concat(
+    const std::vector<AggregatedMavlinkPacket>& packets) {
+  std::vector<uint8_t> ret;
+  for (const auto& packet : packets) {
+    ret.insert(ret.end(), packet.aggregated_data->begin(),
+               packet.aggregated_data->end());
+  }
+  return ret;
+}
+
+int main() {
+  const auto messages = create_fc_telemetry_mix();
+  // Correctness first - both paths must produce identical chunks
+  {
+    std::vector<AggregatedMavlinkPacket> legacy;
+    std::vector<AggregatedMavlinkPacket> current;
+    const int legacy_n_bytes = legacy_pack(messages, legacy);
+    const int current_n_bytes =
+        aggregate_pack_messages(messages, 1024, current);
+    if (legacy_n_bytes != current_n_bytes || legacy.size() != current.size() ||
+        concat(legacy) != concat(current)) {
+      std::cerr << "Mismatch between legacy and single-pass packing"
+                << std::endl;
+      return -1;
+    }
+    for (size_t i = 0; i < legacy.size(); i++) {
+      if (legacy[i].aggregated_data->size() !=
+          current[i].aggregated_data->size()) {
+        std::cerr << "Mismatch in chunk " << i << std::endl;
+        return -1;
+      }
+    }
+    std::cout << "Telemetry mix: " << messages.size() << " messages, "
+              << current_n_bytes << " bytes, " << current.size()
+              << " chunk(s)" << std::endl;
+  }
+  static constexpr int N_ITERATIONS = 200000;
+  {
+    const auto begin = std::chrono::steady_clock::now();
+    int n_packets = 0;
+    for (int i = 0; i < N_ITERATIONS; i++) {
+      std::vector<AggregatedMavlinkPacket> packets;
+      legacy_pack(messages, packets);
+      n_packets += packets.size();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    const double elapsed_s =
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+            .count();
+    std::cout << "Legacy (double pack): "
+              << (N_ITERATIONS * messages.size()) / elapsed_s
+              << " messages/s (" << n_packets << " chunks)" << std::endl;
+  }
+  {
+    NullEndpoint endpoint;
+    const auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < N_ITERATIONS; i++) {
+      endpoint.sendMessages(messages);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - begin;
+    const double elapsed_s =
+        std::chrono::duration_cast<std::chrono::duration<double>>(elapsed)
+            .count();
+    std::cout << "MEndpoint::sendMessages (single pass): "
+              << (N_ITERATIONS * messages.size()) / elapsed_s
+              << " messages/s (" << endpoint.n_packets << " chunks)"
+              << std::endl;
+    std::cout << endpoint.createInfo();
+  }
+  return 0;
+}
@@ -0,0 +1,270 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+// Unit test for the /proc and /sys parsing of the OnboardComputerSampler, a
+// sanity check of the sampler on the machine it runs on, and a bench against
+// the previous implementation (top / regex / ifstream based, kept here for
+// reference - it is not used anywhere else anymore).
+// Usage: test_onboard_computer_sampler [n_iterations]
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <regex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/internal/onboard_computer_sampler.h"
+#include "openhd_spdlog.h"
+#include "openhd_util.h"
+#include "openhd_util_filesystem.h"
+
+namespace legacy {
+
+static std::optional<int> read_cpuload_once_blocking() {
+  auto res_opt = OHDUtil::run_command_out(
+      R"lit(top -bn1 | grep -i '^%cpu')lit");
+  if (!res_opt.has_value()) {
+    return std::nullopt;
+  }
+  const std::string res = res_opt.value();
+  std::smatch result;
+  const std::regex r1{"ni,(.*) id"};
+  auto res1 = std::regex_search(res, result, r1);
+  if (!res1 || result.size() < 1) {
+    return std::nullopt;
+  }
+  const std::string intermediate1 = result[0];
+  if (intermediate1.length() < 3) {
+    return std::nullopt;
+  }
+  std::regex begin("ni,");
+  const auto intermediate2 = std::regex_replace(intermediate1, begin, "");
+  const auto cpu_idle_perc = std::atof(intermediate2.c_str());
+  const auto cpu_idle_perc_int = static_cast<int>(lround(cpu_idle_perc));
+  return 100 - cpu_idle_perc_int;
+}
+
+static openhd::onboard::RamUsage calculate_memory_usage_percent() {
+  std::ifstream meminfo("/proc/meminfo");
+  std::string line;
+  std::regex pattern("\\s+");
+  long long total_memory = 0;
+  long long free_memory = 0;
+  while (std::getline(meminfo, line)) {
+    std::vector<std::string> fields;
+    auto words_begin =
+        std::sregex_token_iterator(line.begin(), line.end(), pattern, -1);
+    auto words_end = std::sregex_token_iterator();
+    for (auto i = words_begin; i != words_end; ++i) {
+      fields.push_back(*i);
+    }
+    if (fields[0] == "MemTotal:") {
+      total_memory = std::stoll(fields[1]);
+    } else if (fields[0] == "MemFree:") {
+      free_memory = std::stoll(fields[1]);
+    }
+  }
+  const long long used_memory = total_memory - free_memory;
+  return {100.0 * used_memory / total_memory, (int)total_memory};
+}
+
+static int read_temperature() {
+  auto temp_file_opt = OHDFilesystemUtil::opt_read_file(
+      "/sys/class/hwmon/hwmon0/temp1_input", false);
+  if (!temp_file_opt.has_value()) {
+    temp_file_opt = OHDFilesystemUtil::opt_read_file(
+        "/sys/class/thermal/thermal_zone0/temp", false);
+    if (!temp_file_opt.has_value()) {
+      return 0;
+    }
+  }
+  auto temp = OHDUtil::string_to_int(temp_file_opt.value());
+  if (!temp.has_value()) return 0;
+  return temp.value() / 1000;
+}
+
+}  // namespace legacy
+
+static void test_parsers() {
+  using namespace openhd::onboard;
+  const char stat[] =
+      "cpu  100 0 100 800 0 0 0 0 0 0\n"
+      "cpu0 50 0 50 400 0 0 0 0 0 0\n"
+      "cpu1 50 0 50 400 0 0 0 0 0 0\n"
+      "intr 12345 0 0\n";
+  ProcStatSnapshot prev{};
+  const bool prev_ok = parse_proc_stat(stat, sizeof(stat) - 1, prev);
+  assert(prev_ok);
+  assert(prev.n_cores == 2);
+  assert(prev.times[0].busy == 200 && prev.times[0].total == 1000);
+  const char stat2[] =
+      "cpu  200 0 200 1400 200 0 0 0 0 0\n"
+      "cpu0 150 0 150 500 0 0 0 0 0 0\n"
+      "cpu1 50 0 50 900 200 0 0 0 0 0\n";
+  ProcStatSnapshot curr{};
+  const bool curr_ok = parse_proc_stat(stat2, sizeof(stat2) - 1, curr);
+  assert(curr_ok);
+  const auto load = calculate_cpu_load(prev, curr);
+  assert(load.total_perc == 20);
+  assert(load.n_cores == 2);
+  assert(load.core_perc[0] == 67);
+  assert(load.core_perc[1] == 0);
+  const char invalid_stat[] = "intr 12345 0 0\n";
+  ProcStatSnapshot invalid{};
+  const bool invalid_ok =
+      parse_proc_stat(invalid_stat, sizeof(invalid_stat) - 1, invalid);
+  assert(!invalid_ok);
+  const char meminfo[] =
+      "MemTotal:        1000 kB\nMemFree:          250 kB\n"
+      "MemAvailable:     600 kB\n";
+  int64_t total = 0;
+  int64_t free = 0;
+  const bool meminfo_ok =
+      parse_meminfo(meminfo, sizeof(meminfo) - 1, total, free);
+  assert(meminfo_ok);
+  assert(total == 1000 && free == 250);
+  const auto int_dec = parse_int("48312\n", 6);
+  const auto int_neg = parse_int("-5", 2);
+  const auto int_hex = parse_int("0x50005\n", 8);
+  const auto int_empty = parse_int("\n", 1);
+  assert(int_dec.value_or(0) == 48312);
+  assert(int_neg.value_or(0) == -5);
+  assert(int_hex.value_or(0) == 0x50005);
+  assert(!int_empty.has_value());
+  // Only checked by assert
+  (void)prev_ok, (void)curr_ok, (void)invalid_ok, (void)meminfo_ok, (void)load;
+  (void)int_dec, (void)int_neg, (void)int_hex, (void)int_empty;
+}
+
+// /proc/stat and /proc/meminfo exist on every linux, the rest depends on the
+// board
+static void test_sampler() {
+  openhd::onboard::OnboardComputerSampler sampler;
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  const auto load = sampler.sample_cpu_load();
+  assert(load.has_value());
+  assert(load->total_perc >= 0 && load->total_perc <= 100);
+  assert(load->n_cores >= 1);
+  std::string cores;
+  for (int i = 0; i < load->n_cores; i++) {
+    assert(load->core_perc[i] <= 100);
+    cores += std::to_string(load->core_perc[i]) + " ";
+  }
+  const auto ram = sampler.sample_memory_usage();
+  assert(ram.has_value());
+  assert(ram->ram_usage_perc > 0 && ram->ram_usage_perc <= 100);
+  assert(ram->ram_total_mb > 0);
+  std::cout << fmt::format(
+                   "CPU load total:{}% cores:[{}] RAM {:.1f}% (total {}) "
+                   "temperature {} cpu freq {}MHz",
+                   load->total_perc, cores, ram->ram_usage_perc,
+                   ram->ram_total_mb,
+                   sampler.read_temperature_degree().value_or(-1),
+                   sampler.read_cpu_frequency_mhz().value_or(-1))
+            << std::endl;
+}
+
+struct CallTiming {
+  double avg_us = 0;
+  double max_us = 0;
+};
+
+template <class F>
+static CallTiming measure_per_call(int n_iterations, F&& f) {
+  CallTiming ret{};
+  double sum_us = 0;
+  for (int i = 0; i < n_iterations; i++) {
+    const auto begin = std::chrono::steady_clock::now();
+    f();
+    const double us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - begin)
+                          .count();
+    sum_us += us;
+    ret.max_us = std::max(ret.max_us, us);
+  }
+  ret.avg_us = sum_us / n_iterations;
+  return ret;
+}
+
+static void print_timing(const char* name, const CallTiming& legacy_timing,
+                         const CallTiming& sampler_timing) {
+  std::cout << fmt::format(
+                   "{:<12} legacy avg:{:>9.1f}us max:{:>9.1f}us | sampler "
+                   "avg:{:>6.1f}us max:{:>6.1f}us",
+                   name, legacy_timing.avg_us, legacy_timing.max_us,
+                   sampler_timing.avg_us, sampler_timing.max_us)
+            << std::endl;
+}
+
+// Each sample, legacy vs sampler. The legacy cpu load forks (popen of top),
+// the fork + exec alone is measured with a no-op command.
+static void bench_vs_legacy(int n_iterations) {
+  openhd::onboard::OnboardComputerSampler sampler;
+  const auto load = sampler.sample_cpu_load();
+  const auto top = legacy::read_cpuload_once_blocking();
+  const auto ram = sampler.sample_memory_usage();
+  const auto ram_legacy = legacy::calculate_memory_usage_percent();
+  std::cout << fmt::format(
+                   "CPU load {}% (top {}%), RAM {:.1f}% (legacy {:.1f}%), "
+                   "temperature {} (legacy {})",
+                   load.has_value() ? load->total_perc : -1, top.value_or(-1),
+                   ram.has_value() ? ram->ram_usage_perc : -1.0,
+                   ram_legacy.ram_usage_perc,
+                   sampler.read_temperature_degree().value_or(-1),
+                   legacy::read_temperature())
+            << std::endl;
+  const auto cpu_legacy = measure_per_call(
+      n_iterations, [] { legacy::read_cpuload_once_blocking(); });
+  const auto cpu_new = measure_per_call(
+      n_iterations * 100, [&sampler] { sampler.sample_cpu_load(); });
+  const auto fork_legacy = measure_per_call(
+      n_iterations, [] { OHDUtil::run_command_out("true"); });
+  const auto ram_legacy_timing = measure_per_call(
+      n_iterations * 10, [] { legacy::calculate_memory_usage_percent(); });
+  const auto ram_new = measure_per_call(
+      n_iterations * 100, [&sampler] { sampler.sample_memory_usage(); });
+  const auto temp_legacy = measure_per_call(
+      n_iterations * 10, [] { legacy::read_temperature(); });
+  const auto temp_new = measure_per_call(
+      n_iterations * 100, [&sampler] { sampler.read_temperature_degree(); });
+  print_timing("cpu load", cpu_legacy, cpu_new);
+  // The sampler never forks
+  print_timing("fork+exec", fork_legacy, CallTiming{});
+  print_timing("memory", ram_legacy_timing, ram_new);
+  print_timing("temperature", temp_legacy, temp_new);
+}
+
+int main(int argc, char* argv[]) {
+  const int n_iterations = argc > 1 ? std::atoi(argv[1]) : 20;
+  test_parsers();
+  std::cout << "Parsers OK" << std::endl;
+  test_sampler();
+  std::cout << "Sampler OK" << std::endl;
+  bench_vs_legacy(n_iterations);
+  return 0;
+}
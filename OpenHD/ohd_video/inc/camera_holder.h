@@ -118,6 +118,18 @@ class CameraHolder :
     persist();
     return true;
   }
+  bool set_h26x_early_tx(int value) {
+    if (!openhd::validate_h26x_early_tx(value)) return false;
+    unsafe_get_settings().h26x_early_tx = value;
+    persist();
+    return true;
+  }
+  bool set_h26x_rtp_packetizer(int value) {
+    if (!openhd::validate_h26x_rtp_packetizer(value)) return false;
+    unsafe_get_settings().h26x_rtp_packetizer = value;
+    persist();
+    return true;
+  }
   bool set_openhd_flip(int value) {
     if (!(value >= OPENHD_FLIP_NONE &&
           value <= OPENHD_FLIP_VERTICAL_AND_HORIZONTAL))
@@ -58,6 +58,11 @@ static constexpr int OPENHD_FLIP_HORIZONTAL = 1;
 static constexpr int OPENHD_FLIP_VERTICAL = 2;
 static constexpr int OPENHD_FLIP_VERTICAL_AND_HORIZONTAL = 3;
 
+// rtph264pay / rtph265pay in the gstreamer pipeline
+static constexpr int RTP_PACKETIZER_GSTREAMER = 0;
+// openhd::RTPHelper, the pipeline outputs raw h264 / h265
+static constexpr int RTP_PACKETIZER_OPENHD = 1;
+
 // User-selectable camera options
 // These values are settings that can change dynamically at run time
 // (non-deterministic)
@@ -108,6 +113,16 @@ struct CameraSettings {
   // N of slices. Not supported on all hardware (none to be exact unless the
   // cisco sw encoder) as of now 0 == frame slicing off
   int h26x_num_slices = 0;
+  // Early (sub-frame) transmission, forward the rtp fragments to the link
+  // without waiting for the end of the frame. 0: off (whole frames),
+  // 1: every complete slice, N>1: every complete slice and at least every N
+  // fragments. Lowers latency, most useful with h26x_num_slices >= 2.
+  int h26x_early_tx = 0;
+  // Who packetizes h264 / h265 into rtp, see RTP_PACKETIZER_XXX.
+  // h26x_early_tx works with both - RTP_PACKETIZER_OPENHD splits the frame into
+  // parts at the same points, but it gets whole access units from the parser,
+  // so the parts of a frame are forwarded right after each other.
+  int h26x_rtp_packetizer = RTP_PACKETIZER_GSTREAMER;
   // enable/disable recording to file
   int air_recording = AIR_RECORDING_OFF;
   //
@@ -0,0 +1,203 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_VIDEO_INC_DVR_WRITER_H_
+#define OPENHD_OPENHD_OHD_VIDEO_INC_DVR_WRITER_H_
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "openhd_spdlog.h"
+#include "openhd_spsc_queue.h"
+#include "openhd_video_frame.h"
+
+namespace openhd::video {
+
+/**
+ * Writes a recording (DVR) to disk on its own thread, such that a slow disk
+ * (e.g. an SD card stalling on writeback) never back-pressures the live video
+ * path.
+ * The producer hands over units (muxed container chunks or frames, depending
+ * on the caller) through a bounded lock-free queue and never blocks. Under
+ * pressure, non-keyframe units are dropped (and everything after them until
+ * the next keyframe, since it would not be decodable anyways). If single units
+ * can't be dropped without corrupting the container (drop_whole_groups), whole
+ * groups (keyframe unit up to the next keyframe unit) are dropped instead.
+ * The writer thread collects the units into a large aligned buffer, which is
+ * written out in big chunks. Files are preallocated (fallocate) ahead of the
+ * write position and optionally opened with O_DIRECT. Segments are rolled by
+ * size / duration, always at a keyframe - each segment starts with the stream
+ * header (e.g. the container header) set by the producer.
+ */
+class DvrWriter {
+ public:
+  // Write function, replaceable for testing (e.g. simulating a slow disk)
+  using WRITE_FN = std::function<ssize_t(int fd, const void* buf, size_t len)>;
+  struct Config {
+    // Called for each new segment, needs to return a not yet used filename
+    std::function<std::string()> create_filename;
+    // In units, rounded up to the next power of 2
+    size_t queue_capacity = 512;
+    // Units are dropped (until the next keyframe) once the queue is filled
+    // more than this
+    int drop_non_keyframes_queue_fill_perc = 50;
+    // For units that are only parts of the container structure, e.g. the
+    // buffers of matroskamux (a frame is split into cluster header, block
+    // header and payload). A keyframe unit starts a group (e.g. a cluster
+    // starting with a keyframe). Under pressure, whole groups are dropped
+    // (decided at the group start), and if the queue overflows in the middle
+    // of a group, what was written of it is removed from the file again.
+    bool drop_whole_groups = false;
+    // Data is written in chunks of this size (multiple of 4096)
+    size_t write_buffer_size = 1024 * 1024;
+    // Data that didn't fill up a chunk is written after at most this delay
+    // (not possible with O_DIRECT), to not lose too much on power loss
+    std::chrono::milliseconds max_buffer_delay{1000};
+    // Files are preallocated in steps of this size, 0 to disable
+    size_t preallocate_size = 32 * 1024 * 1024;
+    bool use_o_direct = false;
+    // 0: No limit
+    uint64_t max_segment_size_bytes = 0;
+    std::chrono::seconds max_segment_duration{0};
+    // Recording stops if less space is left on the disk
+    int64_t min_free_space_mb = 0;
+    WRITE_FN write_fn = nullptr;
+    // Called (on the writer thread) once a segment is complete and on disk
+    std::function<void(const std::string& filename)> on_segment_closed;
+  };
+  struct Stats {
+    uint64_t n_units_written = 0;
+    uint64_t n_units_dropped = 0;
+    // See Config::drop_whole_groups
+    uint64_t n_groups_rolled_back = 0;
+    uint64_t n_bytes_written = 0;
+    // Of the last second
+    uint32_t write_throughput_kbytes = 0;
+    uint32_t queue_depth = 0;
+    uint32_t queue_high_water = 0;
+    uint32_t max_write_duration_ms = 0;
+    uint32_t n_segments = 0;
+    bool out_of_space = false;
+    bool write_error = false;
+    std::string to_string() const;
+  };
+  explicit DvrWriter(Config config);
+  // Same as stop()
+  ~DvrWriter();
+  DvrWriter(const DvrWriter&) = delete;
+  DvrWriter& operator=(const DvrWriter&) = delete;
+  // Written at the beginning of each segment, appended on each call.
+  // Needs to be complete before the first unit is enqueued.
+  void add_stream_header(const uint8_t* data, size_t size);
+  // Never blocks. Returns false if the unit was dropped.
+  bool enqueue(VideoFragment unit, bool is_keyframe);
+  // Writes everything that is queued, closes the current segment and stops
+  // the writer thread. Blocks until the data is on disk.
+  void stop();
+  Stats get_stats() const;
+
+ private:
+  struct Unit {
+    VideoFragment data;
+    bool is_keyframe = false;
+    // Incremented with each keyframe unit, see Config::drop_whole_groups
+    uint64_t group = 0;
+  };
+  void loop();
+  void write_unit(const Unit& unit);
+  // Removes the group that is being written from the file (buffer), if the
+  // producer couldn't enqueue all of it
+  void rollback_aborted_group();
+  void append(const uint8_t* data, size_t size);
+  bool open_segment();
+  void close_segment();
+  bool is_segment_limit_reached() const;
+  // Writes (and empties) the buffer
+  void write_buffer();
+  bool write_fully(const uint8_t* data, size_t size);
+  // Makes sure the file is preallocated up until (at least) end_offset
+  void preallocate(uint64_t end_offset);
+  bool has_enough_free_space();
+  void update_throughput();
+
+ private:
+  const Config m_config;
+  std::shared_ptr<spdlog::logger> m_console;
+  SpscQueue<Unit> m_queue;
+  // Producer only
+  bool m_producer_waiting_for_keyframe = false;
+  uint64_t m_producer_group = 0;
+  // Set by the producer if (the rest of) this group didn't fit into the queue
+  std::atomic<uint64_t> m_aborted_group = 0;
+  // Guards the stream header (set once by the producer, read on each segment)
+  std::mutex m_header_mutex;
+  std::vector<uint8_t> m_stream_header;
+  std::mutex m_wake_mutex;
+  std::condition_variable m_wake_cv;
+  std::atomic<bool> m_stop_requested = false;
+  std::unique_ptr<std::thread> m_thread;
+  // Writer thread only
+  int m_fd = -1;
+  bool m_fd_is_o_direct = false;
+  bool m_fallocate_supported = true;
+  std::string m_segment_filename;
+  // Bytes written to the segment file (not including the buffer)
+  uint64_t m_file_offset = 0;
+  uint64_t m_preallocated_until = 0;
+  std::chrono::steady_clock::time_point m_segment_begin{};
+  // Group being written (0: none) and where it starts in the segment
+  uint64_t m_writer_group = 0;
+  uint64_t m_group_begin_offset = 0;
+  uint64_t m_group_n_units = 0;
+  std::unique_ptr<uint8_t, void (*)(void*)> m_buffer{nullptr, free};
+  size_t m_buffer_fill = 0;
+  std::chrono::steady_clock::time_point m_buffer_oldest_data{};
+  uint64_t m_throughput_bytes = 0;
+  std::chrono::steady_clock::time_point m_throughput_begin{};
+  std::chrono::steady_clock::time_point m_last_stats_log{};
+  // Published
+  std::atomic<uint64_t> m_n_units_written = 0;
+  std::atomic<uint64_t> m_n_units_dropped = 0;
+  std::atomic<uint64_t> m_n_groups_rolled_back = 0;
+  std::atomic<uint64_t> m_n_bytes_written = 0;
+  std::atomic<uint32_t> m_write_throughput_kbytes = 0;
+  std::atomic<uint32_t> m_queue_high_water = 0;
+  std::atomic<uint32_t> m_max_write_duration_ms = 0;
+  std::atomic<uint32_t> m_n_segments = 0;
+  std::atomic<bool> m_out_of_space = false;
+  std::atomic<bool> m_write_error = false;
+};
+
+}  // namespace openhd::video
+
+#endif  // OPENHD_OPENHD_OHD_VIDEO_INC_DVR_WRITER_H_
@@ -0,0 +1,120 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_VIDEO_INC_GROUND_RECORDER_H_
+#define OPENHD_OPENHD_OHD_VIDEO_INC_GROUND_RECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "openhd_spdlog.h"
+#include "openhd_spsc_queue.h"
+#include "openhd_video_frame.h"
+
+namespace openhd::video {
+
+/**
+ * Ground side DVR - records the video the ground receives (rtp, as it comes
+ * out of wifibroadcast) without any help from gstreamer.
+ * The link receive callback only copies the rtp packet into a pooled buffer
+ * and hands it over through a lock-free queue (one per stream), a full queue
+ * drops the packet. Everything else happens on the recorder thread:
+ * The rtp packets are depacketized (H264 / H265, the codec is detected from
+ * the stream since the ground doesn't know what the air is sending) into
+ * access units and written as a streamable .mkv (one cluster per keyframe)
+ * through a DvrWriter. Once a recording is done, it is remuxed to .mp4 (where
+ * the keyframes are indexed, e.g. for seeking).
+ * Packets lost on the link (e.g. more than FEC could recover) are a
+ * discontinuity - the incomplete frame and everything up to the next keyframe
+ * is dropped, the recording continues at the next keyframe. The timestamps
+ * keep the gap, such that the recording stays in sync with real time.
+ * A new file is started if the stream parameters change (e.g. resolution),
+ * the stream restarts or no data was received for a while.
+ */
+class GroundRecorder {
+ public:
+  struct Config {
+    // 0: primary, 1: secondary
+    int n_streams = 2;
+    // Per stream, in rtp packets
+    size_t queue_capacity = 1024;
+    // Called for each new file, needs to return a not yet used filename
+    std::function<std::string(int stream_index)> create_filename;
+    // Recording (of all streams) stops if less space is left on the disk
+    int64_t min_free_space_mb = 300;
+    // The current file is closed if no data was received for this long
+    std::chrono::milliseconds idle_timeout{3000};
+    // Called (on some worker thread) once a file is complete and on disk
+    std::function<void(const std::string& filename)> on_file_closed;
+  };
+  struct Stats {
+    uint64_t n_packets = 0;
+    // Queue full
+    uint64_t n_packets_dropped = 0;
+    uint64_t n_frames_written = 0;
+    uint64_t n_keyframes_written = 0;
+    // Incomplete, or not decodable since after a discontinuity
+    uint64_t n_frames_dropped = 0;
+    uint64_t n_discontinuities = 0;
+    uint32_t n_files = 0;
+    std::string to_string() const;
+  };
+  explicit GroundRecorder(Config config);
+  // Writes what was received so far and closes the file(s)
+  ~GroundRecorder();
+  GroundRecorder(const GroundRecorder&) = delete;
+  GroundRecorder& operator=(const GroundRecorder&) = delete;
+  // Called by the link receive thread(s) - only one thread per stream index.
+  // Never blocks.
+  void on_rtp_packet(int stream_index, const uint8_t* data, int data_len);
+  Stats get_stats(int stream_index) const;
+
+ private:
+  // Depacketizer and file state of one stream
+  class StreamRecorder;
+  struct StreamQueue {
+    explicit StreamQueue(size_t capacity) : queue(capacity) {}
+    SpscQueue<VideoFragment> queue;
+    std::atomic<uint64_t> n_packets = 0;
+    std::atomic<uint64_t> n_packets_dropped = 0;
+  };
+  void loop();
+
+ private:
+  const Config m_config;
+  std::shared_ptr<spdlog::logger> m_console;
+  std::vector<std::unique_ptr<StreamQueue>> m_queues;
+  std::vector<std::unique_ptr<StreamRecorder>> m_streams;
+  std::atomic<bool> m_terminate = false;
+  std::unique_ptr<std::thread> m_thread;
+};
+
+}  // namespace openhd::video
+
+#endif  // OPENHD_OPENHD_OHD_VIDEO_INC_GROUND_RECORDER_H_
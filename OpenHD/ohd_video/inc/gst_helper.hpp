@@ -765,6 +765,19 @@ static std::string create_parse_and_rtp_packetize(
   ss << create_rtp_packetize_for_codec(videoCodec, rtp_fragment_size);
   return ss.str();
 }
+// Same, but the rtp packetization is done by openhd::RTPHelper - the appsink
+// gets one buffer per access unit (annex b)
+static std::string create_parse_for_openhd_rtp(const VideoCodec videoCodec) {
+  std::stringstream ss;
+  ss << "queue ! ";
+  ss << create_parse_for_codec(videoCodec);
+  if (videoCodec == VideoCodec::H264) {
+    ss << "video/x-h264,stream-format=byte-stream,alignment=au ! ";
+  } else {
+    ss << "video/x-h265,stream-format=byte-stream,alignment=au ! ";
+  }
+  return ss.str();
+}
 static std::string create_queue_and_parse(const VideoCodec videoCodec) {
   std::stringstream ss;
   ss << "queue ! ";
@@ -808,28 +821,28 @@ static std::string file_suffix_for_video_codec(const VideoCodec videoCodec) {
     return ".avi";
   }
 }
-// Assumes there is a tee command named "t" somewhere in the pipeline right
-// after the encoding step, so we can get the raw encoded data out.
-// .avi supports h264 and mjpeg, and works even in case the stream would crash
-// doesn't support h265 though
+// Recording branch, attached at run time to the tee named "t" right after the
+// encoding step (see GstRecordingBranch), so we can get the raw encoded data
+// out. The muxed data is written by a DvrWriter (appsink "rec_sink").
 // .mp4 is always corrupted on crash
-// .mkv supports h264 and h265, but no mjpeg. It is the default in OBS though,
-// so we decided to use .mkv for h264 and h265 and .avi for mjpeg in case the
-// gst pipeline is not stopped properly
-static std::string createRecordingForVideoCodec(
-    const VideoCodec videoCodec, const std::string& out_filename) {
+// .mkv supports h264 and h265. It is the default in OBS though, so we decided
+// to use .mkv in case the gst pipeline is not stopped properly
+// streamable=true: The writer only appends, the muxer can't seek back to write
+// the index (cues) - the recording is still playable, remuxing adds the index
+// NOTE: The element names are used by GstRecordingBranch
+static std::string createRecordingBranchForVideoCodec(
+    const VideoCodec videoCodec) {
   std::stringstream ss;
-  // don't forget the white space before the " t." !
-  ss << " t. ! queue ! ";
+  ss << "queue ! ";
+  // config-interval=-1: The branch is attached mid-stream, make sure the
+  // parameter sets are in front of the first keyframe we record
   if (videoCodec == VideoCodec::H264) {
-    ss << "h264parse ! ";
-  } else if (videoCodec == VideoCodec::H265) {
-    ss << "h265parse ! ";
-  }
-  // ss <<"mp4mux ! filesink location="<<out_filename;
-  if (videoCodec == VideoCodec::H264 || videoCodec == VideoCodec::H265) {
-    ss << "matroskamux ! filesink location=" << out_filename;
+    ss << "h264parse name=rec_parse config-interval=-1 ! ";
+  } else {
+    ss << "h265parse name=rec_parse config-interval=-1 ! ";
   }
+  ss << "matroskamux streamable=true ! ";
+  ss << "appsink name=rec_sink sync=false async=false wait-on-eos=false";
   return ss.str();
 }
 
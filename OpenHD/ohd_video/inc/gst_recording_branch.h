@@ -0,0 +1,129 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_VIDEO_INC_GST_RECORDING_BRANCH_H_
+#define OPENHD_OPENHD_OHD_VIDEO_INC_GST_RECORDING_BRANCH_H_
+
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "camera_enums.hpp"
+#include "dvr_writer.h"
+#include "openhd_spdlog.h"
+
+/**
+ * Air recording as a branch of the tee named "t" (right after the encoder),
+ * which can be attached to and detached from the already running pipeline.
+ * This way arming / disarming (AIR_RECORDING_AUTO_ARM_DISARM) doesn't require
+ * a pipeline restart, which would result in a video blackout of several
+ * seconds, exactly at takeoff.
+ * When attached, the branch drops everything until the next keyframe (and
+ * asks the encoder for one), such that each recording starts with an IDR.
+ * The muxed data is handed to a DvrWriter (appsink), such that a slow or
+ * stalling SD card never back-pressures the encoder and with it the live
+ * stream. If the writer can't keep up, whole clusters (keyframe to keyframe)
+ * are dropped - never single muxer buffers, the file stays valid.
+ * When detached, the branch is unlinked from the tee and receives an EOS, so
+ * the muxer can properly finalize the file - the live stream is never
+ * interrupted.
+ * NOTE: Not thread-safe, all calls need to come from the thread driving the
+ * pipeline (GStreamerStream: the stream thread)
+ */
+class GstRecordingBranch {
+ public:
+  // The pipeline needs to contain a "tee name=t" - if it doesn't, start()
+  // always fails.
+  GstRecordingBranch(GstElement* pipeline, VideoCodec codec,
+                     std::shared_ptr<spdlog::logger> console);
+  // Stops a running recording (blocks for a bounded amount of time)
+  ~GstRecordingBranch();
+  GstRecordingBranch(const GstRecordingBranch&) = delete;
+  GstRecordingBranch& operator=(const GstRecordingBranch&) = delete;
+  // Creates a new recording file and links the branch to the tee.
+  // Returns true on success (or if already recording).
+  bool start();
+  // Unlinks the branch and sends EOS into it, returns immediately.
+  // Call poll() regularly until is_active() returns false.
+  void request_stop();
+  // Finishes a pending stop once the muxer is done (or after a timeout)
+  void poll();
+  // request_stop() and poll() until done
+  void stop_blocking();
+  // True if recording or a stop is still pending
+  bool is_active() const { return m_state != State::IDLE; }
+  bool is_recording() const { return m_state == State::RECORDING; }
+  // File of the current (or last) recording
+  const std::string& get_filename() const { return m_filename; }
+  // Of the current recording, if there is one
+  std::optional<openhd::video::DvrWriter::Stats> get_writer_stats() const;
+
+ private:
+  enum class State { IDLE, RECORDING, STOPPING };
+  static constexpr auto STOP_TIMEOUT = std::chrono::seconds(2);
+  // Don't try re-creating the branch on each call if it failed
+  static constexpr auto RETRY_START_INTERVAL = std::chrono::seconds(5);
+  static GstPadProbeReturn wait_for_keyframe_probe(GstPad* pad,
+                                                   GstPadProbeInfo* info,
+                                                   gpointer user_data);
+  static GstPadProbeReturn unlink_probe(GstPad* pad, GstPadProbeInfo* info,
+                                        gpointer user_data);
+  static GstPadProbeReturn eos_probe(GstPad* pad, GstPadProbeInfo* info,
+                                     gpointer user_data);
+  static GstFlowReturn on_new_sample(GstAppSink* appsink, gpointer user_data);
+  bool add_pad_probe(const char* element_name, const char* pad_name,
+                     GstPadProbeType type, GstPadProbeCallback callback);
+  void request_keyframe();
+  void finalize_stop();
+  // Flushes and closes the file without blocking the calling thread
+  void close_writer_async();
+  // Removes (and unrefs) the branch bin, safe to call when half-created
+  void remove_bin();
+
+ private:
+  GstElement* m_pipeline;
+  const VideoCodec m_codec;
+  std::shared_ptr<spdlog::logger> m_console;
+  GstElement* m_tee = nullptr;
+  GstElement* m_bin = nullptr;
+  GstPad* m_tee_src_pad = nullptr;
+  // Fed from the branch streaming thread (the only producer)
+  std::shared_ptr<openhd::video::DvrWriter> m_writer;
+  gulong m_unlink_probe_id = 0;
+  State m_state = State::IDLE;
+  std::string m_filename;
+  std::chrono::steady_clock::time_point m_recording_begin{};
+  std::chrono::steady_clock::time_point m_stop_begin{};
+  std::optional<std::chrono::steady_clock::time_point> m_last_start_failure;
+  // Set from the gstreamer streaming thread(s)
+  std::atomic<bool> m_unlinked = false;
+  std::atomic<bool> m_eos_reached = false;
+  std::atomic<int> m_n_dropped_until_keyframe = 0;
+};
+
+#endif  // OPENHD_OPENHD_OHD_VIDEO_INC_GST_RECORDING_BRANCH_H_
@@ -35,11 +35,12 @@
 #include "camera_settings.hpp"
 #include "camerastream.h"
 #include "gst_bitrate_controll_wrapper.hpp"
+#include "gst_recording_branch.h"
 #include "openhd_platform.h"
 #include "openhd_spdlog.h"
 // #include "gst_recorder.h"
-#include "nalu/CodecConfigFinder.hpp"
 #include "openhd_rtp.h"
+#include "rtp_frame_assembler.h"
 
 // Implementation of OHD CameraStream for pretty much everything, using
 // gstreamer.
@@ -71,6 +72,9 @@ class GStreamerStream : public CameraStream {
       openhd::LinkActionHandler::LinkBitrateInformation lb) override;
   // this is called when the FC reports itself as armed / disarmed
   void handle_update_arming_state(bool armed) override;
+  // Attaches / detaches the recording branch if needed, without interrupting
+  // the live stream. Called from the stream thread.
+  void update_air_recording();
   void loop_infinite();
   void stream_once();
   // To reduce the time on the param callback(s) - they need to return
@@ -85,12 +89,12 @@ class GStreamerStream : public CameraStream {
   // not supported by all camera(s).
   // for dynamically changing the bitrate
   std::optional<GstBitrateControlElement> m_bitrate_ctrl_element = std::nullopt;
-  // If a pipeline is started with air recording enabled, the file name the
-  // recording is written to is stored here otherwise, it is set to std::nullopt
-  std::optional<std::string> m_opt_curr_recording_filename = std::nullopt;
+  // Exists if air recording is enabled (on or auto arm / disarm) for the
+  // current pipeline, records while attached.
+  std::unique_ptr<GstRecordingBranch> m_recording_branch;
   std::shared_ptr<spdlog::logger> m_console;
   // Set to true if armed, used for auto record on arm
-  bool m_armed_enable_air_recording = false;
+  std::atomic<bool> m_armed_enable_air_recording = false;
   std::atomic<int> m_curr_dynamic_bitrate_kbits = -1;
   // Not working yet, keep the old approach
   // std::unique_ptr<GstVideoRecorder> m_gst_video_recorder=nullptr;
@@ -100,21 +104,13 @@ class GStreamerStream : public CameraStream {
 
  private:
   // The stuff here is to pull the data out of the gstreamer pipeline, such that
-  // we can forward it to the WB link
-  void on_new_rtp_frame_fragment(std::shared_ptr<std::vector<uint8_t>> fragment,
-                                 uint64_t dts);
-  void on_new_rtp_fragmented_frame();
-  std::vector<std::shared_ptr<std::vector<uint8_t>>> m_frame_fragments;
-
-  void x_on_new_rtp_fragmented_frame(
-      std::vector<std::shared_ptr<std::vector<uint8_t>>> frame_fragments);
-  bool m_last_fu_s_idr = false;
-  bool dirty_use_raw = false;
+  // we can forward it to the WB link. Created for each pipeline in setup().
+  std::unique_ptr<openhd::RTPFrameAssembler> m_frame_assembler;
+  // Only if the pipeline outputs raw h264 / h265 (see
+  // CameraSettings::h26x_rtp_packetizer)
+  std::unique_ptr<openhd::RTPHelper> m_rtp_packetizer;
   std::chrono::steady_clock::time_point m_last_log_streaming_disabled =
       std::chrono::steady_clock::now();
-
- private:
-  std::shared_ptr<openhd::RTPHelper> m_rtp_helper;
 };
 
 #endif
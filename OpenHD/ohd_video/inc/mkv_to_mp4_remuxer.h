@@ -0,0 +1,77 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_VIDEO_INC_MKV_TO_MP4_REMUXER_H_
+#define OPENHD_OPENHD_OHD_VIDEO_INC_MKV_TO_MP4_REMUXER_H_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace openhd::video {
+
+/**
+ * Native (no gstreamer, no subprocess) remuxing of air recordings from .mkv
+ * into .mp4, without re-encoding.
+ * Supports what matroskamux writes for us: one H264 / H265 video track, in
+ * SimpleBlocks or BlockGroups, including unknown-size segments / clusters
+ * (streamable) and files that were cut off (crash / power loss) - everything
+ * up to the last complete frame is kept.
+ * Only the element headers are read, the frame data is copied file to file
+ * (copy_file_range), it never passes through user space. Since mkv (avc / hvc)
+ * and mp4 both store length-prefixed NALUs, the frames are copied as they are.
+ * While working, progress is written to out_file.part and out_file.journal.
+ * Every checkpoint_interval_bytes, the data is synced and a checkpoint is
+ * added to the journal - if interrupted (cancel, crash, power loss), the next
+ * call for the same file continues at the last checkpoint. out_file is only
+ * created once complete, the input file is never modified.
+ */
+struct RemuxOptions {
+  uint64_t checkpoint_interval_bytes = 16 * 1024 * 1024;
+  // Checked between clusters (optional), stops early if it returns true
+  std::function<bool()> should_cancel = nullptr;
+};
+
+struct RemuxResult {
+  bool success = false;
+  // Stopped early by RemuxOptions::should_cancel, can be continued
+  bool cancelled = false;
+  std::string error;
+  // Continued from a previous (interrupted) run
+  bool resumed = false;
+  uint32_t n_samples = 0;
+  uint32_t n_keyframes = 0;
+  // Frame data copied in this run
+  uint64_t n_bytes_copied = 0;
+  std::chrono::milliseconds media_duration{0};
+  std::string to_string() const;
+};
+
+RemuxResult remux_mkv_to_mp4(const std::string& in_file,
+                             const std::string& out_file,
+                             const RemuxOptions& options = {});
+
+}  // namespace openhd::video
+
+#endif  // OPENHD_OPENHD_OHD_VIDEO_INC_MKV_TO_MP4_REMUXER_H_
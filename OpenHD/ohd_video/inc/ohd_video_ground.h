@@ -24,6 +24,7 @@
 #ifndef OPENHD_OPENHD_OHD_VIDEO_INC_OHD_VIDEO_GROUND_H_
 #define OPENHD_OPENHD_OHD_VIDEO_INC_OHD_VIDEO_GROUND_H_
 
+#include "ground_recorder.h"
 #include "openhd_external_device.h"
 #include "openhd_link.hpp"
 #include "openhd_udp.h"
@@ -43,6 +44,15 @@ class OHDVideoGround {
    */
   explicit OHDVideoGround(std::shared_ptr<OHDLink> link_handle);
   ~OHDVideoGround();
+  /**
+   * Forward video to all device(s) consuming video (and record it, if
+   * enabled).
+   * Called by the ohd link handle (aka only wb right now), public for testing
+   * (e.g. feeding a recorded rtp stream)
+   * @param stream_index 0 for primary video stream, 1 for secondary, ...
+   * @param data and @param data_len: r.n always a full rtp frame fragment
+   */
+  void on_video_data(int stream_index, const uint8_t* data, int data_len);
 
  private:
   // Start forwarding to another ip
@@ -56,14 +66,8 @@ class OHDVideoGround {
   std::unique_ptr<openhd::UDPMultiForwarder> m_primary_video_forwarder;
   std::unique_ptr<openhd::UDPMultiForwarder> m_secondary_video_forwarder;
   std::unique_ptr<openhd::UDPMultiForwarder> m_audio_forwarder;
-  /**
-   * Forward video to all device(s) consuming video.
-   * Called by the ohd link handle (aka only wb right now)
-   * @param stream_index 0 for primary video stream, 1 for secondary, ...
-   * @param data and @param data_len: r.n always a full rtp frame fragment
-   */
-  void on_video_data(int stream_index, const uint8_t* data, int data_len);
-
+  // Only if GEN_GROUND_RECORDING is enabled
+  std::unique_ptr<openhd::video::GroundRecorder> m_ground_recorder;
   /**
    * Forward audio. We only have up to 1 audio stream
    */
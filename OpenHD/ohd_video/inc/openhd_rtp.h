@@ -24,79 +24,91 @@
 #ifndef OPENHD_OPENHD_RTP_H
 #define OPENHD_OPENHD_RTP_H
 
-#include "nalu/CodecConfigFinder.hpp"
-#include "openhd_link.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
 #include "openhd_spdlog.h"
-#include "rtp-payload-internal.h"
+#include "openhd_video_frame.h"
 
 namespace openhd {
 
 /**
- * Due to legacy reasons, we have 2 cases:
- * 1) We use gstreamer for rtp encoding - in this case, we get rtp fragments out
- * via appsink and only need to listen for the FU-E (End bit) fragment(s) to
- * properly forward a fragmented frame 2) We use gstreamer or something else for
- * h264/h265 encoding, but not rtp encoding - in this case, we get
- * TODO: Be specific on the format
- * NALUs and packetize them using lib rtp. The first
- * approach is much more reliable, but the second approach has its own
- * advantages, too.
+ * Packetizes raw H264 / H265 (annex b byte stream, one access unit at a time)
+ * into rtp (RFC 6184 / RFC 7798, non-interleaved mode) - the alternative to
+ * rtph264pay / rtph265pay in the gstreamer pipeline, selected per camera (see
+ * CameraSettings::h26x_rtp_packetizer).
+ * One instance per pipeline, there is no shared (static) state. Each packet is
+ * written in place into a FragmentPool slot, NAL units are found with memchr
+ * and the parameter sets are cached (in re-used buffers) and sent as one
+ * aggregation packet in front of each keyframe and at least once per second.
+ * Once warmed up, nothing is allocated per access unit or fragment.
+ * Like RTPFrameAssembler, the output is one frame per access unit - or, with
+ * early_tx enabled, one part per slice (and / or N fragments), split at the
+ * same points as RTPFrameAssembler does.
  */
 class RTPHelper {
  public:
-  explicit RTPHelper(bool is_h265);
-  ~RTPHelper();
-
-  typedef std::function<void(
-      std::vector<std::shared_ptr<std::vector<uint8_t>>> frame_fragments)>
-      OUT_CB;
-  void set_out_cb(RTPHelper::OUT_CB cb);
-
-  // Accepts one or more than one NALUs.
-  // Needs to be aligned on NAL !
-  void feed_multiple_nalu(const uint8_t* data, int data_len);
-
-  // Feeds exactly one NALU
-  void feed_nalu(const uint8_t* data, int data_len);
-
- public:
-  // public due to c/c++ mix (callbacks)
-  void on_new_rtp_fragment(const uint8_t* nalu, int bytes, uint32_t timestamp,
-                           int last);
-
- private:
-  void on_new_split_nalu(const uint8_t* data, int data_len);
-  void on_new_nalu_frame(const uint8_t* data, int data_len);
-  const bool m_is_h265;
-  OUT_CB m_out_cb = nullptr;
-  rtp_payload_t m_handler{};
-  void* encoder;
-  std::shared_ptr<spdlog::logger> m_console;
-  std::vector<std::shared_ptr<std::vector<uint8_t>>> m_frame_fragments;
-  CodecConfigFinder m_config_finder;
-  std::chrono::steady_clock::time_point m_last_codec_config_send_ts =
-      std::chrono::steady_clock::now();
-};
-
-class RTPFragmentBuffer {
- public:
-  explicit RTPFragmentBuffer();
-  void buffer_and_forward(std::shared_ptr<std::vector<uint8_t>> fragment,
-                          uint64_t dts);
-
- public:
-  bool m_enable_ultra_secure_encryption = false;
-  bool m_is_h265 = false;
-  bool m_uses_intra_refresh = false;
-  int m_stream_index = 0;
+  struct Config {
+    bool is_h265 = false;
+    int stream_index = 0;
+    bool uses_intra_refresh = false;
+    // See CameraSettings::h26x_early_tx
+    int early_tx = 0;
+    // Max size of a rtp packet (header included), should not exceed
+    // FragmentPool::SLOT_SIZE
+    int mtu = 1440;
+  };
+  explicit RTPHelper(Config config, ON_ENCODE_FRAME_CB out_cb);
+  void set_enable_ultra_secure_encryption(bool enable) {
+    m_enable_ultra_secure_encryption = enable;
+  }
+  // Accepts one access unit (one or more NAL units with start codes), calls
+  // the out cb once with all its rtp fragments (once per part with early_tx).
+  void feed_access_unit(const uint8_t* data, size_t data_len);
+  // Returns the position of the next start code (00 00 01) in [begin,end),
+  // end if there is none. Exposed for testing.
+  static const uint8_t* find_start_code(const uint8_t* begin,
+                                        const uint8_t* end);
 
  private:
-  void on_new_rtp_fragmented_frame();
+  // NAL unit (without start code) of the current access unit
+  struct Nalu {
+    const uint8_t* data;
+    size_t size;
+  };
+  void on_parameter_set(std::vector<uint8_t>& cache, const Nalu& nalu);
+  void packetize_parameter_sets();
+  void packetize_nalu(const Nalu& nalu, bool is_last);
+  // Returns a packet with the rtp header already written, payload_size bytes
+  // left to fill in after the header
+  VideoFragment create_packet(size_t payload_size, bool marker,
+                              uint8_t*& payload);
+  // Early tx: forwards the fragments so far as one part of the frame, if the
+  // last one ended a slice / there are enough of them
+  void maybe_forward_part(bool is_slice_end);
+  void forward_part(bool is_last_part);
 
  private:
+  const Config m_config;
+  const ON_ENCODE_FRAME_CB m_out_cb;
   std::shared_ptr<spdlog::logger> m_console;
-  bool m_last_fu_s_idr = false;
-  std::vector<std::shared_ptr<std::vector<uint8_t>>> m_frame_fragments;
+  std::atomic<bool> m_enable_ultra_secure_encryption = false;
+  // Re-used for each access unit
+  std::vector<Nalu> m_nalus;
+  std::vector<VideoFragment> m_fragments;
+  std::vector<uint8_t> m_vps, m_sps, m_pps;
+  // Of the access unit that is being packetized
+  std::chrono::steady_clock::time_point m_curr_creation_time{};
+  bool m_curr_is_keyframe = false;
+  int m_curr_part_index = 0;
+  std::chrono::steady_clock::time_point m_last_parameter_sets_sent{};
+  uint16_t m_seq = 0;
+  uint32_t m_timestamp = 0;
+  bool m_has_timestamp = false;
+  uint32_t m_ssrc;
 };
 
 }  // namespace openhd
@@ -0,0 +1,72 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_RECORDING_REMUXER_H
+#define OPENHD_RECORDING_REMUXER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "openhd_spdlog.h"
+
+// Converts finished .mkv air recordings into more manageable .mp4 files.
+// All files are remuxed one after another on a single worker thread (created
+// on demand) with idle cpu and io priority, such that remuxing a backlog of
+// recordings (e.g. after a crash) never competes with the live video.
+// Remuxing is resumable (see remux_mkv_to_mp4) - if interrupted, the next run
+// continues where it left off.
+class RecordingRemuxer {
+ public:
+  static RecordingRemuxer& instance();
+  // Interrupts the current remux (it is continued on the next start)
+  ~RecordingRemuxer();
+  // Queues all .mkv files in the openhd videos (air recording) directory
+  void remux_all_remaining_mkv_files_async();
+  // Queues a finished .mkv file unless it is already queued / being remuxed.
+  // Thread-safe, returns false if the file was not queued.
+  bool remux_mkv_file_async(const std::string& filename);
+
+ private:
+  RecordingRemuxer();
+  // Files that don't fit are picked up by the next remux_all_... call
+  static constexpr size_t MAX_QUEUE_SIZE = 32;
+  void loop();
+  void remux(const std::string& filename);
+
+ private:
+  std::shared_ptr<spdlog::logger> m_console;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::string> m_queue;
+  std::string m_current;
+  bool m_terminate = false;
+  std::atomic<bool> m_cancel = false;
+  std::unique_ptr<std::thread> m_thread;
+};
+
+#endif  // OPENHD_RECORDING_REMUXER_H
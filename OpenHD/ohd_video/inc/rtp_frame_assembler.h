@@ -0,0 +1,113 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#ifndef OPENHD_OPENHD_OHD_VIDEO_INC_RTP_FRAME_ASSEMBLER_H_
+#define OPENHD_OPENHD_OHD_VIDEO_INC_RTP_FRAME_ASSEMBLER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "openhd_spdlog.h"
+#include "openhd_video_frame.h"
+
+namespace openhd {
+
+/**
+ * Aggregates the rtp fragments coming out of the encoder pipeline (rtph264pay /
+ * rtph265pay) into frames.
+ * One instance per pipeline - codec and the per-stream flags don't change for
+ * the lifetime of a pipeline, so they are passed once on construction and the
+ * codec specific parser is selected there, too.
+ * End of frame is the RTP marker bit (last packet of an access unit). Pipelines
+ * that never set it (nal aligned input to the payloader) fall back to the end
+ * of a fragmentation unit, until the first marker bit is seen.
+ * With early_tx enabled, the fragments are forwarded in parts as soon as a
+ * slice (and / or N fragments) is complete instead of once per frame - the
+ * link can then start FEC encoding / transmitting before the encoder is done
+ * with the whole frame.
+ */
+class RTPFrameAssembler {
+ public:
+  struct Config {
+    bool is_h265 = false;
+    int stream_index = 0;
+    bool uses_intra_refresh = false;
+    // See CameraSettings::h26x_early_tx
+    int early_tx = 0;
+  };
+  explicit RTPFrameAssembler(Config config, ON_ENCODE_FRAME_CB out_cb);
+  // Unlike the rest, this one can change without restarting the pipeline
+  void set_enable_ultra_secure_encryption(bool enable) {
+    m_enable_ultra_secure_encryption = enable;
+  }
+  // Feed the next rtp packet, calls the out cb if it completes a frame
+  void add_fragment(VideoFragment fragment);
+  // Drops a partially assembled frame, if there is any.
+  void reset();
+
+  // What we need to know about a single rtp packet, exposed for testing
+  struct FragmentInfo {
+    bool valid = false;
+    // RTP marker bit
+    bool marker = false;
+    // Last fragment of a fragmentation unit (FU-A / FU)
+    bool is_fu_end = false;
+    // Last fragment of a slice (VCL NAL unit), FU or single NAL
+    bool is_slice_end = false;
+    // Contains an IDR slice (or the start of one), single NAL, aggregation
+    // packet (STAP-A / AP) or FU start fragment
+    bool contains_idr = false;
+    // STAP-A / AP
+    bool is_aggregation = false;
+  };
+  template <bool IS_H265>
+  static FragmentInfo parse(const uint8_t* data, std::size_t data_len);
+
+ private:
+  using PARSE_FN = FragmentInfo (*)(const uint8_t*, std::size_t);
+  FragmentInfo parse_fragment(const VideoFragment& fragment) const;
+  void forward_part(bool is_last_part);
+  const Config m_config;
+  const ON_ENCODE_FRAME_CB m_out_cb;
+  const PARSE_FN m_parse;
+  std::shared_ptr<spdlog::logger> m_console;
+  std::vector<VideoFragment> m_frame_fragments;
+  std::atomic<bool> m_enable_ultra_secure_encryption = false;
+  bool m_curr_frame_is_idr = false;
+  // Arrival of the first fragment of the current frame
+  std::chrono::steady_clock::time_point m_curr_frame_begin;
+  int m_curr_part_index = 0;
+  bool m_marker_seen = false;
+  // Most likely something wrong with the stream if we don't get an end of
+  // frame for this many fragments
+  static constexpr size_t MAX_N_FRAGMENTS_PER_FRAME = 500;
+  // Enough for the rtp header and the payload header(s) of all but
+  // aggregation packets
+  static constexpr size_t PARSE_PREFIX_SIZE = 64;
+};
+
+}  // namespace openhd
+
+#endif  // OPENHD_OPENHD_OHD_VIDEO_INC_RTP_FRAME_ASSEMBLER_H_
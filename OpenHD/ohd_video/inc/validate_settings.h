@@ -91,6 +91,14 @@ bool validate_rpi_keyframe_interval(int value);
 // see gst-rpicamsrc documentation
 bool validate_rpi_intra_refresh_type(int value);
 
+static bool validate_h26x_early_tx(int value) {
+  return value >= 0 && value <= 100;
+}
+
+static bool validate_h26x_rtp_packetizer(int value) {
+  return value == 0 || value == 1;
+}
+
 static bool validate_rpi_libcamera_ev_value(int value) {
   return value >= -10 && value <= 10;
 }
@@ -37,8 +37,9 @@ NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(VideoFormat, videoCodec, width, height,
 NLOHMANN_DEFINE_TYPE_NON_INTRUSIVE(
     CameraSettings, enable_streaming, streamed_video_format, h26x_bitrate_kbits,
     h26x_keyframe_interval, h26x_intra_refresh_type, h26x_num_slices,
-    air_recording, camera_rotation_degree, openhd_flip, openhd_brightness,
-    openhd_sharpness, openhd_saturation, openhd_contrast,
+    h26x_early_tx, h26x_rtp_packetizer, air_recording, camera_rotation_degree,
+    openhd_flip, openhd_brightness, openhd_sharpness, openhd_saturation,
+    openhd_contrast,
     // rpi libcamera specific IQ params begin
     rpi_libcamera_ev_value, rpi_libcamera_denoise_index,
     rpi_libcamera_awb_index, rpi_libcamera_metering_index,
@@ -186,6 +187,19 @@ std::vector<openhd::Setting> CameraHolder::get_all_settings() {
     ret.push_back(openhd::Setting{
         "N_SLICES",
         openhd::IntSetting{get_settings().h26x_num_slices, c_h26x_num_slices}});
+    auto c_h26x_early_tx = [this](std::string, int value) {
+      return set_h26x_early_tx(value);
+    };
+    ret.push_back(openhd::Setting{
+        "EARLY_TX",
+        openhd::IntSetting{get_settings().h26x_early_tx, c_h26x_early_tx}});
+    auto c_h26x_rtp_packetizer = [this](std::string, int value) {
+      return set_h26x_rtp_packetizer(value);
+    };
+    ret.push_back(openhd::Setting{
+        "RTP_PACKETIZER",
+        openhd::IntSetting{get_settings().h26x_rtp_packetizer,
+                           c_h26x_rtp_packetizer}});
   }
   // right now only supported by libcamera and (partially) x20
   const bool SUPPORTS_OPENHD_IQ = m_camera.requires_rpi_libcamera_pipeline() ||
@@ -0,0 +1,441 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "dvr_writer.h"
+
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#include "openhd_spdlog_include.h"
+#include "openhd_util_filesystem.h"
+
+namespace openhd::video {
+
+static constexpr size_t BLOCK_SIZE = 4096;
+
+std::string DvrWriter::Stats::to_string() const {
+  return fmt::format(
+      "DvrWriter[written:{} dropped:{} rolled back:{} {}MB {}kB/s queue:{} "
+      "(max {}) max_write:{}ms segments:{}{}{}]",
+      n_units_written, n_units_dropped, n_groups_rolled_back,
+      n_bytes_written / 1024 / 1024,
+      write_throughput_kbytes, queue_depth, queue_high_water,
+      max_write_duration_ms, n_segments, out_of_space ? " OUT OF SPACE" : "",
+      write_error ? " WRITE ERROR" : "");
+}
+
+DvrWriter::DvrWriter(Config config)
+    : m_config(std::move(config)), m_queue(m_config.queue_capacity) {
+  assert(m_config.create_filename);
+  assert(m_config.write_buffer_size > 0 &&
+         m_config.write_buffer_size % BLOCK_SIZE == 0);
+  m_console = openhd::log::create_or_get("dvr");
+  void* buffer = nullptr;
+  // Aligned, such that it can be used with O_DIRECT
+  if (posix_memalign(&buffer, BLOCK_SIZE, m_config.write_buffer_size) != 0) {
+    throw std::bad_alloc();
+  }
+  m_buffer.reset(static_cast<uint8_t*>(buffer));
+  m_thread = std::make_unique<std::thread>(&DvrWriter::loop, this);
+}
+
+DvrWriter::~DvrWriter() { stop(); }
+
+void DvrWriter::add_stream_header(const uint8_t* data, size_t size) {
+  std::lock_guard<std::mutex> guard(m_header_mutex);
+  m_stream_header.insert(m_stream_header.end(), data, data + size);
+}
+
+bool DvrWriter::enqueue(VideoFragment unit, bool is_keyframe) {
+  const auto drop = [this]() {
+    m_producer_waiting_for_keyframe = true;
+    m_n_units_dropped.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  };
+  if (m_out_of_space || m_write_error) return drop();
+  if (m_producer_waiting_for_keyframe && !is_keyframe) return drop();
+  const size_t depth = m_queue.size();
+  if (depth + 1 > m_queue_high_water.load(std::memory_order_relaxed)) {
+    m_queue_high_water.store(depth + 1, std::memory_order_relaxed);
+  }
+  // The disk can't keep up - better lose a couple of frames in the recording
+  // than stalling the live stream
+  const bool pressure =
+      depth * 100 >=
+      m_queue.capacity() * m_config.drop_non_keyframes_queue_fill_perc;
+  if (pressure) {
+    // Whole groups are only dropped at their start, otherwise keep the
+    // keyframes
+    if (m_config.drop_whole_groups == is_keyframe) return drop();
+  }
+  if (is_keyframe) m_producer_group++;
+  if (!m_queue.try_push(
+          Unit{std::move(unit), is_keyframe, m_producer_group})) {
+    if (m_config.drop_whole_groups && !is_keyframe) {
+      m_aborted_group.store(m_producer_group, std::memory_order_release);
+    }
+    return drop();
+  }
+  m_producer_waiting_for_keyframe = false;
+  m_wake_cv.notify_one();
+  return true;
+}
+
+void DvrWriter::stop() {
+  if (!m_thread) return;
+  m_stop_requested = true;
+  m_wake_cv.notify_one();
+  m_thread->join();
+  m_thread = nullptr;
+}
+
+DvrWriter::Stats DvrWriter::get_stats() const {
+  Stats ret{};
+  ret.n_units_written = m_n_units_written;
+  ret.n_units_dropped = m_n_units_dropped;
+  ret.n_groups_rolled_back = m_n_groups_rolled_back;
+  ret.n_bytes_written = m_n_bytes_written;
+  ret.write_throughput_kbytes = m_write_throughput_kbytes;
+  ret.queue_depth = static_cast<uint32_t>(m_queue.size());
+  ret.queue_high_water = m_queue_high_water;
+  ret.max_write_duration_ms = m_max_write_duration_ms;
+  ret.n_segments = m_n_segments;
+  ret.out_of_space = m_out_of_space;
+  ret.write_error = m_write_error;
+  return ret;
+}
+
+void DvrWriter::loop() {
+  m_throughput_begin = std::chrono::steady_clock::now();
+  m_last_stats_log = m_throughput_begin;
+  Unit unit{};
+  while (true) {
+    // Read the flag before draining, such that nothing enqueued before stop()
+    // is lost
+    const bool stop_requested = m_stop_requested;
+    bool any_unit = false;
+    while (m_queue.try_pop(unit)) {
+      write_unit(unit);
+      unit = Unit{};
+      any_unit = true;
+    }
+    if (stop_requested) break;
+    // O_DIRECT can only write full blocks, the rest is written on close
+    if (m_buffer_fill > 0 && !m_fd_is_o_direct &&
+        std::chrono::steady_clock::now() - m_buffer_oldest_data >
+            m_config.max_buffer_delay) {
+      write_buffer();
+    }
+    update_throughput();
+    if (!any_unit) {
+      std::unique_lock<std::mutex> lock(m_wake_mutex);
+      m_wake_cv.wait_for(lock, std::chrono::milliseconds(20));
+    }
+  }
+  close_segment();
+  m_console->debug("{}", get_stats().to_string());
+}
+
+void DvrWriter::write_unit(const Unit& unit) {
+  if (m_out_of_space || m_write_error) {
+    close_segment();
+    m_n_units_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (m_config.drop_whole_groups) {
+    rollback_aborted_group();
+    if (unit.group == m_aborted_group.load(std::memory_order_acquire)) {
+      m_n_units_dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  // Segments are only rolled at keyframes, such that each of them can be
+  // played on its own
+  if (m_fd >= 0 && unit.is_keyframe && is_segment_limit_reached()) {
+    close_segment();
+  }
+  if (m_fd < 0 && !open_segment()) {
+    m_n_units_dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (unit.is_keyframe) {
+    m_writer_group = unit.group;
+    m_group_begin_offset = m_file_offset + m_buffer_fill;
+    m_group_n_units = 0;
+  }
+  struct iovec spans[VideoFragment::MAX_N_SPANS];
+  const int n_spans = unit.data.get_spans(spans);
+  for (int i = 0; i < n_spans; i++) {
+    append(static_cast<const uint8_t*>(spans[i].iov_base), spans[i].iov_len);
+  }
+  m_n_units_written.fetch_add(1, std::memory_order_relaxed);
+  m_group_n_units++;
+}
+
+void DvrWriter::rollback_aborted_group() {
+  if (m_writer_group == 0 ||
+      m_aborted_group.load(std::memory_order_acquire) != m_writer_group) {
+    return;
+  }
+  m_writer_group = 0;
+  m_n_units_written.fetch_sub(m_group_n_units, std::memory_order_relaxed);
+  m_n_units_dropped.fetch_add(m_group_n_units, std::memory_order_relaxed);
+  m_n_groups_rolled_back.fetch_add(1, std::memory_order_relaxed);
+  const uint64_t offset = m_group_begin_offset;
+  if (offset >= m_file_offset) {
+    // Still in the buffer
+    m_buffer_fill = offset - m_file_offset;
+    return;
+  }
+  // Parts of the group are on disk already. O_DIRECT can only write whole
+  // blocks - the start of the block the group begins in is read back.
+  const uint64_t aligned =
+      m_fd_is_o_direct ? offset / BLOCK_SIZE * BLOCK_SIZE : offset;
+  const size_t keep = offset - aligned;
+  if (keep > 0 &&
+      pread(m_fd, m_buffer.get(), BLOCK_SIZE, (off_t)aligned) !=
+          (ssize_t)BLOCK_SIZE) {
+    m_console->error("Cannot read back {} ({})", m_segment_filename,
+                     strerror(errno));
+    m_write_error = true;
+    return;
+  }
+  if (ftruncate(m_fd, (off_t)aligned) != 0 ||
+      lseek(m_fd, (off_t)aligned, SEEK_SET) < 0) {
+    m_console->error("Cannot cut {} ({})", m_segment_filename,
+                     strerror(errno));
+    m_write_error = true;
+    return;
+  }
+  m_file_offset = aligned;
+  m_preallocated_until = aligned;
+  m_buffer_fill = keep;
+  m_buffer_oldest_data = std::chrono::steady_clock::now();
+}
+
+void DvrWriter::append(const uint8_t* data, size_t size) {
+  if (m_buffer_fill == 0 && size > 0) {
+    m_buffer_oldest_data = std::chrono::steady_clock::now();
+  }
+  while (size > 0) {
+    const size_t n = std::min(size, m_config.write_buffer_size - m_buffer_fill);
+    std::memcpy(m_buffer.get() + m_buffer_fill, data, n);
+    m_buffer_fill += n;
+    data += n;
+    size -= n;
+    if (m_buffer_fill == m_config.write_buffer_size) {
+      write_buffer();
+      if (size > 0) m_buffer_oldest_data = std::chrono::steady_clock::now();
+    }
+  }
+}
+
+bool DvrWriter::is_segment_limit_reached() const {
+  if (m_config.max_segment_size_bytes > 0 &&
+      m_file_offset + m_buffer_fill >= m_config.max_segment_size_bytes) {
+    return true;
+  }
+  return m_config.max_segment_duration.count() > 0 &&
+         std::chrono::steady_clock::now() - m_segment_begin >=
+             m_config.max_segment_duration;
+}
+
+bool DvrWriter::open_segment() {
+  m_segment_filename = m_config.create_filename();
+  // A group that is rolled back might need to be read back (O_DIRECT)
+  const int flags = (m_config.drop_whole_groups ? O_RDWR : O_WRONLY) |
+                    O_CREAT | O_TRUNC | O_CLOEXEC;
+  m_fd = -1;
+  m_fd_is_o_direct = false;
+  if (m_config.use_o_direct) {
+    m_fd = open(m_segment_filename.c_str(), flags | O_DIRECT, 0666);
+    if (m_fd >= 0) {
+      m_fd_is_o_direct = true;
+    } else {
+      m_console->warn("O_DIRECT not supported for {} ({})", m_segment_filename,
+                      strerror(errno));
+    }
+  }
+  if (m_fd < 0) {
+    m_fd = open(m_segment_filename.c_str(), flags, 0666);
+  }
+  if (m_fd < 0) {
+    m_console->error("Cannot open {} ({})", m_segment_filename,
+                     strerror(errno));
+    m_write_error = true;
+    return false;
+  }
+  if (!has_enough_free_space()) {
+    m_console->warn("Not enough free space for recording");
+    m_out_of_space = true;
+    close(m_fd);
+    m_fd = -1;
+    OHDFilesystemUtil::remove_if_existing(m_segment_filename);
+    return false;
+  }
+  m_file_offset = 0;
+  m_preallocated_until = 0;
+  m_buffer_fill = 0;
+  m_writer_group = 0;
+  m_segment_begin = std::chrono::steady_clock::now();
+  m_n_segments.fetch_add(1, std::memory_order_relaxed);
+  m_console->info("Recording to {}", m_segment_filename);
+  std::lock_guard<std::mutex> guard(m_header_mutex);
+  append(m_stream_header.data(), m_stream_header.size());
+  return true;
+}
+
+void DvrWriter::close_segment() {
+  if (m_fd < 0) return;
+  if (m_config.drop_whole_groups) rollback_aborted_group();
+  if (m_buffer_fill > 0) {
+    if (m_fd_is_o_direct) {
+      // The tail is most likely not a multiple of the block size
+      const int flags = fcntl(m_fd, F_GETFL);
+      fcntl(m_fd, F_SETFL, flags & ~O_DIRECT);
+      m_fd_is_o_direct = false;
+    }
+    write_buffer();
+  }
+  // Give back what was preallocated but not used
+  if (m_preallocated_until > m_file_offset) {
+    if (ftruncate(m_fd, (off_t)m_file_offset) != 0) {
+      m_console->debug("ftruncate failed ({})", strerror(errno));
+    }
+  }
+  fdatasync(m_fd);
+  close(m_fd);
+  m_fd = -1;
+  OHDFilesystemUtil::make_file_read_write_everyone(m_segment_filename);
+  const auto duration_s = std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::steady_clock::now() -
+                              m_segment_begin)
+                              .count();
+  m_console->info("Closed {} ({}MB, {}s)", m_segment_filename,
+                  m_file_offset / 1024 / 1024, duration_s);
+  if (m_config.on_segment_closed) {
+    m_config.on_segment_closed(m_segment_filename);
+  }
+}
+
+void DvrWriter::write_buffer() {
+  if (m_buffer_fill == 0 || m_fd < 0) return;
+  preallocate(m_file_offset + m_buffer_fill);
+  if (write_fully(m_buffer.get(), m_buffer_fill)) {
+    if (!m_fd_is_o_direct) {
+      // Kick off writeback right away instead of letting dirty pages pile up
+      // and getting stalled by one large writeback later on
+      sync_file_range(m_fd, (off64_t)m_file_offset, (off64_t)m_buffer_fill,
+                      SYNC_FILE_RANGE_WRITE);
+    }
+    m_file_offset += m_buffer_fill;
+    m_n_bytes_written.fetch_add(m_buffer_fill, std::memory_order_relaxed);
+    m_throughput_bytes += m_buffer_fill;
+  }
+  m_buffer_fill = 0;
+}
+
+bool DvrWriter::write_fully(const uint8_t* data, size_t size) {
+  const auto begin = std::chrono::steady_clock::now();
+  while (size > 0) {
+    const ssize_t ret = m_config.write_fn ? m_config.write_fn(m_fd, data, size)
+                                          : ::write(m_fd, data, size);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      m_console->error("Cannot write {} ({})", m_segment_filename,
+                       strerror(errno));
+      if (errno == ENOSPC) {
+        m_out_of_space = true;
+      } else {
+        m_write_error = true;
+      }
+      return false;
+    }
+    data += ret;
+    size -= ret;
+  }
+  const auto duration_ms = static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - begin)
+          .count());
+  if (duration_ms > m_max_write_duration_ms) {
+    m_max_write_duration_ms = duration_ms;
+  }
+  return true;
+}
+
+void DvrWriter::preallocate(uint64_t end_offset) {
+  if (m_config.preallocate_size == 0 || end_offset <= m_preallocated_until) {
+    return;
+  }
+  // Checking the free space once per preallocation step is enough
+  if (!has_enough_free_space()) {
+    m_console->warn("Running out of space, stopping recording");
+    m_out_of_space = true;
+  }
+  const uint64_t begin = m_preallocated_until;
+  const uint64_t len =
+      std::max<uint64_t>(m_config.preallocate_size, end_offset - begin);
+  if (m_fallocate_supported &&
+      fallocate(m_fd, FALLOC_FL_KEEP_SIZE, (off_t)begin, (off_t)len) != 0) {
+    m_console->debug("fallocate not supported ({})", strerror(errno));
+    m_fallocate_supported = false;
+  }
+  m_preallocated_until = begin + len;
+}
+
+bool DvrWriter::has_enough_free_space() {
+  if (m_config.min_free_space_mb <= 0) return true;
+  struct statvfs info {};
+  if (fstatvfs(m_fd, &info) != 0) return true;
+  const int64_t free_mb =
+      (int64_t)info.f_bavail * (int64_t)info.f_frsize / 1024 / 1024;
+  return free_mb >= m_config.min_free_space_mb;
+}
+
+void DvrWriter::update_throughput() {
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed = now - m_throughput_begin;
+  if (elapsed >= std::chrono::seconds(1)) {
+    const auto elapsed_ms =
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+    m_write_throughput_kbytes =
+        static_cast<uint32_t>(m_throughput_bytes * 1000 / 1024 / elapsed_ms);
+    m_throughput_bytes = 0;
+    m_throughput_begin = now;
+  }
+  if (now - m_last_stats_log >= std::chrono::seconds(10)) {
+    m_console->debug("{}", get_stats().to_string());
+    m_last_stats_log = now;
+  }
+}
+
+}  // namespace openhd::video
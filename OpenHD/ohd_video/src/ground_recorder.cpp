@@ -0,0 +1,948 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "ground_recorder.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include "dvr_writer.h"
+#include "openhd_spdlog_include.h"
+#include "openhd_util_async.h"
+
+namespace openhd::video {
+
+namespace {
+
+constexpr size_t RTP_HEADER_SIZE = 12;
+constexpr int64_t RTP_CLOCK_RATE = 90000;
+// A larger jump of the rtp timestamp (or one backwards) is a restart of the
+// stream on the air unit
+constexpr int64_t MAX_TIMESTAMP_JUMP = 10 * RTP_CLOCK_RATE;
+// Something is wrong with the stream if a frame gets larger
+constexpr size_t MAX_FRAME_SIZE = 8 * 1024 * 1024;
+// Room in front of each frame for the cluster / block headers
+constexpr size_t FRAME_HEADER_ROOM = 48;
+// The relative timecode of a block is an int16
+constexpr int64_t MAX_CLUSTER_DURATION_MS = 30000;
+// Don't hammer a failing (or full) disk
+constexpr auto OPEN_RETRY_INTERVAL = std::chrono::seconds(10);
+
+// Matroska element ids (including the length marker)
+constexpr uint32_t ID_EBML = 0x1A45DFA3;
+constexpr uint32_t ID_EBML_VERSION = 0x4286;
+constexpr uint32_t ID_EBML_READ_VERSION = 0x42F7;
+constexpr uint32_t ID_EBML_MAX_ID_LENGTH = 0x42F2;
+constexpr uint32_t ID_EBML_MAX_SIZE_LENGTH = 0x42F3;
+constexpr uint32_t ID_DOC_TYPE = 0x4282;
+constexpr uint32_t ID_DOC_TYPE_VERSION = 0x4287;
+constexpr uint32_t ID_DOC_TYPE_READ_VERSION = 0x4285;
+constexpr uint32_t ID_SEGMENT = 0x18538067;
+constexpr uint32_t ID_INFO = 0x1549A966;
+constexpr uint32_t ID_TIMECODE_SCALE = 0x2AD7B1;
+constexpr uint32_t ID_MUXING_APP = 0x4D80;
+constexpr uint32_t ID_WRITING_APP = 0x5741;
+constexpr uint32_t ID_TRACKS = 0x1654AE6B;
+constexpr uint32_t ID_TRACK_ENTRY = 0xAE;
+constexpr uint32_t ID_TRACK_NUMBER = 0xD7;
+constexpr uint32_t ID_TRACK_UID = 0x73C5;
+constexpr uint32_t ID_TRACK_TYPE = 0x83;
+constexpr uint32_t ID_CODEC_ID = 0x86;
+constexpr uint32_t ID_CODEC_PRIVATE = 0x63A2;
+constexpr uint32_t ID_VIDEO = 0xE0;
+constexpr uint32_t ID_PIXEL_WIDTH = 0xB0;
+constexpr uint32_t ID_PIXEL_HEIGHT = 0xBA;
+constexpr uint32_t ID_CLUSTER = 0x1F43B675;
+constexpr uint32_t ID_CLUSTER_TIMECODE = 0xE7;
+constexpr uint32_t ID_SIMPLE_BLOCK = 0xA3;
+
+void put_id(std::vector<uint8_t>& out, uint32_t id) {
+  int n = 4;
+  while (n > 1 && ((id >> ((n - 1) * 8)) & 0xFF) == 0) n--;
+  for (int i = n - 1; i >= 0; i--) out.push_back((id >> (i * 8)) & 0xFF);
+}
+
+// Always 8 bytes, which is what the block headers need (fixed size)
+void put_size(std::vector<uint8_t>& out, uint64_t size) {
+  out.push_back(0x01);
+  for (int i = 6; i >= 0; i--) out.push_back((size >> (i * 8)) & 0xFF);
+}
+
+// Segment / cluster that are written before their size is known (streamable)
+void put_unknown_size(std::vector<uint8_t>& out) {
+  out.insert(out.end(), {0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF});
+}
+
+void put_element(std::vector<uint8_t>& out, uint32_t id, const uint8_t* data,
+                 size_t size) {
+  put_id(out, id);
+  put_size(out, size);
+  out.insert(out.end(), data, data + size);
+}
+
+void put_element(std::vector<uint8_t>& out, uint32_t id,
+                 const std::vector<uint8_t>& data) {
+  put_element(out, id, data.data(), data.size());
+}
+
+void put_string(std::vector<uint8_t>& out, uint32_t id,
+                const std::string& value) {
+  put_element(out, id, (const uint8_t*)value.data(), value.size());
+}
+
+void put_uint(std::vector<uint8_t>& out, uint32_t id, uint64_t value) {
+  int n = 8;
+  while (n > 1 && ((value >> ((n - 1) * 8)) & 0xFF) == 0) n--;
+  put_id(out, id);
+  out.push_back(0x80 | n);
+  for (int i = n - 1; i >= 0; i--) out.push_back((value >> (i * 8)) & 0xFF);
+}
+
+void put_u16(std::vector<uint8_t>& out, uint16_t value) {
+  out.push_back(value >> 8);
+  out.push_back(value & 0xFF);
+}
+
+struct RtpPacket {
+  bool marker;
+  uint16_t seq;
+  uint32_t timestamp;
+  uint32_t ssrc;
+  const uint8_t* payload;
+  size_t payload_len;
+};
+
+bool parse_rtp(const uint8_t* data, size_t len, RtpPacket& out) {
+  if (len < RTP_HEADER_SIZE || (data[0] >> 6) != 2) return false;
+  size_t header_len = RTP_HEADER_SIZE + (data[0] & 0x0F) * 4;
+  if ((data[0] & 0x10) != 0) {
+    // Header extension
+    if (len < header_len + 4) return false;
+    header_len += 4 + ((data[header_len + 2] << 8) | data[header_len + 3]) * 4;
+  }
+  size_t padding = 0;
+  if ((data[0] & 0x20) != 0) padding = data[len - 1];
+  if (len < header_len + padding + 1) return false;
+  out.marker = (data[1] & 0x80) != 0;
+  out.seq = (data[2] << 8) | data[3];
+  out.timestamp = ((uint32_t)data[4] << 24) | (data[5] << 16) |
+                  (data[6] << 8) | data[7];
+  out.ssrc = ((uint32_t)data[8] << 24) | (data[9] << 16) | (data[10] << 8) |
+             data[11];
+  out.payload = data + header_len;
+  out.payload_len = len - header_len - padding;
+  return true;
+}
+
+// The ground doesn't know the codec. It is detected from the parameter sets
+// (which are needed to start a recording anyways), which can be told apart
+// unambiguously: H265 NAL unit headers (nuh_layer_id 0) always start with an
+// even byte and have a non-zero second byte (temporal id + 1), the H264 SPS
+// (header byte 0x27 / 0x47 / 0x67) is odd, a H264 STAP-A starts with the
+// (16 bit) size of the first NAL unit.
+bool is_h265_payload(const uint8_t* p, size_t len) {
+  if (len < 3 || (p[0] & 0x81) != 0 || p[1] != 0x01) return false;
+  const int type = (p[0] >> 1) & 0x3F;
+  // VPS, SPS or an aggregation packet starting with the VPS
+  return type == 32 || type == 33 ||
+         (type == 48 && len >= 5 && ((p[4] >> 1) & 0x3F) == 32);
+}
+
+bool is_h264_payload(const uint8_t* p, size_t len) {
+  if (len < 4 || (p[0] & 0x80) != 0) return false;
+  const int type = p[0] & 0x1F;
+  // SPS or a STAP-A starting with the SPS
+  return type == 7 || (type == 24 && p[1] == 0 && (p[3] & 0x1F) == 7);
+}
+
+// Removes the emulation prevention bytes
+std::vector<uint8_t> nal_to_rbsp(const uint8_t* data, size_t len) {
+  std::vector<uint8_t> ret;
+  ret.reserve(len);
+  int zeros = 0;
+  for (size_t i = 0; i < len; i++) {
+    if (zeros >= 2 && data[i] == 0x03) {
+      zeros = 0;
+      continue;
+    }
+    zeros = data[i] == 0 ? zeros + 1 : 0;
+    ret.push_back(data[i]);
+  }
+  return ret;
+}
+
+// Reads (exp-golomb coded) values from a RBSP
+class BitReader {
+ public:
+  explicit BitReader(std::vector<uint8_t> data) : m_data(std::move(data)) {}
+  uint32_t u(int n) {
+    uint32_t ret = 0;
+    for (int i = 0; i < n; i++) ret = (ret << 1) | bit();
+    return ret;
+  }
+  uint32_t ue() {
+    int n_zeros = 0;
+    while (bit() == 0) {
+      if (++n_zeros >= 32) {
+        m_error = true;
+        return 0;
+      }
+    }
+    return ((1u << n_zeros) - 1) + u(n_zeros);
+  }
+  int32_t se() {
+    const uint32_t value = ue();
+    return (value & 1) ? (int32_t)((value + 1) / 2) : -(int32_t)(value / 2);
+  }
+  void skip(int n) { u(n); }
+  bool error() const { return m_error; }
+
+ private:
+  uint32_t bit() {
+    if (m_pos >= m_data.size() * 8) {
+      m_error = true;
+      return 0;
+    }
+    const uint32_t ret = (m_data[m_pos / 8] >> (7 - m_pos % 8)) & 1;
+    m_pos++;
+    return ret;
+  }
+  std::vector<uint8_t> m_data;
+  size_t m_pos = 0;
+  bool m_error = false;
+};
+
+// What we need from the SPS for the container
+struct SpsInfo {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t chroma_format_idc = 1;
+  uint32_t bit_depth_luma_minus8 = 0;
+  uint32_t bit_depth_chroma_minus8 = 0;
+  // H265 only
+  std::array<uint8_t, 12> general_profile_tier_level{};
+  uint32_t max_sub_layers_minus1 = 0;
+  uint32_t temporal_id_nesting = 0;
+};
+
+bool is_h264_high_profile(uint32_t profile_idc) {
+  switch (profile_idc) {
+    case 100:
+    case 110:
+    case 122:
+    case 244:
+    case 44:
+    case 83:
+    case 86:
+    case 118:
+    case 128:
+    case 138:
+    case 139:
+    case 134:
+    case 135:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool parse_h264_sps(const std::vector<uint8_t>& nal, SpsInfo& info) {
+  BitReader r(nal_to_rbsp(nal.data(), nal.size()));
+  r.skip(8);  // NAL unit header
+  const uint32_t profile_idc = r.u(8);
+  r.skip(16);  // constraint flags, level_idc
+  r.ue();      // seq_parameter_set_id
+  if (is_h264_high_profile(profile_idc)) {
+    info.chroma_format_idc = r.ue();
+    if (info.chroma_format_idc == 3) r.skip(1);
+    info.bit_depth_luma_minus8 = r.ue();
+    info.bit_depth_chroma_minus8 = r.ue();
+    r.skip(1);  // qpprime_y_zero_transform_bypass_flag
+    if (r.u(1)) {
+      // seq_scaling_matrix_present_flag
+      const int n_lists = info.chroma_format_idc != 3 ? 8 : 12;
+      for (int i = 0; i < n_lists; i++) {
+        if (!r.u(1)) continue;
+        const int size = i < 6 ? 16 : 64;
+        int last_scale = 8, next_scale = 8;
+        for (int j = 0; j < size && next_scale != 0; j++) {
+          next_scale = (last_scale + r.se() + 256) % 256;
+          if (next_scale != 0) last_scale = next_scale;
+        }
+      }
+    }
+  }
+  r.ue();  // log2_max_frame_num_minus4
+  const uint32_t pic_order_cnt_type = r.ue();
+  if (pic_order_cnt_type == 0) {
+    r.ue();
+  } else if (pic_order_cnt_type == 1) {
+    r.skip(1);
+    r.se();
+    r.se();
+    const uint32_t n = r.ue();
+    for (uint32_t i = 0; i < n && !r.error(); i++) r.se();
+  }
+  r.ue();     // max_num_ref_frames
+  r.skip(1);  // gaps_in_frame_num_value_allowed_flag
+  const uint32_t width_in_mbs = r.ue() + 1;
+  const uint32_t height_in_map_units = r.ue() + 1;
+  const uint32_t frame_mbs_only_flag = r.u(1);
+  if (!frame_mbs_only_flag) r.skip(1);
+  r.skip(1);  // direct_8x8_inference_flag
+  uint32_t crop_left = 0, crop_right = 0, crop_top = 0, crop_bottom = 0;
+  if (r.u(1)) {
+    crop_left = r.ue();
+    crop_right = r.ue();
+    crop_top = r.ue();
+    crop_bottom = r.ue();
+  }
+  if (r.error()) return false;
+  const bool is_subsampled_x =
+      info.chroma_format_idc == 1 || info.chroma_format_idc == 2;
+  const uint32_t crop_unit_x = is_subsampled_x ? 2 : 1;
+  uint32_t crop_unit_y = info.chroma_format_idc == 1 ? 2 : 1;
+  crop_unit_y *= 2 - frame_mbs_only_flag;
+  info.width = width_in_mbs * 16 - crop_unit_x * (crop_left + crop_right);
+  info.height = (2 - frame_mbs_only_flag) * height_in_map_units * 16 -
+                crop_unit_y * (crop_top + crop_bottom);
+  return true;
+}
+
+bool parse_h265_sps(const std::vector<uint8_t>& nal, SpsInfo& info) {
+  BitReader r(nal_to_rbsp(nal.data(), nal.size()));
+  r.skip(16);  // NAL unit header
+  r.skip(4);   // sps_video_parameter_set_id
+  info.max_sub_layers_minus1 = r.u(3);
+  info.temporal_id_nesting = r.u(1);
+  for (auto& b : info.general_profile_tier_level) b = r.u(8);
+  std::array<bool, 8> sub_layer_profile_present{};
+  std::array<bool, 8> sub_layer_level_present{};
+  for (uint32_t i = 0; i < info.max_sub_layers_minus1; i++) {
+    sub_layer_profile_present[i] = r.u(1);
+    sub_layer_level_present[i] = r.u(1);
+  }
+  if (info.max_sub_layers_minus1 > 0) {
+    for (uint32_t i = info.max_sub_layers_minus1; i < 8; i++) r.skip(2);
+  }
+  for (uint32_t i = 0; i < info.max_sub_layers_minus1; i++) {
+    if (sub_layer_profile_present[i]) r.skip(88);
+    if (sub_layer_level_present[i]) r.skip(8);
+  }
+  r.ue();  // sps_seq_parameter_set_id
+  info.chroma_format_idc = r.ue();
+  if (info.chroma_format_idc == 3) r.skip(1);
+  info.width = r.ue();
+  info.height = r.ue();
+  if (r.u(1)) {
+    // conformance_window_flag
+    const uint32_t sub_width =
+        info.chroma_format_idc == 1 || info.chroma_format_idc == 2 ? 2 : 1;
+    const uint32_t sub_height = info.chroma_format_idc == 1 ? 2 : 1;
+    const uint32_t left = r.ue(), right = r.ue();
+    const uint32_t top = r.ue(), bottom = r.ue();
+    info.width -= sub_width * (left + right);
+    info.height -= sub_height * (top + bottom);
+  }
+  info.bit_depth_luma_minus8 = r.ue();
+  info.bit_depth_chroma_minus8 = r.ue();
+  return !r.error();
+}
+
+// AVCDecoderConfigurationRecord (ISO/IEC 14496-15), NALU length size 4
+std::vector<uint8_t> build_avcc(const std::vector<uint8_t>& sps,
+                                const std::vector<uint8_t>& pps,
+                                const SpsInfo& info) {
+  std::vector<uint8_t> out{1, sps[1], sps[2], sps[3], 0xFF, 0xE1};
+  put_u16(out, sps.size());
+  out.insert(out.end(), sps.begin(), sps.end());
+  out.push_back(1);
+  put_u16(out, pps.size());
+  out.insert(out.end(), pps.begin(), pps.end());
+  if (is_h264_high_profile(sps[1])) {
+    out.push_back(0xFC | info.chroma_format_idc);
+    out.push_back(0xF8 | info.bit_depth_luma_minus8);
+    out.push_back(0xF8 | info.bit_depth_chroma_minus8);
+    out.push_back(0);
+  }
+  return out;
+}
+
+// HEVCDecoderConfigurationRecord (ISO/IEC 14496-15), NALU length size 4
+std::vector<uint8_t> build_hvcc(const std::vector<uint8_t>& vps,
+                                const std::vector<uint8_t>& sps,
+                                const std::vector<uint8_t>& pps,
+                                const SpsInfo& info) {
+  std::vector<uint8_t> out{1};
+  out.insert(out.end(), info.general_profile_tier_level.begin(),
+             info.general_profile_tier_level.end());
+  // min_spatial_segmentation_idc, parallelismType: unknown
+  out.insert(out.end(), {0xF0, 0x00, 0xFC});
+  out.push_back(0xFC | info.chroma_format_idc);
+  out.push_back(0xF8 | info.bit_depth_luma_minus8);
+  out.push_back(0xF8 | info.bit_depth_chroma_minus8);
+  put_u16(out, 0);  // avgFrameRate
+  out.push_back(((info.max_sub_layers_minus1 + 1) << 3) |
+                (info.temporal_id_nesting << 2) | 3);
+  out.push_back(3);
+  const std::array<std::pair<uint8_t, const std::vector<uint8_t>*>, 3>
+      arrays{{{32, &vps}, {33, &sps}, {34, &pps}}};
+  for (const auto& [type, nal] : arrays) {
+    out.push_back(0x80 | type);
+    put_u16(out, 1);
+    put_u16(out, nal->size());
+    out.insert(out.end(), nal->begin(), nal->end());
+  }
+  return out;
+}
+
+}  // namespace
+
+class GroundRecorder::StreamRecorder {
+ public:
+  StreamRecorder(const GroundRecorder::Config& config, int stream_index,
+                 std::shared_ptr<spdlog::logger> console)
+      : m_config(config),
+        m_stream_index(stream_index),
+        m_console(std::move(console)) {
+    reset_frame();
+  }
+  ~StreamRecorder() { close_file(true); }
+  void on_packet(const uint8_t* data, size_t len);
+  // Closes the file if the stream stopped
+  void check_idle(std::chrono::steady_clock::time_point now);
+  void close_file(bool blocking);
+  // Published
+  std::atomic<uint64_t> m_n_frames_written = 0;
+  std::atomic<uint64_t> m_n_keyframes_written = 0;
+  std::atomic<uint64_t> m_n_frames_dropped = 0;
+  std::atomic<uint64_t> m_n_discontinuities = 0;
+  std::atomic<uint32_t> m_n_files = 0;
+
+ private:
+  enum class Codec { UNKNOWN, H264, H265 };
+  // Forget everything about the stream (e.g. on restart)
+  void reset_stream();
+  void reset_frame();
+  void on_discontinuity();
+  void depacketize(const uint8_t* payload, size_t len);
+  void add_nal(const uint8_t* data, size_t len);
+  void begin_fu_nal(const uint8_t* header, size_t header_len);
+  void append_fu_data(const uint8_t* data, size_t len);
+  void end_nal();
+  void finish_frame();
+  bool open_file();
+  void write_frame(bool is_keyframe);
+
+ private:
+  const GroundRecorder::Config& m_config;
+  const int m_stream_index;
+  std::shared_ptr<spdlog::logger> m_console;
+  Codec m_codec = Codec::UNKNOWN;
+  bool m_has_seq = false;
+  uint16_t m_last_seq = 0;
+  uint32_t m_ssrc = 0;
+  std::chrono::steady_clock::time_point m_last_packet{};
+  // rtp timestamp, extended to 64 bit
+  bool m_has_timestamp = false;
+  uint32_t m_last_timestamp = 0;
+  int64_t m_ext_timestamp = 0;
+  bool m_waiting_for_keyframe = true;
+  bool m_skip_frame = false;
+  // Frame in progress: length-prefixed NAL units, after FRAME_HEADER_ROOM
+  std::shared_ptr<std::vector<uint8_t>> m_frame;
+  size_t m_last_frame_size = 0;
+  int64_t m_frame_timestamp = 0;
+  bool m_frame_has_data = false;
+  bool m_frame_is_keyframe = false;
+  bool m_frame_has_parameter_sets = false;
+  bool m_frame_corrupt = false;
+  // Offset of the FU NAL unit that is being assembled, 0 if none
+  size_t m_fu_nal_offset = 0;
+  // Latest parameter sets (without start code)
+  std::vector<uint8_t> m_vps, m_sps, m_pps;
+  bool m_parameter_sets_changed = false;
+  // Current file
+  std::shared_ptr<DvrWriter> m_writer;
+  std::string m_filename;
+  std::vector<uint8_t> m_codec_private;
+  int64_t m_file_begin_timestamp = 0;
+  int64_t m_cluster_timecode_ms = -1;
+  int64_t m_last_pts_ms = 0;
+  std::chrono::steady_clock::time_point m_last_open_failure{};
+};
+
+void GroundRecorder::StreamRecorder::on_packet(const uint8_t* data,
+                                               size_t len) {
+  RtpPacket packet{};
+  if (!parse_rtp(data, len, packet)) return;
+  m_last_packet = std::chrono::steady_clock::now();
+  if (m_has_seq && packet.ssrc != m_ssrc) {
+    m_console->debug("Stream {} restarted (ssrc)", m_stream_index);
+    close_file(false);
+    reset_stream();
+  }
+  if (m_codec == Codec::UNKNOWN) {
+    if (is_h265_payload(packet.payload, packet.payload_len)) {
+      m_codec = Codec::H265;
+    } else if (is_h264_payload(packet.payload, packet.payload_len)) {
+      m_codec = Codec::H264;
+    } else {
+      return;
+    }
+    m_console->debug("Stream {} is {}", m_stream_index,
+                     m_codec == Codec::H265 ? "H265" : "H264");
+  }
+  if (m_has_seq) {
+    const auto diff = (int16_t)(packet.seq - m_last_seq);
+    // Duplicate or re-ordered (too late anyways)
+    if (diff <= 0) return;
+    if (diff > 1) {
+      on_discontinuity();
+      // The rest of the damaged frame is of no use either
+      m_skip_frame = m_has_timestamp && packet.timestamp == m_last_timestamp;
+    }
+  }
+  m_has_seq = true;
+  m_last_seq = packet.seq;
+  m_ssrc = packet.ssrc;
+  if (!m_has_timestamp || packet.timestamp != m_last_timestamp) {
+    const int64_t delta =
+        m_has_timestamp ? (int32_t)(packet.timestamp - m_last_timestamp) : 0;
+    if (delta < 0 || delta > MAX_TIMESTAMP_JUMP) {
+      m_console->debug("Stream {} restarted (timestamp)", m_stream_index);
+      close_file(false);
+      reset_stream();
+      // This packet is the first of the new stream
+      return on_packet(data, len);
+    }
+    // New frame, the previous one lost its marker bit (but nothing else, the
+    // sequence numbers are continuous)
+    if (m_frame_has_data) finish_frame();
+    m_has_timestamp = true;
+    m_last_timestamp = packet.timestamp;
+    m_ext_timestamp += delta;
+    m_skip_frame = false;
+  }
+  if (m_skip_frame) return;
+  m_frame_timestamp = m_ext_timestamp;
+  m_frame_has_data = true;
+  depacketize(packet.payload, packet.payload_len);
+  if (packet.marker) finish_frame();
+}
+
+void GroundRecorder::StreamRecorder::check_idle(
+    std::chrono::steady_clock::time_point now) {
+  if (m_has_seq && now - m_last_packet > m_config.idle_timeout) {
+    m_console->debug("Stream {} stopped", m_stream_index);
+    close_file(false);
+    reset_stream();
+  }
+}
+
+void GroundRecorder::StreamRecorder::reset_stream() {
+  m_codec = Codec::UNKNOWN;
+  m_has_seq = false;
+  m_has_timestamp = false;
+  m_ext_timestamp = 0;
+  m_waiting_for_keyframe = true;
+  m_skip_frame = false;
+  m_vps.clear();
+  m_sps.clear();
+  m_pps.clear();
+  m_parameter_sets_changed = false;
+  reset_frame();
+}
+
+void GroundRecorder::StreamRecorder::reset_frame() {
+  // The frame is handed over to the writer without copying it, so a new
+  // buffer is needed for each frame
+  if (!m_frame || m_frame.use_count() > 1) {
+    m_frame = std::make_shared<std::vector<uint8_t>>();
+    m_frame->reserve(
+        std::max<size_t>(64 * 1024, m_last_frame_size + m_last_frame_size / 2));
+  }
+  m_frame->resize(FRAME_HEADER_ROOM);
+  m_frame_has_data = false;
+  m_frame_is_keyframe = false;
+  m_frame_has_parameter_sets = false;
+  m_frame_corrupt = false;
+  m_fu_nal_offset = 0;
+}
+
+void GroundRecorder::StreamRecorder::on_discontinuity() {
+  // Lost on the link (more than FEC could recover) - the current frame is
+  // incomplete and the ones after it reference it
+  m_n_discontinuities++;
+  if (m_frame_has_data) m_n_frames_dropped++;
+  m_waiting_for_keyframe = true;
+  reset_frame();
+}
+
+void GroundRecorder::StreamRecorder::depacketize(const uint8_t* payload,
+                                                 size_t len) {
+  const bool is_h265 = m_codec == Codec::H265;
+  const size_t nal_header_len = is_h265 ? 2 : 1;
+  if (len < nal_header_len) {
+    m_frame_corrupt = true;
+    return;
+  }
+  const int type = is_h265 ? (payload[0] >> 1) & 0x3F : payload[0] & 0x1F;
+  const int type_ap = is_h265 ? 48 : 24;
+  const int type_fu = is_h265 ? 49 : 28;
+  if (type == type_ap) {
+    // STAP-A / AP: (16 bit size, NAL unit)...
+    size_t offset = nal_header_len;
+    while (offset + 2 <= len) {
+      const size_t size = (payload[offset] << 8) | payload[offset + 1];
+      offset += 2;
+      if (size == 0 || offset + size > len) {
+        m_frame_corrupt = true;
+        return;
+      }
+      add_nal(payload + offset, size);
+      offset += size;
+    }
+  } else if (type == type_fu) {
+    // FU-A / FU: FU header (S, E, type) after the payload header
+    if (len < nal_header_len + 2) {
+      m_frame_corrupt = true;
+      return;
+    }
+    const uint8_t fu_header = payload[nal_header_len];
+    const bool is_start = (fu_header & 0x80) != 0;
+    const bool is_end = (fu_header & 0x40) != 0;
+    if (is_start) {
+      std::array<uint8_t, 2> header{};
+      if (is_h265) {
+        header[0] = (payload[0] & 0x81) | ((fu_header & 0x3F) << 1);
+        header[1] = payload[1];
+      } else {
+        header[0] = (payload[0] & 0xE0) | (fu_header & 0x1F);
+      }
+      begin_fu_nal(header.data(), nal_header_len);
+    } else if (m_fu_nal_offset == 0) {
+      // Lost the start (of this or of a previous frame)
+      m_frame_corrupt = true;
+      return;
+    }
+    append_fu_data(payload + nal_header_len + 1, len - nal_header_len - 1);
+    if (is_end) end_nal();
+  } else if ((is_h265 && type < 48) || (!is_h265 && type >= 1 && type < 24)) {
+    add_nal(payload, len);
+  } else {
+    // E.g. STAP-B / MTAP, the air doesn't create them
+    m_frame_corrupt = true;
+  }
+}
+
+void GroundRecorder::StreamRecorder::add_nal(const uint8_t* data,
+                                             size_t len) {
+  begin_fu_nal(data, len);
+  end_nal();
+}
+
+void GroundRecorder::StreamRecorder::begin_fu_nal(const uint8_t* header,
+                                                  size_t header_len) {
+  // Start of a new NAL unit while the previous one is not done
+  if (m_fu_nal_offset != 0) m_frame_corrupt = true;
+  m_fu_nal_offset = m_frame->size();
+  m_frame->resize(m_frame->size() + 4);
+  append_fu_data(header, header_len);
+}
+
+void GroundRecorder::StreamRecorder::append_fu_data(const uint8_t* data,
+                                                    size_t len) {
+  if (m_frame->size() + len > MAX_FRAME_SIZE) {
+    m_frame_corrupt = true;
+    return;
+  }
+  m_frame->insert(m_frame->end(), data, data + len);
+}
+
+void GroundRecorder::StreamRecorder::end_nal() {
+  if (m_fu_nal_offset == 0) return;
+  uint8_t* length = m_frame->data() + m_fu_nal_offset;
+  const uint8_t* nal = length + 4;
+  const size_t nal_len = m_frame->size() - m_fu_nal_offset - 4;
+  m_fu_nal_offset = 0;
+  length[0] = nal_len >> 24;
+  length[1] = nal_len >> 16;
+  length[2] = nal_len >> 8;
+  length[3] = nal_len;
+  if (nal_len == 0) return;
+  std::vector<uint8_t>* parameter_set = nullptr;
+  if (m_codec == Codec::H265) {
+    const int type = (nal[0] >> 1) & 0x3F;
+    // IDR / CRA / BLA
+    if (type >= 16 && type <= 21) m_frame_is_keyframe = true;
+    if (type == 32) parameter_set = &m_vps;
+    if (type == 33) parameter_set = &m_sps;
+    if (type == 34) parameter_set = &m_pps;
+  } else {
+    const int type = nal[0] & 0x1F;
+    if (type == 5) m_frame_is_keyframe = true;
+    if (type == 7) parameter_set = &m_sps;
+    if (type == 8) parameter_set = &m_pps;
+  }
+  if (parameter_set) {
+    m_frame_has_parameter_sets = true;
+    if (parameter_set->size() != nal_len ||
+        std::memcmp(parameter_set->data(), nal, nal_len) != 0) {
+      parameter_set->assign(nal, nal + nal_len);
+      m_parameter_sets_changed = true;
+    }
+  }
+}
+
+void GroundRecorder::StreamRecorder::finish_frame() {
+  // A NAL unit without its end (FU end lost together with the marker)
+  if (m_fu_nal_offset != 0) m_frame_corrupt = true;
+  // With intra refresh there are no IDR frames, but the parameter sets are
+  // sent before the first (intra coded) slice of a refresh period
+  const bool is_keyframe = m_frame_is_keyframe || m_frame_has_parameter_sets;
+  bool drop = m_frame_corrupt || (m_waiting_for_keyframe && !is_keyframe);
+  if (!drop && is_keyframe && (!m_writer || m_parameter_sets_changed)) {
+    drop = !open_file();
+  }
+  if (drop || !m_writer) {
+    if (m_frame_corrupt) m_waiting_for_keyframe = true;
+    m_n_frames_dropped++;
+  } else {
+    m_waiting_for_keyframe = false;
+    write_frame(is_keyframe);
+  }
+  reset_frame();
+}
+
+bool GroundRecorder::StreamRecorder::open_file() {
+  const bool is_h265 = m_codec == Codec::H265;
+  if (m_sps.empty() || m_pps.empty() || (is_h265 && m_vps.empty())) {
+    return false;
+  }
+  m_parameter_sets_changed = false;
+  SpsInfo info{};
+  if (!(is_h265 ? parse_h265_sps(m_sps, info) : parse_h264_sps(m_sps, info))) {
+    m_console->warn("Stream {}: cannot parse SPS", m_stream_index);
+    return false;
+  }
+  auto codec_private = is_h265 ? build_hvcc(m_vps, m_sps, m_pps, info)
+                               : build_avcc(m_sps, m_pps, info);
+  // E.g. the air re-sends the same SPS / PPS with a different id
+  if (m_writer && codec_private == m_codec_private) return true;
+  close_file(false);
+  const auto now = std::chrono::steady_clock::now();
+  if (now - m_last_open_failure < OPEN_RETRY_INTERVAL) return false;
+  m_filename = m_config.create_filename(m_stream_index);
+  m_codec_private = std::move(codec_private);
+  DvrWriter::Config config{};
+  config.create_filename = [filename = m_filename]() { return filename; };
+  config.min_free_space_mb = m_config.min_free_space_mb;
+  config.on_segment_closed = m_config.on_file_closed;
+  m_writer = std::make_shared<DvrWriter>(std::move(config));
+  std::vector<uint8_t> ebml;
+  put_uint(ebml, ID_EBML_VERSION, 1);
+  put_uint(ebml, ID_EBML_READ_VERSION, 1);
+  put_uint(ebml, ID_EBML_MAX_ID_LENGTH, 4);
+  put_uint(ebml, ID_EBML_MAX_SIZE_LENGTH, 8);
+  put_string(ebml, ID_DOC_TYPE, "matroska");
+  put_uint(ebml, ID_DOC_TYPE_VERSION, 4);
+  put_uint(ebml, ID_DOC_TYPE_READ_VERSION, 2);
+  std::vector<uint8_t> info_element;
+  put_uint(info_element, ID_TIMECODE_SCALE, 1000000);
+  put_string(info_element, ID_MUXING_APP, "OpenHD");
+  put_string(info_element, ID_WRITING_APP, "OpenHD ground recorder");
+  std::vector<uint8_t> video;
+  put_uint(video, ID_PIXEL_WIDTH, info.width);
+  put_uint(video, ID_PIXEL_HEIGHT, info.height);
+  std::vector<uint8_t> track;
+  put_uint(track, ID_TRACK_NUMBER, 1);
+  put_uint(track, ID_TRACK_UID, 1);
+  put_uint(track, ID_TRACK_TYPE, 1);
+  put_string(track, ID_CODEC_ID,
+             is_h265 ? "V_MPEGH/ISO/HEVC" : "V_MPEG4/ISO/AVC");
+  put_element(track, ID_CODEC_PRIVATE, m_codec_private);
+  put_element(track, ID_VIDEO, video);
+  std::vector<uint8_t> tracks;
+  put_element(tracks, ID_TRACK_ENTRY, track);
+  std::vector<uint8_t> header;
+  put_element(header, ID_EBML, ebml);
+  // Such that the file is valid at any time
+  put_id(header, ID_SEGMENT);
+  put_unknown_size(header);
+  put_element(header, ID_INFO, info_element);
+  put_element(header, ID_TRACKS, tracks);
+  m_writer->add_stream_header(header.data(), header.size());
+  m_file_begin_timestamp = m_frame_timestamp;
+  m_cluster_timecode_ms = -1;
+  m_last_pts_ms = 0;
+  m_n_files++;
+  m_console->info("Ground recording [{}] started, {} {}x{}", m_filename,
+                  is_h265 ? "H265" : "H264", info.width, info.height);
+  return true;
+}
+
+void GroundRecorder::StreamRecorder::write_frame(bool is_keyframe) {
+  const auto writer_stats = m_writer->get_stats();
+  if (writer_stats.out_of_space || writer_stats.write_error) {
+    m_console->warn("Ground recording [{}] stopped: {}", m_filename,
+                    writer_stats.out_of_space ? "out of space" : "write error");
+    m_last_open_failure = std::chrono::steady_clock::now();
+    close_file(false);
+    m_n_frames_dropped++;
+    return;
+  }
+  // Frames after a gap keep their (later) timestamp
+  const int64_t pts_ms = std::max(
+      m_last_pts_ms,
+      (m_frame_timestamp - m_file_begin_timestamp) * 1000 / RTP_CLOCK_RATE);
+  m_last_pts_ms = pts_ms;
+  const bool new_cluster =
+      is_keyframe || m_cluster_timecode_ms < 0 ||
+      pts_ms - m_cluster_timecode_ms > MAX_CLUSTER_DURATION_MS;
+  if (new_cluster) m_cluster_timecode_ms = pts_ms;
+  const int16_t relative_timecode = pts_ms - m_cluster_timecode_ms;
+  const size_t frame_size = m_frame->size() - FRAME_HEADER_ROOM;
+  std::vector<uint8_t> header;
+  header.reserve(FRAME_HEADER_ROOM);
+  if (new_cluster) {
+    put_id(header, ID_CLUSTER);
+    put_unknown_size(header);
+    put_uint(header, ID_CLUSTER_TIMECODE, m_cluster_timecode_ms);
+  }
+  put_id(header, ID_SIMPLE_BLOCK);
+  put_size(header, 4 + frame_size);
+  header.push_back(0x81);  // Track number 1
+  put_u16(header, relative_timecode);
+  header.push_back(is_keyframe ? 0x80 : 0x00);
+  assert(header.size() <= FRAME_HEADER_ROOM);
+  // The headers go right in front of the frame data, no copy needed
+  uint8_t* begin = m_frame->data() + FRAME_HEADER_ROOM - header.size();
+  std::memcpy(begin, header.data(), header.size());
+  m_last_frame_size = frame_size;
+  VideoFragment unit(m_frame, begin, header.size() + frame_size);
+  if (m_writer->enqueue(std::move(unit), is_keyframe)) {
+    m_n_frames_written++;
+    if (is_keyframe) m_n_keyframes_written++;
+  } else {
+    m_n_frames_dropped++;
+  }
+}
+
+void GroundRecorder::StreamRecorder::close_file(bool blocking) {
+  if (!m_writer) return;
+  auto writer = std::move(m_writer);
+  m_writer = nullptr;
+  m_console->info("Ground recording [{}] stopped, {}", m_filename,
+                  writer->get_stats().to_string());
+  if (blocking) {
+    writer->stop();
+    return;
+  }
+  // Flushing the tail and fdatasync can take a while, which must not stall
+  // the recording of the other stream
+  openhd::AsyncHandle::instance().execute_async(
+      "close ground recording", [writer]() { writer->stop(); });
+}
+
+std::string GroundRecorder::Stats::to_string() const {
+  return fmt::format(
+      "GroundRecorder[packets:{} dropped:{} frames:{} keyframes:{} "
+      "frames_dropped:{} discontinuities:{} files:{}]",
+      n_packets, n_packets_dropped, n_frames_written, n_keyframes_written,
+      n_frames_dropped, n_discontinuities, n_files);
+}
+
+GroundRecorder::GroundRecorder(Config config) : m_config(std::move(config)) {
+  assert(m_config.create_filename);
+  m_console = openhd::log::create_or_get("gnd_rec");
+  for (int i = 0; i < m_config.n_streams; i++) {
+    m_queues.push_back(std::make_unique<StreamQueue>(m_config.queue_capacity));
+    m_streams.push_back(
+        std::make_unique<StreamRecorder>(m_config, i, m_console));
+  }
+  m_thread = std::make_unique<std::thread>(&GroundRecorder::loop, this);
+}
+
+GroundRecorder::~GroundRecorder() {
+  m_terminate = true;
+  if (m_thread && m_thread->joinable()) m_thread->join();
+  // Blocks until the files are on disk
+  m_streams.clear();
+}
+
+void GroundRecorder::on_rtp_packet(int stream_index, const uint8_t* data,
+                                   int data_len) {
+  if (stream_index < 0 || stream_index >= (int)m_queues.size() ||
+      data_len <= 0) {
+    return;
+  }
+  auto& queue = *m_queues[stream_index];
+  queue.n_packets.fetch_add(1, std::memory_order_relaxed);
+  auto packet = VideoFragment::pooled_copy_of(data, data_len);
+  if (!queue.queue.try_push(std::move(packet))) {
+    queue.n_packets_dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+GroundRecorder::Stats GroundRecorder::get_stats(int stream_index) const {
+  Stats ret{};
+  if (stream_index < 0 || stream_index >= (int)m_queues.size()) return ret;
+  const auto& queue = *m_queues[stream_index];
+  const auto& stream = *m_streams[stream_index];
+  ret.n_packets = queue.n_packets;
+  ret.n_packets_dropped = queue.n_packets_dropped;
+  ret.n_frames_written = stream.m_n_frames_written;
+  ret.n_keyframes_written = stream.m_n_keyframes_written;
+  ret.n_frames_dropped = stream.m_n_frames_dropped;
+  ret.n_discontinuities = stream.m_n_discontinuities;
+  ret.n_files = stream.m_n_files;
+  return ret;
+}
+
+void GroundRecorder::loop() {
+  VideoFragment packet;
+  while (true) {
+    // Read before draining, such that everything that was queued before
+    // the destructor was called is written
+    const bool terminate = m_terminate;
+    bool any = false;
+    for (size_t i = 0; i < m_queues.size(); i++) {
+      while (m_queues[i]->queue.try_pop(packet)) {
+        m_streams[i]->on_packet(packet.data(), packet.size());
+        any = true;
+      }
+    }
+    if (terminate) break;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto& stream : m_streams) stream->check_idle(now);
+    // Polling (instead of waking the recorder up for each packet) keeps the
+    // link receive thread free of any syscalls
+    if (!any) std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+}
+
+}  // namespace openhd::video
@@ -27,9 +27,12 @@
 #include <gst/app/gstappsink.h>
 #include <gst/gst.h>
 
+#include <atomic>
+#include <new>
 #include <optional>
 
 #include "openhd_spdlog.h"
+#include "openhd_video_frame.h"
 
 namespace openhd {
 
@@ -49,6 +52,105 @@ static std::shared_ptr<std::vector<uint8_t>> gst_copy_buffer(
   return ret;
 }
 
+// What a zero-copy fragment keeps alive: a reference on the GstBuffer and the
+// mapping(s) of its memories - the data pointers are only valid while mapped,
+// so the memories are unmapped (and the buffer unreffed) once the last copy of
+// the fragment is gone. Lives in a FragmentPool slot, such that there is no
+// allocation per fragment (the heap is only used if the pool is exhausted).
+struct GstFragmentPayload {
+  GstBuffer* buffer;
+  GstMapInfo maps[openhd::VideoFragment::MAX_N_SPANS];
+  guint n_maps;
+  std::atomic<uint32_t> n_refs;
+  // -1 if allocated on the heap
+  int32_t slot;
+};
+static_assert(sizeof(GstFragmentPayload) <= openhd::FragmentPool::SLOT_SIZE,
+              "GstFragmentPayload has to fit into a FragmentPool slot");
+
+static void gst_fragment_ref(void* handle) {
+  static_cast<GstFragmentPayload*>(handle)->n_refs.fetch_add(
+      1, std::memory_order_relaxed);
+}
+static void gst_fragment_unref(void* handle) {
+  auto* payload = static_cast<GstFragmentPayload*>(handle);
+  if (payload->n_refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+  for (guint i = 0; i < payload->n_maps; i++) {
+    gst_memory_unmap(payload->maps[i].memory, &payload->maps[i]);
+  }
+  gst_buffer_unref(payload->buffer);
+  const int32_t slot = payload->slot;
+  payload->~GstFragmentPayload();
+  if (slot >= 0) {
+    openhd::FragmentPool::instance().unref((uint32_t)slot);
+  } else {
+    ::operator delete(payload);
+  }
+}
+static constexpr openhd::VideoFragment::ExternalRef GST_FRAGMENT_REF{
+    gst_fragment_ref, gst_fragment_unref};
+
+// Zero-copy alternative to gst_copy_buffer - references the memories of the
+// buffer (e.g. rtp header and payload, as produced by rtph264pay /
+// rtph265pay) instead of mapping the whole buffer, which would merge them into
+// a newly allocated one. Each memory is mapped for as long as the fragment
+// (or a copy of it) is alive, the buffer is given back to gstreamer once the
+// last copy is gone.
+// Only system memory is referenced like this. Anything else (e.g. more
+// memories than a fragment can reference, or dmabuf, which is often uncached
+// and slow to read) is copied into a FragmentPool slot once.
+// NOTE: Don't hold on to these fragments for long - some encoder(s) only have a
+// small, fixed number of output buffers.
+static openhd::VideoFragment gst_wrap_buffer(GstBuffer* buffer) {
+  assert(buffer);
+  const guint n_memory = gst_buffer_n_memory(buffer);
+  bool can_reference =
+      n_memory > 0 && n_memory <= openhd::VideoFragment::MAX_N_SPANS;
+  for (guint i = 0; can_reference && i < n_memory; i++) {
+    can_reference = gst_memory_is_type(gst_buffer_peek_memory(buffer, i),
+                                       GST_ALLOCATOR_SYSMEM);
+  }
+  if (can_reference) {
+    auto& pool = openhd::FragmentPool::instance();
+    const int32_t slot = pool.try_acquire();
+    void* storage = slot >= 0 ? (void*)pool.get_slot_data((uint32_t)slot)
+                              : ::operator new(sizeof(GstFragmentPayload));
+    auto* payload = new (storage) GstFragmentPayload{};
+    payload->slot = slot;
+    payload->n_refs.store(1, std::memory_order_relaxed);
+    for (guint i = 0; i < n_memory; i++) {
+      if (!gst_memory_map(gst_buffer_peek_memory(buffer, i),
+                          &payload->maps[payload->n_maps], GST_MAP_READ)) {
+        break;
+      }
+      payload->n_maps++;
+    }
+    if (payload->n_maps == n_memory) {
+      payload->buffer = gst_buffer_ref(buffer);
+      const auto& maps = payload->maps;
+      return openhd::VideoFragment::from_external(
+          GST_FRAGMENT_REF, payload, maps[0].data, maps[0].size,
+          n_memory > 1 ? maps[1].data : nullptr,
+          n_memory > 1 ? maps[1].size : 0);
+    }
+    // Mapping failed - undo and copy instead
+    for (guint i = 0; i < payload->n_maps; i++) {
+      gst_memory_unmap(payload->maps[i].memory, &payload->maps[i]);
+    }
+    payload->~GstFragmentPayload();
+    if (slot >= 0) {
+      pool.unref((uint32_t)slot);
+    } else {
+      ::operator delete(storage);
+    }
+  }
+  uint8_t* out_data = nullptr;
+  const size_t buffer_size = gst_buffer_get_size(buffer);
+  auto ret = openhd::VideoFragment::pooled_create(buffer_size, out_data);
+  gst_buffer_extract(buffer, 0, out_data, buffer_size);
+  return ret;
+}
+
 struct GstBufferX {
   std::shared_ptr<std::vector<uint8_t>> buffer;
   uint64_t buffer_dts = 0;
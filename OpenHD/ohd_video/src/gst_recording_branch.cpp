@@ -0,0 +1,332 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "gst_recording_branch.h"
+
+#include <cassert>
+#include <thread>
+#include <utility>
+
+#include "air_recording_helper.hpp"
+#include "camera_settings.hpp"
+#include "gst_appsink_helper.h"
+#include "gst_helper.hpp"
+#include "openhd_spdlog_include.h"
+#include "openhd_util_async.h"
+#include "openhd_util_filesystem.h"
+#include "recording_remuxer.h"
+
+GstRecordingBranch::GstRecordingBranch(GstElement* pipeline, VideoCodec codec,
+                                       std::shared_ptr<spdlog::logger> console)
+    : m_pipeline(pipeline), m_codec(codec), m_console(std::move(console)) {
+  assert(m_pipeline);
+  m_tee = gst_bin_get_by_name(GST_BIN(m_pipeline), "t");
+  if (m_tee == nullptr) {
+    m_console->warn("No tee in pipeline, air recording not possible");
+  }
+}
+
+GstRecordingBranch::~GstRecordingBranch() {
+  stop_blocking();
+  if (m_tee) {
+    gst_object_unref(m_tee);
+    m_tee = nullptr;
+  }
+}
+
+bool GstRecordingBranch::start() {
+  if (m_state == State::RECORDING) return true;
+  if (m_state != State::IDLE || m_tee == nullptr) return false;
+  if (m_last_start_failure.has_value() &&
+      std::chrono::steady_clock::now() - m_last_start_failure.value() <
+          RETRY_START_INTERVAL) {
+    return false;
+  }
+  const auto suffix = OHDGstHelper::file_suffix_for_video_codec(m_codec);
+  m_filename = openhd::video::create_unused_recording_filename(suffix);
+  const auto description =
+      OHDGstHelper::createRecordingBranchForVideoCodec(m_codec);
+  m_console->debug("Attaching recording branch [{}]", description);
+  GError* error = nullptr;
+  m_bin = gst_parse_bin_from_description(description.c_str(), TRUE, &error);
+  if (error) {
+    m_console->error("Cannot create recording branch: {}", error->message);
+    g_error_free(error);
+    if (m_bin) gst_object_unref(m_bin);
+    m_bin = nullptr;
+    m_last_start_failure = std::chrono::steady_clock::now();
+    return false;
+  }
+  gst_object_ref_sink(m_bin);
+  gst_bin_add(GST_BIN(m_pipeline), m_bin);
+  m_unlinked = false;
+  m_eos_reached = false;
+  m_n_dropped_until_keyframe = 0;
+  openhd::video::DvrWriter::Config config{};
+  // The file is created with the first (key)frame
+  config.create_filename = [first = m_filename, suffix]() mutable {
+    if (!first.empty()) return std::exchange(first, std::string());
+    return openhd::video::create_unused_recording_filename(suffix);
+  };
+  config.min_free_space_mb = MINIMUM_AMOUNT_FREE_SPACE_FOR_AIR_RECORDING_MB;
+  // matroskamux splits each frame into several buffers (see on_new_sample),
+  // only whole clusters can be dropped
+  config.drop_whole_groups = true;
+  // Streamable .mkv has no index - convert finished recordings to .mp4
+  config.on_segment_closed = [](const std::string& filename) {
+    RecordingRemuxer::instance().remux_mkv_file_async(filename);
+  };
+  m_writer = std::make_shared<openhd::video::DvrWriter>(std::move(config));
+  bool success = add_pad_probe("rec_parse", "src", GST_PAD_PROBE_TYPE_BUFFER,
+                               &GstRecordingBranch::wait_for_keyframe_probe) &&
+                 add_pad_probe("rec_sink", "sink",
+                               GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                               &GstRecordingBranch::eos_probe);
+  if (success) {
+    GstElement* appsink = gst_bin_get_by_name(GST_BIN(m_bin), "rec_sink");
+    GstAppSinkCallbacks callbacks{};
+    callbacks.new_sample = &GstRecordingBranch::on_new_sample;
+    gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, this,
+                               nullptr);
+    gst_object_unref(appsink);
+    success = gst_element_sync_state_with_parent(m_bin);
+  }
+  if (success) {
+#if GST_CHECK_VERSION(1, 20, 0)
+    m_tee_src_pad = gst_element_request_pad_simple(m_tee, "src_%u");
+#else
+    m_tee_src_pad = gst_element_get_request_pad(m_tee, "src_%u");
+#endif
+    GstPad* bin_sink = gst_element_get_static_pad(m_bin, "sink");
+    success = m_tee_src_pad != nullptr && bin_sink != nullptr &&
+              gst_pad_link(m_tee_src_pad, bin_sink) == GST_PAD_LINK_OK;
+    if (bin_sink) gst_object_unref(bin_sink);
+  }
+  if (!success) {
+    m_console->error("Cannot attach recording branch");
+    remove_bin();
+    m_writer = nullptr;
+    OHDFilesystemUtil::remove_if_existing(m_filename);
+    m_last_start_failure = std::chrono::steady_clock::now();
+    return false;
+  }
+  m_last_start_failure = std::nullopt;
+  request_keyframe();
+  m_recording_begin = std::chrono::steady_clock::now();
+  m_state = State::RECORDING;
+  m_console->info("Air recording to [{}] started", m_filename);
+  return true;
+}
+
+void GstRecordingBranch::request_stop() {
+  if (m_state != State::RECORDING) return;
+  m_state = State::STOPPING;
+  m_stop_begin = std::chrono::steady_clock::now();
+  // Unlink as soon as the tee src pad is idle (no buffer in flight) - might
+  // be called right away from this thread
+  m_unlink_probe_id =
+      gst_pad_add_probe(m_tee_src_pad, GST_PAD_PROBE_TYPE_IDLE,
+                        &GstRecordingBranch::unlink_probe, this, nullptr);
+}
+
+void GstRecordingBranch::poll() {
+  if (m_state != State::STOPPING) return;
+  const bool done = m_unlinked && m_eos_reached;
+  const bool timeout =
+      std::chrono::steady_clock::now() - m_stop_begin > STOP_TIMEOUT;
+  if (!done && !timeout) return;
+  if (!done) {
+    m_console->warn("Recording branch did not finish in time (unlinked:{})",
+                    m_unlinked.load());
+  }
+  finalize_stop();
+}
+
+void GstRecordingBranch::stop_blocking() {
+  request_stop();
+  while (m_state == State::STOPPING) {
+    poll();
+    if (m_state == State::STOPPING) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+}
+
+std::optional<openhd::video::DvrWriter::Stats>
+GstRecordingBranch::get_writer_stats() const {
+  if (!m_writer) return std::nullopt;
+  return m_writer->get_stats();
+}
+
+GstPadProbeReturn GstRecordingBranch::wait_for_keyframe_probe(
+    GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  auto self = static_cast<GstRecordingBranch*>(user_data);
+  GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+  if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+    self->m_n_dropped_until_keyframe++;
+    return GST_PAD_PROBE_DROP;
+  }
+  self->m_console->debug("Recording starts at keyframe, dropped {} frames",
+                         self->m_n_dropped_until_keyframe.load());
+  return GST_PAD_PROBE_REMOVE;
+}
+
+GstPadProbeReturn GstRecordingBranch::unlink_probe(GstPad* pad,
+                                                   GstPadProbeInfo* info,
+                                                   gpointer user_data) {
+  auto self = static_cast<GstRecordingBranch*>(user_data);
+  GstPad* bin_sink = gst_element_get_static_pad(self->m_bin, "sink");
+  gst_pad_unlink(pad, bin_sink);
+  // Let the muxer write its index / duration and flush to the file
+  gst_pad_send_event(bin_sink, gst_event_new_eos());
+  gst_object_unref(bin_sink);
+  self->m_unlinked = true;
+  return GST_PAD_PROBE_REMOVE;
+}
+
+GstPadProbeReturn GstRecordingBranch::eos_probe(GstPad* pad,
+                                                GstPadProbeInfo* info,
+                                                gpointer user_data) {
+  auto self = static_cast<GstRecordingBranch*>(user_data);
+  if (GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info)) != GST_EVENT_EOS) {
+    return GST_PAD_PROBE_OK;
+  }
+  self->m_eos_reached = true;
+  // Everything has been handed to the writer at this point. Don't let the EOS
+  // reach the appsink, otherwise it is posted on the pipeline bus.
+  return GST_PAD_PROBE_DROP;
+}
+
+GstFlowReturn GstRecordingBranch::on_new_sample(GstAppSink* appsink,
+                                                gpointer user_data) {
+  auto self = static_cast<GstRecordingBranch*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(appsink);
+  if (sample == nullptr) return GST_FLOW_OK;
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  if (buffer && gst_buffer_get_size(buffer) > 0) {
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_HEADER)) {
+      // Container header (EBML / tracks), comes before any frame
+      GstMapInfo map;
+      if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        self->m_writer->add_stream_header(map.data, map.size);
+        gst_buffer_unmap(buffer, &map);
+      }
+    } else {
+      // matroskamux pushes the cluster header, the SimpleBlock header and the
+      // frame as separate buffers. Only a cluster header that starts with a
+      // keyframe is not marked as DELTA_UNIT - which is where the writer may
+      // start dropping / roll the segment (whole clusters only).
+      const bool is_keyframe_cluster =
+          !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+      // Never blocks - if the disk can't keep up, data is dropped instead
+      self->m_writer->enqueue(openhd::gst_wrap_buffer(buffer),
+                              is_keyframe_cluster);
+    }
+  }
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+bool GstRecordingBranch::add_pad_probe(const char* element_name,
+                                       const char* pad_name,
+                                       GstPadProbeType type,
+                                       GstPadProbeCallback callback) {
+  GstElement* element = gst_bin_get_by_name(GST_BIN(m_bin), element_name);
+  if (element == nullptr) {
+    m_console->error("No {} in recording branch", element_name);
+    return false;
+  }
+  GstPad* pad = gst_element_get_static_pad(element, pad_name);
+  gst_object_unref(element);
+  if (pad == nullptr) return false;
+  gst_pad_add_probe(pad, type, callback, this, nullptr);
+  gst_object_unref(pad);
+  return true;
+}
+
+void GstRecordingBranch::request_keyframe() {
+  // Same as gst_video_event_new_upstream_force_key_unit(), without the need to
+  // link gstreamer-video. Travels upstream through the tee to the encoder -
+  // if the encoder doesn't support it, we just start at the next regular
+  // keyframe.
+  GstStructure* structure = gst_structure_new(
+      "GstForceKeyUnit", "running-time", GST_TYPE_CLOCK_TIME,
+      GST_CLOCK_TIME_NONE, "all-headers", G_TYPE_BOOLEAN, TRUE, "count",
+      G_TYPE_UINT, 0, nullptr);
+  GstEvent* event = gst_event_new_custom(GST_EVENT_CUSTOM_UPSTREAM, structure);
+  if (!gst_pad_send_event(m_tee_src_pad, event)) {
+    m_console->debug("Keyframe request not handled");
+  }
+}
+
+void GstRecordingBranch::finalize_stop() {
+  if (!m_unlinked) {
+    // The idle probe never fired (e.g. the pipeline is stalled), unlink anyways
+    if (m_unlink_probe_id != 0) {
+      gst_pad_remove_probe(m_tee_src_pad, m_unlink_probe_id);
+    }
+    GstPad* bin_sink = gst_element_get_static_pad(m_bin, "sink");
+    gst_pad_unlink(m_tee_src_pad, bin_sink);
+    gst_object_unref(bin_sink);
+  }
+  m_unlink_probe_id = 0;
+  remove_bin();
+  close_writer_async();
+  const auto duration_s = std::chrono::duration_cast<std::chrono::seconds>(
+                              std::chrono::steady_clock::now() -
+                              m_recording_begin)
+                              .count();
+  m_console->info("Air recording [{}] stopped after {}s", m_filename,
+                  duration_s);
+  m_state = State::IDLE;
+}
+
+void GstRecordingBranch::close_writer_async() {
+  if (!m_writer) return;
+  const auto stats = m_writer->get_stats();
+  m_console->debug("{}", stats.to_string());
+  if (stats.write_error) {
+    // E.g. the SD card is gone, don't re-try right away
+    m_last_start_failure = std::chrono::steady_clock::now();
+  }
+  // Flushing the tail and fdatasync can take a while on a slow SD card, which
+  // must not stall the stream thread. The writer makes the file(s) read /
+  // writeable by everybody when closing them.
+  auto writer = std::move(m_writer);
+  openhd::AsyncHandle::instance().execute_async(
+      "close air recording", [writer]() { writer->stop(); });
+}
+
+void GstRecordingBranch::remove_bin() {
+  if (m_bin) {
+    gst_element_set_state(m_bin, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(m_pipeline), m_bin);
+    gst_object_unref(m_bin);
+    m_bin = nullptr;
+  }
+  if (m_tee_src_pad) {
+    gst_element_release_request_pad(m_tee, m_tee_src_pad);
+    gst_object_unref(m_tee_src_pad);
+    m_tee_src_pad = nullptr;
+  }
+}
@@ -29,19 +29,14 @@
 #include <utility>
 #include <vector>
 
-#include "air_recording_helper.hpp"
 #include "config_paths.h"
 #include "gst_appsink_helper.h"
 #include "gst_debug_helper.h"
 #include "gst_helper.hpp"
-#include "gst_recording_demuxer.h"
-#include "nalu/CodecConfigFinder.hpp"
-#include "nalu/fragment_helper.h"
 #include "nalu/nalu_helper.h"
 #include "openhd_rtp.h"
 #include "openhd_util.h"
 #include "rpi_hdmi_to_csi_v4l2_helper.h"
-#include "rtp_eof_helper.h"
 #include "x20_cam_helper.h"
 
 GStreamerStream::GStreamerStream(std::shared_ptr<CameraHolder> camera_holder,
@@ -53,10 +48,6 @@ GStreamerStream::GStreamerStream(std::shared_ptr<CameraHolder> camera_holder,
   assert(m_console);
   m_console->debug("GStreamerStream::GStreamerStream for cam {}",
                    m_camera_holder->get_camera().cam_type_as_verbose_string());
-  if (OHDFilesystemUtil::exists(
-          (std::string(getConfigBasePath()) + "exp_raw.txt").c_str())) {
-    dirty_use_raw = true;
-  }
   m_camera_holder->register_listener([this]() {
     // right now, every time the settings for this camera change, we just
     // re-start the whole stream. That is not ideal, since some cameras support
@@ -227,51 +218,26 @@ void GStreamerStream::setup() {
     m_console->warn("Probably ill-formatted pipeline: [{}]",
                     pipeline_content.str());
   }
-  const bool ADD_RECORDING_TO_PIPELINE =
-      setting.air_recording == AIR_RECORDING_ON ||
-      (setting.air_recording == AIR_RECORDING_AUTO_ARM_DISARM &&
-       m_armed_enable_air_recording);
-  // for safety we only add the tee command at the right place if recording is
-  // enabled.
-  if (ADD_RECORDING_TO_PIPELINE) {
-    m_console->info("Air recording active");
-    pipeline_content << "tee name=t ! ";
+  // The recording branch is attached to / detached from the tee at run time
+  // (see update_air_recording()). For safety we only add the tee at the right
+  // place if recording is enabled at all.
+  const bool ADD_TEE_TO_PIPELINE = setting.air_recording != AIR_RECORDING_OFF;
+  if (ADD_TEE_TO_PIPELINE) {
+    pipeline_content << "tee name=t allow-not-linked=true ! ";
   }
   // After we've written the parts for the different camera implementation(s) we
   // just need to append the rtp part and the udp out add rtp part
-  if (dirty_use_raw) {
-    /*pipeline_content <<
-    OHDGstHelper::create_queue_and_parse(setting.streamed_video_format.videoCodec);
-    pipeline_content <<
-    OHDGstHelper::create_caps_nal(setting.streamed_video_format.videoCodec);
-    pipeline_content << " queue ! ";*/
-    pipeline_content << " queue ! ";
-    /*pipeline_content << OHDGstHelper::create_parse_for_codec(
+  const int rtp_fragment_size = 1440;
+  if (setting.h26x_rtp_packetizer == RTP_PACKETIZER_OPENHD) {
+    m_console->debug("Using openhd rtp packetizer, mtu {}", rtp_fragment_size);
+    pipeline_content << OHDGstHelper::create_parse_for_openhd_rtp(
         setting.streamed_video_format.videoCodec);
-    pipeline_content << OHDGstHelper::create_caps_nal(
-        setting.streamed_video_format.videoCodec, true);*/
-    pipeline_content << OHDGstHelper::createOutputAppSink();
-    /*pipeline_content << "video/x-h264,stream-format=byte-stream ! ";
-    pipeline_content << OHDGstHelper::createOutputAppSink();*/
   } else {
-    const int rtp_fragment_size = 1440;
     m_console->debug("Using {} for rtp fragmentation", rtp_fragment_size);
     pipeline_content << OHDGstHelper::create_parse_and_rtp_packetize(
         setting.streamed_video_format.videoCodec, rtp_fragment_size);
-    pipeline_content << OHDGstHelper::createOutputAppSink();
-  }
-  if (ADD_RECORDING_TO_PIPELINE) {
-    const auto recording_filename =
-        openhd::video::create_unused_recording_filename(
-            OHDGstHelper::file_suffix_for_video_codec(
-                setting.streamed_video_format.videoCodec));
-    m_console->debug("Using [{}] for recording", recording_filename);
-    pipeline_content << OHDGstHelper::createRecordingForVideoCodec(
-        setting.streamed_video_format.videoCodec, recording_filename);
-    m_opt_curr_recording_filename = recording_filename;
-  } else {
-    m_opt_curr_recording_filename = std::nullopt;
   }
+  pipeline_content << OHDGstHelper::createOutputAppSink();
   {
     const auto index = m_camera_holder->get_camera().index;
     const uint8_t cam_type = (uint8_t)m_camera_holder->get_camera().camera_type;
@@ -280,7 +246,7 @@ void GStreamerStream::setup() {
         (uint8_t)index,
         cam_type,
         CAM_STATUS_RESTARTING,
-        ADD_RECORDING_TO_PIPELINE,
+        false,
         (uint8_t)video_codec_to_int(setting.streamed_video_format.videoCodec),
         (uint16_t)setting.h26x_bitrate_kbits,
         (uint8_t)setting.h26x_keyframe_interval,
@@ -302,20 +268,41 @@ void GStreamerStream::setup() {
   }
   m_bitrate_ctrl_element = get_dynamic_bitrate_control_element_in_pipeline(
       m_gst_pipeline, *m_camera_holder);
+  if (ADD_TEE_TO_PIPELINE) {
+    m_recording_branch = std::make_unique<GstRecordingBranch>(
+        m_gst_pipeline, setting.streamed_video_format.videoCodec, m_console);
+  }
   // we pull data out of the gst pipeline as cpu memory buffer(s) using the
   // gstreamer "appsink" element
   m_app_sink_element =
       gst_bin_get_by_name(GST_BIN(m_gst_pipeline), "out_appsink");
   assert(m_app_sink_element);
   // m_console->debug("Cam encoding format: {}",(int)cam_info.encoding_format);
-  auto lol_cb =
-      [this](
-          std::vector<std::shared_ptr<std::vector<uint8_t>>> frame_fragments) {
-        x_on_new_rtp_fragmented_frame(frame_fragments);
-      };
-  m_rtp_helper = std::make_shared<openhd::RTPHelper>(
-      setting.streamed_video_format.videoCodec == VideoCodec::H265);
-  m_rtp_helper->set_out_cb(lol_cb);
+  // Codec and intra refresh cannot change without restarting the pipeline -
+  // resolve them once here instead of per fragment
+  openhd::RTPFrameAssembler::Config assembler_config{};
+  assembler_config.is_h265 =
+      setting.streamed_video_format.videoCodec == VideoCodec::H265;
+  assembler_config.stream_index = m_camera_holder->get_camera().index;
+  assembler_config.uses_intra_refresh = setting.h26x_intra_refresh_type != -1;
+  assembler_config.early_tx = setting.h26x_early_tx;
+  m_frame_assembler = std::make_unique<openhd::RTPFrameAssembler>(
+      assembler_config, m_output_cb);
+  m_frame_assembler->set_enable_ultra_secure_encryption(
+      setting.enable_ultra_secure_encryption);
+  m_rtp_packetizer = nullptr;
+  if (setting.h26x_rtp_packetizer == RTP_PACKETIZER_OPENHD) {
+    openhd::RTPHelper::Config packetizer_config{};
+    packetizer_config.is_h265 = assembler_config.is_h265;
+    packetizer_config.stream_index = assembler_config.stream_index;
+    packetizer_config.uses_intra_refresh = assembler_config.uses_intra_refresh;
+    packetizer_config.early_tx = assembler_config.early_tx;
+    packetizer_config.mtu = rtp_fragment_size;
+    m_rtp_packetizer =
+        std::make_unique<openhd::RTPHelper>(packetizer_config, m_output_cb);
+    m_rtp_packetizer->set_enable_ultra_secure_encryption(
+        setting.enable_ultra_secure_encryption);
+  }
 }
 
 void GStreamerStream::start() {
@@ -339,6 +326,8 @@ void GStreamerStream::stop() {
 void GStreamerStream::cleanup_pipe() {
   m_console->debug("GStreamerStream::cleanup_pipe() begin");
   assert(m_gst_pipeline != nullptr);
+  // Stops the recording (if there is any) and drops the reference to the tee
+  m_recording_branch = nullptr;
   // Drop the reference to the bitrate control element (if it exists)
   if (m_bitrate_ctrl_element.has_value()) {
     unref_bitrate_element(m_bitrate_ctrl_element.value());
@@ -358,29 +347,6 @@ void GStreamerStream::cleanup_pipe() {
                                                    GST_STATE_NULL);
   gst_object_unref(m_gst_pipeline);
   m_gst_pipeline = nullptr;
-  if (m_opt_curr_recording_filename) {
-    // make file read / writeable by everybody
-    OHDFilesystemUtil::make_file_read_write_everyone(
-        m_opt_curr_recording_filename.value());
-    // we do not want empty files - this can happen rarely in case the file is
-    // created, but no video data is actually written to it actually, looks like
-    // it is possible the file might be empty until the gst pipeline is actually
-    // terminating - annoying gst crap ! why is there no way to properly
-    // terminate ! better leave the file there
-    /*if(OHDFilesystemUtil::get_file_size_bytes(m_opt_curr_recording_filename.value())==0){
-      m_console->debug("Ground recording {} is
-    empty",m_opt_curr_recording_filename.value());
-      OHDFilesystemUtil::remove_if_existing(m_opt_curr_recording_filename.value());
-    }*/
-    m_opt_curr_recording_filename = std::nullopt;
-  }
-  // start demuxing of (all) .mkv files unless the FC is currently armed ( we
-  // are in flight) this will of course also de-mux the new ground recording (if
-  // there is any)
-  // if(m_opt_action_handler &&
-  // !m_opt_action_handler->arm_state.is_currently_armed()){
-  // GstRecordingDemuxer::instance().demux_all_remaining_mkv_files_async();
-  //}
   m_console->debug("GStreamerStream::cleanup_pipe() end");
 }
 
@@ -424,15 +390,50 @@ void GStreamerStream::handle_change_bitrate_request(
 void GStreamerStream::handle_update_arming_state(bool armed) {
   m_console->debug("handle_update_arming_state: {}", armed);
   const auto settings = m_camera_holder->get_settings();
+  m_armed_enable_air_recording = armed;
   if (settings.air_recording == AIR_RECORDING_AUTO_ARM_DISARM) {
-    if (armed) {
-      m_armed_enable_air_recording = true;
-      m_console->debug("Starting air recording");
-    } else {
-      m_armed_enable_air_recording = false;
+    // No restart required, the stream thread attaches / detaches the
+    // recording branch (see update_air_recording)
+    m_console->debug("{} air recording", armed ? "Starting" : "Stopping");
+  }
+}
+
+void GStreamerStream::update_air_recording() {
+  if (!m_recording_branch) return;
+  m_recording_branch->poll();
+  const auto air_recording = m_camera_holder->get_settings().air_recording;
+  const bool should_record =
+      air_recording == AIR_RECORDING_ON ||
+      (air_recording == AIR_RECORDING_AUTO_ARM_DISARM &&
+       m_armed_enable_air_recording);
+  const auto cam_index = m_camera_holder->get_camera().index;
+  const auto writer_stats = m_recording_branch->get_writer_stats();
+  if (writer_stats.has_value() &&
+      (writer_stats->out_of_space || writer_stats->write_error)) {
+    // The writer already stopped writing - finalize the file
+    m_console->warn("Stopping air recording, {}", writer_stats->to_string());
+    m_recording_branch->request_stop();
+    openhd::LinkActionHandler::instance().set_cam_info_air_recording(
+        cam_index, false);
+    // Disables air recording if there is not enough space left
+    m_camera_holder->check_remaining_space_air_recording(true);
+    return;
+  }
+  if (should_record && !m_recording_branch->is_active()) {
+    // The writer watches the free space while recording, here we only need
+    // to check before starting
+    m_camera_holder->check_remaining_space_air_recording(true);
+    if (m_camera_holder->get_settings().air_recording == AIR_RECORDING_OFF) {
+      return;
+    }
+    if (m_recording_branch->start()) {
+      openhd::LinkActionHandler::instance().set_cam_info_air_recording(
+          cam_index, true);
     }
-    // restart pipeline such that recording is started / stopped
-    request_restart();
+  } else if (!should_record && m_recording_branch->is_recording()) {
+    m_recording_branch->request_stop();
+    openhd::LinkActionHandler::instance().set_cam_info_air_recording(
+        cam_index, false);
   }
 }
 
@@ -513,13 +514,12 @@ void GStreamerStream::stream_once() {
   // For 'bugged camera restart' fix
   std::chrono::steady_clock::time_point m_last_camera_frame =
       std::chrono::steady_clock::now();
-  m_frame_fragments.resize(0);
+  if (m_frame_assembler) m_frame_assembler->reset();
   // As soon as we get the first frame, we change the status to streaming
   bool has_first_frame = false;
-  // Every X seconds, we check if we are about to run out of space
-  std::chrono::steady_clock::time_point
-      m_last_air_recording_remaining_space_check =
-          std::chrono::steady_clock::now();
+  // Every X seconds, we check if encryption has been changed
+  std::chrono::steady_clock::time_point m_last_encryption_check =
+      std::chrono::steady_clock::now();
   while (true) {
     // Quickly terminate if openhd wants to terminate
     if (!m_keep_looping) break;
@@ -560,6 +560,7 @@ void GStreamerStream::stream_once() {
         m_request_restart = true;
       }
     }
+    update_air_recording();
     // Check if we require a full restart
     bool tmp_true = true;
     if (m_request_restart.compare_exchange_strong(tmp_true, false)) {
@@ -567,13 +568,20 @@ void GStreamerStream::stream_once() {
       m_console->debug("Restart requested, restarting");
       break;
     }
-    const auto elapsed_remaining_space =
-        std::chrono::steady_clock::now() -
-        m_last_air_recording_remaining_space_check;
-    if (elapsed_remaining_space > std::chrono::seconds(1)) {
-      m_camera_holder->check_remaining_space_air_recording(true);
-      m_last_air_recording_remaining_space_check =
-          std::chrono::steady_clock::now();
+    if (std::chrono::steady_clock::now() - m_last_encryption_check >
+        std::chrono::seconds(1)) {
+      // Encryption can be changed without a restart
+      const bool enable_ultra_secure_encryption =
+          m_camera_holder->get_settings().enable_ultra_secure_encryption;
+      if (m_frame_assembler) {
+        m_frame_assembler->set_enable_ultra_secure_encryption(
+            enable_ultra_secure_encryption);
+      }
+      if (m_rtp_packetizer) {
+        m_rtp_packetizer->set_enable_ultra_secure_encryption(
+            enable_ultra_secure_encryption);
+      }
+      m_last_encryption_check = std::chrono::steady_clock::now();
     }
     // try get a new frame fragment from gst
     GstSample* sample = gst_app_sink_try_pull_sample(
@@ -585,120 +593,36 @@ void GStreamerStream::stream_once() {
             m_camera_holder->get_camera().index, CAM_STATUS_STREAMING);
       }
       GstBuffer* buffer = gst_sample_get_buffer(sample);
-      // tmp declaration for give sample back early optimization
-      std::shared_ptr<std::vector<uint8_t>> fragment_data = nullptr;
-      uint64_t buffer_dts = 0;
       if (buffer && gst_buffer_get_size(buffer) > 0) {
-        fragment_data = openhd::gst_copy_buffer(buffer);
-        buffer_dts = buffer->dts;
-      }
-      // Optimization: Give the buffer back to gstreamer as soon as possible.
-      // After copying the data from the sample, unref it first, then forward
-      // the data via cb
-      gst_sample_unref(sample);
-      sample = nullptr;
-      if (fragment_data && !fragment_data->empty()) {
-        // If we got a new sample, aggregate then forward
-        if (dirty_use_raw) {
-          m_rtp_helper->feed_multiple_nalu(fragment_data->data(),
-                                           fragment_data->size());
+        if (m_rtp_packetizer) {
+          // One access unit, packetized (copied) into pooled fragments right
+          // away
+          GstMapInfo map;
+          if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            m_rtp_packetizer->feed_access_unit(map.data, map.size);
+            gst_buffer_unmap(buffer, &map);
+          }
         } else {
-          on_new_rtp_frame_fragment(std::move(fragment_data), buffer_dts);
+          // We don't copy the data out of the buffer, the fragment keeps a
+          // reference on the buffer instead.
+          m_frame_assembler->add_fragment(openhd::gst_wrap_buffer(buffer));
         }
         m_last_camera_frame = std::chrono::steady_clock::now();
       }
+      gst_sample_unref(sample);
+      sample = nullptr;
     }
   }
   // If we land here, we need to clean up the pipe and (re) start
   const auto terminate_begin = std::chrono::steady_clock::now();
+  // Give the muxer a chance to finalize the recording while the pipeline is
+  // still running
+  if (m_recording_branch) m_recording_branch->stop_blocking();
   stop();
   cleanup_pipe();
-  m_frame_fragments.resize(0);
+  if (m_frame_assembler) m_frame_assembler->reset();
   m_console->debug("Terminating pipeline took {}ms",
                    std::chrono::duration_cast<std::chrono::milliseconds>(
                        std::chrono::steady_clock::now() - terminate_begin)
                        .count());
 }
-
-void GStreamerStream::on_new_rtp_frame_fragment(
-    std::shared_ptr<std::vector<uint8_t>> fragment, uint64_t dts) {
-  m_frame_fragments.push_back(fragment);
-  const auto curr_video_codec =
-      m_camera_holder->get_settings().streamed_video_format.videoCodec;
-  openhd::rtp_eof_helper::RTPFragmentInfo info{};
-  const bool is_h265 = curr_video_codec == VideoCodec::H265;
-  if (is_h265) {
-    info = openhd::rtp_eof_helper::h265_more_info(fragment->data(),
-                                                  fragment->size());
-  } else {
-    info = openhd::rtp_eof_helper::h264_more_info(fragment->data(),
-                                                  fragment->size());
-  }
-  if (info.is_fu_start) {
-    if (is_idr_frame(info.nal_unit_type, is_h265)) {
-      m_last_fu_s_idr = true;
-    } else {
-      m_last_fu_s_idr = false;
-    }
-  }
-  // m_console->debug("Fragment {} start:{} end:{}
-  // type:{}",m_frame_fragments.size(),
-  //                  OHDUtil::yes_or_no(info.is_fu_start),
-  //                  OHDUtil::yes_or_no(info.is_fu_end),
-  //                  x_get_nal_unit_type_as_string(info.nal_unit_type,is_h265));
-  bool is_last_fragment_of_frame = info.is_fu_end;
-  if (m_frame_fragments.size() > 500) {
-    // Most likely something wrong with the "find end of frame" workaround
-    m_console->debug("No end of frame found after 1000 fragments");
-    is_last_fragment_of_frame = true;
-  }
-  if (is_last_fragment_of_frame) {
-    on_new_rtp_fragmented_frame();
-    m_frame_fragments.resize(0);
-    m_last_fu_s_idr = false;
-  }
-}
-
-void GStreamerStream::on_new_rtp_fragmented_frame() {
-  // m_console->debug("Got frame with {} fragments",rtp_fragments.size());
-  if (m_output_cb) {
-    const auto stream_index = m_camera_holder->get_camera().index;
-    const bool enable_ultra_secure_encryption =
-        m_camera_holder->get_settings().enable_ultra_secure_encryption;
-    const bool is_intra_enabled =
-        m_camera_holder->get_settings().h26x_intra_refresh_type != -1;
-    const bool is_intra_frame = m_last_fu_s_idr;
-    auto frame = openhd::FragmentedVideoFrame{m_frame_fragments,
-                                              std::chrono::steady_clock::now(),
-                                              enable_ultra_secure_encryption,
-                                              nullptr,
-                                              is_intra_enabled,
-                                              is_intra_frame};
-    // m_console->debug("{}",frame.to_string());
-    m_output_cb(stream_index, frame);
-  } else {
-    m_console->debug("No output cb");
-  }
-}
-
-void GStreamerStream::x_on_new_rtp_fragmented_frame(
-    std::vector<std::shared_ptr<std::vector<uint8_t>>> frame_fragments) {
-  if (m_output_cb) {
-    const auto stream_index = m_camera_holder->get_camera().index;
-    const bool enable_ultra_secure_encryption =
-        m_camera_holder->get_settings().enable_ultra_secure_encryption;
-    const bool is_intra_enabled =
-        m_camera_holder->get_settings().h26x_intra_refresh_type != -1;
-    const bool is_intra_frame = m_last_fu_s_idr;
-    auto frame = openhd::FragmentedVideoFrame{frame_fragments,
-                                              std::chrono::steady_clock::now(),
-                                              enable_ultra_secure_encryption,
-                                              nullptr,
-                                              is_intra_enabled,
-                                              is_intra_frame};
-    // m_console->debug("{}",frame.to_string());
-    m_output_cb(stream_index, frame);
-  } else {
-    m_console->debug("No output cb");
-  }
-}
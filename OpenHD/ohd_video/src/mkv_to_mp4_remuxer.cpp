@@ -0,0 +1,883 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "mkv_to_mp4_remuxer.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "openhd_spdlog.h"
+#include "openhd_spdlog_include.h"
+#include "openhd_util_filesystem.h"
+
+namespace openhd::video {
+
+namespace {
+
+// Matroska element ids (including the length marker)
+constexpr uint32_t ID_SEGMENT = 0x18538067;
+constexpr uint32_t ID_INFO = 0x1549A966;
+constexpr uint32_t ID_TIMECODE_SCALE = 0x2AD7B1;
+constexpr uint32_t ID_TRACKS = 0x1654AE6B;
+constexpr uint32_t ID_TRACK_ENTRY = 0xAE;
+constexpr uint32_t ID_TRACK_NUMBER = 0xD7;
+constexpr uint32_t ID_TRACK_TYPE = 0x83;
+constexpr uint32_t ID_CODEC_ID = 0x86;
+constexpr uint32_t ID_CODEC_PRIVATE = 0x63A2;
+constexpr uint32_t ID_DEFAULT_DURATION = 0x23E383;
+constexpr uint32_t ID_VIDEO = 0xE0;
+constexpr uint32_t ID_PIXEL_WIDTH = 0xB0;
+constexpr uint32_t ID_PIXEL_HEIGHT = 0xBA;
+constexpr uint32_t ID_CLUSTER = 0x1F43B675;
+constexpr uint32_t ID_CLUSTER_TIMECODE = 0xE7;
+constexpr uint32_t ID_SIMPLE_BLOCK = 0xA3;
+constexpr uint32_t ID_BLOCK_GROUP = 0xA0;
+constexpr uint32_t ID_BLOCK = 0xA1;
+constexpr uint32_t ID_REFERENCE_BLOCK = 0xFB;
+
+constexpr uint64_t UNKNOWN_SIZE = UINT64_MAX;
+// Enough for the largest element header (4 + 8) and block header (8 + 3)
+constexpr size_t HEADER_READ_SIZE = 32;
+// Elements we need the content of are small, everything else is skipped
+constexpr uint64_t MAX_READ_ELEMENT_SIZE = 1024 * 1024;
+constexpr uint32_t MP4_TIMESCALE = 90000;
+constexpr uint32_t MOVIE_TIMESCALE = 1000;
+constexpr uint32_t JOURNAL_MAGIC = 0x4F48444A;
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+// Masters we descend into. Since streamable files use unknown sizes for the
+// segment and the clusters, we don't track where a master ends - the
+// elements are just read one after another.
+bool is_entered_master(uint32_t id) {
+  return id == ID_SEGMENT || id == ID_INFO || id == ID_TRACKS ||
+         id == ID_TRACK_ENTRY || id == ID_VIDEO || id == ID_CLUSTER ||
+         id == ID_BLOCK_GROUP;
+}
+
+// EBML variable length integer. Returns the number of bytes used, 0 if invalid
+// or incomplete. If keep_marker, the length marker is kept (element ids).
+int parse_vint(const uint8_t* data, size_t len, uint64_t& value,
+               bool keep_marker, bool* is_unknown = nullptr) {
+  if (len == 0 || data[0] == 0) return 0;
+  const int n = __builtin_clz((unsigned int)data[0]) - 23;
+  if ((size_t)n > len) return 0;
+  const uint8_t value_mask = 0xFF >> n;
+  value = keep_marker ? data[0] : (data[0] & value_mask);
+  bool all_ones = (data[0] & value_mask) == value_mask;
+  for (int i = 1; i < n; i++) {
+    value = (value << 8) | data[i];
+    all_ones = all_ones && data[i] == 0xFF;
+  }
+  if (is_unknown) *is_unknown = all_ones;
+  return n;
+}
+
+uint64_t parse_uint(const std::vector<uint8_t>& data) {
+  uint64_t ret = 0;
+  for (const auto b : data) ret = (ret << 8) | b;
+  return ret;
+}
+
+struct Track {
+  uint64_t number = 0;
+  uint64_t type = 0;
+  std::string codec_id;
+  std::vector<uint8_t> codec_private;
+  uint64_t default_duration_ns = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  bool is_h265() const { return codec_id == "V_MPEGH/ISO/HEVC"; }
+  bool is_supported() const {
+    return type == 1 && !codec_private.empty() &&
+           (codec_id == "V_MPEG4/ISO/AVC" || is_h265());
+  }
+};
+
+struct Sample {
+  int64_t pts_ns;
+  uint32_t size;
+  bool is_keyframe;
+};
+
+struct Chunk {
+  uint64_t offset;
+  uint32_t first_sample;
+};
+
+// Fixed size, appended to the journal on each checkpoint
+struct JournalRecord {
+  enum Type : uint32_t { HEADER = 1, CHUNK = 2, SAMPLE = 3, CHECKPOINT = 4 };
+  uint32_t type;
+  // HEADER: version, SAMPLE: size
+  uint32_t size;
+  // HEADER: input file size, CHUNK: output offset, SAMPLE: pts in ns,
+  // CHECKPOINT: input offset
+  int64_t a;
+  // HEADER: magic, SAMPLE: keyframe, CHECKPOINT: output offset
+  uint64_t b;
+};
+static_assert(sizeof(JournalRecord) == 24);
+
+// Minimal ISO BMFF box writer
+class BoxWriter {
+ public:
+  void u8(uint8_t v) { m_buf.push_back(v); }
+  void u16(uint16_t v) {
+    u8(v >> 8);
+    u8(v);
+  }
+  void u32(uint32_t v) {
+    u16(v >> 16);
+    u16(v);
+  }
+  void u64(uint64_t v) {
+    u32(v >> 32);
+    u32(v);
+  }
+  void zeros(size_t n) { m_buf.insert(m_buf.end(), n, 0); }
+  void bytes(const void* data, size_t size) {
+    auto p = static_cast<const uint8_t*>(data);
+    m_buf.insert(m_buf.end(), p, p + size);
+  }
+  void fourcc(const char* type) { bytes(type, 4); }
+  size_t begin(const char* type) {
+    const size_t pos = m_buf.size();
+    u32(0);
+    fourcc(type);
+    return pos;
+  }
+  size_t begin_full(const char* type, uint8_t version, uint32_t flags) {
+    const size_t pos = begin(type);
+    u32((uint32_t)version << 24 | flags);
+    return pos;
+  }
+  void end(size_t pos) {
+    const uint32_t size = m_buf.size() - pos;
+    for (int i = 0; i < 4; i++) m_buf[pos + i] = size >> (24 - 8 * i);
+  }
+  void matrix() {
+    for (const uint32_t v : {0x00010000u, 0u, 0u, 0u, 0x00010000u, 0u, 0u, 0u,
+                             0x40000000u}) {
+      u32(v);
+    }
+  }
+  const std::vector<uint8_t>& data() const { return m_buf; }
+
+ private:
+  std::vector<uint8_t> m_buf;
+};
+
+int64_t ns_to_mp4_timescale(int64_t ns) {
+  return ns / 1000 * MP4_TIMESCALE / 1000000;
+}
+
+std::vector<uint8_t> build_ftyp(bool is_h265) {
+  BoxWriter w;
+  const auto ftyp = w.begin("ftyp");
+  w.fourcc("isom");
+  w.u32(512);
+  w.fourcc("isom");
+  w.fourcc("iso2");
+  w.fourcc(is_h265 ? "hvc1" : "avc1");
+  w.fourcc("mp41");
+  w.end(ftyp);
+  return w.data();
+}
+
+bool write_fully(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+  while (size > 0) {
+    const ssize_t ret = pwrite(fd, data, size, (off_t)offset);
+    if (ret < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += ret;
+    size -= ret;
+    offset += ret;
+  }
+  return true;
+}
+
+class Remuxer {
+ public:
+  Remuxer(std::string in_file, std::string out_file,
+          const RemuxOptions& options)
+      : m_in_file(std::move(in_file)),
+        m_out_file(std::move(out_file)),
+        m_part_file(m_out_file + ".part"),
+        m_journal_file(m_out_file + ".journal"),
+        m_options(options) {
+    m_console = openhd::log::create_or_get("remux");
+  }
+  ~Remuxer() {
+    if (m_in_fd >= 0) close(m_in_fd);
+    if (m_out_fd >= 0) close(m_out_fd);
+    if (m_journal_fd >= 0) close(m_journal_fd);
+  }
+
+  RemuxResult run() {
+    if (!open_files()) return m_result;
+    // The header (tracks) is always parsed, even when resuming
+    const auto first_cluster = parse(0, true);
+    if (!first_cluster.has_value()) return m_result;
+    if (!select_track()) return m_result;
+    uint64_t resume_offset = 0;
+    if (load_journal(*first_cluster, resume_offset)) {
+      m_result.resumed = true;
+      m_console->debug("Resuming {} at {} ({} frames done)", m_in_file,
+                       resume_offset, m_samples.size());
+    } else if (!start_fresh()) {
+      return m_result;
+    } else {
+      resume_offset = *first_cluster;
+    }
+    const auto end = parse(resume_offset, false);
+    if (!end.has_value()) return m_result;
+    if (!checkpoint(*end)) return m_result;
+    finalize();
+    return m_result;
+  }
+
+ private:
+  bool fail(const std::string& error) {
+    m_result.error = error;
+    return false;
+  }
+  bool fail_errno(const std::string& what) {
+    return fail(fmt::format("{} ({})", what, strerror(errno)));
+  }
+
+  bool open_files() {
+    m_in_fd = open(m_in_file.c_str(), O_RDONLY | O_CLOEXEC);
+    if (m_in_fd < 0) return fail_errno("Cannot open " + m_in_file);
+    struct stat st {};
+    if (fstat(m_in_fd, &st) != 0) return fail_errno("Cannot stat input");
+    m_in_size = st.st_size;
+    posix_fadvise(m_in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    m_out_fd = open(m_part_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (m_out_fd < 0) return fail_errno("Cannot open " + m_part_file);
+    m_journal_fd =
+        open(m_journal_file.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (m_journal_fd < 0) return fail_errno("Cannot open " + m_journal_file);
+    return true;
+  }
+
+  // Parses elements starting at offset. If header_only, stops at the first
+  // cluster and returns its offset. Otherwise returns the offset where the
+  // data ends (end of file or the first incomplete element).
+  std::optional<uint64_t> parse(uint64_t offset, bool header_only) {
+    uint8_t hdr[HEADER_READ_SIZE];
+    while (true) {
+      const ssize_t n_read = pread(m_in_fd, hdr, sizeof(hdr), (off_t)offset);
+      if (n_read < 0) {
+        fail_errno("Cannot read input");
+        return std::nullopt;
+      }
+      uint64_t id = 0;
+      uint64_t size = 0;
+      bool unknown_size = false;
+      const int id_len = parse_vint(hdr, n_read, id, true);
+      const int size_len =
+          id_len == 0 ? 0
+                      : parse_vint(hdr + id_len, n_read - id_len, size, false,
+                                   &unknown_size);
+      if (id_len == 0 || id_len > 4 || size_len == 0) break;
+      const uint64_t data_offset = offset + id_len + size_len;
+      if (id == ID_CLUSTER) {
+        if (header_only) return offset;
+        if (m_bytes_since_checkpoint >= m_options.checkpoint_interval_bytes &&
+            !checkpoint(offset)) {
+          return std::nullopt;
+        }
+        if (m_options.should_cancel && m_options.should_cancel()) {
+          m_result.cancelled = true;
+          fail("Cancelled");
+          return std::nullopt;
+        }
+        m_cluster_timecode = 0;
+        m_new_chunk = true;
+      }
+      if (is_entered_master(id)) {
+        if (id == ID_TRACK_ENTRY) m_tracks.emplace_back();
+        if (id == ID_BLOCK_GROUP) m_block_group_sample = std::nullopt;
+        offset = data_offset;
+        continue;
+      }
+      if (unknown_size || data_offset + size > m_in_size) {
+        // Cut off (or corrupt) - keep everything up to here
+        if (offset < m_in_size) {
+          m_console->debug("{} ends with an incomplete element at {}",
+                           m_in_file, offset);
+        }
+        break;
+      }
+      if (id == ID_SIMPLE_BLOCK || id == ID_BLOCK) {
+        const size_t hdr_offset = data_offset - offset;
+        if (!handle_block(data_offset, size, hdr + hdr_offset,
+                          n_read - hdr_offset, id == ID_SIMPLE_BLOCK)) {
+          return std::nullopt;
+        }
+      } else if (id == ID_REFERENCE_BLOCK) {
+        // The block of this group references another frame
+        if (m_block_group_sample.has_value()) {
+          m_samples[*m_block_group_sample].is_keyframe = false;
+          m_pending_records[m_block_group_record].b = 0;
+        }
+      } else if (is_needed_leaf(id) && size <= MAX_READ_ELEMENT_SIZE) {
+        std::vector<uint8_t> data(size);
+        if (pread(m_in_fd, data.data(), size, (off_t)data_offset) !=
+            (ssize_t)size) {
+          break;
+        }
+        handle_leaf(id, data);
+      }
+      offset = data_offset + size;
+    }
+    if (header_only) {
+      fail("No video data in " + m_in_file);
+      return std::nullopt;
+    }
+    return offset;
+  }
+
+  static bool is_needed_leaf(uint64_t id) {
+    return id == ID_TIMECODE_SCALE || id == ID_TRACK_NUMBER ||
+           id == ID_TRACK_TYPE || id == ID_CODEC_ID ||
+           id == ID_CODEC_PRIVATE || id == ID_DEFAULT_DURATION ||
+           id == ID_PIXEL_WIDTH || id == ID_PIXEL_HEIGHT ||
+           id == ID_CLUSTER_TIMECODE;
+  }
+
+  void handle_leaf(uint64_t id, const std::vector<uint8_t>& data) {
+    if (id == ID_TIMECODE_SCALE) {
+      m_timecode_scale = std::max<uint64_t>(parse_uint(data), 1);
+      return;
+    }
+    if (id == ID_CLUSTER_TIMECODE) {
+      m_cluster_timecode = (int64_t)parse_uint(data);
+      return;
+    }
+    if (m_tracks.empty()) return;
+    auto& track = m_tracks.back();
+    switch (id) {
+      case ID_TRACK_NUMBER:
+        track.number = parse_uint(data);
+        break;
+      case ID_TRACK_TYPE:
+        track.type = parse_uint(data);
+        break;
+      case ID_CODEC_ID:
+        track.codec_id.assign(data.begin(), data.end());
+        // Strings might be zero-padded
+        track.codec_id.erase(track.codec_id.find_last_not_of('\0') + 1);
+        break;
+      case ID_CODEC_PRIVATE:
+        track.codec_private = data;
+        break;
+      case ID_DEFAULT_DURATION:
+        track.default_duration_ns = parse_uint(data);
+        break;
+      case ID_PIXEL_WIDTH:
+        track.width = parse_uint(data);
+        break;
+      case ID_PIXEL_HEIGHT:
+        track.height = parse_uint(data);
+        break;
+      default:
+        break;
+    }
+  }
+
+  bool select_track() {
+    for (const auto& track : m_tracks) {
+      if (track.is_supported()) {
+        m_track = track;
+        return true;
+      }
+    }
+    return fail("No H264 / H265 track in " + m_in_file);
+  }
+
+  bool handle_block(uint64_t data_offset, uint64_t size, const uint8_t* hdr,
+                    size_t hdr_len, bool is_simple_block) {
+    uint64_t track_number = 0;
+    const int n = parse_vint(hdr, hdr_len, track_number, false);
+    if (n == 0 || (size_t)n + 3 > hdr_len || size < (uint64_t)n + 3) {
+      return true;
+    }
+    if (track_number != m_track.number) return true;
+    const auto relative_timecode = (int16_t)((hdr[n] << 8) | hdr[n + 1]);
+    const uint8_t flags = hdr[n + 2];
+    if (flags & 0x06) return fail("Laced blocks are not supported");
+    // For BlockGroups, a ReferenceBlock (if any) follows the block
+    const bool is_keyframe = is_simple_block ? (flags & 0x80) != 0 : true;
+    const int64_t pts_ns =
+        (m_cluster_timecode + relative_timecode) * (int64_t)m_timecode_scale;
+    const uint64_t payload_offset = data_offset + n + 3;
+    const uint64_t payload_size = size - n - 3;
+    if (m_new_chunk) {
+      m_chunks.push_back({m_out_offset, (uint32_t)m_samples.size()});
+      m_pending_records.push_back(
+          {JournalRecord::CHUNK, 0, (int64_t)m_out_offset, 0});
+      m_new_chunk = false;
+    }
+    if (!copy(payload_offset, payload_size)) return false;
+    m_samples.push_back({pts_ns, (uint32_t)payload_size, is_keyframe});
+    m_pending_records.push_back({JournalRecord::SAMPLE, (uint32_t)payload_size,
+                                 pts_ns, is_keyframe ? 1u : 0u});
+    if (!is_simple_block) {
+      m_block_group_sample = m_samples.size() - 1;
+      m_block_group_record = m_pending_records.size() - 1;
+    }
+    return true;
+  }
+
+  // Copies in the kernel if possible, falls back to read / write otherwise
+  bool copy(uint64_t in_offset, uint64_t size) {
+    m_bytes_since_checkpoint += size;
+    m_result.n_bytes_copied += size;
+    while (size > 0 && m_use_copy_file_range) {
+      auto in_off = (off64_t)in_offset;
+      auto out_off = (off64_t)m_out_offset;
+      const ssize_t ret =
+          copy_file_range(m_in_fd, &in_off, m_out_fd, &out_off, size, 0);
+      if (ret < 0 && errno == EINTR) continue;
+      if (ret < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL ||
+                      errno == EOPNOTSUPP)) {
+        m_console->debug("copy_file_range not supported ({})",
+                         strerror(errno));
+        m_use_copy_file_range = false;
+        break;
+      }
+      if (ret <= 0) return fail_errno("Cannot copy to " + m_part_file);
+      in_offset += ret;
+      m_out_offset += ret;
+      size -= ret;
+    }
+    while (size > 0) {
+      if (m_copy_buffer.empty()) m_copy_buffer.resize(1024 * 1024);
+      const size_t n = std::min<uint64_t>(size, m_copy_buffer.size());
+      const ssize_t ret =
+          pread(m_in_fd, m_copy_buffer.data(), n, (off_t)in_offset);
+      if (ret <= 0) return fail_errno("Cannot read input");
+      if (!write_fully(m_out_fd, m_copy_buffer.data(), ret, m_out_offset)) {
+        return fail_errno("Cannot write " + m_part_file);
+      }
+      in_offset += ret;
+      m_out_offset += ret;
+      size -= ret;
+    }
+    return true;
+  }
+
+  // Makes everything up to here durable and resumable from input_offset
+  bool checkpoint(uint64_t input_offset) {
+    if (fdatasync(m_out_fd) != 0) return fail_errno("Cannot sync output");
+    m_pending_records.push_back({JournalRecord::CHECKPOINT, 0,
+                                 (int64_t)input_offset, m_out_offset});
+    const size_t size = m_pending_records.size() * sizeof(JournalRecord);
+    if (!write_fully(m_journal_fd,
+                     reinterpret_cast<const uint8_t*>(m_pending_records.data()),
+                     size, m_journal_size) ||
+        fdatasync(m_journal_fd) != 0) {
+      return fail_errno("Cannot write journal");
+    }
+    m_journal_size += size;
+    m_pending_records.clear();
+    m_block_group_sample = std::nullopt;
+    m_bytes_since_checkpoint = 0;
+    return true;
+  }
+
+  // Restores the state of the last checkpoint, returns false if there is
+  // nothing (valid) to resume from
+  bool load_journal(uint64_t first_cluster, uint64_t& resume_offset) {
+    struct stat st {};
+    if (fstat(m_journal_fd, &st) != 0) return false;
+    std::vector<JournalRecord> records(st.st_size / sizeof(JournalRecord));
+    const size_t size = records.size() * sizeof(JournalRecord);
+    if (records.empty() ||
+        pread(m_journal_fd, records.data(), size, 0) != (ssize_t)size) {
+      return false;
+    }
+    const auto& header = records[0];
+    if (header.type != JournalRecord::HEADER ||
+        header.size != JOURNAL_VERSION || header.b != JOURNAL_MAGIC ||
+        header.a != (int64_t)m_in_size) {
+      m_console->debug("Journal of {} does not match", m_in_file);
+      return false;
+    }
+    std::optional<size_t> last_checkpoint;
+    for (size_t i = 1; i < records.size(); i++) {
+      if (records[i].type == JournalRecord::CHECKPOINT) last_checkpoint = i;
+    }
+    if (!last_checkpoint.has_value()) return false;
+    const auto& checkpoint = records[*last_checkpoint];
+    if ((uint64_t)checkpoint.a < first_cluster ||
+        (uint64_t)checkpoint.a > m_in_size) {
+      return false;
+    }
+    for (size_t i = 1; i < *last_checkpoint; i++) {
+      const auto& record = records[i];
+      if (record.type == JournalRecord::CHUNK) {
+        m_chunks.push_back({(uint64_t)record.a, (uint32_t)m_samples.size()});
+      } else if (record.type == JournalRecord::SAMPLE) {
+        m_samples.push_back({record.a, record.size, record.b != 0});
+      }
+    }
+    m_out_offset = checkpoint.b;
+    m_journal_size = (*last_checkpoint + 1) * sizeof(JournalRecord);
+    // Drop whatever was written after the checkpoint
+    if (ftruncate(m_out_fd, (off_t)m_out_offset) != 0 ||
+        ftruncate(m_journal_fd, (off_t)m_journal_size) != 0) {
+      m_samples.clear();
+      m_chunks.clear();
+      return false;
+    }
+    resume_offset = checkpoint.a;
+    return true;
+  }
+
+  bool start_fresh() {
+    if (ftruncate(m_out_fd, 0) != 0 || ftruncate(m_journal_fd, 0) != 0) {
+      return fail_errno("Cannot truncate");
+    }
+    auto header = build_ftyp(m_track.is_h265());
+    // mdat with 64 bit size, written when done
+    const uint8_t mdat[16] = {0, 0, 0, 1, 'm', 'd', 'a', 't'};
+    header.insert(header.end(), mdat, mdat + sizeof(mdat));
+    if (!write_fully(m_out_fd, header.data(), header.size(), 0)) {
+      return fail_errno("Cannot write " + m_part_file);
+    }
+    m_out_offset = header.size();
+    const JournalRecord record{JournalRecord::HEADER, JOURNAL_VERSION,
+                               (int64_t)m_in_size, JOURNAL_MAGIC};
+    if (!write_fully(m_journal_fd, reinterpret_cast<const uint8_t*>(&record),
+                     sizeof(record), 0)) {
+      return fail_errno("Cannot write journal");
+    }
+    m_journal_size = sizeof(record);
+    return true;
+  }
+
+  void finalize() {
+    if (m_samples.empty()) {
+      fail("No frames in " + m_in_file);
+      return;
+    }
+    const uint64_t mdat_offset = build_ftyp(m_track.is_h265()).size();
+    uint8_t mdat_size[8];
+    const uint64_t size = m_out_offset - mdat_offset;
+    for (int i = 0; i < 8; i++) mdat_size[i] = size >> (56 - 8 * i);
+    const auto moov = build_moov();
+    if (!write_fully(m_out_fd, mdat_size, 8, mdat_offset + 8) ||
+        !write_fully(m_out_fd, moov.data(), moov.size(), m_out_offset) ||
+        ftruncate(m_out_fd, (off_t)(m_out_offset + moov.size())) != 0 ||
+        fdatasync(m_out_fd) != 0) {
+      fail_errno("Cannot write " + m_part_file);
+      return;
+    }
+    close(m_out_fd);
+    m_out_fd = -1;
+    if (rename(m_part_file.c_str(), m_out_file.c_str()) != 0) {
+      fail_errno("Cannot rename " + m_part_file);
+      return;
+    }
+    OHDFilesystemUtil::remove_if_existing(m_journal_file);
+    OHDFilesystemUtil::make_file_read_write_everyone(m_out_file);
+    m_result.success = true;
+  }
+
+  std::vector<uint8_t> build_moov() {
+    const size_t n = m_samples.size();
+    // Blocks are in decode order but carry presentation timestamps - the
+    // decode timestamps are the sorted presentation timestamps, shifted such
+    // that no frame is presented before it is decoded
+    std::vector<int64_t> pts(n);
+    for (size_t i = 0; i < n; i++) {
+      pts[i] = ns_to_mp4_timescale(m_samples[i].pts_ns);
+    }
+    std::vector<int64_t> dts = pts;
+    std::sort(dts.begin(), dts.end());
+    int64_t delay = 0;
+    for (size_t i = 0; i < n; i++) delay = std::max(delay, dts[i] - pts[i]);
+    const int64_t begin = dts[0] - delay;
+    for (auto& v : dts) v -= delay + begin;
+    for (auto& v : pts) v -= begin;
+    int64_t last_duration =
+        ns_to_mp4_timescale((int64_t)m_track.default_duration_ns);
+    if (last_duration <= 0) {
+      last_duration = n > 1 ? dts[n - 1] - dts[n - 2] : MP4_TIMESCALE / 30;
+    }
+    std::vector<uint32_t> durations(n);
+    for (size_t i = 0; i + 1 < n; i++) durations[i] = dts[i + 1] - dts[i];
+    durations[n - 1] = last_duration;
+    const uint64_t duration = dts[n - 1] + last_duration;
+    const uint64_t movie_duration = duration * MOVIE_TIMESCALE / MP4_TIMESCALE;
+    m_result.n_samples = n;
+    m_result.media_duration = std::chrono::milliseconds(movie_duration);
+
+    BoxWriter w;
+    const auto moov = w.begin("moov");
+    const auto mvhd = w.begin_full("mvhd", 0, 0);
+    w.zeros(8);
+    w.u32(MOVIE_TIMESCALE);
+    w.u32(movie_duration);
+    w.u32(0x00010000);
+    w.u16(0x0100);
+    w.zeros(10);
+    w.matrix();
+    w.zeros(24);
+    w.u32(2);
+    w.end(mvhd);
+    const auto trak = w.begin("trak");
+    const auto tkhd = w.begin_full("tkhd", 0, 3);
+    w.zeros(8);
+    w.u32(1);
+    w.u32(0);
+    w.u32(movie_duration);
+    w.zeros(16);
+    w.matrix();
+    w.u32(m_track.width << 16);
+    w.u32(m_track.height << 16);
+    w.end(tkhd);
+    const auto mdia = w.begin("mdia");
+    const auto mdhd = w.begin_full("mdhd", 0, 0);
+    w.zeros(8);
+    w.u32(MP4_TIMESCALE);
+    w.u32(duration);
+    w.u16(0x55C4);  // "und"
+    w.u16(0);
+    w.end(mdhd);
+    const auto hdlr = w.begin_full("hdlr", 0, 0);
+    w.u32(0);
+    w.fourcc("vide");
+    w.zeros(12);
+    w.bytes("VideoHandler", 13);
+    w.end(hdlr);
+    const auto minf = w.begin("minf");
+    const auto vmhd = w.begin_full("vmhd", 0, 1);
+    w.zeros(8);
+    w.end(vmhd);
+    const auto dinf = w.begin("dinf");
+    const auto dref = w.begin_full("dref", 0, 0);
+    w.u32(1);
+    w.end(w.begin_full("url ", 0, 1));
+    w.end(dref);
+    w.end(dinf);
+    const auto stbl = w.begin("stbl");
+    write_stsd(w);
+    write_stts(w, durations);
+    write_ctts(w, pts, dts);
+    write_stss(w);
+    write_stsc(w);
+    const auto stsz = w.begin_full("stsz", 0, 0);
+    w.u32(0);
+    w.u32(n);
+    for (const auto& sample : m_samples) w.u32(sample.size);
+    w.end(stsz);
+    write_stco(w);
+    w.end(stbl);
+    w.end(minf);
+    w.end(mdia);
+    w.end(trak);
+    w.end(moov);
+    return w.data();
+  }
+
+  void write_stsd(BoxWriter& w) {
+    const auto stsd = w.begin_full("stsd", 0, 0);
+    w.u32(1);
+    const auto entry = w.begin(m_track.is_h265() ? "hvc1" : "avc1");
+    w.zeros(6);
+    w.u16(1);  // data reference index
+    w.zeros(16);
+    w.u16(m_track.width);
+    w.u16(m_track.height);
+    w.u32(0x00480000);
+    w.u32(0x00480000);
+    w.u32(0);
+    w.u16(1);  // frame count
+    w.zeros(32);
+    w.u16(0x0018);
+    w.u16(0xFFFF);
+    // matroska stores the same decoder configuration record as mp4
+    const auto config = w.begin(m_track.is_h265() ? "hvcC" : "avcC");
+    w.bytes(m_track.codec_private.data(), m_track.codec_private.size());
+    w.end(config);
+    w.end(entry);
+    w.end(stsd);
+  }
+
+  static void write_stts(BoxWriter& w, const std::vector<uint32_t>& durations) {
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    for (const auto duration : durations) {
+      if (!entries.empty() && entries.back().second == duration) {
+        entries.back().first++;
+      } else {
+        entries.emplace_back(1, duration);
+      }
+    }
+    const auto stts = w.begin_full("stts", 0, 0);
+    w.u32(entries.size());
+    for (const auto& [count, duration] : entries) {
+      w.u32(count);
+      w.u32(duration);
+    }
+    w.end(stts);
+  }
+
+  static void write_ctts(BoxWriter& w, const std::vector<int64_t>& pts,
+                         const std::vector<int64_t>& dts) {
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    bool any_offset = false;
+    for (size_t i = 0; i < pts.size(); i++) {
+      const auto offset = (uint32_t)(pts[i] - dts[i]);
+      any_offset = any_offset || offset != 0;
+      if (!entries.empty() && entries.back().second == offset) {
+        entries.back().first++;
+      } else {
+        entries.emplace_back(1, offset);
+      }
+    }
+    // No B-frames (the usual case for OpenHD)
+    if (!any_offset) return;
+    const auto ctts = w.begin_full("ctts", 0, 0);
+    w.u32(entries.size());
+    for (const auto& [count, offset] : entries) {
+      w.u32(count);
+      w.u32(offset);
+    }
+    w.end(ctts);
+  }
+
+  void write_stss(BoxWriter& w) {
+    std::vector<uint32_t> keyframes;
+    for (size_t i = 0; i < m_samples.size(); i++) {
+      if (m_samples[i].is_keyframe) keyframes.push_back(i + 1);
+    }
+    m_result.n_keyframes = keyframes.size();
+    // Not present means every frame is a keyframe
+    if (keyframes.size() == m_samples.size()) return;
+    const auto stss = w.begin_full("stss", 0, 0);
+    w.u32(keyframes.size());
+    for (const auto index : keyframes) w.u32(index);
+    w.end(stss);
+  }
+
+  void write_stsc(BoxWriter& w) {
+    // (first chunk, samples per chunk)
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+      const uint32_t end = i + 1 < m_chunks.size()
+                               ? m_chunks[i + 1].first_sample
+                               : m_samples.size();
+      const uint32_t n_samples = end - m_chunks[i].first_sample;
+      if (entries.empty() || entries.back().second != n_samples) {
+        entries.emplace_back(i + 1, n_samples);
+      }
+    }
+    const auto stsc = w.begin_full("stsc", 0, 0);
+    w.u32(entries.size());
+    for (const auto& [first_chunk, n_samples] : entries) {
+      w.u32(first_chunk);
+      w.u32(n_samples);
+      w.u32(1);
+    }
+    w.end(stsc);
+  }
+
+  void write_stco(BoxWriter& w) {
+    const bool large = !m_chunks.empty() && m_chunks.back().offset > UINT32_MAX;
+    const auto box = w.begin_full(large ? "co64" : "stco", 0, 0);
+    w.u32(m_chunks.size());
+    for (const auto& chunk : m_chunks) {
+      if (large) {
+        w.u64(chunk.offset);
+      } else {
+        w.u32(chunk.offset);
+      }
+    }
+    w.end(box);
+  }
+
+ private:
+  const std::string m_in_file;
+  const std::string m_out_file;
+  const std::string m_part_file;
+  const std::string m_journal_file;
+  const RemuxOptions m_options;
+  std::shared_ptr<spdlog::logger> m_console;
+  RemuxResult m_result{};
+  int m_in_fd = -1;
+  int m_out_fd = -1;
+  int m_journal_fd = -1;
+  uint64_t m_in_size = 0;
+  // Parser state
+  std::vector<Track> m_tracks;
+  Track m_track{};
+  uint64_t m_timecode_scale = 1000000;
+  int64_t m_cluster_timecode = 0;
+  bool m_new_chunk = false;
+  std::optional<size_t> m_block_group_sample;
+  size_t m_block_group_record = 0;
+  // Output state
+  uint64_t m_out_offset = 0;
+  bool m_use_copy_file_range = true;
+  std::vector<uint8_t> m_copy_buffer;
+  std::vector<Sample> m_samples;
+  std::vector<Chunk> m_chunks;
+  // Not yet in the journal
+  std::vector<JournalRecord> m_pending_records;
+  uint64_t m_journal_size = 0;
+  uint64_t m_bytes_since_checkpoint = 0;
+};
+
+}  // namespace
+
+std::string RemuxResult::to_string() const {
+  if (!success) {
+    return fmt::format("RemuxResult[failed: {}{}]", error,
+                       resumed ? " resumed" : "");
+  }
+  return fmt::format(
+      "RemuxResult[frames:{} keyframes:{} {:.1f}s copied:{}MB{}]", n_samples,
+      n_keyframes, media_duration.count() / 1000.0,
+      n_bytes_copied / 1024 / 1024, resumed ? " resumed" : "");
+}
+
+RemuxResult remux_mkv_to_mp4(const std::string& in_file,
+                             const std::string& out_file,
+                             const RemuxOptions& options) {
+  Remuxer remuxer(in_file, out_file, options);
+  return remuxer.run();
+}
+
+}  // namespace openhd::video
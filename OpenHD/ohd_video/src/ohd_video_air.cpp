@@ -31,6 +31,7 @@
 #include "nalu/fragment_helper.h"
 #include "openhd_config.h"
 #include "openhd_reboot_util.h"
+#include "recording_remuxer.h"
 
 OHDVideoAir::OHDVideoAir(std::vector<XCamera> cameras,
                          std::shared_ptr<OHDLink> link)
@@ -39,6 +40,10 @@ OHDVideoAir::OHDVideoAir(std::vector<XCamera> cameras,
   assert(m_console);
   assert(!cameras.empty());
   m_console->debug("OHDVideo::OHDVideo()");
+  // In case any non-remuxed recordings exists (e.g. due to a openhd crash,
+  // unsafe shutdown,...). Done before any camera is started, such that we
+  // never pick up a file that is currently being recorded.
+  RecordingRemuxer::instance().remux_all_remaining_mkv_files_async();
   m_primary_video_forwarder = std::make_unique<openhd::UDPMultiForwarder>();
   m_secondary_video_forwarder = std::make_unique<openhd::UDPMultiForwarder>();
   m_audio_forwarder = std::make_unique<openhd::UDPMultiForwarder>();
@@ -95,9 +100,6 @@ OHDVideoAir::OHDVideoAir(std::vector<XCamera> cameras,
       [this](openhd::ExternalDevice external_device, bool connected) {
         start_stop_forwarding_external_device(external_device, connected);
       });
-  // In case any non-demuxed recordings exists (e.g. due to a openhd crash,
-  // unsafe shutdown,...)
-  // GstRecordingDemuxer::instance().demux_all_remaining_mkv_files_async();
   m_console->debug("OHDVideo::running");
 }
 
@@ -276,7 +278,9 @@ void OHDVideoAir::on_video_data(
     auto& forwarder = stream_index == 0 ? m_primary_video_forwarder
                                         : m_secondary_video_forwarder;
     for (auto& fragment : fragmented_video_frame.rtp_fragments) {
-      forwarder->forwardPacketViaUDP(fragment->data(), fragment->size());
+      struct iovec spans[openhd::VideoFragment::MAX_N_SPANS];
+      const int n_spans = fragment.get_spans(spans);
+      forwarder->forwardPacketViaUDP(spans, n_spans);
     }
     if (fragmented_video_frame.dirty_frame) {
       auto fragments =
@@ -25,8 +25,10 @@
 
 #include <utility>
 
+#include "air_recording_helper.hpp"
 #include "openhd_config.h"
 #include "openhd_util.h"
+#include "recording_remuxer.h"
 
 OHDVideoGround::OHDVideoGround(std::shared_ptr<OHDLink> link_handle)
     : m_link_handle(std::move(link_handle)) {
@@ -44,6 +46,27 @@ OHDVideoGround::OHDVideoGround(std::shared_ptr<OHDLink> link_handle)
     m_primary_video_forwarder->addForwarder("127.0.0.1", 5800);
     m_secondary_video_forwarder->addForwarder("127.0.0.1", 5801);
   }
+  if (openhd::load_config().NW_BATCH_VIDEO_FORWARDING) {
+    const auto max_delay = std::chrono::microseconds(
+        openhd::load_config().NW_BATCH_VIDEO_FORWARDING_MAX_DELAY_US);
+    m_primary_video_forwarder->enableBatching(max_delay);
+    m_secondary_video_forwarder->enableBatching(max_delay);
+  }
+  if (openhd::load_config().GEN_GROUND_RECORDING) {
+    // Recordings that were not remuxed yet (e.g. power loss)
+    RecordingRemuxer::instance().remux_all_remaining_mkv_files_async();
+    openhd::video::GroundRecorder::Config config{};
+    config.create_filename = [](int stream_index) {
+      return openhd::video::create_unused_recording_filename(
+          stream_index == 0 ? "_ground.mkv" : "_ground_secondary.mkv");
+    };
+    config.on_file_closed = [](const std::string& filename) {
+      RecordingRemuxer::instance().remux_mkv_file_async(filename);
+    };
+    m_ground_recorder =
+        std::make_unique<openhd::video::GroundRecorder>(std::move(config));
+    m_console->info("Ground recording enabled");
+  }
   if (m_link_handle) {
     m_link_handle->register_on_receive_video_data_cb(
         [this](int stream_index, const uint8_t* data, int data_len) {
@@ -71,6 +94,8 @@ OHDVideoGround::~OHDVideoGround() {
     m_link_handle->register_on_receive_video_data_cb(nullptr);
     m_link_handle->m_audio_data_rx_cb = nullptr;
   }
+  // Writes what is left and closes the recording(s)
+  m_ground_recorder.reset();
 }
 
 void OHDVideoGround::addForwarder(const std::string& client_addr) {
@@ -87,12 +112,22 @@ void OHDVideoGround::removeForwarder(const std::string& client_addr) {
 void OHDVideoGround::on_video_data(int stream_index, const uint8_t* data,
                                    int data_len) {
   // openhd::log::get_default()->debug("on_video_data {}",stream_index);
-  if (stream_index == 0) {
-    m_primary_video_forwarder->forwardPacketViaUDP(data, data_len);
-  } else if (stream_index == 1) {
-    m_secondary_video_forwarder->forwardPacketViaUDP(data, data_len);
-  } else {
+  if (!(stream_index == 0 || stream_index == 1)) {
     openhd::log::get_default()->debug("Invalid stream index {}", stream_index);
+    return;
+  }
+  auto& forwarder = stream_index == 0 ? m_primary_video_forwarder
+                                      : m_secondary_video_forwarder;
+  forwarder->forwardPacketViaUDP(data, data_len);
+  // With batching enabled, the last fragment of a frame (RTP marker bit set)
+  // pushes out the whole frame - the decoder cannot do anything with it until
+  // then anyways.
+  if (data_len >= 2 && (data[1] & 0x80) != 0) {
+    forwarder->flushBatch();
+  }
+  // After forwarding, the recorder only takes a copy
+  if (m_ground_recorder) {
+    m_ground_recorder->on_rtp_packet(stream_index, data, data_len);
   }
 }
 
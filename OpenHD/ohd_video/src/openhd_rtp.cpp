@@ -23,181 +23,279 @@
 
 #include "openhd_rtp.h"
 
+#include <algorithm>
+#include <cstring>
+#include <random>
 #include <utility>
 
-#include "nalu/CodecConfigFinder.hpp"
-#include "nalu/fragment_helper.h"
-#include "nalu/nalu_helper.h"
-#include "openhd_util_time.h"
-#include "rtp-profile.h"
-#include "rtp_eof_helper.h"
-
-static void* rtp_alloc(void* /*param*/, int bytes) {
-  static uint8_t buffer[2 * 1024 * 1024 + 4] = {
-      0,
-      0,
-      0,
-      1,
-  };
-  assert(bytes <= sizeof(buffer) - 4);
-  return buffer + 4;
-}
+// Look into the rtp rfc(s) for more details:
+// RFC 3550 (RTP), RFC 6184 (H264 payload), RFC 7798 (H265 payload)
+static constexpr std::size_t RTP_HEADER_SIZE = 12;
+// Same as rtph264pay / rtph265pay
+static constexpr uint8_t RTP_PAYLOAD_TYPE = 96;
+static constexpr uint32_t RTP_CLOCK_RATE = 90000;
+static constexpr uint8_t H264_STAP_A = 24;
+static constexpr uint8_t H264_FU_A = 28;
+static constexpr uint8_t H265_AP = 48;
+static constexpr uint8_t H265_FU = 49;
+
+namespace {
 
-static void rtp_free(void* /*param*/, void* /*packet*/) {}
+enum class NalKind { VPS, SPS, PPS, DISCARD, KEYFRAME, OTHER };
 
-static int rtp_encode_packet(void* param, const void* packet, int bytes,
-                             uint32_t timestamp, int flags) {
-  auto self = (openhd::RTPHelper*)param;
-  // openhd::log::get_default()->debug(" rtp_encode_packet {} {}
-  // {}",bytes,timestamp,flags);
-  self->on_new_rtp_fragment((const uint8_t*)packet, bytes, timestamp, flags);
-  // TODO
-  return 0;
+NalKind get_nal_kind(const uint8_t* nal, bool is_h265) {
+  if (is_h265) {
+    const uint8_t type = (nal[0] >> 1) & 0x3F;
+    if (type == 32) return NalKind::VPS;
+    if (type == 33) return NalKind::SPS;
+    if (type == 34) return NalKind::PPS;
+    // AUD, SEI (prefix / suffix)
+    if (type == 35 || type == 39 || type == 40) return NalKind::DISCARD;
+    // IRAP (BLA, IDR, CRA)
+    if (type >= 16 && type <= 21) return NalKind::KEYFRAME;
+    return NalKind::OTHER;
+  }
+  const uint8_t type = nal[0] & 0x1F;
+  if (type == 7) return NalKind::SPS;
+  if (type == 8) return NalKind::PPS;
+  // SEI, AUD (AUDs are written manually on the rx)
+  if (type == 6 || type == 9) return NalKind::DISCARD;
+  if (type == 5) return NalKind::KEYFRAME;
+  return NalKind::OTHER;
 }
 
-openhd::RTPHelper::RTPHelper(bool is_h265) : m_is_h265(is_h265) {
-  m_console = openhd::log::create_or_get("RTPHelp");
+void write_u16(uint8_t* dst, uint16_t value) {
+  dst[0] = value >> 8;
+  dst[1] = value & 0xFF;
+}
 
-  m_handler.alloc = rtp_alloc;
-  m_handler.free = rtp_free;
-  m_handler.packet = rtp_encode_packet;
+void write_u32(uint8_t* dst, uint32_t value) {
+  write_u16(dst, value >> 16);
+  write_u16(dst + 2, value & 0xFFFF);
+}
 
-  int payload = 96;  // WEIRD RTP_PAYLOAD_H264
-  const char* encoding = "H264";
-  if (m_is_h265) {
-    encoding = "H265";
-  }
-  uint16_t seq = 0;
-  uint32_t ssrc = 0;
+}  // namespace
 
-  encoder =
-      rtp_payload_encode_create(payload, encoding, seq, ssrc, &m_handler, this);
-  assert(encoder);
+openhd::RTPHelper::RTPHelper(Config config, ON_ENCODE_FRAME_CB out_cb)
+    : m_config(config),
+      m_out_cb(std::move(out_cb)),
+      m_ssrc(std::random_device{}()) {
+  m_console = openhd::log::create_or_get("RTPHelper");
+  // Enough for the usual number of slices / fragments of a frame, grows
+  // (once) for bigger ones
+  m_nalus.reserve(16);
+  m_fragments.reserve(256);
 }
 
-openhd::RTPHelper::~RTPHelper() { rtp_payload_encode_destroy(encoder); }
-
-void openhd::RTPHelper::feed_multiple_nalu(const uint8_t* data, int data_len) {
-  int offset = 0;
-  while (offset < data_len) {
-    int nalu_len = find_next_nal(&data[offset], data_len);
-    on_new_split_nalu(&data[offset], nalu_len);
-    offset += nalu_len;
+const uint8_t* openhd::RTPHelper::find_start_code(const uint8_t* begin,
+                                                  const uint8_t* end) {
+  // memchr for the (rare) 0x01, then check the two bytes in front of it
+  const uint8_t* p = begin + 2;
+  while (p < end) {
+    p = static_cast<const uint8_t*>(std::memchr(p, 0x01, end - p));
+    if (p == nullptr) return end;
+    if (p[-1] == 0 && p[-2] == 0) return p - 2;
+    p++;
   }
+  return end;
 }
 
-void openhd::RTPHelper::feed_nalu(const uint8_t* data, int data_len) {
-  // m_console->debug("feed_nalu {}", data_len);
-  int32_t timestamp = 0;
-  timestamp = openhd::util::steady_clock_time_epoch_ms();
-  rtp_payload_encode_input(encoder, data, data_len, timestamp);
-  // all frames processed
-  // m_console->debug("Done, got {} fragments", m_frame_fragments.size());
-  if (m_out_cb) {
-    m_out_cb(m_frame_fragments);
+void openhd::RTPHelper::feed_access_unit(const uint8_t* data,
+                                         size_t data_len) {
+  const auto creation_time = std::chrono::steady_clock::now();
+  const uint8_t* end = data + data_len;
+  m_nalus.clear();
+  bool is_keyframe = false;
+  const uint8_t* start_code = find_start_code(data, end);
+  while (start_code != end) {
+    const uint8_t* nal_begin = start_code + 3;
+    start_code = find_start_code(nal_begin, end);
+    // Trailing zero bytes (e.g. the first byte of a 4 byte start code)
+    const uint8_t* nal_end = start_code;
+    while (nal_end > nal_begin && nal_end[-1] == 0) nal_end--;
+    const Nalu nalu{nal_begin, (size_t)(nal_end - nal_begin)};
+    if (nalu.size < (m_config.is_h265 ? 2u : 1u)) continue;
+    switch (get_nal_kind(nal_begin, m_config.is_h265)) {
+      case NalKind::VPS:
+        on_parameter_set(m_vps, nalu);
+        break;
+      case NalKind::SPS:
+        on_parameter_set(m_sps, nalu);
+        break;
+      case NalKind::PPS:
+        on_parameter_set(m_pps, nalu);
+        break;
+      case NalKind::DISCARD:
+        break;
+      case NalKind::KEYFRAME:
+        is_keyframe = true;
+        m_nalus.push_back(nalu);
+        break;
+      case NalKind::OTHER:
+        m_nalus.push_back(nalu);
+        break;
+    }
+  }
+  if (m_nalus.empty()) return;
+  // Wait until we have codec config
+  if (m_sps.empty() || m_pps.empty() || (m_config.is_h265 && m_vps.empty())) {
+    return;
+  }
+  const auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          creation_time.time_since_epoch())
+                          .count();
+  const auto timestamp = (uint32_t)(now_us * (RTP_CLOCK_RATE / 1000) / 1000);
+  // Two access units must never share a timestamp
+  if (m_has_timestamp && (int32_t)(timestamp - m_timestamp) <= 0) {
+    m_timestamp++;
+  } else {
+    m_timestamp = timestamp;
+  }
+  m_has_timestamp = true;
+  if (is_keyframe ||
+      creation_time - m_last_parameter_sets_sent >= std::chrono::seconds(1)) {
+    m_last_parameter_sets_sent = creation_time;
+    packetize_parameter_sets();
+  }
+  m_curr_creation_time = creation_time;
+  m_curr_is_keyframe = is_keyframe;
+  m_curr_part_index = 0;
+  for (size_t i = 0; i < m_nalus.size(); i++) {
+    const bool is_last = i == m_nalus.size() - 1;
+    packetize_nalu(m_nalus[i], is_last);
+    if (!is_last) maybe_forward_part(true);
   }
-  m_frame_fragments.clear();
+  forward_part(true);
 }
 
-void openhd::RTPHelper::on_new_rtp_fragment(const uint8_t* data, int data_len,
-                                            uint32_t timestamp, int last) {
-  // m_console->debug("on_new_rtp_fragment {} ts:{} last:{}", data_len,
-  // timestamp,
-  //                  last);
-  auto shared = std::make_shared<std::vector<uint8_t>>(data, data + data_len);
-  m_frame_fragments.emplace_back(shared);
+void openhd::RTPHelper::maybe_forward_part(const bool is_slice_end) {
+  if (m_config.early_tx <= 0 || m_fragments.empty()) return;
+  const bool n_fragments_reached =
+      m_config.early_tx > 1 &&
+      m_fragments.size() >= (size_t)m_config.early_tx;
+  if (is_slice_end || n_fragments_reached) {
+    forward_part(false);
+  }
 }
 
-void openhd::RTPHelper::set_out_cb(openhd::RTPHelper::OUT_CB cb) {
-  m_out_cb = std::move(cb);
+void openhd::RTPHelper::forward_part(const bool is_last_part) {
+  if (m_out_cb) {
+    auto frame = openhd::FragmentedVideoFrame{std::move(m_fragments),
+                                              m_curr_creation_time,
+                                              m_enable_ultra_secure_encryption,
+                                              nullptr,
+                                              m_config.uses_intra_refresh,
+                                              m_curr_is_keyframe,
+                                              m_curr_part_index,
+                                              is_last_part};
+    m_out_cb(m_config.stream_index, frame);
+    // Take the buffer back (the consumer holds references to the fragments
+    // it needs), such that it doesn't have to be re-allocated
+    m_fragments = std::move(frame.rtp_fragments);
+  }
+  m_fragments.clear();
+  m_curr_part_index++;
 }
 
-void openhd::RTPHelper::on_new_split_nalu(const uint8_t* data, int data_len) {
-  NALU nalu(data, data_len);
-  // m_console->debug("Got new NAL {}
-  // {}",data_len,nalu.get_nal_unit_type_as_string()); if(nalu.is_sei())return;
-  if (m_config_finder.all_config_available(m_is_h265)) {
-    if (nalu.is_config()) {
-      if (m_config_finder.check_is_still_same_config_data(nalu)) {
-        // we can discard this NAL
-      } else {
-        m_config_finder.reset();
-        m_config_finder.save_if_config(nalu);
-      }
-    } else {
-      if (nalu.is_sei() || nalu.is_aud()) {
-        // We can discard (AUDs are written manually on the rx)
-      } else {
-        on_new_nalu_frame(data, data_len);
-      }
-    }
-  } else {
-    m_config_finder.save_if_config(nalu);
+void openhd::RTPHelper::on_parameter_set(std::vector<uint8_t>& cache,
+                                         const Nalu& nalu) {
+  if (cache.size() == nalu.size &&
+      std::memcmp(cache.data(), nalu.data, nalu.size) == 0) {
+    return;
   }
+  m_console->debug("Parameter set changed, size:{}", nalu.size);
+  // assign re-uses the buffer if it is big enough
+  cache.assign(nalu.data, nalu.data + nalu.size);
+  // Make sure the rx gets the new one right away
+  m_last_parameter_sets_sent = {};
 }
 
-void openhd::RTPHelper::on_new_nalu_frame(const uint8_t* data, int data_len) {
-  // Wait until we have codec config
-  if (!m_config_finder.all_config_available(m_is_h265)) {
+void openhd::RTPHelper::packetize_parameter_sets() {
+  const size_t max_payload = m_config.mtu - RTP_HEADER_SIZE;
+  const size_t payload_hdr_size = m_config.is_h265 ? 2 : 1;
+  size_t payload_size = payload_hdr_size;
+  if (m_config.is_h265) payload_size += 2 + m_vps.size();
+  payload_size += 2 + m_sps.size() + 2 + m_pps.size();
+  if (payload_size > max_payload) {
+    // Unusually big, send them one by one
+    if (m_config.is_h265) packetize_nalu({m_vps.data(), m_vps.size()}, false);
+    packetize_nalu({m_sps.data(), m_sps.size()}, false);
+    packetize_nalu({m_pps.data(), m_pps.size()}, false);
     return;
   }
-  const auto elapsed_last_config =
-      std::chrono::steady_clock::now() - m_last_codec_config_send_ts;
-  if (elapsed_last_config >= std::chrono::seconds(1)) {
-    m_last_codec_config_send_ts = std::chrono::steady_clock::now();
-    auto config = m_config_finder.get_config_data(m_is_h265);
-    feed_nalu(config->data(), config->size());
+  uint8_t* payload;
+  m_fragments.push_back(create_packet(payload_size, false, payload));
+  if (m_config.is_h265) {
+    // Aggregation packet, F / layer id / TID taken from the VPS
+    payload[0] = (m_vps[0] & 0x81) | (H265_AP << 1);
+    payload[1] = m_vps[1];
+  } else {
+    // STAP-A, F and NRI taken from the SPS
+    payload[0] = (m_sps[0] & 0xE0) | H264_STAP_A;
   }
-  feed_nalu(data, data_len);
-}
-
-openhd::RTPFragmentBuffer::RTPFragmentBuffer() {
-  m_console = openhd::log::create_or_get("RTPFragmentBuffer");
+  size_t offset = payload_hdr_size;
+  auto append = [&](const std::vector<uint8_t>& nal) {
+    write_u16(payload + offset, nal.size());
+    std::memcpy(payload + offset + 2, nal.data(), nal.size());
+    offset += 2 + nal.size();
+  };
+  if (m_config.is_h265) append(m_vps);
+  append(m_sps);
+  append(m_pps);
 }
 
-void openhd::RTPFragmentBuffer::buffer_and_forward(
-    std::shared_ptr<std::vector<uint8_t>> fragment, uint64_t dts) {
-  m_frame_fragments.push_back(fragment);
-  openhd::rtp_eof_helper::RTPFragmentInfo info{};
-  if (m_is_h265) {
-    info = openhd::rtp_eof_helper::h265_more_info(fragment->data(),
-                                                  fragment->size());
-  } else {
-    info = openhd::rtp_eof_helper::h264_more_info(fragment->data(),
-                                                  fragment->size());
+void openhd::RTPHelper::packetize_nalu(const Nalu& nalu, const bool is_last) {
+  const size_t max_payload = m_config.mtu - RTP_HEADER_SIZE;
+  uint8_t* payload;
+  if (nalu.size <= max_payload) {
+    // Single NAL unit packet
+    m_fragments.push_back(create_packet(nalu.size, is_last, payload));
+    std::memcpy(payload, nalu.data, nalu.size);
+    return;
   }
-  if (info.is_fu_start) {
-    if (is_idr_frame(info.nal_unit_type, m_is_h265)) {
-      m_last_fu_s_idr = true;
+  // Fragmentation unit(s), the NAL header is replaced by the payload header
+  // and the fu header
+  const size_t nal_hdr_size = m_config.is_h265 ? 2 : 1;
+  const size_t fu_hdr_size = nal_hdr_size + 1;
+  const size_t max_chunk = max_payload - fu_hdr_size;
+  const uint8_t nal_type = m_config.is_h265 ? (nalu.data[0] >> 1) & 0x3F
+                                            : nalu.data[0] & 0x1F;
+  const uint8_t* chunk = nalu.data + nal_hdr_size;
+  size_t remaining = nalu.size - nal_hdr_size;
+  bool first = true;
+  while (remaining > 0) {
+    const size_t chunk_size = std::min(remaining, max_chunk);
+    const bool last_chunk = chunk_size == remaining;
+    m_fragments.push_back(create_packet(fu_hdr_size + chunk_size,
+                                        is_last && last_chunk, payload));
+    if (m_config.is_h265) {
+      payload[0] = (nalu.data[0] & 0x81) | (H265_FU << 1);
+      payload[1] = nalu.data[1];
     } else {
-      m_last_fu_s_idr = false;
+      payload[0] = (nalu.data[0] & 0xE0) | H264_FU_A;
     }
-  }
-  // m_console->debug("Fragment {} start:{} end:{}
-  // type:{}",m_frame_fragments.size(),
-  //                  OHDUtil::yes_or_no(info.is_fu_start),
-  //                  OHDUtil::yes_or_no(info.is_fu_end),
-  //                  x_get_nal_unit_type_as_string(info.nal_unit_type,is_h265));
-  bool is_last_fragment_of_frame = info.is_fu_end;
-  if (m_frame_fragments.size() > 500) {
-    // Most likely something wrong with the "find end of frame" workaround
-    m_console->debug("No end of frame found after 1000 fragments");
-    is_last_fragment_of_frame = true;
-  }
-  if (is_last_fragment_of_frame) {
-    on_new_rtp_fragmented_frame();
-    m_frame_fragments.resize(0);
-    m_last_fu_s_idr = false;
+    payload[nal_hdr_size] =
+        (first ? 0x80 : 0) | (last_chunk ? 0x40 : 0) | nal_type;
+    std::memcpy(payload + fu_hdr_size, chunk, chunk_size);
+    chunk += chunk_size;
+    remaining -= chunk_size;
+    first = false;
+    // The end of the access unit is always forwarded by the caller
+    if (!(is_last && last_chunk)) maybe_forward_part(false);
   }
 }
 
-void openhd::RTPFragmentBuffer::on_new_rtp_fragmented_frame() {
-  const bool is_intra_frame = m_last_fu_s_idr;
-  auto frame = openhd::FragmentedVideoFrame{m_frame_fragments,
-                                            std::chrono::steady_clock::now(),
-                                            m_enable_ultra_secure_encryption,
-                                            nullptr,
-                                            m_uses_intra_refresh,
-                                            is_intra_frame};
-  // m_console->debug("{}",frame.to_string());
+openhd::VideoFragment openhd::RTPHelper::create_packet(size_t payload_size,
+                                                       const bool marker,
+                                                       uint8_t*& payload) {
+  uint8_t* data;
+  auto ret = VideoFragment::pooled_create(RTP_HEADER_SIZE + payload_size, data);
+  // V=2, no padding, extension or CSRC(s)
+  data[0] = 0x80;
+  data[1] = (marker ? 0x80 : 0) | RTP_PAYLOAD_TYPE;
+  write_u16(data + 2, m_seq++);
+  write_u32(data + 4, m_timestamp);
+  write_u32(data + 8, m_ssrc);
+  payload = data + RTP_HEADER_SIZE;
+  return ret;
 }
@@ -0,0 +1,175 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "recording_remuxer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "air_recording_helper.hpp"
+#include "mkv_to_mp4_remuxer.h"
+#include "openhd_spdlog_include.h"
+#include "openhd_util.h"
+#include "openhd_util_filesystem.h"
+
+// Returns all files ending in .mkv in the video recordings directory
+static std::vector<std::string> get_all_mkv_video_files() {
+  const auto video_path = std::string(getVideoPath());
+  if (!OHDFilesystemUtil::exists(video_path)) return {};
+  const auto files =
+      OHDFilesystemUtil::getAllEntriesFullPathInDirectory(video_path);
+  std::vector<std::string> files_to_convert{};
+  for (const auto& file : files) {
+    if (OHDUtil::endsWith(file, ".mkv")) {
+      files_to_convert.push_back(file);
+    }
+  }
+  std::sort(files_to_convert.begin(), files_to_convert.end());
+  return files_to_convert;
+}
+
+// Remuxing is never urgent - only use cpu / disk time nobody else wants
+static void set_current_thread_idle_priority(
+    const std::shared_ptr<spdlog::logger>& console) {
+  sched_param param{};
+  param.sched_priority = 0;
+  if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+    console->debug("Cannot set SCHED_IDLE");
+  }
+  static constexpr int IOPRIO_WHO_PROCESS = 1;
+  static constexpr int IOPRIO_CLASS_IDLE = 3;
+  static constexpr int IOPRIO_CLASS_SHIFT = 13;
+  if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, (int)syscall(SYS_gettid),
+              IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+    console->debug("Cannot set idle io priority");
+  }
+}
+
+RecordingRemuxer::RecordingRemuxer() {
+  m_console = openhd::log::create_or_get("remux");
+}
+
+RecordingRemuxer::~RecordingRemuxer() {
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_terminate = true;
+    m_cancel = true;
+  }
+  m_cv.notify_one();
+  if (m_thread) {
+    m_console->debug("Waiting for remuxing to end");
+    m_thread->join();
+    m_thread = nullptr;
+  }
+}
+
+RecordingRemuxer& RecordingRemuxer::instance() {
+  static RecordingRemuxer remuxer;
+  return remuxer;
+}
+
+void RecordingRemuxer::remux_all_remaining_mkv_files_async() {
+  for (const auto& file : get_all_mkv_video_files()) {
+    remux_mkv_file_async(file);
+  }
+}
+
+bool RecordingRemuxer::remux_mkv_file_async(const std::string& filename) {
+  if (!OHDUtil::endsWith(filename, ".mkv")) {
+    m_console->debug("{} not a .mkv file", filename);
+    return false;
+  }
+  std::lock_guard<std::mutex> guard(m_mutex);
+  if (m_terminate) return false;
+  if (filename == m_current ||
+      std::find(m_queue.begin(), m_queue.end(), filename) != m_queue.end()) {
+    m_console->debug("Already remuxing {}", filename);
+    return false;
+  }
+  if (m_queue.size() >= MAX_QUEUE_SIZE) {
+    m_console->warn("Remux queue full, not queueing {}", filename);
+    return false;
+  }
+  m_queue.push_back(filename);
+  if (!m_thread) {
+    m_thread = std::make_unique<std::thread>(&RecordingRemuxer::loop, this);
+  }
+  m_cv.notify_one();
+  return true;
+}
+
+void RecordingRemuxer::loop() {
+  set_current_thread_idle_priority(m_console);
+  while (true) {
+    std::string filename;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_current.clear();
+      m_cv.wait(lock, [this] { return m_terminate || !m_queue.empty(); });
+      if (m_terminate) return;
+      filename = m_queue.front();
+      m_queue.pop_front();
+      m_current = filename;
+    }
+    remux(filename);
+  }
+}
+
+void RecordingRemuxer::remux(const std::string& filename) {
+  if (!OHDFilesystemUtil::exists(filename)) return;
+  const std::string out_file = filename.substr(0, filename.size() - 4) + ".mp4";
+  if (OHDFilesystemUtil::exists(out_file) &&
+      !OHDFilesystemUtil::exists(out_file + ".part")) {
+    // Interrupted right after the .mp4 was completed
+    m_console->debug("{} already exists", out_file);
+    OHDFilesystemUtil::remove_if_existing(filename);
+    return;
+  }
+  m_console->debug("Remuxing {}", filename);
+  const auto begin = std::chrono::steady_clock::now();
+  openhd::video::RemuxOptions options{};
+  options.should_cancel = [this]() { return m_cancel.load(); };
+  const auto result =
+      openhd::video::remux_mkv_to_mp4(filename, out_file, options);
+  const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - begin)
+                              .count();
+  if (result.success) {
+    // Now we can safely delete the old file
+    OHDFilesystemUtil::remove_if_existing(filename);
+    m_console->info("Remuxed {} in {}ms {}", out_file, elapsed_ms,
+                    result.to_string());
+  } else if (result.cancelled) {
+    m_console->debug("Remuxing {} interrupted", filename);
+  } else {
+    m_console->warn("Cannot remux {} {}", filename, result.to_string());
+    OHDFilesystemUtil::remove_if_existing(out_file + ".part");
+    OHDFilesystemUtil::remove_if_existing(out_file + ".journal");
+  }
+}
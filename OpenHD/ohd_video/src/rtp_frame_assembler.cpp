@@ -0,0 +1,200 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include "rtp_frame_assembler.h"
+
+#include <utility>
+
+#include "nalu/NALU.hpp"
+
+// Look into the rtp rfc(s) for more details:
+// RFC 3550 (RTP), RFC 6184 (H264 payload), RFC 7798 (H265 payload)
+static constexpr std::size_t RTP_HEADER_SIZE = 12;
+static constexpr uint8_t H264_STAP_A = 24;
+static constexpr uint8_t H264_FU_A = 28;
+static constexpr uint8_t H265_AP = 48;
+static constexpr uint8_t H265_FU = 49;
+
+// Video coding layer (slice data) NAL unit types
+static constexpr bool is_vcl_nal_unit_type(uint8_t type, bool is_h265) {
+  return is_h265 ? type <= 31 : type >= 1 && type <= 5;
+}
+
+// Returns the offset of the rtp payload, 0 if this is not a valid rtp packet
+static std::size_t get_rtp_payload_offset(const uint8_t* data,
+                                          std::size_t data_len) {
+  if (data_len < RTP_HEADER_SIZE || (data[0] >> 6) != 2) return 0;
+  // CSRC(s)
+  std::size_t offset = RTP_HEADER_SIZE + (data[0] & 0x0F) * 4;
+  // header extension
+  if (data[0] & 0x10) {
+    if (data_len < offset + 4) return 0;
+    offset += 4 + ((data[offset + 2] << 8) | data[offset + 3]) * 4;
+  }
+  return offset < data_len ? offset : 0;
+}
+
+// Iterates over the NALUs of a STAP-A / AP payload, starting at offset
+static bool aggregation_contains_idr(const uint8_t* payload,
+                                     std::size_t payload_len,
+                                     std::size_t offset, bool is_h265) {
+  while (offset + 2 < payload_len) {
+    const std::size_t nal_size = (payload[offset] << 8) | payload[offset + 1];
+    offset += 2;
+    if (nal_size == 0 || offset + nal_size > payload_len) break;
+    if (is_idr_frame(payload[offset], is_h265)) return true;
+    offset += nal_size;
+  }
+  return false;
+}
+
+template <bool IS_H265>
+openhd::RTPFrameAssembler::FragmentInfo openhd::RTPFrameAssembler::parse(
+    const uint8_t* data, std::size_t data_len) {
+  FragmentInfo info{};
+  const std::size_t offset = get_rtp_payload_offset(data, data_len);
+  if (offset == 0) return info;
+  const uint8_t* payload = data + offset;
+  const std::size_t payload_len = data_len - offset;
+  // h265 has a 2 byte payload header, h264 a 1 byte one
+  constexpr std::size_t PAYLOAD_HDR_SIZE = IS_H265 ? 2 : 1;
+  if (payload_len < PAYLOAD_HDR_SIZE) return info;
+  info.valid = true;
+  info.marker = (data[1] & 0x80) != 0;
+  const uint8_t type = IS_H265 ? (payload[0] >> 1) & 0x3F : payload[0] & 0x1F;
+  if (type == (IS_H265 ? H265_FU : H264_FU_A)) {
+    if (payload_len < PAYLOAD_HDR_SIZE + 1) {
+      info.valid = false;
+      return info;
+    }
+    const uint8_t fu_header = payload[PAYLOAD_HDR_SIZE];
+    const bool fu_start = (fu_header & 0x80) != 0;
+    info.is_fu_end = (fu_header & 0x40) != 0;
+    const uint8_t nal_type = IS_H265 ? fu_header & 0x3F : fu_header & 0x1F;
+    info.is_slice_end =
+        info.is_fu_end && is_vcl_nal_unit_type(nal_type, IS_H265);
+    // Reconstruct the (first byte of the) NAL header
+    const uint8_t nal_header = IS_H265 ? nal_type << 1 : nal_type;
+    info.contains_idr = fu_start && is_idr_frame(nal_header, IS_H265);
+  } else if (type == (IS_H265 ? H265_AP : H264_STAP_A)) {
+    info.is_aggregation = true;
+    info.contains_idr = aggregation_contains_idr(payload, payload_len,
+                                                 PAYLOAD_HDR_SIZE, IS_H265);
+  } else {
+    // single NAL unit packet
+    info.is_slice_end = is_vcl_nal_unit_type(type, IS_H265);
+    info.contains_idr = is_idr_frame(payload[0], IS_H265);
+  }
+  return info;
+}
+
+template openhd::RTPFrameAssembler::FragmentInfo
+openhd::RTPFrameAssembler::parse<false>(const uint8_t*, std::size_t);
+template openhd::RTPFrameAssembler::FragmentInfo
+openhd::RTPFrameAssembler::parse<true>(const uint8_t*, std::size_t);
+
+openhd::RTPFrameAssembler::RTPFrameAssembler(Config config,
+                                             ON_ENCODE_FRAME_CB out_cb)
+    : m_config(config),
+      m_out_cb(std::move(out_cb)),
+      m_parse(config.is_h265 ? &parse<true> : &parse<false>) {
+  m_console = openhd::log::create_or_get("RTPFrameAssembler");
+}
+
+openhd::RTPFrameAssembler::FragmentInfo
+openhd::RTPFrameAssembler::parse_fragment(const VideoFragment& fragment) const {
+  if (fragment.is_contiguous()) {
+    return m_parse(fragment.data(), fragment.size());
+  }
+  // E.g. rtp header and payload in different gstreamer memories - only the
+  // beginning is copied, unless we need more
+  uint8_t buff[FragmentPool::SLOT_SIZE];
+  size_t len = fragment.copy_to(buff, PARSE_PREFIX_SIZE);
+  FragmentInfo info = m_parse(buff, len);
+  if ((!info.valid || info.is_aggregation) && fragment.size() > len) {
+    len = fragment.copy_to(buff, sizeof(buff));
+    info = m_parse(buff, len);
+  }
+  return info;
+}
+
+void openhd::RTPFrameAssembler::add_fragment(VideoFragment fragment) {
+  const FragmentInfo info = parse_fragment(fragment);
+  if (m_frame_fragments.empty() && m_curr_part_index == 0) {
+    m_curr_frame_begin = std::chrono::steady_clock::now();
+  }
+  m_frame_fragments.push_back(std::move(fragment));
+  m_curr_frame_is_idr |= info.contains_idr;
+  if (info.marker && !m_marker_seen) {
+    m_marker_seen = true;
+    m_console->debug("Using rtp marker bit for end of frame");
+  }
+  bool is_last_fragment_of_frame =
+      m_marker_seen ? info.marker : info.is_fu_end;
+  if (m_frame_fragments.size() >= MAX_N_FRAGMENTS_PER_FRAME) {
+    m_console->debug("No end of frame found after {} fragments",
+                     m_frame_fragments.size());
+    is_last_fragment_of_frame = true;
+  }
+  if (is_last_fragment_of_frame) {
+    forward_part(true);
+  } else if (m_config.early_tx > 0) {
+    const bool n_fragments_reached =
+        m_config.early_tx > 1 &&
+        m_frame_fragments.size() >= (size_t)m_config.early_tx;
+    if (info.is_slice_end || n_fragments_reached) {
+      forward_part(false);
+    }
+  }
+}
+
+void openhd::RTPFrameAssembler::reset() {
+  m_frame_fragments.resize(0);
+  m_curr_frame_is_idr = false;
+  m_curr_part_index = 0;
+}
+
+void openhd::RTPFrameAssembler::forward_part(const bool is_last_part) {
+  if (m_out_cb) {
+    // The fragments are handed over to the frame, no copy
+    auto frame =
+        openhd::FragmentedVideoFrame{std::move(m_frame_fragments),
+                                     m_curr_frame_begin,
+                                     m_enable_ultra_secure_encryption,
+                                     nullptr,
+                                     m_config.uses_intra_refresh,
+                                     m_curr_frame_is_idr,
+                                     m_curr_part_index,
+                                     is_last_part};
+    m_out_cb(m_config.stream_index, frame);
+  } else {
+    m_console->debug("No output cb");
+  }
+  m_frame_fragments.clear();
+  if (is_last_part) {
+    m_curr_frame_is_idr = false;
+    m_curr_part_index = 0;
+  } else {
+    m_curr_part_index++;
+  }
+}
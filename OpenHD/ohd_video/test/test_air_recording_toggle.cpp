@@ -0,0 +1,123 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "gst_helper.hpp"
+#include "gst_recording_branch.h"
+#include "openhd_spdlog_include.h"
+#include "openhd_util_filesystem.h"
+
+//
+// Toggles air recording on a running dummy (videotestsrc) pipeline a couple of
+// times, like arming / disarming does, and checks that the live stream
+// (appsink) is not interrupted while the recording branch is attached /
+// detached. Writes the recordings to the usual air recording directory.
+//
+static constexpr int N_RECORDINGS = 3;
+static constexpr auto TOGGLE_INTERVAL = std::chrono::seconds(2);
+
+int main(int argc, char* argv[]) {
+  auto console = openhd::log::create_or_get("test");
+  OHDGstHelper::initGstreamerOrThrow();
+  CameraSettings settings{};
+  if (argc > 1 && std::string(argv[1]) == "h265") {
+    settings.streamed_video_format.videoCodec = VideoCodec::H265;
+  }
+  const auto codec = settings.streamed_video_format.videoCodec;
+  std::stringstream ss;
+  ss << OHDGstHelper::createDummyStream(settings);
+  ss << "tee name=t allow-not-linked=true ! ";
+  ss << OHDGstHelper::create_parse_and_rtp_packetize(codec, 1440);
+  ss << OHDGstHelper::createOutputAppSink();
+  std::cout << "Pipeline: " << ss.str() << std::endl;
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(ss.str().c_str(), &error);
+  if (error) {
+    std::cerr << "Cannot create pipeline: " << error->message << std::endl;
+    return 1;
+  }
+  GstElement* appsink = gst_bin_get_by_name(GST_BIN(pipeline), "out_appsink");
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  auto branch = std::make_unique<GstRecordingBranch>(pipeline, codec, console);
+  std::vector<std::string> recordings;
+  const uint64_t timeout_ns = 40 * 1000 * 1000;
+  auto last_sample = std::chrono::steady_clock::now();
+  auto last_toggle = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::duration max_gap{};
+  int n_samples = 0;
+  int n_toggles = 0;
+  while (n_toggles < N_RECORDINGS * 2) {
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_toggle > TOGGLE_INTERVAL) {
+      if (branch->is_recording()) {
+        branch->request_stop();
+        n_toggles++;
+        last_toggle = now;
+      } else if (!branch->is_active()) {
+        if (branch->start()) recordings.push_back(branch->get_filename());
+        n_toggles++;
+        last_toggle = now;
+      }
+    }
+    branch->poll();
+    GstSample* sample =
+        gst_app_sink_try_pull_sample(GST_APP_SINK(appsink), timeout_ns);
+    if (sample) {
+      const auto sample_time = std::chrono::steady_clock::now();
+      // Ignore the pipeline startup
+      if (n_samples > 0) {
+        max_gap = std::max(max_gap, sample_time - last_sample);
+      }
+      last_sample = sample_time;
+      n_samples++;
+      gst_sample_unref(sample);
+    }
+  }
+  branch = nullptr;
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(appsink);
+  gst_object_unref(pipeline);
+  const auto max_gap_ms =
+      std::chrono::duration_cast<std::chrono::milliseconds>(max_gap).count();
+  std::cout << "Live stream: " << n_samples
+            << " fragments, max gap:" << max_gap_ms << "ms" << std::endl;
+  bool success = recordings.size() == N_RECORDINGS;
+  for (const auto& recording : recordings) {
+    const auto size = OHDFilesystemUtil::get_file_size_bytes(recording);
+    std::cout << recording << " " << size << " bytes" << std::endl;
+    success = success && size > 0;
+  }
+  // A frame interval is ~33ms, anything close to a pipeline restart (seconds)
+  // means the live stream was interrupted
+  success = success && max_gap_ms < 500;
+  std::cout << (success ? "OK" : "FAILED") << std::endl;
+  return success ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <unistd.h>
+
+#include <cassert>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dvr_writer.h"
+#include "openhd_util_filesystem.h"
+
+//
+// Unit test and benchmark for DvrWriter.
+// First checks the segments written contain exactly the header and the units,
+// then simulates an SD card that regularly stalls on write and shows the
+// producer (the camera thread in OpenHD) is never blocked by it.
+//
+static const std::string TEST_DIR = "/tmp/test_dvr_writer/";
+
+static std::function<std::string()> make_create_filename() {
+  auto counter = std::make_shared<int>(0);
+  return [counter]() {
+    return TEST_DIR + "segment_" + std::to_string((*counter)++) + ".bin";
+  };
+}
+
+static std::vector<uint8_t> read_file(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+static std::vector<uint8_t> make_unit(int index, size_t size) {
+  std::vector<uint8_t> ret(size);
+  for (size_t i = 0; i < size; i++) ret[i] = (uint8_t)(index + i);
+  return ret;
+}
+
+static void test_segments() {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  openhd::video::DvrWriter::Config config{};
+  config.create_filename = make_create_filename();
+  config.write_buffer_size = 64 * 1024;
+  config.preallocate_size = 256 * 1024;
+  config.max_segment_size_bytes = 300 * 1024;
+  config.queue_capacity = 4096;
+  const std::vector<uint8_t> header = {'H', 'E', 'A', 'D'};
+  // Expected content per segment
+  std::vector<std::vector<uint8_t>> expected;
+  {
+    openhd::video::DvrWriter writer(config);
+    writer.add_stream_header(header.data(), header.size());
+    uint64_t segment_size = 0;
+    for (int i = 0; i < 1000; i++) {
+      const bool is_keyframe = i % 30 == 0;
+      const auto unit = make_unit(i, is_keyframe ? 20000 : 1000 + i % 7);
+      // Same rule as the writer - roll at the first keyframe over the limit
+      if (expected.empty() ||
+          (is_keyframe && segment_size >= config.max_segment_size_bytes)) {
+        expected.push_back(header);
+        segment_size = header.size();
+      }
+      expected.back().insert(expected.back().end(), unit.begin(), unit.end());
+      segment_size += unit.size();
+      const bool ok = writer.enqueue(
+          openhd::VideoFragment::copy_of(unit.data(), unit.size()),
+          is_keyframe);
+      assert(ok);
+      // Let the writer keep up (the queue is large enough anyways)
+      if (i % 100 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+    writer.stop();
+    const auto stats = writer.get_stats();
+    std::cout << stats.to_string() << std::endl;
+    assert(stats.n_units_dropped == 0);
+    assert(stats.n_segments == expected.size());
+  }
+  for (size_t i = 0; i < expected.size(); i++) {
+    const auto content =
+        read_file(TEST_DIR + "segment_" + std::to_string(i) + ".bin");
+    // Preallocated space must not show up in the file
+    assert(content == expected[i]);
+  }
+  std::cout << "Segments OK (" << expected.size() << ")" << std::endl;
+}
+
+// Like the air recording (matroskamux output) - a group (cluster) consists of
+// many units, a file must only contain complete groups, no matter how many
+// units had to be dropped.
+static constexpr size_t GROUP_UNIT_SIZE = 1000;
+
+static ssize_t stalling_write(int fd, const void* buf, size_t len) {
+  static int n_writes = 0;
+  if (++n_writes % 3 == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return write(fd, buf, len);
+}
+
+static void test_drop_whole_groups(bool use_o_direct) {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  openhd::video::DvrWriter::Config config{};
+  config.create_filename = make_create_filename();
+  config.drop_whole_groups = true;
+  config.queue_capacity = 32;
+  config.write_buffer_size = 16 * 1024;
+  config.use_o_direct = use_o_direct;
+  config.write_fn = stalling_write;
+  openhd::video::DvrWriter::Stats stats{};
+  {
+    openhd::video::DvrWriter writer(config);
+    for (uint32_t group = 0; group < 200; group++) {
+      const uint32_t n_units = 10 + group % 40;
+      for (uint32_t i = 0; i < n_units; i++) {
+        // group, index in group, n units in group
+        auto unit = make_unit(group + i, GROUP_UNIT_SIZE);
+        std::memcpy(unit.data(), &group, 4);
+        std::memcpy(unit.data() + 4, &i, 4);
+        std::memcpy(unit.data() + 8, &n_units, 4);
+        writer.enqueue(openhd::VideoFragment::copy_of(unit.data(), unit.size()),
+                       i == 0);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+      }
+    }
+    writer.stop();
+    stats = writer.get_stats();
+  }
+  std::cout << (use_o_direct ? "O_DIRECT " : "") << stats.to_string()
+            << std::endl;
+  assert(stats.n_groups_rolled_back > 0);
+  const auto content = read_file(TEST_DIR + "segment_0.bin");
+  assert(content.size() == stats.n_units_written * GROUP_UNIT_SIZE);
+  int n_groups = 0;
+  uint32_t expected_index = 0;
+  for (size_t offset = 0; offset < content.size(); offset += GROUP_UNIT_SIZE) {
+    uint32_t index, n_units;
+    std::memcpy(&index, content.data() + offset + 4, 4);
+    std::memcpy(&n_units, content.data() + offset + 8, 4);
+    assert(index == expected_index);
+    expected_index = index + 1 == n_units ? 0 : index + 1;
+    if (expected_index == 0) n_groups++;
+  }
+  // The last group is complete, too
+  assert(expected_index == 0);
+  std::cout << "Complete groups only OK (" << n_groups << ")" << std::endl;
+}
+
+// Writes with ~20MB/s, but stalls for 300ms every 4th write
+static ssize_t slow_write(int fd, const void* buf, size_t len) {
+  static int n_writes = 0;
+  const int stall_ms = (++n_writes % 4 == 0) ? 300 : 0;
+  std::this_thread::sleep_for(std::chrono::milliseconds(stall_ms) +
+                              std::chrono::microseconds(len / 20));
+  return write(fd, buf, len);
+}
+
+static void bench_slow_disk(int bitrate_mbits, int duration_s) {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  openhd::video::DvrWriter::Config config{};
+  config.create_filename = make_create_filename();
+  config.queue_capacity = 64;
+  config.write_buffer_size = 256 * 1024;
+  config.write_fn = slow_write;
+  openhd::video::DvrWriter writer(config);
+  const int fps = 60;
+  const size_t frame_size = bitrate_mbits * 1000 * 1000 / 8 / fps;
+  const auto frame = make_unit(0, frame_size);
+  std::chrono::nanoseconds max_enqueue{0};
+  auto next = std::chrono::steady_clock::now();
+  for (int i = 0; i < fps * duration_s; i++) {
+    const bool is_keyframe = i % fps == 0;
+    auto unit = openhd::VideoFragment::copy_of(frame.data(), frame.size());
+    const auto before = std::chrono::steady_clock::now();
+    writer.enqueue(std::move(unit), is_keyframe);
+    max_enqueue =
+        std::max(max_enqueue, std::chrono::steady_clock::now() - before);
+    next += std::chrono::microseconds(1000 * 1000 / fps);
+    std::this_thread::sleep_until(next);
+  }
+  const auto stop_begin = std::chrono::steady_clock::now();
+  writer.stop();
+  const auto stats = writer.get_stats();
+  std::cout << bitrate_mbits << "MBit/s: " << stats.to_string() << std::endl;
+  std::cout << "Max enqueue: "
+            << std::chrono::duration_cast<std::chrono::microseconds>(
+                   max_enqueue)
+                   .count()
+            << "us, stop (flush) took "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - stop_begin)
+                   .count()
+            << "ms" << std::endl;
+  assert(stats.n_units_written + stats.n_units_dropped ==
+         (uint64_t)fps * duration_s);
+}
+
+int main(int argc, char* argv[]) {
+  test_segments();
+  test_drop_whole_groups(false);
+  test_drop_whole_groups(true);
+  const int duration_s = argc > 1 ? std::stoi(argv[1]) : 5;
+  // Within what the simulated disk can do on average, but not during a stall
+  bench_slow_disk(8, duration_s);
+  // More than the simulated disk can do - units have to be dropped
+  bench_slow_disk(200, duration_s);
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  return 0;
+}
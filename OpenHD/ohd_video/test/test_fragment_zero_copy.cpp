@@ -0,0 +1,187 @@
+/******************************************************************************
+ * OpenHD
+ * 
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ * 
+ * This software is provided "as-is," without warranty of any kind, express or 
+ * implied, including but not limited to the warranties of merchantability, 
+ * fitness for a particular purpose, and non-infringement. For details, see the 
+ * full license in the LICENSE file provided with this source code.
+ * 
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for 
+ * civilian and non-military purposes. Use in any military or defense 
+ * applications is strictly prohibited unless explicitly and individually 
+ * licensed otherwise by the OpenHD Team.
+ * 
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ * 
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <sstream>
+
+#include "../src/gst_appsink_helper.h"
+#include "gst_helper.hpp"
+#include "openhd_fragment_pool.h"
+#include "openhd_util_time.h"
+#include "openhd_video_frame.h"
+
+//
+// Micro benchmark for the appsink -> link enqueue path, on real rtph264pay /
+// rtph265pay output (videotestsrc, sw encoder).
+// Compares copying each rtp fragment out of its gstreamer buffer (old
+// approach, gst_buffer_map merges header and payload memory) with
+// referencing the buffer memories (gst_wrap_buffer). Also prints the memory
+// layout of the buffers, and checks that wrapping doesn't merge them.
+// test_fragment_zero_copy [h265]
+//
+static constexpr int N_FRAMES = 600;
+static constexpr int N_RUNS = 10;
+
+// Runs the encoder once and keeps all the rtp buffers it produced
+static std::vector<GstBuffer*> pull_rtp_buffers(const VideoCodec codec) {
+  CameraSettings settings{};
+  settings.streamed_video_format.videoCodec = codec;
+  std::stringstream ss;
+  ss << OHDGstHelper::createDummyStream(settings);
+  ss << OHDGstHelper::create_parse_and_rtp_packetize(codec, 1440);
+  ss << " appsink name=out_appsink sync=false";
+  std::string pipeline_str = ss.str();
+  // Not live, no more than N_FRAMES
+  const std::string src = "videotestsrc name=videotestsrc";
+  pipeline_str.replace(pipeline_str.find(src), src.size(),
+                       src + " num-buffers=" + std::to_string(N_FRAMES));
+  std::cout << "Pipeline: " << pipeline_str << std::endl;
+  GError* error = nullptr;
+  GstElement* pipeline = gst_parse_launch(pipeline_str.c_str(), &error);
+  if (error) {
+    std::cerr << "Cannot create pipeline: " << error->message << std::endl;
+    return {};
+  }
+  GstElement* appsink = gst_bin_get_by_name(GST_BIN(pipeline), "out_appsink");
+  gst_element_set_state(pipeline, GST_STATE_PLAYING);
+  std::vector<GstBuffer*> ret;
+  while (GstSample* sample = gst_app_sink_pull_sample(GST_APP_SINK(appsink))) {
+    ret.push_back(gst_buffer_ref(gst_sample_get_buffer(sample)));
+    gst_sample_unref(sample);
+  }
+  gst_element_set_state(pipeline, GST_STATE_NULL);
+  gst_object_unref(appsink);
+  gst_object_unref(pipeline);
+  return ret;
+}
+
+static void print_layout(const std::vector<GstBuffer*>& buffers) {
+  std::map<guint, int> n_memory_count;
+  int n_sysmem = 0;
+  for (auto* buffer : buffers) {
+    const guint n_memory = gst_buffer_n_memory(buffer);
+    n_memory_count[n_memory]++;
+    bool all_sysmem = true;
+    for (guint i = 0; i < n_memory; i++) {
+      all_sysmem &= gst_memory_is_type(gst_buffer_peek_memory(buffer, i),
+                                       GST_ALLOCATOR_SYSMEM);
+    }
+    if (all_sysmem) n_sysmem++;
+  }
+  std::cout << buffers.size() << " rtp buffers, system memory only:"
+            << n_sysmem << ", n memories:";
+  for (const auto& [n_memory, count] : n_memory_count) {
+    std::cout << " " << n_memory << "x" << count;
+  }
+  std::cout << "\n";
+}
+
+// What a link does with a frame - either forward each fragment (ethernet,
+// microhard, local forwarding) or convert it for WBStreamTx
+static int64_t consume(const std::vector<openhd::VideoFragment>& fragments,
+                       bool as_wb) {
+  int64_t total = 0;
+  if (as_wb) {
+    for (const auto& fragment : fragments) {
+      total += fragment.as_vector()->size();
+    }
+  } else {
+    for (const auto& fragment : fragments) {
+      struct iovec spans[openhd::VideoFragment::MAX_N_SPANS];
+      const int n_spans = fragment.get_spans(spans);
+      for (int i = 0; i < n_spans; i++) {
+        total += ((const uint8_t*)spans[i].iov_base)[spans[i].iov_len - 1];
+      }
+      total += fragment.size();
+    }
+  }
+  return total;
+}
+
+static void run(const std::string& tag, const std::vector<GstBuffer*>& buffers,
+                bool zero_copy, bool as_wb) {
+  int64_t total = 0;
+  std::chrono::steady_clock::duration elapsed{};
+  auto& pool = openhd::FragmentPool::instance();
+  const auto hits_before = pool.get_stats().count_hit;
+  std::vector<openhd::VideoFragment> fragments;
+  fragments.reserve(buffers.size());
+  for (int run = 0; run < N_RUNS; run++) {
+    const auto begin = std::chrono::steady_clock::now();
+    for (auto* buffer : buffers) {
+      if (zero_copy) {
+        fragments.push_back(openhd::gst_wrap_buffer(buffer));
+      } else {
+        fragments.emplace_back(openhd::gst_copy_buffer(buffer));
+      }
+      // The link consumes the fragments of a frame while the encoder is
+      // already busy with the next one - don't let them pile up
+      if (fragments.size() >= 64) {
+        total += consume(fragments, as_wb);
+        fragments.clear();
+      }
+    }
+    total += consume(fragments, as_wb);
+    fragments.clear();
+    elapsed += std::chrono::steady_clock::now() - begin;
+  }
+  const auto n_fragments = buffers.size() * N_RUNS;
+  const auto per_fragment_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+      n_fragments;
+  std::cout << tag << ": " << openhd::util::time_readable(elapsed) << " total, "
+            << per_fragment_ns << "ns per fragment, pooled copies:"
+            << pool.get_stats().count_hit - hits_before
+            << " (check:" << total << ")\n";
+}
+
+int main(int argc, char* argv[]) {
+  OHDGstHelper::initGstreamerOrThrow();
+  const bool is_h265 = argc > 1 && std::string(argv[1]) == "h265";
+  const auto buffers =
+      pull_rtp_buffers(is_h265 ? VideoCodec::H265 : VideoCodec::H264);
+  if (buffers.empty()) return 1;
+  print_layout(buffers);
+  std::vector<guint> n_memory_before;
+  for (auto* buffer : buffers) {
+    n_memory_before.push_back(gst_buffer_n_memory(buffer));
+  }
+  // Zero copy first - gst_copy_buffer (gst_buffer_map) merges the memories
+  run("zero   -> udp forward", buffers, true, false);
+  run("zero   -> wb enqueue ", buffers, true, true);
+  for (size_t i = 0; i < buffers.size(); i++) {
+    if (gst_buffer_n_memory(buffers[i]) != n_memory_before[i]) {
+      std::cerr << "gst_wrap_buffer merged the memories of a buffer\n";
+      return 1;
+    }
+  }
+  run("copy   -> udp forward", buffers, false, false);
+  run("copy   -> wb enqueue ", buffers, false, true);
+  for (auto* buffer : buffers) gst_buffer_unref(buffer);
+  return 0;
+}
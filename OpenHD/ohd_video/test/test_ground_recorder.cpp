@@ -0,0 +1,474 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "ffmpeg_videosamples.hpp"
+#include "ground_recorder.h"
+#include "mkv_to_mp4_remuxer.h"
+#include "ohd_video_ground.h"
+#include "openhd_config.h"
+#include "openhd_fragment_pool.h"
+#include "openhd_util_filesystem.h"
+#include "openhd_util_time.h"
+
+//
+// Unit test for the ground recorder.
+// Packetizes a stream the same way rtph264pay / rtph265pay do it (keyframes
+// are the ffmpeg sample frames, the other frames random slices), drops some
+// packets like the link does if FEC cannot recover them and checks the
+// resulting .mkv frame by frame (data, keyframe flag and timestamp) - and
+// that it can be remuxed. Both streams are fed at the same time from their
+// own thread, like the link does it.
+// Pass a captured stream to record it through OHDVideoGround::on_video_data,
+// e.g. ... ! rtph264pay mtu=1440 ! rtpstreampay ! filesink
+// location=capture.rtp, test_ground_recorder capture.rtp
+//
+static const std::string TEST_DIR = "/tmp/test_ground_recorder/";
+static constexpr int MTU = 1440;
+static constexpr int RTP_HEADER_SIZE = 12;
+static constexpr int KEYFRAME_INTERVAL = 60;
+static constexpr uint32_t TIMESTAMP_INCREMENT = 1500;
+
+using NALU = std::vector<uint8_t>;
+
+// Annex B -> NAL units
+static std::vector<NALU> split_nalus(const uint8_t* data, size_t size) {
+  std::vector<size_t> starts;
+  for (size_t i = 0; i + 3 <= size; i++) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      starts.push_back(i + 3);
+    }
+  }
+  std::vector<NALU> ret;
+  for (size_t i = 0; i < starts.size(); i++) {
+    size_t end = i + 1 < starts.size() ? starts[i + 1] - 3 : size;
+    while (end > starts[i] && data[end - 1] == 0) end--;
+    ret.emplace_back(data + starts[i], data + end);
+  }
+  return ret;
+}
+
+struct TestFrame {
+  std::vector<NALU> nalus;
+  bool is_keyframe;
+};
+
+static std::vector<TestFrame> create_frames(bool is_h265, int n_frames) {
+  std::mt19937 gen{is_h265 ? 265u : 264u};
+  const auto keyframe =
+      is_h265 ? split_nalus(k_HEVCMainTestFrame, sizeof(k_HEVCMainTestFrame))
+              : split_nalus(k_H264TestFrame, sizeof(k_H264TestFrame));
+  std::vector<TestFrame> ret;
+  for (int i = 0; i < n_frames; i++) {
+    if (i % KEYFRAME_INTERVAL == 0) {
+      ret.push_back({keyframe, true});
+      continue;
+    }
+    // 1 or 2 slices, large enough to be fragmented most of the time
+    TestFrame frame{{}, false};
+    const int n_slices = 1 + gen() % 2;
+    for (int s = 0; s < n_slices; s++) {
+      NALU nalu(200 + gen() % 6000);
+      for (auto& b : nalu) b = gen();
+      if (is_h265) {
+        nalu[0] = 1 << 1;  // TRAIL_R
+        nalu[1] = 0x01;
+      } else {
+        nalu[0] = 0x41;  // non-IDR slice
+      }
+      frame.nalus.push_back(std::move(nalu));
+    }
+    ret.push_back(std::move(frame));
+  }
+  return ret;
+}
+
+class Packetizer {
+ public:
+  Packetizer(bool is_h265, uint16_t seq, uint32_t timestamp, uint32_t ssrc)
+      : m_is_h265(is_h265), m_seq(seq), m_timestamp(timestamp), m_ssrc(ssrc) {}
+  std::vector<std::vector<uint8_t>> packetize(const TestFrame& frame) {
+    std::vector<std::vector<uint8_t>> ret;
+    size_t i = 0;
+    // H264: SPS / PPS in a STAP-A, H265: VPS / SPS / PPS as single NAL units
+    if (!m_is_h265 && frame.is_keyframe) {
+      std::vector<uint8_t> payload{0x78};
+      for (; i < 2; i++) {
+        payload.push_back(frame.nalus[i].size() >> 8);
+        payload.push_back(frame.nalus[i].size() & 0xFF);
+        payload.insert(payload.end(), frame.nalus[i].begin(),
+                       frame.nalus[i].end());
+      }
+      ret.push_back(make_packet(payload, false));
+    }
+    for (; i < frame.nalus.size(); i++) {
+      packetize_nalu(frame.nalus[i], i == frame.nalus.size() - 1, ret);
+    }
+    m_timestamp += TIMESTAMP_INCREMENT;
+    return ret;
+  }
+
+ private:
+  void packetize_nalu(const NALU& nalu, bool last_nalu,
+                      std::vector<std::vector<uint8_t>>& out) {
+    if ((int)nalu.size() <= MTU - RTP_HEADER_SIZE) {
+      out.push_back(make_packet(nalu, last_nalu));
+      return;
+    }
+    const size_t hdr_size = m_is_h265 ? 2 : 1;
+    const size_t max_fu_payload = MTU - RTP_HEADER_SIZE - hdr_size - 1;
+    for (size_t offset = hdr_size; offset < nalu.size();) {
+      const size_t len = std::min(max_fu_payload, nalu.size() - offset);
+      const bool start = offset == hdr_size;
+      const bool end = offset + len == nalu.size();
+      std::vector<uint8_t> payload;
+      const uint8_t se = (start ? 0x80 : 0) | (end ? 0x40 : 0);
+      if (m_is_h265) {
+        payload = {(uint8_t)((49 << 1) | (nalu[0] & 0x81)), nalu[1],
+                   (uint8_t)(se | ((nalu[0] >> 1) & 0x3F))};
+      } else {
+        payload = {(uint8_t)((nalu[0] & 0xE0) | 28),
+                   (uint8_t)(se | (nalu[0] & 0x1F))};
+      }
+      payload.insert(payload.end(), nalu.begin() + offset,
+                     nalu.begin() + offset + len);
+      out.push_back(make_packet(payload, end && last_nalu));
+      offset += len;
+    }
+  }
+  std::vector<uint8_t> make_packet(const std::vector<uint8_t>& payload,
+                                   bool marker) {
+    std::vector<uint8_t> packet(RTP_HEADER_SIZE);
+    packet[0] = 0x80;
+    packet[1] = (uint8_t)((marker ? 0x80 : 0) | 96);
+    packet[2] = m_seq >> 8;
+    packet[3] = m_seq & 0xFF;
+    for (int i = 0; i < 4; i++) {
+      packet[4 + i] = m_timestamp >> (24 - 8 * i);
+      packet[8 + i] = m_ssrc >> (24 - 8 * i);
+    }
+    m_seq++;
+    packet.insert(packet.end(), payload.begin(), payload.end());
+    return packet;
+  }
+  const bool m_is_h265;
+  uint16_t m_seq;
+  uint32_t m_timestamp;
+  const uint32_t m_ssrc;
+};
+
+struct MkvFrame {
+  std::vector<uint8_t> data;
+  bool is_keyframe;
+  int64_t pts_ms;
+};
+
+struct MkvFile {
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<MkvFrame> frames;
+};
+
+// Just enough of a parser for what the ground recorder writes
+static MkvFile read_mkv(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)),
+                                  std::istreambuf_iterator<char>());
+  const auto read_vint = [&](size_t& offset, bool keep_marker) {
+    const int n = __builtin_clz((unsigned int)data.at(offset)) - 23;
+    uint64_t value = keep_marker ? data[offset] : data[offset] & (0xFF >> n);
+    for (int i = 1; i < n; i++) value = (value << 8) | data.at(offset + i);
+    offset += n;
+    return value;
+  };
+  const auto read_uint = [&](size_t offset, uint64_t size) {
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < size; i++) value = (value << 8) | data[offset + i];
+    return value;
+  };
+  MkvFile ret;
+  int64_t cluster_timecode = 0;
+  size_t offset = 0;
+  while (offset < data.size()) {
+    const auto id = read_vint(offset, true);
+    const auto size = read_vint(offset, false);
+    // Segment, cluster (unknown size), tracks, track entry, video
+    if (id == 0x18538067 || id == 0x1F43B675 || id == 0x1654AE6B ||
+        id == 0xAE || id == 0xE0) {
+      continue;
+    }
+    assert(offset + size <= data.size());
+    if (id == 0xB0) ret.width = read_uint(offset, size);
+    if (id == 0xBA) ret.height = read_uint(offset, size);
+    if (id == 0xE7) cluster_timecode = read_uint(offset, size);
+    if (id == 0xA3) {
+      assert(data[offset] == 0x81);
+      const auto relative = (int16_t)read_uint(offset + 1, 2);
+      const bool is_keyframe = (data[offset + 3] & 0x80) != 0;
+      ret.frames.push_back({{data.begin() + offset + 4,
+                             data.begin() + offset + size},
+                            is_keyframe,
+                            cluster_timecode + relative});
+    }
+    offset += size;
+  }
+  return ret;
+}
+
+static std::vector<uint8_t> to_length_prefixed(const TestFrame& frame) {
+  std::vector<uint8_t> ret;
+  for (const auto& nalu : frame.nalus) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      ret.push_back(nalu.size() >> shift);
+    }
+    ret.insert(ret.end(), nalu.begin(), nalu.end());
+  }
+  return ret;
+}
+
+class FileCollector {
+ public:
+  void add(const std::string& filename) {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_files.push_back(filename);
+  }
+  std::vector<std::string> get() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_files;
+  }
+
+ private:
+  std::mutex m_mutex;
+  std::vector<std::string> m_files;
+};
+
+static openhd::video::GroundRecorder::Config create_config(
+    FileCollector& collector) {
+  openhd::video::GroundRecorder::Config config{};
+  config.create_filename = [](int stream_index) {
+    static std::atomic<int> count = 0;
+    return TEST_DIR + "stream" + std::to_string(stream_index) + "_" +
+           std::to_string(count++) + ".mkv";
+  };
+  config.min_free_space_mb = 0;
+  config.idle_timeout = std::chrono::milliseconds(300);
+  config.on_file_closed = [&collector](const std::string& filename) {
+    collector.add(filename);
+  };
+  return config;
+}
+
+// Checks the recording of the given frames (where the ones with a lost
+// packet never made it to the recorder completely)
+static void verify_recording(const std::string& filename, bool is_h265,
+                             const std::vector<TestFrame>& frames,
+                             const std::set<int>& damaged_frames) {
+  const auto mkv = read_mkv(filename);
+  assert(mkv.width == 1280 && mkv.height == 720);
+  // A damaged frame is dropped and so is everything up to the next keyframe
+  std::vector<int> expected;
+  bool waiting_for_keyframe = false;
+  for (int i = 0; i < (int)frames.size(); i++) {
+    if (damaged_frames.count(i)) {
+      waiting_for_keyframe = true;
+      continue;
+    }
+    if (waiting_for_keyframe && !frames[i].is_keyframe) continue;
+    waiting_for_keyframe = false;
+    expected.push_back(i);
+  }
+  assert(mkv.frames.size() == expected.size());
+  for (size_t i = 0; i < expected.size(); i++) {
+    const auto& frame = frames[expected[i]];
+    assert(mkv.frames[i].data == to_length_prefixed(frame));
+    assert(mkv.frames[i].is_keyframe == frame.is_keyframe);
+    // The timestamps keep the gaps
+    assert(mkv.frames[i].pts_ms ==
+           (int64_t)expected[i] * TIMESTAMP_INCREMENT * 1000 / 90000);
+  }
+  const auto mp4_filename = filename.substr(0, filename.size() - 4) + ".mp4";
+  const auto result = openhd::video::remux_mkv_to_mp4(filename, mp4_filename);
+  assert(result.success);
+  assert(result.n_samples == expected.size());
+  std::cout << filename << " (" << (is_h265 ? "H265" : "H264") << "): "
+            << mkv.frames.size() << "/" << frames.size()
+            << " frames recorded, " << result.to_string() << "\n";
+}
+
+static void test_recording_with_losses() {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  FileCollector collector;
+  auto recorder = std::make_unique<openhd::video::GroundRecorder>(
+      create_config(collector));
+  constexpr int N_FRAMES = 600;
+  // Frames that lose a packet: mid frame, the first packet, the last packet
+  // (with the marker bit) and right before a keyframe
+  const std::set<int> damaged_frames{100, 250, 400, 479};
+  std::map<int, std::vector<TestFrame>> frames;
+  // Not part of the measurement, the pool is created on first use
+  openhd::FragmentPool::instance();
+  std::vector<std::thread> threads;
+  for (int stream_index : {0, 1}) {
+    const bool is_h265 = stream_index == 1;
+    frames[stream_index] = create_frames(is_h265, N_FRAMES);
+    threads.emplace_back([&, stream_index, is_h265]() {
+      // Sequence number and timestamp wrap around during the test
+      Packetizer packetizer{is_h265, 65000, 0xFFFF0000, 1234};
+      int n_packets = 0;
+      std::chrono::nanoseconds max_duration{0};
+      for (int i = 0; i < N_FRAMES; i++) {
+        auto packets = packetizer.packetize(frames[stream_index][i]);
+        if (damaged_frames.count(i)) {
+          const size_t lost = i == 250 ? 0
+                              : i == 400 ? packets.size() - 1
+                                         : packets.size() / 2;
+          packets.erase(packets.begin() + lost);
+        }
+        for (const auto& packet : packets) {
+          const auto before = std::chrono::steady_clock::now();
+          recorder->on_rtp_packet(stream_index, packet.data(), packet.size());
+          max_duration =
+              std::max(max_duration, std::chrono::steady_clock::now() - before);
+          n_packets++;
+        }
+        // Don't overrun the queue, the link doesn't deliver faster either
+        if (i % 10 == 0) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+      std::cout << "Stream " << stream_index << ": " << n_packets
+                << " packets, max on_rtp_packet "
+                << openhd::util::time_readable(max_duration) << "\n";
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  // The stream stopped - the recorder closes the files by itself
+  std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+  const auto files = collector.get();
+  assert(files.size() == 2);
+  for (int stream_index : {0, 1}) {
+    const auto stats = recorder->get_stats(stream_index);
+    std::cout << stats.to_string() << "\n";
+    assert(stats.n_packets_dropped == 0);
+    assert(stats.n_discontinuities == damaged_frames.size());
+    assert(stats.n_files == 1);
+    const auto filename = *std::find_if(
+        files.begin(), files.end(), [&](const std::string& file) {
+          return file.find("stream" + std::to_string(stream_index)) !=
+                 std::string::npos;
+        });
+    verify_recording(filename, stream_index == 1, frames[stream_index],
+                     damaged_frames);
+  }
+  recorder.reset();
+}
+
+// A restart of the air unit (or a new codec) starts a new file
+static void test_restart() {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  FileCollector collector;
+  auto recorder = std::make_unique<openhd::video::GroundRecorder>(
+      create_config(collector));
+  const auto frames_h264 = create_frames(false, 120);
+  const auto frames_h265 = create_frames(true, 120);
+  Packetizer first{false, 0, 1000, 1};
+  Packetizer second{true, 5000, 50000, 2};
+  for (const auto& frame : frames_h264) {
+    for (const auto& packet : first.packetize(frame)) {
+      recorder->on_rtp_packet(0, packet.data(), packet.size());
+    }
+  }
+  for (const auto& frame : frames_h265) {
+    for (const auto& packet : second.packetize(frame)) {
+      recorder->on_rtp_packet(0, packet.data(), packet.size());
+    }
+  }
+  // Closes the file(s) on destruction, the first one is closed in the
+  // background on restart
+  recorder.reset();
+  for (int i = 0; i < 100 && collector.get().size() < 2; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  auto files = collector.get();
+  assert(files.size() == 2);
+  std::sort(files.begin(), files.end());
+  verify_recording(files[0], false, frames_h264, {});
+  verify_recording(files[1], true, frames_h265, {});
+}
+
+// RFC 4571 framing (2 byte big endian length per packet), like written by
+// rtpstreampay. Recorded the same way the ground does it while flying.
+static void run_captured(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot open " << filename << "\n";
+    return;
+  }
+  const std::string config_file = "/tmp/test_ground_recorder.config";
+  std::ofstream(config_file) << "[generic]\nGEN_GROUND_RECORDING = true\n";
+  openhd::set_config_file(config_file);
+  auto ground = std::make_unique<OHDVideoGround>(nullptr);
+  uint8_t len_buff[2];
+  std::vector<uint8_t> packet;
+  int n_packets = 0;
+  while (file.read((char*)len_buff, 2)) {
+    packet.resize((len_buff[0] << 8) | len_buff[1]);
+    if (!file.read((char*)packet.data(), packet.size())) break;
+    ground->on_video_data(0, packet.data(), packet.size());
+    // Roughly the rate of the link, such that the queue doesn't overflow
+    if (++n_packets % 10 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  // Closes the recording, give the remuxer some time (an interrupted remux
+  // is continued on the next start)
+  ground.reset();
+  std::this_thread::sleep_for(std::chrono::seconds(2));
+  std::cout << filename << ": " << n_packets
+            << " packets, see the videos directory for the recording\n";
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1) {
+    run_captured(argv[1]);
+    return 0;
+  }
+  test_recording_with_losses();
+  test_restart();
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  std::cout << "All tests passed\n";
+  return 0;
+}
@@ -0,0 +1,354 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cassert>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "mkv_to_mp4_remuxer.h"
+#include "openhd_util_filesystem.h"
+
+//
+// Unit test and benchmark for the mkv -> mp4 remuxer.
+// Generates recordings the way matroskamux streamable=true writes them
+// (unknown-size segment and clusters, one cluster per GOP), remuxes them and
+// checks every frame ends up in the .mp4 where the sample tables say it is.
+// Also checks cut-off recordings, resuming an interrupted remux and measures
+// the throughput. Usage: test_mkv_to_mp4_remuxer [size of the big file in MB]
+//
+static const std::string TEST_DIR = "/tmp/test_mkv_to_mp4_remuxer/";
+static constexpr int FPS = 60;
+
+static void put_id(std::vector<uint8_t>& out, uint32_t id) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    if ((id >> shift) != 0) out.push_back(id >> shift);
+  }
+}
+
+static void put_size(std::vector<uint8_t>& out, uint64_t size) {
+  out.push_back(0x01);
+  for (int shift = 48; shift >= 0; shift -= 8) out.push_back(size >> shift);
+}
+
+static void put_unknown_size(std::vector<uint8_t>& out) {
+  out.push_back(0x01);
+  out.insert(out.end(), 7, 0xFF);
+}
+
+static void put_element(std::vector<uint8_t>& out, uint32_t id,
+                        const std::vector<uint8_t>& data) {
+  put_id(out, id);
+  put_size(out, data.size());
+  out.insert(out.end(), data.begin(), data.end());
+}
+
+static void put_uint(std::vector<uint8_t>& out, uint32_t id, uint64_t value) {
+  std::vector<uint8_t> data;
+  for (int shift = 56; shift >= 0; shift -= 8) data.push_back(value >> shift);
+  put_element(out, id, data);
+}
+
+static void fill_frame(int index, uint8_t* data, size_t size) {
+  for (size_t i = 0; i < size; i++) data[i] = (uint8_t)(index * 31 + i);
+}
+
+static size_t frame_size(int index, size_t keyframe_size) {
+  return index % FPS == 0 ? keyframe_size : keyframe_size / 4 + index % 13;
+}
+
+struct GeneratedRecording {
+  int n_frames = 0;
+  int n_keyframes = 0;
+  // Where the data of each frame (block) ends in the file
+  std::vector<uint64_t> frame_end_offsets;
+};
+
+static GeneratedRecording generate_mkv(const std::string& filename,
+                                       int duration_s, size_t keyframe_size) {
+  GeneratedRecording ret{};
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  uint64_t offset = 0;
+  std::vector<uint8_t> out;
+  const auto flush = [&]() {
+    file.write((const char*)out.data(), out.size());
+    offset += out.size();
+    out.clear();
+  };
+  std::vector<uint8_t> ebml;
+  put_uint(ebml, 0x4286, 1);
+  put_element(ebml, 0x4282, {'m', 'a', 't', 'r', 'o', 's', 'k', 'a'});
+  put_element(out, 0x1A45DFA3, ebml);
+  put_id(out, 0x18538067);
+  put_unknown_size(out);
+  std::vector<uint8_t> info;
+  put_uint(info, 0x2AD7B1, 1000000);
+  put_element(out, 0x1549A966, info);
+  std::vector<uint8_t> video;
+  put_uint(video, 0xB0, 1920);
+  put_uint(video, 0xBA, 1080);
+  std::vector<uint8_t> track;
+  put_uint(track, 0xD7, 1);
+  put_uint(track, 0x83, 1);
+  const std::string codec = "V_MPEG4/ISO/AVC";
+  put_element(track, 0x86, {codec.begin(), codec.end()});
+  put_element(track, 0x63A2, {0x01, 0x64, 0x00, 0x28, 0xFF, 0xE1, 0x00, 0x00});
+  put_uint(track, 0x23E383, 1000000000 / FPS);
+  put_element(track, 0xE0, video);
+  std::vector<uint8_t> tracks;
+  put_element(tracks, 0xAE, track);
+  put_element(out, 0x1654AE6B, tracks);
+  std::vector<uint8_t> frame;
+  const int n_frames = duration_s * FPS;
+  for (int i = 0; i < n_frames; i++) {
+    const bool is_keyframe = i % FPS == 0;
+    if (is_keyframe) {
+      put_id(out, 0x1F43B675);
+      put_unknown_size(out);
+      put_uint(out, 0xE7, i / FPS * 1000);
+      ret.n_keyframes++;
+    }
+    frame.resize(4 + frame_size(i, keyframe_size));
+    frame[0] = 0x81;  // track 1
+    const int relative_timecode = (i % FPS) * 1000 / FPS;
+    frame[1] = relative_timecode >> 8;
+    frame[2] = relative_timecode;
+    frame[3] = is_keyframe ? 0x80 : 0x00;
+    fill_frame(i, frame.data() + 4, frame.size() - 4);
+    put_element(out, 0xA3, frame);
+    ret.frame_end_offsets.push_back(offset + out.size());
+    if (out.size() > 1024 * 1024) flush();
+  }
+  flush();
+  ret.n_frames = n_frames;
+  return ret;
+}
+
+static std::vector<uint8_t> read_file(const std::string& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  return {std::istreambuf_iterator<char>(file),
+          std::istreambuf_iterator<char>()};
+}
+
+static uint32_t read_u32(const uint8_t* p) {
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+         p[3];
+}
+
+// Returns the content of the first box with the given path, e.g.
+// {"moov", "trak", "mdia"}
+static std::vector<uint8_t> find_box(int fd, uint64_t begin, uint64_t end,
+                                     std::vector<std::string> path) {
+  while (begin + 8 <= end) {
+    uint8_t header[16];
+    assert(pread(fd, header, 16, begin) >= 8);
+    uint64_t size = read_u32(header);
+    uint64_t header_size = 8;
+    if (size == 1) {
+      size = (uint64_t)read_u32(header + 8) << 32 | read_u32(header + 12);
+      header_size = 16;
+    }
+    assert(size >= header_size && begin + size <= end);
+    if (std::string((const char*)header + 4, 4) == path[0]) {
+      if (path.size() == 1) {
+        std::vector<uint8_t> ret(size - header_size);
+        assert(pread(fd, ret.data(), ret.size(), begin + header_size) ==
+               (ssize_t)ret.size());
+        return ret;
+      }
+      path.erase(path.begin());
+      return find_box(fd, begin + header_size, begin + size, path);
+    }
+    begin += size;
+  }
+  return {};
+}
+
+// Checks the .mp4 structure and that each frame is where the tables say
+static void verify_mp4(const std::string& filename, int n_frames,
+                       int n_keyframes, size_t keyframe_size) {
+  const int fd = open(filename.c_str(), O_RDONLY);
+  assert(fd >= 0);
+  const uint64_t file_size = OHDFilesystemUtil::get_file_size_bytes(filename);
+  const std::vector<std::string> stbl = {"moov", "trak", "mdia", "minf",
+                                         "stbl"};
+  const auto table = [&](const char* name) {
+    auto path = stbl;
+    path.emplace_back(name);
+    return find_box(fd, 0, file_size, path);
+  };
+  const auto stsz = table("stsz");
+  const auto stsc = table("stsc");
+  const auto stco = table("stco");
+  const auto stss = table("stss");
+  assert(!stsz.empty() && !stsc.empty() && !stco.empty());
+  assert((int)read_u32(stsz.data() + 8) == n_frames);
+  assert((int)read_u32(stss.data() + 4) == n_keyframes);
+  const auto stsd = table("stsd");
+  assert(stsd.size() > 16 && std::string((const char*)&stsd[12], 4) == "avc1");
+  const uint32_t n_chunks = read_u32(stco.data() + 4);
+  const uint32_t n_stsc = read_u32(stsc.data() + 4);
+  int sample = 0;
+  std::vector<uint8_t> expected;
+  std::vector<uint8_t> actual;
+  for (uint32_t chunk = 0; chunk < n_chunks; chunk++) {
+    uint32_t samples_per_chunk = 0;
+    for (uint32_t i = 0; i < n_stsc; i++) {
+      if (read_u32(stsc.data() + 8 + i * 12) <= chunk + 1) {
+        samples_per_chunk = read_u32(stsc.data() + 8 + i * 12 + 4);
+      }
+    }
+    uint64_t offset = read_u32(stco.data() + 8 + chunk * 4);
+    for (uint32_t i = 0; i < samples_per_chunk; i++, sample++) {
+      const uint32_t size = read_u32(stsz.data() + 12 + sample * 4);
+      assert(size == frame_size(sample, keyframe_size));
+      expected.resize(size);
+      actual.resize(size);
+      fill_frame(sample, expected.data(), size);
+      assert(pread(fd, actual.data(), size, offset) == (ssize_t)size);
+      assert(actual == expected);
+      offset += size;
+    }
+  }
+  assert(sample == n_frames);
+  close(fd);
+}
+
+static void test_remux(size_t keyframe_size) {
+  const auto in = TEST_DIR + "basic.mkv";
+  const auto out = TEST_DIR + "basic.mp4";
+  const auto rec = generate_mkv(in, 10, keyframe_size);
+  const auto result = openhd::video::remux_mkv_to_mp4(in, out);
+  std::cout << "Basic: " << result.to_string() << std::endl;
+  assert(result.success && !result.resumed);
+  assert((int)result.n_samples == rec.n_frames);
+  assert((int)result.n_keyframes == rec.n_keyframes);
+  // Matroska timestamps are in ms
+  assert(std::chrono::abs(result.media_duration - std::chrono::seconds(10)) <
+         std::chrono::milliseconds(20));
+  assert(!OHDFilesystemUtil::exists(out + ".part"));
+  assert(!OHDFilesystemUtil::exists(out + ".journal"));
+  verify_mp4(out, rec.n_frames, rec.n_keyframes, keyframe_size);
+}
+
+// Recording cut off in the middle of a frame (crash / power loss)
+static void test_truncated(size_t keyframe_size) {
+  const auto in = TEST_DIR + "truncated.mkv";
+  const auto out = TEST_DIR + "truncated.mp4";
+  const auto rec = generate_mkv(in, 10, keyframe_size);
+  const int n_complete = rec.n_frames / 2;
+  const uint64_t cut = rec.frame_end_offsets[n_complete - 1] + 10;
+  assert(truncate(in.c_str(), cut) == 0);
+  const auto result = openhd::video::remux_mkv_to_mp4(in, out);
+  std::cout << "Truncated: " << result.to_string() << std::endl;
+  assert(result.success && (int)result.n_samples == n_complete);
+  verify_mp4(out, n_complete, (n_complete + FPS - 1) / FPS, keyframe_size);
+}
+
+// Interrupted (and some garbage written after the last checkpoint, like
+// after a power loss) - the result needs to be identical to a remux in one go
+static void test_resume(size_t keyframe_size) {
+  const auto in = TEST_DIR + "resume.mkv";
+  const auto out = TEST_DIR + "resume.mp4";
+  const auto reference = TEST_DIR + "reference.mp4";
+  const auto rec = generate_mkv(in, 20, keyframe_size);
+  openhd::video::RemuxOptions options{};
+  options.checkpoint_interval_bytes = 512 * 1024;
+  assert(openhd::video::remux_mkv_to_mp4(in, reference, options).success);
+  int n_clusters = 0;
+  options.should_cancel = [&n_clusters]() { return ++n_clusters > 12; };
+  auto result = openhd::video::remux_mkv_to_mp4(in, out, options);
+  assert(!result.success && result.cancelled);
+  {
+    std::ofstream part(out + ".part", std::ios::binary | std::ios::app);
+    part << "garbage after the last checkpoint";
+    std::ofstream journal(out + ".journal", std::ios::binary | std::ios::app);
+    journal << "incomplete";
+  }
+  options.should_cancel = nullptr;
+  result = openhd::video::remux_mkv_to_mp4(in, out, options);
+  std::cout << "Resumed: " << result.to_string() << std::endl;
+  assert(result.success && result.resumed);
+  assert((int)result.n_samples == rec.n_frames);
+  assert(read_file(out) == read_file(reference));
+  verify_mp4(out, rec.n_frames, rec.n_keyframes, keyframe_size);
+}
+
+static void bench_throughput(int size_mb) {
+  const auto in = TEST_DIR + "bench.mkv";
+  const auto out = TEST_DIR + "bench.mp4";
+  // ~size_mb MB, 100kB keyframes at 60fps (roughly 16MBit/s)
+  const size_t keyframe_size = 100 * 1024;
+  const int bytes_per_second = keyframe_size * (1 + (FPS - 1) / 4.0);
+  const int duration_s =
+      std::max(1, (int)((uint64_t)size_mb * 1024 * 1024 / bytes_per_second));
+  generate_mkv(in, duration_s, keyframe_size);
+  const auto in_size = OHDFilesystemUtil::get_file_size_bytes(in);
+  // Reference: plain user space copy of the whole file
+  auto begin = std::chrono::steady_clock::now();
+  {
+    const int in_fd = open(in.c_str(), O_RDONLY);
+    const int out_fd = open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    std::vector<uint8_t> buffer(1024 * 1024);
+    ssize_t n;
+    while ((n = read(in_fd, buffer.data(), buffer.size())) > 0) {
+      assert(write(out_fd, buffer.data(), n) == n);
+    }
+    fdatasync(out_fd);
+    close(in_fd);
+    close(out_fd);
+  }
+  const auto copy_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now() - begin)
+                           .count();
+  OHDFilesystemUtil::remove_if_existing(out);
+  begin = std::chrono::steady_clock::now();
+  const auto result = openhd::video::remux_mkv_to_mp4(in, out);
+  const auto remux_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - begin)
+                            .count();
+  assert(result.success);
+  std::cout << "Bench: " << in_size / 1024 / 1024 << "MB, "
+            << result.to_string() << std::endl;
+  std::cout << "Remux took " << remux_ms << "ms ("
+            << in_size / 1024 / std::max<int64_t>(remux_ms, 1) << "MB/s), "
+            << "read+write copy took " << copy_ms << "ms" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  OHDFilesystemUtil::create_directories(TEST_DIR);
+  test_remux(60 * 1024);
+  test_truncated(60 * 1024);
+  test_resume(60 * 1024);
+  bench_throughput(argc > 1 ? std::stoi(argv[1]) : 256);
+  OHDFilesystemUtil::safe_delete_directory(TEST_DIR);
+  std::cout << "All tests passed" << std::endl;
+  return 0;
+}
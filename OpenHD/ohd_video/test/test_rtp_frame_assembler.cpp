@@ -0,0 +1,461 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "openhd_util_time.h"
+#include "rtp_frame_assembler.h"
+
+//
+// Unit test and benchmark for RTPFrameAssembler.
+// By default, feeds synthetic rtp streams (packetized the same way as
+// rtph264pay / rtph265pay do it) and checks the frame boundaries and IDR
+// flags. Pass a captured stream to see how it is split into frames, e.g.
+// ... ! rtph264pay mtu=1440 ! rtpstreampay ! filesink location=capture.rtp
+// test_rtp_frame_assembler capture.rtp [h265]
+// The (sleep driven, ~6s) early tx latency benchmark only runs with
+// test_rtp_frame_assembler latency
+//
+static constexpr int MTU = 1440;
+static constexpr int RTP_HEADER_SIZE = 12;
+
+struct TestFrame {
+  std::vector<std::vector<uint8_t>> nalus;
+  bool is_idr;
+};
+
+static std::vector<uint8_t> make_nalu(bool is_h265, int type, int size) {
+  static std::mt19937 gen{42};
+  std::vector<uint8_t> nalu(size);
+  for (auto& b : nalu) b = gen();
+  if (is_h265) {
+    nalu[0] = (uint8_t)(type << 1);
+    nalu[1] = 0x01;
+  } else {
+    nalu[0] = (uint8_t)(0x60 | type);
+  }
+  return nalu;
+}
+
+class Packetizer {
+ public:
+  Packetizer(bool is_h265, bool set_marker, bool aggregate_config)
+      : m_is_h265(is_h265),
+        m_set_marker(set_marker),
+        m_aggregate_config(aggregate_config) {}
+  // Returns the rtp packets of the given frame
+  std::vector<std::vector<uint8_t>> packetize(const TestFrame& frame) {
+    std::vector<std::vector<uint8_t>> ret;
+    size_t i = 0;
+    // SPS / PPS (/ VPS) in one aggregation packet
+    if (m_aggregate_config && frame.is_idr) {
+      std::vector<uint8_t> payload;
+      if (m_is_h265) {
+        payload = {48 << 1, 0x01};
+      } else {
+        payload = {0x78};
+      }
+      const size_t n_config_nalus = m_is_h265 ? 3 : 2;
+      for (; i < n_config_nalus; i++) {
+        const auto& nalu = frame.nalus[i];
+        payload.push_back(nalu.size() >> 8);
+        payload.push_back(nalu.size() & 0xFF);
+        payload.insert(payload.end(), nalu.begin(), nalu.end());
+      }
+      ret.push_back(make_packet(payload, false));
+    }
+    for (; i < frame.nalus.size(); i++) {
+      const bool last_nalu = i == frame.nalus.size() - 1;
+      packetize_nalu(frame.nalus[i], last_nalu, ret);
+    }
+    m_timestamp += 1500;
+    return ret;
+  }
+
+ private:
+  void packetize_nalu(const std::vector<uint8_t>& nalu, bool last_nalu,
+                      std::vector<std::vector<uint8_t>>& out) {
+    if ((int)nalu.size() <= MTU - RTP_HEADER_SIZE) {
+      out.push_back(make_packet(nalu, last_nalu));
+      return;
+    }
+    const size_t hdr_size = m_is_h265 ? 2 : 1;
+    const size_t max_fu_payload = MTU - RTP_HEADER_SIZE - hdr_size - 1;
+    for (size_t offset = hdr_size; offset < nalu.size();) {
+      const size_t len = std::min(max_fu_payload, nalu.size() - offset);
+      const bool start = offset == hdr_size;
+      const bool end = offset + len == nalu.size();
+      std::vector<uint8_t> payload;
+      const uint8_t se = (start ? 0x80 : 0) | (end ? 0x40 : 0);
+      if (m_is_h265) {
+        payload = {(uint8_t)((49 << 1) | (nalu[0] & 0x81)), nalu[1],
+                   (uint8_t)(se | ((nalu[0] >> 1) & 0x3F))};
+      } else {
+        payload = {(uint8_t)((nalu[0] & 0xE0) | 28),
+                   (uint8_t)(se | (nalu[0] & 0x1F))};
+      }
+      payload.insert(payload.end(), nalu.begin() + offset,
+                     nalu.begin() + offset + len);
+      out.push_back(make_packet(payload, end && last_nalu));
+      offset += len;
+    }
+  }
+  std::vector<uint8_t> make_packet(const std::vector<uint8_t>& payload,
+                                   bool marker) {
+    std::vector<uint8_t> packet(RTP_HEADER_SIZE);
+    packet[0] = 0x80;
+    packet[1] = (uint8_t)((marker && m_set_marker ? 0x80 : 0) | 96);
+    packet[2] = m_seq >> 8;
+    packet[3] = m_seq & 0xFF;
+    for (int i = 0; i < 4; i++) packet[4 + i] = m_timestamp >> (24 - 8 * i);
+    m_seq++;
+    packet.insert(packet.end(), payload.begin(), payload.end());
+    return packet;
+  }
+  const bool m_is_h265;
+  const bool m_set_marker;
+  const bool m_aggregate_config;
+  uint16_t m_seq = 0;
+  uint32_t m_timestamp = 0;
+};
+
+// GOP of 30 frames. Some P frames are small enough for a single NAL packet.
+static std::vector<TestFrame> create_frames(bool is_h265, int n_frames,
+                                            int n_slices) {
+  std::vector<TestFrame> frames;
+  for (int i = 0; i < n_frames; i++) {
+    TestFrame frame{};
+    frame.is_idr = i % 30 == 0;
+    if (frame.is_idr) {
+      if (is_h265) frame.nalus.push_back(make_nalu(true, 32, 24));
+      frame.nalus.push_back(make_nalu(is_h265, is_h265 ? 33 : 7, 30));
+      frame.nalus.push_back(make_nalu(is_h265, is_h265 ? 34 : 8, 8));
+      for (int s = 0; s < n_slices; s++) {
+        frame.nalus.push_back(make_nalu(is_h265, is_h265 ? 20 : 5, 60000));
+      }
+    } else {
+      const int size = i % 7 == 0 ? 600 : 8000 + (i % 5) * 1000;
+      for (int s = 0; s < n_slices; s++) {
+        frame.nalus.push_back(make_nalu(is_h265, 1, size));
+      }
+    }
+    frames.push_back(frame);
+  }
+  return frames;
+}
+
+// Until the first marker bit has been seen, the assembler has to assume
+// frames end with a FU end fragment - feed one frame to get past that.
+static void feed_warmup_frame(openhd::RTPFrameAssembler& assembler,
+                              bool is_h265) {
+  Packetizer packetizer{is_h265, true, false};
+  for (const auto& packet :
+       packetizer.packetize(create_frames(is_h265, 1, 1).at(0))) {
+    assembler.add_fragment(
+        openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+  }
+}
+
+static void test_frame_boundaries(bool is_h265, bool set_marker,
+                                  bool aggregate_config, bool multi_slice) {
+  const auto frames = create_frames(is_h265, 300, multi_slice ? 2 : 1);
+  Packetizer packetizer{is_h265, set_marker, aggregate_config};
+  std::vector<size_t> expected_n_fragments;
+  std::vector<std::vector<uint8_t>> packets;
+  for (const auto& frame : frames) {
+    auto frame_packets = packetizer.packetize(frame);
+    expected_n_fragments.push_back(frame_packets.size());
+    packets.insert(packets.end(), frame_packets.begin(), frame_packets.end());
+  }
+  std::vector<openhd::FragmentedVideoFrame> out_frames;
+  auto cb = [&out_frames](int stream_index,
+                          const openhd::FragmentedVideoFrame& frame) {
+    out_frames.push_back(frame);
+  };
+  openhd::RTPFrameAssembler assembler{{is_h265, 0, false}, cb};
+  if (set_marker) {
+    feed_warmup_frame(assembler, is_h265);
+    out_frames.clear();
+  }
+  for (const auto& packet : packets) {
+    assembler.add_fragment(
+        openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+  }
+  std::cout << (is_h265 ? "h265" : "h264")
+            << " marker:" << (set_marker ? "Y" : "N")
+            << " aggregated config:" << (aggregate_config ? "Y" : "N")
+            << " multi slice:" << (multi_slice ? "Y" : "N") << " -> "
+            << out_frames.size() << "/" << frames.size() << " frames\n";
+  assert(out_frames.size() == frames.size());
+  for (size_t i = 0; i < frames.size(); i++) {
+    assert(out_frames[i].rtp_fragments.size() == expected_n_fragments[i]);
+    assert(out_frames[i].is_idr_frame == frames[i].is_idr);
+  }
+}
+
+// Without the marker bit, a frame ends with a FU end fragment (legacy
+// behaviour) - small (single NAL) P frames are merged with the next frame.
+static void test_no_marker_fallback(bool is_h265) {
+  const auto frames = create_frames(is_h265, 300, 1);
+  Packetizer packetizer{is_h265, false, false};
+  int n_out_frames = 0;
+  int n_expected = 0;
+  openhd::RTPFrameAssembler assembler{
+      {is_h265, 0, false},
+      [&n_out_frames](int, const openhd::FragmentedVideoFrame&) {
+        n_out_frames++;
+      }};
+  for (const auto& frame : frames) {
+    const bool ends_with_fu = frame.nalus.back().size() > MTU;
+    if (ends_with_fu) n_expected++;
+    for (const auto& packet : packetizer.packetize(frame)) {
+      assembler.add_fragment(
+          openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+    }
+  }
+  assert(n_out_frames == n_expected);
+}
+
+// Early tx, every slice is forwarded as soon as it is complete
+static void test_early_tx_parts(bool is_h265) {
+  static constexpr int N_SLICES = 3;
+  const auto frames = create_frames(is_h265, 90, N_SLICES);
+  Packetizer packetizer{is_h265, true, true};
+  std::vector<openhd::FragmentedVideoFrame> parts;
+  openhd::RTPFrameAssembler::Config config{is_h265, 0, false};
+  config.early_tx = 1;
+  openhd::RTPFrameAssembler assembler{
+      config, [&parts](int, const openhd::FragmentedVideoFrame& part) {
+        parts.push_back(part);
+      }};
+  feed_warmup_frame(assembler, is_h265);
+  parts.clear();
+  size_t n_fragments = 0;
+  for (const auto& frame : frames) {
+    for (const auto& packet : packetizer.packetize(frame)) {
+      assembler.add_fragment(
+          openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+      n_fragments++;
+    }
+  }
+  assert(parts.size() == frames.size() * N_SLICES);
+  size_t n_part_fragments = 0;
+  for (size_t i = 0; i < parts.size(); i++) {
+    const auto& part = parts[i];
+    const auto& frame = frames[i / N_SLICES];
+    assert(part.part_index == (int)(i % N_SLICES));
+    assert(part.is_last_part == (i % N_SLICES == N_SLICES - 1));
+    // Config and first IDR slice are in the first part already
+    assert(part.is_idr_frame == frame.is_idr);
+    if (part.part_index != 0) {
+      assert(part.creation_time == parts[i - 1].creation_time);
+    }
+    n_part_fragments += part.rtp_fragments.size();
+  }
+  assert(n_part_fragments == n_fragments);
+}
+
+static void test_malformed() {
+  const std::vector<std::vector<uint8_t>> packets = {
+      {},
+      {0x80},
+      {0x80, 0x60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+      // FU without FU header
+      {0x80, 0x60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x7C},
+      // CSRC count exceeds the packet
+      {0x8F, 0x60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x65},
+      // STAP-A with a size exceeding the packet
+      {0x80, 0x60, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0x78, 0xFF, 0xFF, 0x65},
+  };
+  for (const auto& packet : packets) {
+    openhd::RTPFrameAssembler::parse<false>(packet.data(), packet.size());
+    openhd::RTPFrameAssembler::parse<true>(packet.data(), packet.size());
+  }
+  assert(!openhd::RTPFrameAssembler::parse<false>(packets[3].data(),
+                                                  packets[3].size())
+              .valid);
+  assert(!openhd::RTPFrameAssembler::parse<false>(packets[4].data(),
+                                                  packets[4].size())
+              .valid);
+}
+
+static void benchmark(bool is_h265) {
+  const auto frames = create_frames(is_h265, 600, 1);
+  Packetizer packetizer{is_h265, true, true};
+  std::vector<openhd::VideoFragment> fragments;
+  for (const auto& frame : frames) {
+    for (const auto& packet : packetizer.packetize(frame)) {
+      fragments.push_back(
+          openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+    }
+  }
+  int64_t n_frames = 0;
+  openhd::RTPFrameAssembler assembler{
+      {is_h265, 0, false},
+      [&n_frames](int, const openhd::FragmentedVideoFrame&) { n_frames++; }};
+  static constexpr int N_RUNS = 20;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int run = 0; run < N_RUNS; run++) {
+    for (const auto& fragment : fragments) {
+      assembler.add_fragment(fragment);
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  const auto per_fragment_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+      (fragments.size() * N_RUNS);
+  std::cout << (is_h265 ? "h265" : "h264") << " bench: "
+            << openhd::util::time_readable(elapsed) << " for "
+            << fragments.size() * N_RUNS << " fragments, " << per_fragment_ns
+            << "ns per fragment, " << n_frames << " frames\n";
+}
+
+// Latency until a frame is out on the link, with and without early tx.
+// The (simulated) encoder produces the slices of a frame over ENCODE_TIME,
+// the link needs TX_TIME_PER_FRAGMENT per fragment (FEC + air time) and can
+// only start with a block (part) once it is complete.
+static void benchmark_latency(int early_tx) {
+  static constexpr int N_FRAMES = 120;
+  static constexpr int N_SLICES = 4;
+  static constexpr auto FRAME_INTERVAL = std::chrono::microseconds(16666);
+  static constexpr auto ENCODE_TIME = std::chrono::milliseconds(8);
+  static constexpr auto TX_TIME_PER_FRAGMENT = std::chrono::microseconds(100);
+  const auto frames = create_frames(false, N_FRAMES, N_SLICES);
+  Packetizer packetizer{false, true, true};
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<openhd::FragmentedVideoFrame> link_queue;
+  bool done = false;
+  std::vector<std::chrono::nanoseconds> latencies;
+  std::thread link_thread([&] {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      cv.wait(lock, [&] { return done || !link_queue.empty(); });
+      if (link_queue.empty()) break;
+      auto part = std::move(link_queue.front());
+      link_queue.pop_front();
+      lock.unlock();
+      std::this_thread::sleep_for(TX_TIME_PER_FRAGMENT *
+                                  part.rtp_fragments.size());
+      if (part.is_last_part) {
+        latencies.push_back(std::chrono::steady_clock::now() -
+                            part.creation_time);
+      }
+      lock.lock();
+    }
+  });
+  openhd::RTPFrameAssembler::Config config{false, 0, false};
+  config.early_tx = early_tx;
+  openhd::RTPFrameAssembler assembler{
+      config, [&](int, const openhd::FragmentedVideoFrame& part) {
+        std::lock_guard<std::mutex> lock(mutex);
+        link_queue.push_back(part);
+        cv.notify_one();
+      }};
+  const auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < frames.size(); i++) {
+    const auto packets = packetizer.packetize(frames[i]);
+    const auto frame_begin = begin + FRAME_INTERVAL * i;
+    for (size_t j = 0; j < packets.size(); j++) {
+      std::this_thread::sleep_until(frame_begin +
+                                    ENCODE_TIME * (j + 1) / packets.size());
+      assembler.add_fragment(openhd::VideoFragment::copy_of(
+          packets[j].data(), packets[j].size()));
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+    cv.notify_one();
+  }
+  link_thread.join();
+  std::chrono::nanoseconds sum{}, max{};
+  for (const auto& latency : latencies) {
+    sum += latency;
+    max = std::max(max, latency);
+  }
+  std::cout << "early_tx:" << early_tx << " creation -> on air avg:"
+            << openhd::util::time_readable(sum / latencies.size())
+            << " max:" << openhd::util::time_readable(max) << "\n";
+}
+
+// RFC 4571 framing (2 byte big endian length per packet), like written by
+// rtpstreampay
+static void run_captured(const std::string& filename, bool is_h265) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    std::cerr << "Cannot open " << filename << "\n";
+    return;
+  }
+  int n_frames = 0, n_idr = 0, n_fragments = 0;
+  openhd::RTPFrameAssembler assembler{
+      {is_h265, 0, false},
+      [&](int, const openhd::FragmentedVideoFrame& frame) {
+        n_frames++;
+        if (frame.is_idr_frame) n_idr++;
+      }};
+  uint8_t len_buff[2];
+  std::vector<uint8_t> packet;
+  while (file.read((char*)len_buff, 2)) {
+    packet.resize((len_buff[0] << 8) | len_buff[1]);
+    if (!file.read((char*)packet.data(), packet.size())) break;
+    assembler.add_fragment(
+        openhd::VideoFragment::copy_of(packet.data(), packet.size()));
+    n_fragments++;
+  }
+  std::cout << filename << ": " << n_fragments << " fragments, " << n_frames
+            << " frames, " << n_idr << " IDR frames\n";
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && std::string(argv[1]) == "latency") {
+    benchmark_latency(0);
+    benchmark_latency(1);
+    benchmark_latency(8);
+    return 0;
+  }
+  if (argc > 1) {
+    run_captured(argv[1], argc > 2 && std::string(argv[2]) == "h265");
+    return 0;
+  }
+  for (bool is_h265 : {false, true}) {
+    test_frame_boundaries(is_h265, true, false, false);
+    test_frame_boundaries(is_h265, true, true, false);
+    test_frame_boundaries(is_h265, true, true, true);
+    test_no_marker_fallback(is_h265);
+    test_early_tx_parts(is_h265);
+  }
+  test_malformed();
+  benchmark(false);
+  benchmark(true);
+  std::cout << "test_rtp_frame_assembler passed\n";
+  return 0;
+}
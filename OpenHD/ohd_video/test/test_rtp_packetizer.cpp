@@ -0,0 +1,463 @@
+/******************************************************************************
+ * OpenHD
+ *
+ * Licensed under the GNU General Public License (GPL) Version 3.
+ *
+ * This software is provided "as-is," without warranty of any kind, express or
+ * implied, including but not limited to the warranties of merchantability,
+ * fitness for a particular purpose, and non-infringement. For details, see the
+ * full license in the LICENSE file provided with this source code.
+ *
+ * Non-Military Use Only:
+ * This software and its associated components are explicitly intended for
+ * civilian and non-military purposes. Use in any military or defense
+ * applications is strictly prohibited unless explicitly and individually
+ * licensed otherwise by the OpenHD Team.
+ *
+ * Contributors:
+ * A full list of contributors can be found at the OpenHD GitHub repository:
+ * https://github.com/OpenHD
+ *
+ * © OpenHD, All Rights Reserved.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+
+#include "ffmpeg_videosamples.hpp"
+#include "openhd_fragment_pool.h"
+#include "openhd_rtp.h"
+#include "openhd_util_time.h"
+
+//
+// Unit test and benchmark for the (raw h264 / h265 -> rtp) packetizer.
+// Feeds access units built from the ffmpeg sample frames (keyframes) and
+// random slices, de-packetizes the output and checks it NAL by NAL - and the
+// rtp headers (seq, timestamp, marker, mtu). Also checks that nothing is
+// allocated per access unit once warmed up, and measures the throughput.
+//
+static constexpr int MTU = 1440;
+static constexpr int RTP_HEADER_SIZE = 12;
+static constexpr int KEYFRAME_INTERVAL = 30;
+
+// Counts all allocations while enabled
+static std::atomic<bool> g_count_allocations{false};
+static std::atomic<int> g_n_allocations{0};
+
+void* operator new(std::size_t size) {
+  if (g_count_allocations) g_n_allocations++;
+  void* ret = std::malloc(size == 0 ? 1 : size);
+  if (ret == nullptr) throw std::bad_alloc();
+  return ret;
+}
+// noinline - otherwise gcc sees free() on memory from new and warns
+__attribute__((noinline)) void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+__attribute__((noinline)) void operator delete(void* ptr,
+                                               std::size_t) noexcept {
+  std::free(ptr);
+}
+
+using NALU = std::vector<uint8_t>;
+
+// Annex B -> NAL units
+static std::vector<NALU> split_nalus(const uint8_t* data, size_t size) {
+  std::vector<size_t> starts;
+  for (size_t i = 0; i + 3 <= size; i++) {
+    if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      starts.push_back(i + 3);
+    }
+  }
+  std::vector<NALU> ret;
+  for (size_t i = 0; i < starts.size(); i++) {
+    size_t end = i + 1 < starts.size() ? starts[i + 1] - 3 : size;
+    while (end > starts[i] && data[end - 1] == 0) end--;
+    ret.emplace_back(data + starts[i], data + end);
+  }
+  return ret;
+}
+
+static int nal_type(const NALU& nalu, bool is_h265) {
+  return is_h265 ? (nalu[0] >> 1) & 0x3F : nalu[0] & 0x1F;
+}
+
+static bool is_parameter_set(const NALU& nalu, bool is_h265) {
+  const int type = nal_type(nalu, is_h265);
+  return is_h265 ? type >= 32 && type <= 34 : type == 7 || type == 8;
+}
+
+static NALU make_aud(bool is_h265) {
+  return is_h265 ? NALU{35 << 1, 0x01, 0x50} : NALU{0x09, 0xF0};
+}
+
+static NALU make_sei(bool is_h265) {
+  NALU ret = is_h265 ? NALU{39 << 1, 0x01} : NALU{0x06};
+  ret.insert(ret.end(), {0x05, 0x04, 0x11, 0x22, 0x33, 0x44, 0x80});
+  return ret;
+}
+
+struct TestAccessUnit {
+  // Annex b, as it comes out of the parser
+  std::vector<uint8_t> data;
+  // What the rx should get (without the parameter sets)
+  std::vector<NALU> expected;
+  bool is_keyframe;
+};
+
+static void append(std::vector<uint8_t>& data, const NALU& nalu,
+                   bool long_start_code) {
+  if (long_start_code) data.push_back(0);
+  data.insert(data.end(), {0, 0, 1});
+  data.insert(data.end(), nalu.begin(), nalu.end());
+}
+
+static std::vector<TestAccessUnit> create_access_units(bool is_h265,
+                                                       int n_units) {
+  std::mt19937 gen{is_h265 ? 265u : 264u};
+  const auto keyframe =
+      is_h265 ? split_nalus(k_HEVCMainTestFrame, sizeof(k_HEVCMainTestFrame))
+              : split_nalus(k_H264TestFrame, sizeof(k_H264TestFrame));
+  std::vector<TestAccessUnit> ret;
+  for (int i = 0; i < n_units; i++) {
+    TestAccessUnit unit{{}, {}, i % KEYFRAME_INTERVAL == 0};
+    append(unit.data, make_aud(is_h265), true);
+    if (unit.is_keyframe) {
+      append(unit.data, make_sei(is_h265), false);
+      for (const auto& nalu : keyframe) {
+        append(unit.data, nalu, true);
+        if (!is_parameter_set(nalu, is_h265)) unit.expected.push_back(nalu);
+      }
+      ret.push_back(std::move(unit));
+      continue;
+    }
+    // 1 to 3 slices, from smaller than one packet to heavily fragmented
+    const int n_slices = 1 + gen() % 3;
+    for (int s = 0; s < n_slices; s++) {
+      NALU nalu(50 + gen() % 20000);
+      for (auto& b : nalu) b = gen();
+      if (is_h265) {
+        nalu[0] = 1 << 1;  // TRAIL_R
+        nalu[1] = 0x01;
+      } else {
+        nalu[0] = 0x41;  // non-IDR slice
+      }
+      // No (accidental) start codes / trailing zeros in the slice data
+      for (size_t k = 2; k < nalu.size(); k++) {
+        if (nalu[k] == 0) nalu[k] = 0x80;
+      }
+      append(unit.data, nalu, s == 0);
+      unit.expected.push_back(std::move(nalu));
+    }
+    ret.push_back(std::move(unit));
+  }
+  return ret;
+}
+
+// Checks the rtp header(s) and de-packetizes the given frame
+class Depacketizer {
+ public:
+  explicit Depacketizer(bool is_h265) : m_is_h265(is_h265) {}
+  std::vector<NALU> depacketize(const openhd::FragmentedVideoFrame& frame) {
+    std::vector<NALU> ret;
+    NALU fu_nalu;
+    const auto& fragments = frame.rtp_fragments;
+    assert(!fragments.empty());
+    const size_t hdr_size = m_is_h265 ? 2 : 1;
+    for (size_t i = 0; i < fragments.size(); i++) {
+      const uint8_t* packet = fragments[i].data();
+      const size_t size = fragments[i].size();
+      assert(size > RTP_HEADER_SIZE && size <= MTU);
+      assert(packet[0] == 0x80);
+      assert((packet[1] & 0x7F) == 96);
+      // Marker only on the last packet of the access unit
+      assert(((packet[1] & 0x80) != 0) == (i == fragments.size() - 1));
+      const uint16_t seq = (packet[2] << 8) | packet[3];
+      const uint32_t ts = read_u32(packet + 4);
+      const uint32_t ssrc = read_u32(packet + 8);
+      if (m_has_seq) {
+        assert(seq == (uint16_t)(m_seq + 1));
+        assert(ssrc == m_ssrc);
+      }
+      // One timestamp per access unit, a new one for each access unit
+      if (i == 0) {
+        assert(!m_has_seq || ts != m_timestamp);
+      } else {
+        assert(ts == m_timestamp);
+      }
+      m_has_seq = true;
+      m_seq = seq;
+      m_timestamp = ts;
+      m_ssrc = ssrc;
+      const uint8_t* payload = packet + RTP_HEADER_SIZE;
+      const size_t payload_size = size - RTP_HEADER_SIZE;
+      const int type = m_is_h265 ? (payload[0] >> 1) & 0x3F : payload[0] & 0x1F;
+      if (type == (m_is_h265 ? 48 : 24)) {
+        // Aggregation packet, only used for the parameter sets
+        assert(i == 0);
+        for (size_t offset = hdr_size; offset < payload_size;) {
+          const size_t nal_size = (payload[offset] << 8) | payload[offset + 1];
+          offset += 2;
+          assert(offset + nal_size <= payload_size);
+          ret.emplace_back(payload + offset, payload + offset + nal_size);
+          offset += nal_size;
+        }
+      } else if (type == (m_is_h265 ? 49 : 28)) {
+        const uint8_t fu_header = payload[hdr_size];
+        if (fu_header & 0x80) {
+          assert(fu_nalu.empty());
+          if (m_is_h265) {
+            fu_nalu = {(uint8_t)((payload[0] & 0x81) | (fu_header & 0x3F) << 1),
+                       payload[1]};
+          } else {
+            fu_nalu = {(uint8_t)((payload[0] & 0xE0) | (fu_header & 0x1F))};
+          }
+        }
+        assert(!fu_nalu.empty());
+        fu_nalu.insert(fu_nalu.end(), payload + hdr_size + 1,
+                       payload + payload_size);
+        if (fu_header & 0x40) {
+          ret.push_back(std::move(fu_nalu));
+          fu_nalu.clear();
+        }
+      } else {
+        assert(fu_nalu.empty());
+        ret.emplace_back(payload, payload + payload_size);
+      }
+    }
+    assert(fu_nalu.empty());
+    return ret;
+  }
+
+ private:
+  static uint32_t read_u32(const uint8_t* p) {
+    return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+  }
+  const bool m_is_h265;
+  bool m_has_seq = false;
+  uint16_t m_seq = 0;
+  uint32_t m_timestamp = 0;
+  uint32_t m_ssrc = 0;
+};
+
+static void test_find_start_code() {
+  auto find = [](const std::vector<uint8_t>& data) {
+    return (int)(openhd::RTPHelper::find_start_code(data.data(),
+                                                    data.data() + data.size()) -
+                 data.data());
+  };
+  assert(find({}) == 0);
+  assert(find({0, 1}) == 2);
+  assert(find({0, 0, 1}) == 0);
+  assert(find({0, 0, 0, 1, 0x67}) == 1);
+  assert(find({1, 1, 0, 1, 0, 0, 2, 0, 0}) == 9);
+  assert(find({0x65, 1, 0, 0, 1}) == 2);
+  std::cout << "test_find_start_code passed\n";
+}
+
+static void test_roundtrip(bool is_h265) {
+  const auto units = create_access_units(is_h265, 200);
+  const auto parameter_sets =
+      is_h265 ? std::vector<int>{32, 33, 34} : std::vector<int>{7, 8};
+  Depacketizer depacketizer{is_h265};
+  std::vector<openhd::FragmentedVideoFrame> frames;
+  openhd::RTPHelper packetizer{
+      {is_h265, 1, false, 0, MTU},
+      [&frames](int stream_index, const openhd::FragmentedVideoFrame& frame) {
+        assert(stream_index == 1);
+        frames.push_back(frame);
+      }};
+  // No output until we have the parameter sets
+  packetizer.feed_access_unit(units[1].data.data(), units[1].data.size());
+  assert(frames.empty());
+  for (const auto& unit : units) {
+    packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+    assert(frames.size() == 1);
+    const auto& frame = frames[0];
+    assert(frame.is_idr_frame == unit.is_keyframe);
+    assert(frame.is_last_part && frame.part_index == 0);
+    auto nalus = depacketizer.depacketize(frame);
+    // Keyframes start with the parameter sets (the test runs for less than
+    // a second, no re-sends for the other frames)
+    if (unit.is_keyframe) {
+      assert(nalus.size() > parameter_sets.size());
+      for (size_t i = 0; i < parameter_sets.size(); i++) {
+        assert(nal_type(nalus[i], is_h265) == parameter_sets[i]);
+      }
+      nalus.erase(nalus.begin(), nalus.begin() + parameter_sets.size());
+    }
+    // AUD and SEI are dropped
+    assert(nalus == unit.expected);
+    frames.clear();
+  }
+  std::cout << (is_h265 ? "h265" : "h264") << " test_roundtrip passed\n";
+}
+
+// With early tx, an access unit is forwarded in parts - per slice and / or
+// per N fragments, like RTPFrameAssembler does
+static void test_early_tx(bool is_h265, int early_tx) {
+  const auto units = create_access_units(is_h265, 100);
+  Depacketizer depacketizer{is_h265};
+  std::vector<openhd::FragmentedVideoFrame> parts;
+  openhd::RTPHelper packetizer{
+      {is_h265, 0, false, early_tx, MTU},
+      [&parts](int, const openhd::FragmentedVideoFrame& frame) {
+        parts.push_back(frame);
+      }};
+  size_t n_parts = 0;
+  for (const auto& unit : units) {
+    packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+    assert(!parts.empty());
+    // The parts put together are the same as without early tx
+    auto frame = parts[0];
+    for (size_t i = 0; i < parts.size(); i++) {
+      assert(parts[i].part_index == (int)i);
+      assert(parts[i].is_last_part == (i == parts.size() - 1));
+      assert(parts[i].is_idr_frame == unit.is_keyframe);
+      if (early_tx > 1) {
+        assert(parts[i].rtp_fragments.size() <= (size_t)early_tx);
+      }
+      if (i > 0) {
+        frame.rtp_fragments.insert(frame.rtp_fragments.end(),
+                                   parts[i].rtp_fragments.begin(),
+                                   parts[i].rtp_fragments.end());
+      }
+    }
+    // At least one part per slice
+    const auto n_slices = std::count_if(
+        unit.expected.begin(), unit.expected.end(),
+        [is_h265](const NALU& nalu) { return !is_parameter_set(nalu, is_h265); });
+    assert(parts.size() >= (size_t)n_slices);
+    if (early_tx == 1) assert(parts.size() == (size_t)n_slices);
+    auto nalus = depacketizer.depacketize(frame);
+    while (is_parameter_set(nalus.front(), is_h265)) nalus.erase(nalus.begin());
+    assert(nalus == unit.expected);
+    n_parts += parts.size();
+    parts.clear();
+  }
+  std::cout << (is_h265 ? "h265" : "h264") << " test_early_tx(" << early_tx
+            << ") passed, " << n_parts << " parts\n";
+}
+
+// Parameter sets are re-sent at least once per second, and right away if
+// they change
+static void test_parameter_set_resend(bool is_h265) {
+  auto units = create_access_units(is_h265, 3);
+  int n_with_parameter_sets = 0;
+  openhd::RTPHelper packetizer{
+      {is_h265, 0, false, 0, MTU},
+      [&](int, const openhd::FragmentedVideoFrame& frame) {
+        const uint8_t* payload = frame.rtp_fragments[0].data() + 12;
+        const int type =
+            is_h265 ? (payload[0] >> 1) & 0x3F : payload[0] & 0x1F;
+        if (type == (is_h265 ? 48 : 24)) n_with_parameter_sets++;
+      }};
+  auto feed = [&](const TestAccessUnit& unit) {
+    packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+  };
+  feed(units[0]);
+  feed(units[1]);
+  assert(n_with_parameter_sets == 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  feed(units[2]);
+  assert(n_with_parameter_sets == 2);
+  // Changed PPS (last byte) in front of a non-keyframe
+  const auto keyframe =
+      is_h265 ? split_nalus(k_HEVCMainTestFrame, sizeof(k_HEVCMainTestFrame))
+              : split_nalus(k_H264TestFrame, sizeof(k_H264TestFrame));
+  NALU pps = keyframe[is_h265 ? 2 : 1];
+  pps.back() ^= 0x10;
+  std::vector<uint8_t> data;
+  append(data, pps, true);
+  data.insert(data.end(), units[1].data.begin(), units[1].data.end());
+  packetizer.feed_access_unit(data.data(), data.size());
+  assert(n_with_parameter_sets == 3);
+  feed(units[1]);
+  assert(n_with_parameter_sets == 3);
+  std::cout << (is_h265 ? "h265" : "h264")
+            << " test_parameter_set_resend passed\n";
+}
+
+// Once warmed up, nothing is allocated per access unit / fragment
+static void test_zero_alloc(bool is_h265) {
+  const auto units = create_access_units(is_h265, 120);
+  int64_t n_fragments = 0;
+  openhd::RTPHelper packetizer{
+      {is_h265, 0, false, 0, MTU},
+      [&n_fragments](int, const openhd::FragmentedVideoFrame& frame) {
+        n_fragments += frame.rtp_fragments.size();
+      }};
+  for (const auto& unit : units) {
+    packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+  }
+  auto& pool = openhd::FragmentPool::instance();
+  const auto misses_before = pool.get_stats().count_miss;
+  g_n_allocations = 0;
+  g_count_allocations = true;
+  for (int run = 0; run < 5; run++) {
+    for (const auto& unit : units) {
+      packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+    }
+  }
+  g_count_allocations = false;
+  const auto misses = pool.get_stats().count_miss;
+  std::cout << (is_h265 ? "h265" : "h264") << " " << n_fragments
+            << " fragments, allocations:" << g_n_allocations
+            << " pool misses:" << misses - misses_before << "\n";
+  assert(g_n_allocations == 0);
+  assert(misses == misses_before);
+  std::cout << (is_h265 ? "h265" : "h264") << " test_zero_alloc passed\n";
+}
+
+static void benchmark(bool is_h265) {
+  const auto units = create_access_units(is_h265, 600);
+  size_t n_bytes = 0;
+  for (const auto& unit : units) n_bytes += unit.data.size();
+  int64_t n_fragments = 0;
+  openhd::RTPHelper packetizer{
+      {is_h265, 0, false, 0, MTU},
+      [&n_fragments](int, const openhd::FragmentedVideoFrame& frame) {
+        n_fragments += frame.rtp_fragments.size();
+      }};
+  static constexpr int N_RUNS = 20;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int run = 0; run < N_RUNS; run++) {
+    for (const auto& unit : units) {
+      packetizer.feed_access_unit(unit.data.data(), unit.data.size());
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - begin;
+  const auto elapsed_ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  const double mb_per_s =
+      (double)(n_bytes * N_RUNS) / 1e6 / ((double)elapsed_ns / 1e9);
+  std::cout << (is_h265 ? "h265" : "h264") << " bench: "
+            << openhd::util::time_readable(elapsed) << " for "
+            << units.size() * N_RUNS << " access units, " << n_fragments
+            << " fragments, " << (int)mb_per_s << "MB/s, "
+            << elapsed_ns / n_fragments << "ns per fragment\n";
+}
+
+int main(int argc, char* argv[]) {
+  // First use of the pool allocates the slots
+  openhd::FragmentPool::instance();
+  test_find_start_code();
+  for (bool is_h265 : {false, true}) {
+    test_roundtrip(is_h265);
+    test_parameter_set_resend(is_h265);
+    test_zero_alloc(is_h265);
+    test_early_tx(is_h265, 1);
+    test_early_tx(is_h265, 8);
+  }
+  benchmark(false);
+  benchmark(true);
+  std::cout << "test_rtp_packetizer passed\n";
+  return 0;
+}
@@ -54,8 +54,10 @@ int main(int argc, char* argv[]) {
                 const openhd::FragmentedVideoFrame& fragmented_video_frame) {
     int total_size = 0;
     for (auto& fragemnt : fragmented_video_frame.rtp_fragments) {
-      forwarder.forwardPacketViaUDP(fragemnt->data(), fragemnt->size());
-      total_size += fragemnt->size();
+      struct iovec spans[openhd::VideoFragment::MAX_N_SPANS];
+      const int n_spans = fragemnt.get_spans(spans);
+      forwarder.forwardPacketViaUDP(spans, n_spans);
+      total_size += fragemnt.size();
     }
     if (fragmented_video_frame.dirty_frame) {
       auto fragments =